@@ -0,0 +1,186 @@
+#include <mesh-optimizer.h>
+#include <bounds.h>
+#include <bvh.h>
+#include <block-compression.h>
+#include <mip-chain.h>
+#include <d3d12.h>
+#include <DirectXTex.h>
+#include <tiny_gltf.h>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <string>
+
+// Timings and quality of the CPU modules of demo-dll. They depend on the machine, so they are reported here instead of being
+// checked by the tests. Runs every benchmark, or the ones named on the command line.
+
+namespace
+{
+	// Positions and indices of every indexed triangle primitive of a glTF file, for the meshlet benchmark
+	std::vector<MeshOptimizer::FTestMesh> LoadMeshes(const std::filesystem::path& filepath)
+	{
+		tinygltf::TinyGLTF loader;
+		loader.SetImageLoader([](tinygltf::Image*, const int, std::string*, std::string*, int, int, const unsigned char*, int, void*)
+		{
+			return true;
+		}, nullptr);
+
+		tinygltf::Model model;
+		std::string errors, warnings;
+		if (!loader.LoadASCIIFromFile(&model, &errors, &warnings, filepath.string()))
+		{
+			return {};
+		}
+
+		std::vector<MeshOptimizer::FTestMesh> meshes;
+		for (const tinygltf::Mesh& mesh : model.meshes)
+		{
+			for (const tinygltf::Primitive& primitive : mesh.primitives)
+			{
+				auto positionAttribute = primitive.attributes.find("POSITION");
+				if (primitive.mode != TINYGLTF_MODE_TRIANGLES || primitive.indices < 0 || positionAttribute == primitive.attributes.cend())
+				{
+					continue;
+				}
+
+				MeshOptimizer::FTestMesh& newMesh = meshes.emplace_back();
+
+				const tinygltf::Accessor& indexAccessor = model.accessors[primitive.indices];
+				const tinygltf::BufferView& indexView = model.bufferViews[indexAccessor.bufferView];
+				const size_t indexSize = tinygltf::GetComponentSizeInBytes(indexAccessor.componentType);
+				const uint8_t* indexSrc = &model.buffers[indexView.buffer].data[indexView.byteOffset + indexAccessor.byteOffset];
+				for (size_t i = 0; i < indexAccessor.count; ++i, indexSrc += indexAccessor.ByteStride(indexView))
+				{
+					newMesh.m_indices.push_back(indexSize == 1 ? *indexSrc : (indexSize == 2 ? *(const uint16_t*)indexSrc : *(const uint32_t*)indexSrc));
+				}
+
+				const tinygltf::Accessor& positionAccessor = model.accessors[positionAttribute->second];
+				const tinygltf::BufferView& positionView = model.bufferViews[positionAccessor.bufferView];
+				const uint8_t* positionSrc = &model.buffers[positionView.buffer].data[positionView.byteOffset + positionAccessor.byteOffset];
+				newMesh.m_positions.resize(3 * positionAccessor.count);
+				for (size_t v = 0; v < positionAccessor.count; ++v)
+				{
+					memcpy(&newMesh.m_positions[3 * v], positionSrc + v * positionAccessor.ByteStride(positionView), 3 * sizeof(float));
+				}
+			}
+		}
+
+		return meshes;
+	}
+
+	// Meshlet build times, fill rates and cone culling on Sponza and high poly spheres
+	void BenchmarkMeshlets()
+	{
+		auto Report = [](const std::string& name, const std::vector<MeshOptimizer::FTestMesh>& meshes)
+		{
+			const MeshOptimizer::Benchmark::FMeshletResult result = MeshOptimizer::Benchmark::RunMeshlets(meshes);
+			std::cout << "Meshlets of " << name << ": " << result.m_triangleCount << " triangles in " << result.m_meshletCount << " meshlets, built in "
+				<< result.m_buildTime << " ms, " << 100.0 * result.m_vertexFill << "% vertex fill, " << 100.0 * result.m_triangleFill << "% triangle fill, "
+				<< 100.0 * result.m_coneCulledFraction << "% cone culled\n";
+		};
+
+		Report("Sponza", LoadMeshes(CONTENT_DIR "/sponza/Sponza.gltf"));
+		Report("a 100k triangle sphere", { MeshOptimizer::CreateTestMesh(224, 224) });
+		Report("a 1M triangle sphere", { MeshOptimizer::CreateTestMesh(724, 724) });
+	}
+
+	// Throughput of the bounds transform kernels
+	void BenchmarkBoundsTransform()
+	{
+		for (const size_t boxCount : { 1024, 64 * 1024 })
+		{
+			std::cout << "Bounds transform of " << boxCount << " boxes: " << Bounds::MeasureTransformThroughput(boxCount, true) << " boxes/us"
+				<< (Bounds::HasSimdSupport() ? "" : " (no SIMD support)") << ", scalar " << Bounds::MeasureTransformThroughput(boxCount, false) << " boxes/us\n";
+		}
+	}
+
+	// Instance BVH build, refit and query times
+	void BenchmarkBvh()
+	{
+		for (const size_t boxCount : { 1000, 100 * 1000, 1000 * 1000 })
+		{
+			const BvhBenchmark::FResult result = BvhBenchmark::Run(boxCount);
+			std::cout << "BVH of " << boxCount << " instances: build " << result.m_buildTime << " ms, refit " << result.m_refitTime << " ms, cull "
+				<< result.m_cullTime << " us, raycast " << result.m_raycastTime << " us\n";
+		}
+	}
+
+	// Block compressor quality and throughput against stb_dxt
+	void BenchmarkBlockCompression()
+	{
+		const char* formatNames[] = { "BC1", "BC3", "BC4", "BC5", "BC7" };
+		for (const BlockCompression::Format format : { BlockCompression::Format::BC1, BlockCompression::Format::BC3, BlockCompression::Format::BC4, BlockCompression::Format::BC5, BlockCompression::Format::BC7 })
+		{
+			const BlockCompression::Benchmark::FResult result = BlockCompression::Benchmark::Run(format, 1024);
+			std::cout << formatNames[(int)format] << " compression: " << result.m_psnr << " dB, " << result.m_throughput << " MP/s"
+				<< (BlockCompression::HasSimdSupport() ? "" : " (no SIMD support)") << ", stb_dxt " << result.m_stbPsnr << " dB, " << result.m_stbThroughput << " MP/s\n";
+		}
+	}
+
+	// Mip chain generation times against DirectXTex
+	void BenchmarkMipGeneration()
+	{
+		constexpr uint32_t size = 2048;
+		const char* filterNames[] = { "box", "kaiser" };
+		for (const MipChain::Filter filter : { MipChain::Filter::Box, MipChain::Filter::Kaiser })
+		{
+			std::cout << "Mip chain of a " << size << "x" << size << " image, " << filterNames[(int)filter] << " filter: sRGB "
+				<< MipChain::MeasureGenerateTime(size, MipChain::Format::RGBA8Srgb, filter, true) << " ms, float "
+				<< MipChain::MeasureGenerateTime(size, MipChain::Format::RGBA32Float, filter, true) << " ms"
+				<< (MipChain::HasSimdSupport() ? "" : " (no SIMD support)") << ", scalar sRGB "
+				<< MipChain::MeasureGenerateTime(size, MipChain::Format::RGBA8Srgb, filter, false) << " ms\n";
+		}
+
+		// The previous path, DirectXTex linear filter
+		for (const DXGI_FORMAT format : { DXGI_FORMAT_R8G8B8A8_UNORM_SRGB, DXGI_FORMAT_R32G32B32A32_FLOAT })
+		{
+			DirectX::ScratchImage source;
+			if (FAILED(source.Initialize2D(format, size, size, 1, 1)))
+			{
+				return;
+			}
+
+			std::mt19937 rng{ 1 };
+			std::generate_n(source.GetPixels(), source.GetPixelsSize(), [&rng]() { return uint8_t(rng() % 64); });
+
+			double bestTime = std::numeric_limits<double>::max();
+			for (int run = 0; run < 3; ++run)
+			{
+				const auto start = std::chrono::high_resolution_clock::now();
+				DirectX::ScratchImage mipchain;
+				if (FAILED(DirectX::GenerateMipMaps(*source.GetImage(0, 0, 0), DirectX::TEX_FILTER_LINEAR, 0, mipchain)))
+				{
+					return;
+				}
+
+				bestTime = std::min(bestTime, std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count());
+			}
+
+			std::cout << "Mip chain of a " << size << "x" << size << " image, DirectXTex linear filter: " << (DirectX::IsSRGB(format) ? "sRGB " : "float ") << bestTime << " ms\n";
+		}
+	}
+}
+
+int main(int argc, char** argv)
+{
+	const std::pair<const char*, void(*)()> benchmarks[] = {
+		{ "meshlets", BenchmarkMeshlets },
+		{ "bounds", BenchmarkBoundsTransform },
+		{ "bvh", BenchmarkBvh },
+		{ "block-compression", BenchmarkBlockCompression },
+		{ "mip-chain", BenchmarkMipGeneration } };
+
+	for (const auto& [name, benchmark] : benchmarks)
+	{
+		if (argc == 1 || std::any_of(argv + 1, argv + argc, [name](const char* arg) { return strcmp(arg, name) == 0; }))
+		{
+			benchmark();
+		}
+	}
+
+	return 0;
+}
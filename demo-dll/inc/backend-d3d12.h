@@ -102,6 +102,7 @@ struct FResource
 	D3DResource_t* m_d3dResource;
 	std::wstring m_name;
 	concurrency::concurrent_vector<D3D12_RESOURCE_STATES> m_subresourceStates;
+	std::vector<winrt::com_ptr<D3DHeap_t>> m_tileHeaps; // reserved resources, one per standard mip then one for the packed mips
 
 	~FResource();
 	void SetName(const std::wstring& name);
@@ -134,6 +135,8 @@ struct FTransientBuffer
 {
 	FResource* m_resource;
 	const FCommandList* m_dependentCmdlist;
+	D3D12_GPU_VIRTUAL_ADDRESS m_gpuAddress;
+	bool m_isLinearAllocation; // slice of the per-frame linear allocator rather than a pooled buffer
 
 	~FTransientBuffer();
 };
@@ -160,7 +163,15 @@ public:
 	void UpdateSubresources(
 		D3DResource_t* destinationResource,
 		const std::vector<D3D12_SUBRESOURCE_DATA>& srcData,
-		std::function<void(FCommandList*)> transition);
+		std::function<void(FCommandList*)> transition,
+		const uint32_t firstSubresource = 0);
+
+	// Copies into a sub range of a buffer that is in the common state, e.g. one that is filled progressively
+	void UpdateBufferRegion(
+		D3DResource_t* destinationResource,
+		const size_t destinationOffset,
+		const uint8_t* pData,
+		const size_t size);
 
 	D3DFence_t* SubmitUploads(FCommandList* owningCL);
 
@@ -210,6 +221,7 @@ namespace RenderBackend12
 
 	// Feature Support
 	uint32_t GetLaneCount();
+	bool SupportsReservedTextures();
 
 	// Resource Management
 	std::unique_ptr<FTransientBuffer> CreateTransientBuffer(
@@ -254,6 +266,36 @@ namespace RenderBackend12
 		const uint8_t* pData = nullptr,
 		FResourceUploadContext* uploadContext = nullptr);
 
+	void UpdateBindlessBuffer(
+		FCommandList* cmdList,
+		FBindlessShaderResource* buffer,
+		const size_t destOffset,
+		const uint8_t* pData,
+		const size_t size);
+
+	void DeferredRelease(std::unique_ptr<FBindlessShaderResource> resource, const FCommandList* dependentCL);
+
+	// 2D texture without memory behind it. Mips are backed with CommitTextureMips and the SRV only exposes the mips from
+	// SetTextureMostDetailedMip onwards, none until it is first called.
+	std::unique_ptr<FBindlessShaderResource> CreateBindlessReservedTexture(
+		const std::wstring& name,
+		const DXGI_FORMAT format,
+		const size_t width,
+		const size_t height,
+		const size_t numMips);
+
+	// First mip of the packed tail, which is committed as a whole. The mip count if the texture has no packed mips.
+	uint32_t GetPackedMipIndex(const FBindlessShaderResource* texture);
+
+	// Backs the mips from firstMip to the last one with memory. The mappings are queued on the copy queue so that uploads
+	// submitted afterwards land in them.
+	void CommitTextureMips(FBindlessShaderResource* texture, const uint32_t firstMip);
+
+	// Moves the texture to a new SRV that starts at mostDetailedMip. The previous descriptor is recycled once dependentCL has
+	// completed, so shader visible references to it must be replaced by work submitted up to dependentCL. dependentCL can be
+	// null the first time.
+	void SetTextureMostDetailedMip(FBindlessShaderResource* texture, const uint32_t mostDetailedMip, const FCommandList* dependentCL);
+
 	std::unique_ptr<FBindlessUav> CreateBindlessUavTexture(
 		const std::wstring& name,
 		const DXGI_FORMAT format,
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <backend-d3d12.h>
+#include <vector>
+
+// Headless device that RenderBackend12 runs against when built with DEMO_NULL_BACKEND.
+// Resources are backed by CPU memory, command lists record into an in-memory stream and fences are
+// signaled as soon as the owning queue executes, so the whole frame can be exercised without a GPU.
+
+enum class NullCommandType : uint32_t
+{
+	Draw,
+	Dispatch,
+	Copy,
+	Barrier,
+	SetPipelineState,
+	SetRootSignature,
+	SetRootArgument,
+	SetDescriptorHeaps,
+	SetFixedFunctionState,
+	SetRenderTargets,
+	Clear,
+	Resolve,
+	Query,
+	Event,
+	Other,
+	Count
+};
+
+struct FNullCommand
+{
+	NullCommandType m_type;
+	D3D12_COMMAND_LIST_TYPE m_queueType;
+	uint64_t m_args[2];
+};
+
+struct FNullBackendStats
+{
+	uint64_t m_frameCount;
+	uint64_t m_commandCount[(size_t)NullCommandType::Count];
+	uint64_t m_executedCommandLists;
+	uint64_t m_fenceSignals;
+	uint64_t m_copiedBytes;
+	uint64_t m_createdCommandLists;
+	uint64_t m_createdResources;
+	uint64_t m_createdPipelineStates;
+	uint64_t m_createdDescriptors;
+	uint64_t m_liveResources;
+	uint64_t m_liveResourceBytes;
+	uint64_t m_peakResourceBytes;
+};
+
+namespace NullBackend
+{
+	winrt::com_ptr<D3DDevice_t> CreateDevice();
+
+	// Frame boundary: snapshots the per-frame counters and the submitted command stream
+	void Present();
+	void Report();
+
+	FNullBackendStats GetTotalStats();
+	FNullBackendStats GetLastFrameStats();
+	std::vector<FNullCommand> GetLastFrameCommands();
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+// Block compression of RGBA8 images to BC1, BC3, BC4, BC5 and BC7. Pure CPU and platform independent, with AVX2, SSE4.1
+// and NEON kernels where available. Images are split across the thread pool by rows of 4x4 blocks.
+namespace BlockCompression
+{
+	// Bump when the encoders change their output, compressed textures are cached on disk
+	constexpr uint32_t k_version = 1;
+
+	enum class Format
+	{
+		BC1, // opaque RGB, alpha is ignored
+		BC3, // BC1 color with a BC4 alpha block
+		BC4, // R
+		BC5, // RG
+		BC7 // RGBA, modes 1 and 6
+	};
+
+	// 8 or 16
+	size_t GetBlockSize(const Format format);
+
+	// True if the SIMD kernels can run on this CPU
+	bool HasSimdSupport();
+
+	// Compresses a 4x4 block of RGBA8 pixels, 16 bytes per row of the block
+	void CompressBlock(const Format format, const uint8_t* rgba, uint8_t* dest, const bool allowSimd = true);
+
+	// Reference decoder, writes 4x4 RGBA8 pixels. Channels missing from the format decode to 0, alpha to 255.
+	void DecompressBlock(const Format format, const uint8_t* block, uint8_t* rgba);
+
+	// Compresses a whole image. Partial blocks on the right and bottom edges repeat the last column and row of pixels.
+	// destRowPitch is the size of a row of blocks.
+	void Compress(
+		const Format format,
+		const uint8_t* rgba,
+		const uint32_t width,
+		const uint32_t height,
+		const size_t rowPitch,
+		uint8_t* dest,
+		const size_t destRowPitch,
+		const bool allowSimd = true);
+
+	namespace Benchmark
+	{
+		struct FResult
+		{
+			double m_psnr; // dB over the channels the format stores
+			double m_throughput; // megapixels per second
+			double m_stbPsnr; // stb_dxt for the same format, BC3 for BC7 since both are 8 bits per pixel
+			double m_stbThroughput;
+		};
+
+		// Procedural size x size image with gradients, hard edges and noise, compressed on every core
+		FResult Run(const Format format, const uint32_t size, const bool allowSimd = true);
+	}
+}
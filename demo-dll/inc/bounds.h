@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+// Batched bounding box math. Pure CPU and platform independent, with AVX2 and NEON kernels where available.
+namespace Bounds
+{
+	// Axis aligned boxes stored as separate center and extent arrays so that kernels can process several boxes per register
+	struct FBoxSoA
+	{
+		void Resize(const size_t count);
+		void Clear();
+		size_t Size() const { return m_centerX.size(); }
+
+		void Set(const size_t index, const float center[3], const float extents[3]);
+
+		std::vector<float> m_centerX;
+		std::vector<float> m_centerY;
+		std::vector<float> m_centerZ;
+		std::vector<float> m_extentX;
+		std::vector<float> m_extentY;
+		std::vector<float> m_extentZ;
+	};
+
+	struct FAabb
+	{
+		float m_min[3];
+		float m_max[3];
+	};
+
+	// True if the SIMD kernels, AVX2 or NEON, can run on this CPU
+	bool HasSimdSupport();
+
+	// Transforms every box of src by its own affine transform followed by root and writes the enclosing axis aligned boxes to
+	// dest. Transforms are 16 floats each, row major for row vectors like DirectXMath. Returns the union of the output boxes,
+	// an inverted box if src is empty.
+	FAabb TransformBoxes(
+		FBoxSoA& dest,
+		const FBoxSoA& src,
+		const float* transforms,
+		const float root[16],
+		const bool allowSimd = true);
+
+	// Clip space planes of a D3D projection (0 <= z <= w) as a * x + b * y + c * z + d >= 0 inside the frustum. Planes of
+	// infinite projections that degenerate to a point at infinity are skipped. Returns the number of planes written.
+	size_t GetFrustumPlanes(float planes[6][4], const float viewProjection[16]);
+
+	// Writes the indices of the boxes in [begin, end) that intersect or lie inside all the planes, in increasing order.
+	// Returns the number of indices written.
+	size_t CullBoxes(
+		uint32_t* visibleIndices,
+		const FBoxSoA& boxes,
+		const size_t begin,
+		const size_t end,
+		const float planes[][4],
+		const size_t planeCount,
+		const bool allowSimd = true);
+
+	// Microbenchmark of TransformBoxes on boxCount random boxes. Returns the throughput in boxes per microsecond.
+	float MeasureTransformThroughput(const size_t boxCount, const bool allowSimd);
+}
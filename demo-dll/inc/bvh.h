@@ -0,0 +1,129 @@
+#pragma once
+
+#include <bounds.h>
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+//-----------------------------------------------------------------------------------------------------------------------------------------------
+//														Bounding Volume Hierarchy
+//-----------------------------------------------------------------------------------------------------------------------------------------------
+
+// Binary BVH over a set of axis aligned boxes, built with a binned surface area heuristic. Primitives are box indices and
+// every node covers a contiguous range of the primitive list.
+class FBvh
+{
+public:
+	enum class Containment
+	{
+		Outside,
+		Intersects,
+		Inside
+	};
+
+	struct FNode
+	{
+		float m_min[3];
+		uint32_t m_first; // into m_primitives
+		float m_max[3];
+		uint32_t m_count; // primitives in the subtree
+		uint32_t m_left; // right child is m_left + 1, 0 for leaves since the root is never a child
+	};
+
+	// Large subtrees are built in parallel
+	void Build(const Bounds::FBoxSoA& boxes);
+
+	// Updates the node bounds after the boxes have moved. The topology is kept, so the tree degrades if boxes move far.
+	// Returns the SAH cost of the refitted tree relative to the cost right after the build, to decide when to rebuild.
+	float Refit(const Bounds::FBoxSoA& boxes);
+
+	void Clear();
+	size_t GetPrimitiveCount() const { return m_primitives.size(); }
+
+	// Writes the indices of the boxes for which test(min, max) is not Outside, in tree order. Subtrees that are Outside are
+	// skipped and subtrees that are Inside are written without testing their boxes. Returns the number of indices written.
+	template<typename TTest>
+	size_t Cull(uint32_t* results, const Bounds::FBoxSoA& boxes, TTest&& test) const;
+
+	// Nearest box hit by the ray within maxDistance. The direction does not need to be normalized, distances are in
+	// multiples of it.
+	bool Raycast(
+		const float origin[3],
+		const float direction[3],
+		const float maxDistance,
+		const Bounds::FBoxSoA& boxes,
+		uint32_t& hitIndex,
+		float& hitDistance) const;
+
+	std::vector<FNode> m_nodes;
+	std::vector<uint32_t> m_primitives;
+
+private:
+	float GetCost() const;
+
+	float m_buildCost = 0.f;
+};
+
+template<typename TTest>
+size_t FBvh::Cull(uint32_t* results, const Bounds::FBoxSoA& boxes, TTest&& test) const
+{
+	if (m_nodes.empty())
+	{
+		return 0;
+	}
+
+	size_t resultCount = 0;
+	uint32_t stack[64];
+	uint32_t stackSize = 0;
+	stack[stackSize++] = 0;
+	while (stackSize > 0)
+	{
+		const FNode& node = m_nodes[stack[--stackSize]];
+		const Containment containment = test(node.m_min, node.m_max);
+		if (containment == Containment::Outside)
+		{
+			continue;
+		}
+
+		if (containment == Containment::Inside)
+		{
+			std::copy_n(&m_primitives[node.m_first], node.m_count, results + resultCount);
+			resultCount += node.m_count;
+		}
+		else if (node.m_left == 0)
+		{
+			for (uint32_t i = node.m_first; i < node.m_first + node.m_count; ++i)
+			{
+				const uint32_t box = m_primitives[i];
+				const float min[3] = { boxes.m_centerX[box] - boxes.m_extentX[box], boxes.m_centerY[box] - boxes.m_extentY[box], boxes.m_centerZ[box] - boxes.m_extentZ[box] };
+				const float max[3] = { boxes.m_centerX[box] + boxes.m_extentX[box], boxes.m_centerY[box] + boxes.m_extentY[box], boxes.m_centerZ[box] + boxes.m_extentZ[box] };
+				if (test(min, max) != Containment::Outside)
+				{
+					results[resultCount++] = box;
+				}
+			}
+		}
+		else
+		{
+			stack[stackSize++] = node.m_left + 1;
+			stack[stackSize++] = node.m_left;
+		}
+	}
+
+	return resultCount;
+}
+
+namespace BvhBenchmark
+{
+	struct FResult
+	{
+		double m_buildTime; // ms
+		double m_refitTime; // ms
+		double m_cullTime; // us per query, an eighth of the scene volume
+		double m_raycastTime; // us per ray
+	};
+
+	// Random boxes scattered in a cube with a density that does not depend on the count
+	FResult Run(const size_t boxCount);
+}
@@ -1,10 +1,28 @@
 #pragma once
 #include <filesystem>
+#include <content-index.h>
 
 namespace Settings
 {
 	constexpr DXGI_FORMAT k_backBufferFormat = DXGI_FORMAT_R8G8B8A8_UNORM_SRGB;
 	constexpr char k_sceneFilename[] = "MetalRoughSpheres.gltf";
+	constexpr bool k_quantizeVertices = true;
+	constexpr bool k_optimizeOverdraw = true;
+	constexpr uint32_t k_meshLodCount = 4; // including the source mesh
+	constexpr float k_lodErrorThreshold = 1.f; // in pixels
+	constexpr DXGI_FORMAT k_baseColorTextureFormat = DXGI_FORMAT_BC1_UNORM_SRGB; // or DXGI_FORMAT_BC7_UNORM_SRGB, twice the size for higher quality
+	constexpr bool k_kaiserMipFilter = true; // sharper distant textures than a box filter, at the cost of slight ringing
+	constexpr size_t k_sceneStreamingBudget = 16 * 1024 * 1024; // bytes uploaded per frame while a scene streams in
+	constexpr uint32_t k_textureStreamingTailSize = 256; // mips up to this size load with the scene, the larger ones stream in by distance
+	constexpr size_t k_textureStreamingBudget = 8 * 1024 * 1024; // bytes of streamed mips uploaded per frame
+	constexpr bool k_occlusionCulling = true;
+	constexpr uint32_t k_occlusionBufferWidth = 256;
+	constexpr uint32_t k_occlusionBufferHeight = 128;
+	constexpr float k_occluderMinSize = 0.05f; // relative to the scene bounds
+	constexpr uint32_t k_maxOccluderTriangles = 4096; // per occluder mesh
+	constexpr uint32_t k_occluderTriangleBudget = 32 * 1024; // rasterized per frame, nearest occluders first
+	constexpr size_t k_bvhCullingMinInstances = 1024; // smaller scenes are culled with flat SIMD batches
+	constexpr float k_bvhRebuildThreshold = 1.5f; // SAH cost growth from refitting that triggers a rebuild
 }
 
 inline void AssertIfFailed(HRESULT hr)
@@ -38,28 +56,14 @@ inline void DebugAssert(bool success, const char* msg = nullptr)
 
 inline std::wstring GetFilepathW(const std::wstring& filename)
 {
-	for (auto& entry : std::filesystem::recursive_directory_iterator(CONTENT_DIR))
-	{
-		if (entry.is_regular_file() && entry.path().filename().wstring() == filename)
-		{
-			return entry.path().wstring();
-		}
-	}
-
-	DebugAssert(false, "File not found");
-	return {};
+	const std::filesystem::path filepath = ContentIndex::Find(filename);
+	DebugAssert(!filepath.empty(), "File not found");
+	return filepath.wstring();
 }
 
 inline std::string GetFilepathA(const std::string& filename)
 {
-	for (auto& entry : std::filesystem::recursive_directory_iterator(CONTENT_DIR))
-	{
-		if (entry.is_regular_file() && entry.path().filename().string() == filename)
-		{
-			return entry.path().string();
-		}
-	}
-
-	DebugAssert(false, "File not found");
-	return {};
+	const std::filesystem::path filepath = ContentIndex::Find(std::filesystem::path{ filename }.wstring());
+	DebugAssert(!filepath.empty(), "File not found");
+	return filepath.string();
 }
\ No newline at end of file
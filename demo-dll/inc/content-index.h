@@ -0,0 +1,19 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+
+// Filename to path index of the content directory. Built once at startup and kept up to date by a directory watcher
+// thread, so lookups never scan the content tree.
+namespace ContentIndex
+{
+	bool Initialize();
+	void Teardown();
+
+	// Full path of the first indexed file with the given name, or an empty path if there is none
+	std::filesystem::path Find(const std::wstring& filename);
+
+	// Bumped by the watcher for every batch of changes under the content directory, including edits to existing files
+	uint64_t GetChangeCount();
+}
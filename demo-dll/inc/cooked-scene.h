@@ -0,0 +1,222 @@
+#pragma once
+
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#include <dxgiformat.h>
+#include <DirectXMath.h>
+#include <DirectXCollision.h>
+#include <mesh-optimizer.h>
+#include <filesystem>
+#include <span>
+#include <string>
+#include <vector>
+
+// Cooked scene (.dscene) layout. The file is a header followed by 16 byte aligned sections, all of them POD
+// so that the loader can map the file and hand section pointers straight to the upload path.
+namespace CookedScene
+{
+	constexpr uint32_t k_magic = 'NCSD';
+	constexpr uint32_t k_version = 12;
+	constexpr size_t k_sectionAlignment = 16;
+
+	enum class Section : uint32_t
+	{
+		Dependencies,
+		Strings,
+		Textures,
+		Materials,
+		Meshes,
+		Instances,
+		Bounds,
+		Cameras,
+		IndexData,
+		PositionData,
+		NormalData,
+		UvData,
+		Meshlets,
+		MeshletBounds,
+		MeshletVertices,
+		MeshletTriangles,
+		Count
+	};
+
+	enum Flags : uint32_t
+	{
+		QuantizedVertices = 1 << 0, // unorm16x3 (+pad) positions, octahedral snorm16x2 normals, half2 uvs
+		OverdrawOptimized = 1 << 1, // triangle clusters sorted for overdraw after vertex cache optimization
+		LodCountShift = 8, // bits 8-15 hold the number of LODs requested per mesh
+	};
+
+	struct FSectionEntry
+	{
+		uint64_t m_offset;
+		uint64_t m_size;
+	};
+
+	struct FHeader
+	{
+		uint32_t m_magic;
+		uint32_t m_version;
+		uint32_t m_flags;
+		uint32_t m_padding;
+		FSectionEntry m_sections[(size_t)Section::Count];
+		DirectX::BoundingBox m_sceneBounds; // world space
+	};
+
+	// Source file the cooked data was built from. A dependency that has changed on disk invalidates the cooked scene.
+	struct FDependency
+	{
+		uint32_t m_pathOffset;
+		uint32_t m_padding;
+		int64_t m_lastWriteTime;
+		uint64_t m_size;
+	};
+
+	// Material slot a texture is sampled from, which decides its compressed format
+	enum class TextureUsage : uint32_t
+	{
+		BaseColor,
+		Normal, // tangent space XY, Z is left to the shader that samples it
+		MetallicRoughness
+	};
+
+	// Encoded image file, or a range of a file when the image is stored in a glTF buffer
+	struct FTexture
+	{
+		uint32_t m_uriOffset;
+		uint32_t m_pathOffset;
+		TextureUsage m_usage;
+		uint32_t m_padding;
+		uint64_t m_byteOffset;
+		uint64_t m_byteSize; // 0 for the whole file
+	};
+
+	// Deduplicated by content, meshes with identical parameters share a material whatever their glTF material
+	struct FMaterial
+	{
+		uint32_t m_nameOffset;
+		DirectX::XMFLOAT3 m_emissiveFactor;
+		DirectX::XMFLOAT3 m_baseColorFactor;
+		float m_metallicFactor;
+		float m_roughnessFactor;
+		int32_t m_baseColorTexture; // index into the texture section
+		int32_t m_metallicRoughnessTexture;
+		int32_t m_normalTexture;
+		int32_t m_baseColorSampler;
+		int32_t m_metallicRoughnessSampler;
+		int32_t m_normalSampler;
+	};
+
+	struct FMeshLod
+	{
+		uint32_t m_indexOffset; // in elements of the mesh's own index format
+		uint32_t m_indexCount;
+		float m_error; // largest simplification error in mesh space
+	};
+
+	struct FMesh
+	{
+		uint32_t m_nameOffset;
+		uint32_t m_materialIndex; // into the material section
+		uint32_t m_indexFormat; // DXGI_FORMAT_R16_UINT or DXGI_FORMAT_R32_UINT
+		uint32_t m_lodCount;
+		FMeshLod m_lods[MeshOptimizer::k_maxLodCount]; // all LODs index the same vertex range
+		uint32_t m_positionOffset;
+		uint32_t m_normalOffset;
+		uint32_t m_uvOffset;
+		uint32_t m_vertexCount;
+		uint32_t m_meshletOffset; // into the meshlet and meshlet bounds sections
+		uint32_t m_meshletCount;
+		uint64_t m_geometryHash; // of every byte the mesh owns in the geometry sections, see GetMeshGeometryRanges
+		DirectX::XMFLOAT3 m_positionScale; // quantized positions dequantize as q * scale + bias
+		DirectX::XMFLOAT3 m_positionBias;
+		float m_uvDensity; // UV units per mesh space unit, the square root of the UV area over the surface area
+	};
+
+	// Placement of a mesh in the scene. Instances are sorted by mesh.
+	struct FInstance
+	{
+		DirectX::XMFLOAT4X4 m_localToWorld;
+		uint32_t m_meshIndex;
+		uint32_t m_padding[3];
+	};
+
+	struct FCamera
+	{
+		uint32_t m_nameOffset;
+		DirectX::XMFLOAT4X4 m_viewTransform;
+		DirectX::XMFLOAT4X4 m_projectionTransform;
+	};
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------------------------
+//														Cooked Scene
+//-----------------------------------------------------------------------------------------------------------------------------------------------
+
+// Read-only memory mapped view of a cooked scene
+class FCookedScene
+{
+public:
+	~FCookedScene();
+
+	bool Open(const std::filesystem::path& filepath);
+	void Close();
+
+	// True if none of the recorded source files have changed since the scene was cooked
+	bool IsUpToDate() const;
+
+	const CookedScene::FHeader* GetHeader() const;
+	std::span<const uint8_t> GetSectionData(const CookedScene::Section section) const;
+	const char* GetString(const uint32_t offset) const;
+
+	template<typename T>
+	std::span<const T> GetSection(const CookedScene::Section section) const
+	{
+		std::span<const uint8_t> data = GetSectionData(section);
+		return { reinterpret_cast<const T*>(data.data()), data.size() / sizeof(T) };
+	}
+
+private:
+	HANDLE m_file = INVALID_HANDLE_VALUE;
+	HANDLE m_mapping = nullptr;
+	const uint8_t* m_view = nullptr;
+	size_t m_sizeInBytes = 0;
+};
+
+// Accumulates sections in memory and writes them out as a cooked scene
+class FCookedSceneWriter
+{
+public:
+	FCookedSceneWriter();
+
+	uint32_t AddString(const std::string& str);
+	void AddDependency(const std::filesystem::path& filepath);
+	void Append(const CookedScene::Section section, const void* data, const size_t sizeInBytes);
+
+	template<typename T>
+	void Append(const CookedScene::Section section, const std::vector<T>& data)
+	{
+		Append(section, data.data(), data.size() * sizeof(T));
+	}
+
+	bool Write(const std::filesystem::path& filepath, const DirectX::BoundingBox& sceneBounds, const uint32_t flags) const;
+
+private:
+	std::vector<uint8_t> m_sections[(size_t)CookedScene::Section::Count];
+};
+
+namespace CookedScene
+{
+	std::filesystem::path GetCookedFilepath(const std::string& sceneFilename);
+
+	struct FByteRange
+	{
+		Section m_section;
+		size_t m_offset;
+		size_t m_size;
+	};
+
+	// Byte ranges of the geometry sections that belong to the mesh. Meshes never share geometry so these can be patched in
+	// place when only the content of a mesh changes.
+	std::vector<FByteRange> GetMeshGeometryRanges(const FMesh& mesh, std::span<const MeshOptimizer::FMeshlet> meshlets, const uint32_t flags);
+}
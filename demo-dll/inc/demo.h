@@ -7,10 +7,18 @@
 
 namespace Demo
 {
+	enum class LoadState
+	{
+		Loading,
+		Loaded,
+		Failed
+	};
+
 	extern "C" __declspec(dllexport) bool WINAPI Initialize(const HWND& windowHandle, const uint32_t resX, const uint32_t resY);
 	extern "C" __declspec(dllexport) void WINAPI Teardown(HWND & windowHandle);
 	extern "C" __declspec(dllexport) void WINAPI Tick(float dt);
 	extern "C" __declspec(dllexport) void WINAPI Render(const uint32_t resX, const uint32_t resY);
+	extern "C" __declspec(dllexport) LoadState WINAPI GetLoadState();
 	extern "C" __declspec(dllexport) void WINAPI OnMouseMove(WPARAM btnState, int x, int y);
 	extern "C" __declspec(dllexport) LRESULT WINAPI WndProcHandler(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam);
 }
@@ -0,0 +1,132 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+// Import time index and vertex reordering. Pure CPU and platform independent.
+namespace MeshOptimizer
+{
+	constexpr uint32_t k_vertexCacheSize = 16;
+	constexpr uint32_t k_maxMeshletVertices = 64;
+	constexpr uint32_t k_maxMeshletTriangles = 124;
+	constexpr uint32_t k_maxLodCount = 5;
+
+	// Cluster of triangles with its own local vertex list. Offsets index the meshlet vertex and triangle arrays.
+	struct FMeshlet
+	{
+		uint32_t m_vertexOffset;
+		uint32_t m_triangleOffset;
+		uint32_t m_vertexCount;
+		uint32_t m_triangleCount;
+	};
+
+	// Bounding sphere and normal cone in mesh space. The meshlet is entirely backfacing for a camera at p if
+	// dot(normalize(m_coneApex - p), m_coneAxis) >= m_coneCutoff.
+	struct FMeshletBounds
+	{
+		float m_center[3];
+		float m_radius;
+		float m_coneApex[3];
+		float m_coneCutoff;
+		float m_coneAxis[3];
+		float m_padding;
+	};
+
+	struct FVertexCacheStats
+	{
+		float m_acmr; // average cache miss ratio, vertex transforms per triangle
+		float m_atvr; // average transform to vertex ratio, 1.0 is optimal
+	};
+
+	// Simulates a FIFO post-transform cache of the given size
+	FVertexCacheStats AnalyzeVertexCache(const uint32_t* indices, const size_t indexCount, const size_t vertexCount, const uint32_t cacheSize = k_vertexCacheSize);
+
+	// Tipsify (Sander et al. 2007). Reorders triangles for post-transform cache reuse. If clusters is not null, it receives the
+	// index offsets at which each cluster of the output starts, for use by OptimizeOverdraw. destIndices must not alias indices.
+	void OptimizeVertexCache(
+		uint32_t* destIndices,
+		const uint32_t* indices,
+		const size_t indexCount,
+		const size_t vertexCount,
+		const uint32_t cacheSize = k_vertexCacheSize,
+		std::vector<uint32_t>* clusters = nullptr);
+
+	// Reorders the clusters produced by OptimizeVertexCache so that outward facing clusters are drawn first. Clusters are
+	// first split at soft boundaries where the local cache efficiency is within threshold of the whole mesh.
+	void OptimizeOverdraw(
+		uint32_t* destIndices,
+		const uint32_t* indices,
+		const size_t indexCount,
+		const float* positions,
+		const size_t positionStride,
+		const size_t vertexCount,
+		const std::vector<uint32_t>& clusters,
+		const float threshold = 1.05f,
+		const uint32_t cacheSize = k_vertexCacheSize);
+
+	// Splits the triangle list into meshlets in input order, so cache optimized input gives compact clusters. Meshlet vertices
+	// are mesh vertex indices and every triangle is packed as three 8 bit local vertex indices.
+	void BuildMeshlets(
+		std::vector<FMeshlet>& meshlets,
+		std::vector<uint32_t>& meshletVertices,
+		std::vector<uint32_t>& meshletTriangles,
+		const uint32_t* indices,
+		const size_t indexCount,
+		const size_t vertexCount,
+		const uint32_t maxVertices = k_maxMeshletVertices,
+		const uint32_t maxTriangles = k_maxMeshletTriangles);
+
+	FMeshletBounds ComputeMeshletBounds(
+		const FMeshlet& meshlet,
+		const uint32_t* meshletVertices,
+		const uint32_t* meshletTriangles,
+		const float* positions,
+		const size_t positionStride);
+
+	// Quadric error edge collapse (Garland and Heckbert 1997). Vertices only ever collapse onto existing vertices, so the result
+	// indexes the same vertex buffer. Vertices on UV seams or on non-manifold borders are locked and open borders only collapse
+	// along themselves. Stops at targetIndexCount or when the next collapse would exceed targetError, a distance in mesh units.
+	// Returns the new index count and writes the largest error introduced to resultError if not null.
+	size_t Simplify(
+		uint32_t* destIndices,
+		const uint32_t* indices,
+		const size_t indexCount,
+		const float* positions,
+		const size_t positionStride,
+		const size_t vertexCount,
+		const size_t targetIndexCount,
+		const float targetError,
+		float* resultError = nullptr);
+
+	// Renumbers vertices in order of first use and rewrites the indices in place. remap[oldVertex] receives the new vertex
+	// index. Unreferenced vertices are moved to the end so that the vertex count does not change.
+	void OptimizeVertexFetch(std::vector<uint32_t>& remap, uint32_t* indices, const size_t indexCount, const size_t vertexCount);
+
+	// Input of the tests and benchmarks
+	struct FTestMesh
+	{
+		std::vector<float> m_positions; // xyz
+		std::vector<uint32_t> m_indices;
+	};
+
+	// Sphere with a bumpy surface and a duplicated column of vertices along its seam, as exporters split vertices along UV
+	// seams. About 2 * rings * segments triangles in scan order.
+	FTestMesh CreateTestMesh(const uint32_t rings, const uint32_t segments);
+
+	namespace Benchmark
+	{
+		struct FMeshletResult
+		{
+			double m_buildTime; // ms for meshlets and their bounds, one mesh after the other
+			size_t m_triangleCount;
+			size_t m_meshletCount;
+			double m_vertexFill; // average fraction of k_maxMeshletVertices in use
+			double m_triangleFill; // average fraction of k_maxMeshletTriangles in use
+			double m_coneCulledFraction; // meshlets rejected by their normal cone, averaged over views from all around each mesh
+		};
+
+		// Meshlets of vertex cache optimized meshes, as the scene cooker builds them
+		FMeshletResult RunMeshlets(const std::vector<FTestMesh>& meshes);
+	}
+}
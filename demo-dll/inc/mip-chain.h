@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+// Mip chain generation for RGBA8 and RGBA32 float images. Pure CPU and platform independent, with AVX2, SSE and NEON
+// kernels where available. Every mip is filtered from the previous one at float precision and split across the thread pool
+// by rows.
+namespace MipChain
+{
+	enum class Filter
+	{
+		Box, // 2x2 average
+		Kaiser // Kaiser windowed sinc over 8x8 source pixels, sharper at the cost of a little ringing
+	};
+
+	enum class Format
+	{
+		RGBA8,
+		RGBA8Srgb, // color is filtered in linear space, alpha as is
+		RGBA32Float
+	};
+
+	struct FImage
+	{
+		uint8_t* m_pixels;
+		uint32_t m_width;
+		uint32_t m_height;
+		size_t m_rowPitch;
+	};
+
+	// Halving and rounding down to a minimum of 1, like D3D
+	uint32_t GetMipSize(const uint32_t size, const uint32_t mip);
+
+	// True if the SIMD kernels can run on this CPU
+	bool HasSimdSupport();
+
+	// Fills mips [1, mipCount) from mips[0], their sizes must follow GetMipSize. With alphaReference >= 0 the alpha of every
+	// mip is scaled so that the fraction of pixels above the reference matches mip 0, which keeps alpha tested surfaces from
+	// thinning out in the distance.
+	void Generate(
+		const FImage* mips,
+		const uint32_t mipCount,
+		const Format format,
+		const Filter filter,
+		const float alphaReference = -1.f,
+		const bool allowSimd = true);
+
+	// Microbenchmark of the full mip chain of a size x size random image. Returns the best time of several runs in milliseconds.
+	double MeasureGenerateTime(const uint32_t size, const Format format, const Filter filter, const bool allowSimd);
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <bounds.h>
+#include <cstdint>
+#include <cstddef>
+#include <filesystem>
+#include <vector>
+
+// Software occlusion culling. Occluders are rasterized into a low resolution reverse-Z depth buffer, with a per tile
+// farthest depth on top of it, and bounding boxes are tested against the result. Pure CPU and platform independent, with
+// AVX2 and NEON kernels where available.
+namespace Occlusion
+{
+	constexpr uint32_t k_tileWidth = 32;
+	constexpr uint32_t k_tileHeight = 8;
+
+	// Occluder geometry in mesh space, positions as float3
+	struct FOccluder
+	{
+		std::vector<float> m_positions;
+		std::vector<uint32_t> m_indices;
+	};
+
+	class FDepthBuffer
+	{
+	public:
+		// Width and height are rounded up to whole tiles
+		FDepthBuffer(const uint32_t width, const uint32_t height);
+
+		// Clears the depth and the occluder bins. worldToClip is the view projection, row major for row vectors, with a
+		// reverse-Z projection: depth is 1 at the near plane and decreases with distance.
+		void Begin(const float worldToClip[16]);
+
+		// Transforms the occluder by localToWorld and the view projection, clips it against the near plane and bins its
+		// triangles into the tiles they overlap. Not thread safe. Returns the number of triangles binned.
+		size_t AddOccluder(const FOccluder& occluder, const float localToWorld[16]);
+
+		// Rasterizes the triangles binned to the tile and updates its farthest depth. Tiles are independent and can be
+		// rasterized concurrently once every occluder has been added.
+		void RasterizeTile(const uint32_t tileIndex);
+
+		// True if part of the world space box may be in front of the rasterized occluders. Boxes that cross the near plane
+		// are always visible.
+		bool IsVisible(const float center[3], const float extents[3]) const;
+
+		// Keeps the boxes that pass IsVisible, compacting indices in place. Returns the number of boxes kept.
+		size_t CullBoxes(uint32_t* indices, const size_t count, const Bounds::FBoxSoA& boxes) const;
+
+		// Writes the depth as a greyscale Portable Float Map, for inspection and for comparison against reference images
+		bool SaveImage(const std::filesystem::path& filepath) const;
+
+		uint32_t GetWidth() const { return m_width; }
+		uint32_t GetHeight() const { return m_height; }
+		uint32_t GetTileCount() const { return m_tilesX * m_tilesY; }
+		const float* GetDepth() const { return m_depth.data(); }
+
+	private:
+		// Screen space triangle with edge and depth functions evaluated at pixel centers as a * x + b * y + c
+		struct FTriangle
+		{
+			float m_edgeA[3];
+			float m_edgeB[3];
+			float m_edgeC[3];
+			float m_depthA;
+			float m_depthB;
+			float m_depthC;
+			int32_t m_minX;
+			int32_t m_minY;
+			int32_t m_maxX; // inclusive
+			int32_t m_maxY;
+		};
+
+		void AddTriangle(const float v0[4], const float v1[4], const float v2[4]);
+
+		uint32_t m_width;
+		uint32_t m_height;
+		uint32_t m_tilesX;
+		uint32_t m_tilesY;
+		float m_worldToClip[16];
+		std::vector<float> m_depth;
+		std::vector<float> m_tileFarthestDepth;
+		std::vector<FTriangle> m_triangles;
+		std::vector<float> m_clipPositions; // scratch for AddOccluder
+		std::vector<std::vector<uint32_t>> m_tileBins;
+	};
+}
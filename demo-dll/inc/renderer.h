@@ -1,30 +1,51 @@
 #pragma once
 
 #include <SimpleMath.h>
+#include <mesh-optimizer.h>
+#include <bounds.h>
+#include <occlusion.h>
+#include <bvh.h>
+#include <map>
 using namespace DirectX::SimpleMath;
 
-namespace tinygltf
-{
-	class Model;
-	class Image;
-	class Sampler;
-}
-
 class FController;
+struct FSceneStreamer;
+struct FView;
+
+struct FRenderMeshLod
+{
+	uint32_t m_indexOffset;
+	uint32_t m_indexCount;
+	float m_error; // object space
+};
 
 struct FRenderMesh
 {
 	std::string m_name;
-	size_t m_indexCount;
-	uint32_t m_indexOffset;
+	FRenderMeshLod m_lods[MeshOptimizer::k_maxLodCount];
+	uint32_t m_lodCount;
+	DXGI_FORMAT m_indexFormat;
 	uint32_t m_positionOffset;
 	uint32_t m_normalOffset;
 	uint32_t m_uvOffset;
+	uint32_t m_vertexCount;
+	uint32_t m_meshletOffset;
+	uint32_t m_meshletCount;
+	uint32_t m_instanceOffset; // into the scene instance list
+	uint32_t m_instanceCount;
+	Vector3 m_positionScale; // dequantization of normalized 16 bit positions
+	Vector3 m_positionBias;
+	uint64_t m_geometryHash;
+	uint32_t m_materialIndex; // into FScene::m_materials
+	float m_uvDensity; // UV units per object space unit
+};
 
-	std::string m_materialName;
+// Material parameters as laid out in the scene material buffer read by the base pass
+struct FMaterial
+{
 	Vector3 m_emissiveFactor;
-	Vector3 m_baseColorFactor;
 	float m_metallicFactor;
+	Vector3 m_baseColorFactor;
 	float m_roughnessFactor;
 	int m_baseColorTextureIndex;
 	int m_metallicRoughnessTextureIndex;
@@ -34,6 +55,8 @@ struct FRenderMesh
 	int m_normalSamplerIndex;
 };
 
+static_assert(sizeof(FMaterial) == 56, "FMaterial must match the Material layout in base-pass.hlsl");
+
 struct FCamera
 {
 	std::string m_name;
@@ -50,27 +73,62 @@ struct FLightProbe
 
 struct FScene
 {
+	// Starts loading the cooked scene in the background, cooking it from the glTF source first if it is missing or out of date.
+	// The previous scene is released immediately so the GPU must be idle.
 	void Reload(const std::string& filename);
-	void LoadNode(int nodeIndex, const tinygltf::Model& model, const Matrix& transform);
-	void LoadMesh(int meshIndex, const tinygltf::Model& model, const Matrix& transform);
-	void LoadCamera(int meshIndex, const tinygltf::Model& model, const Matrix& transform);
 	void Clear();
 
+	// Publishes the content loaded since the last call, within the per frame upload budget. Meshes become visible in order
+	// and textures that are still loading are replaced by a placeholder. Returns true on the call that publishes the scene
+	// layout and cameras.
+	bool Stream();
+	bool IsLoading() const;
+
+	// Recooks the scene if its sources changed and patches the changed meshes, materials, instances and textures in place
+	// without waiting on the GPU. Returns false if the layout of the scene buffers changed and a full reload is required.
+	bool HotReload();
+
+	// Transforms the instance bounds by the instance and root transforms and refits the instance BVH to them. Called every
+	// frame once the root transform is known.
+	void UpdateWorldBounds();
+
+	// Requests the mips that the meshes in view need, from the texel density of their UVs and their distance, and uploads the
+	// ones read since the last call within Settings::k_textureStreamingBudget. Called every frame after UpdateWorldBounds.
+	void StreamTextures(const FView& view, const uint32_t resY);
+
 	// Scene file
 	std::string m_sceneFilename = {};
+	bool m_loadFailed = false; // the scene stays empty until the next reload
 
 	// Scene entity lists
 	std::vector<FRenderMesh> m_meshGeo;
-	std::vector<Matrix> m_meshTransforms;
+	std::vector<Matrix> m_instanceTransforms; // grouped by mesh, see FRenderMesh::m_instanceOffset
+	std::vector<uint32_t> m_instanceMeshIndices;
+	std::vector<FMaterial> m_materials; // deduplicated by the cooker
 	std::vector<DirectX::BoundingBox> m_meshBounds; // object space
+	Bounds::FBoxSoA m_instanceBounds; // object space bounds of the instance's mesh
+	Bounds::FBoxSoA m_instanceWorldBounds; // world space including the root transform
+	FBvh m_instanceBvh; // over m_instanceWorldBounds
 	std::vector<FCamera> m_cameras;
+	std::map<std::wstring, int64_t> m_textureTimestamps; // source image last write time, by texture name
 
 	// Scene geo
 	std::unique_ptr<FBindlessShaderResource> m_meshIndexBuffer;
 	std::unique_ptr<FBindlessShaderResource> m_meshPositionBuffer;
 	std::unique_ptr<FBindlessShaderResource> m_meshNormalBuffer;
 	std::unique_ptr<FBindlessShaderResource> m_meshUvBuffer;
+	std::unique_ptr<FBindlessShaderResource> m_instanceTransformBuffer;
+	std::unique_ptr<FBindlessShaderResource> m_materialBuffer;
+	std::unique_ptr<FBindlessShaderResource> m_meshletBuffer;
+	std::unique_ptr<FBindlessShaderResource> m_meshletBoundsBuffer;
+	std::unique_ptr<FBindlessShaderResource> m_meshletVertexBuffer; // mesh relative vertex indices
+	std::unique_ptr<FBindlessShaderResource> m_meshletTriangleBuffer; // 3x8 bit meshlet local indices per triangle
+	std::vector<MeshOptimizer::FMeshlet> m_meshlets;
+	std::vector<MeshOptimizer::FMeshletBounds> m_meshletBounds; // mesh space
+	std::vector<Occlusion::FOccluder> m_occluders; // by mesh, empty for meshes that are not worth rasterizing as occluders
 	DirectX::BoundingBox m_sceneBounds; // world space
+	DirectX::BoundingBox m_rotatedSceneBounds; // world space including the root transform
+	bool m_quantizedVertices;
 
 	// Image based lighting
 	FLightProbe m_globalLightProbe;
@@ -78,20 +136,8 @@ struct FScene
 	// Transform
 	Matrix m_rootTransform;
 
-private:
-	int LoadTexture(const tinygltf::Image& image, const bool srgb);
-	int LoadSampler(const tinygltf::Sampler& sampler);
-
-private:
-	uint8_t* m_scratchIndexBuffer;
-	uint8_t* m_scratchPositionBuffer;
-	uint8_t* m_scratchNormalBuffer;
-	uint8_t* m_scratchUvBuffer;
-
-	size_t m_scratchIndexBufferOffset;
-	size_t m_scratchPositionBufferOffset;
-	size_t m_scratchNormalBufferOffset;
-	size_t m_scratchUvBufferOffset;
+	// Background load in progress, if any
+	std::shared_ptr<FSceneStreamer> m_streamer;
 };
 
 struct FView
@@ -4,12 +4,11 @@
 #define rootsig \
     "StaticSampler(s0, visibility = SHADER_VISIBILITY_PIXEL, filter = FILTER_ANISOTROPIC, maxAnisotropy = 8, addressU = TEXTURE_ADDRESS_WRAP, addressV = TEXTURE_ADDRESS_WRAP, borderColor = STATIC_BORDER_COLOR_OPAQUE_WHITE), " \
     "StaticSampler(s1, visibility = SHADER_VISIBILITY_PIXEL, filter = FILTER_COMPARISON_MIN_MAG_LINEAR_MIP_POINT, comparisonFunc = COMPARISON_LESS_EQUAL, addressU = TEXTURE_ADDRESS_BORDER, addressV = TEXTURE_ADDRESS_BORDER, borderColor = STATIC_BORDER_COLOR_OPAQUE_WHITE), " \
-    "RootConstants(b0, num32BitConstants=20, visibility = SHADER_VISIBILITY_VERTEX)," \
-    "CBV(b1, space = 0, visibility = SHADER_VISIBILITY_PIXEL"), \
+    "RootConstants(b0, num32BitConstants=13, visibility = SHADER_VISIBILITY_ALL)," \
     "CBV(b2, space = 0, visibility = SHADER_VISIBILITY_ALL"), \
     "CBV(b3, space = 0, visibility = SHADER_VISIBILITY_ALL"), \
     "DescriptorTable(SRV(t0, space = 0, numDescriptors = 1000), visibility = SHADER_VISIBILITY_PIXEL), " \
-    "DescriptorTable(SRV(t1, space = 0, numDescriptors = 1000), visibility = SHADER_VISIBILITY_VERTEX), " \
+    "DescriptorTable(SRV(t1, space = 0, numDescriptors = 1000), visibility = SHADER_VISIBILITY_ALL), " \
     "DescriptorTable(SRV(t2, space = 1, numDescriptors = 1000), visibility = SHADER_VISIBILITY_PIXEL) "
 
 struct LightProbeData
@@ -27,6 +26,8 @@ struct FrameCbLayout
 	uint sceneNormalBufferBindlessIndex;
 	uint sceneUvBufferBindlessIndex;
 	LightProbeData sceneLightProbe;
+	uint sceneInstanceTransformBufferBindlessIndex;
+	uint sceneMaterialBufferBindlessIndex;
 };
 
 struct ViewCbLayout
@@ -37,14 +38,19 @@ struct ViewCbLayout
 
 struct MeshCbLayout
 {
-	float4x4 localToWorld;
 	uint indexOffset;
 	uint positionOffset;
 	uint normalOffset;
 	uint uvOffset;
+	uint indexSize;
+	float3 positionScale;
+	float3 positionBias;
+	uint instanceOffset;
+	uint materialIndex;
 };
 
-struct MaterialCbLayout
+// Laid out like FMaterial in the scene material buffer, MATERIAL_STRIDE is sizeof(FMaterial)
+struct Material
 {
 	float3 emissiveFactor;
 	float metallicFactor;
@@ -60,7 +66,6 @@ struct MaterialCbLayout
 
 SamplerState g_anisoSampler : register(s0);
 ConstantBuffer<MeshCbLayout> g_meshConstants : register(b0);
-ConstantBuffer<MaterialCbLayout> g_materialConstants : register(b1);
 ConstantBuffer<ViewCbLayout> g_viewConstants : register(b2);
 ConstantBuffer<FrameCbLayout> g_frameConstants : register(b3);
 Texture2D g_bindless2DTextures[] : register(t0, space0);
@@ -83,13 +88,36 @@ float3 Eye()
 		-g_viewConstants.viewTransform._43);
 }
 
-vs_to_ps vs_main(uint vertexId : SV_VertexID)
+float3 OctahedralDecode(float2 f)
+{
+	float3 n = float3(f.x, f.y, 1.f - abs(f.x) - abs(f.y));
+	float t = saturate(-n.z);
+	n.xy += (n.xy >= 0.f) ? -t : t;
+	return normalize(n);
+}
+
+vs_to_ps vs_main(uint vertexId : SV_VertexID, uint instanceId : SV_InstanceID)
 {
 	vs_to_ps o;
 
-	// size of 4 for 32 bit indices
-	uint index = g_bindlessBuffers[g_frameConstants.sceneIndexBufferBindlessIndex].Load(4*(vertexId + g_meshConstants.indexOffset));
+	// 2 or 4 bytes per index. 16 bit indices are packed two to a dword.
+	uint indexAddress = g_meshConstants.indexSize * (vertexId + g_meshConstants.indexOffset);
+	uint indexDword = g_bindlessBuffers[g_frameConstants.sceneIndexBufferBindlessIndex].Load(indexAddress & ~3);
+	uint index = g_meshConstants.indexSize == 4 ? indexDword : ((indexAddress & 2) ? indexDword >> 16 : indexDword & 0xffff);
 
+#if QUANTIZED_VERTICES
+	// size of 8 for unorm16x3 positions (+ padding), normalized to the mesh bounds
+	uint2 packedPosition = g_bindlessBuffers[g_frameConstants.scenePositionBufferBindlessIndex].Load2(8 * (index + g_meshConstants.positionOffset));
+	float3 position = float3(packedPosition.x & 0xffff, packedPosition.x >> 16, packedPosition.y & 0xffff) * g_meshConstants.positionScale + g_meshConstants.positionBias;
+
+	// size of 4 for octahedral snorm16x2 normals
+	uint packedNormal = g_bindlessBuffers[g_frameConstants.sceneNormalBufferBindlessIndex].Load(4 * (index + g_meshConstants.normalOffset));
+	float3 normal = OctahedralDecode(max(float2(int2(packedNormal << 16, packedNormal) >> 16) / 32767.f, -1.f));
+
+	// size of 4 for half2 uv's
+	uint packedUv = g_bindlessBuffers[g_frameConstants.sceneUvBufferBindlessIndex].Load(4 * (index + g_meshConstants.uvOffset));
+	float2 uv = f16tof32(uint2(packedUv, packedUv >> 16));
+#else
 	// size of 12 for float3 positions
 	float3 position = g_bindlessBuffers[g_frameConstants.scenePositionBufferBindlessIndex].Load<float3>(12 * (index + g_meshConstants.positionOffset));
 
@@ -98,8 +126,18 @@ vs_to_ps vs_main(uint vertexId : SV_VertexID)
 
 	// size of 8 for float2 uv's
 	float2 uv = g_bindlessBuffers[g_frameConstants.sceneUvBufferBindlessIndex].Load<float2>(8 * (index + g_meshConstants.uvOffset));
-
-	float4x4 localToWorld = mul(g_meshConstants.localToWorld, g_frameConstants.sceneRotation);
+#endif
+
+	// size of 64 for row major float4x4 instance transforms
+	ByteAddressBuffer instanceTransforms = g_bindlessBuffers[g_frameConstants.sceneInstanceTransformBufferBindlessIndex];
+	uint transformAddress = 64 * (instanceId + g_meshConstants.instanceOffset);
+	float4x4 instanceTransform = float4x4(
+		instanceTransforms.Load<float4>(transformAddress),
+		instanceTransforms.Load<float4>(transformAddress + 16),
+		instanceTransforms.Load<float4>(transformAddress + 32),
+		instanceTransforms.Load<float4>(transformAddress + 48));
+
+	float4x4 localToWorld = mul(instanceTransform, g_frameConstants.sceneRotation);
 	float4 worldPos = mul(float4(position, 1.f), localToWorld);
 	float4x4 viewProjTransform = mul(g_viewConstants.viewTransform, g_viewConstants.projectionTransform);
 
@@ -123,10 +161,11 @@ float4 ps_main(vs_to_ps input) : SV_Target
 	float NoH = saturate(dot(n, h));
 	float LoH = saturate(dot(l, h));
 
-	float3 baseColor = g_materialConstants.baseColorTextureIndex != -1 ? g_materialConstants.baseColorFactor * g_bindless2DTextures[g_materialConstants.baseColorTextureIndex].Sample(g_anisoSampler, input.uv).rgb : g_materialConstants.baseColorFactor;
-	float2 metallicRoughnessMap = g_materialConstants.metallicRoughnessTextureIndex != -1 ? g_bindless2DTextures[g_materialConstants.metallicRoughnessTextureIndex].Sample(g_anisoSampler, input.uv).bg : 1.f.xx;
-	float metallic = g_materialConstants.metallicFactor * metallicRoughnessMap.x;
-	float perceptualRoughness = g_materialConstants.roughnessFactor * metallicRoughnessMap.y;
+	Material material = g_bindlessBuffers[g_frameConstants.sceneMaterialBufferBindlessIndex].Load<Material>(MATERIAL_STRIDE * g_meshConstants.materialIndex);
+	float3 baseColor = material.baseColorTextureIndex != -1 ? material.baseColorFactor * g_bindless2DTextures[material.baseColorTextureIndex].Sample(g_anisoSampler, input.uv).rgb : material.baseColorFactor;
+	float2 metallicRoughnessMap = material.metallicRoughnessTextureIndex != -1 ? g_bindless2DTextures[material.metallicRoughnessTextureIndex].Sample(g_anisoSampler, input.uv).rg : 1.f.xx; // metalness and roughness, moved to RG for BC5
+	float metallic = material.metallicFactor * metallicRoughnessMap.x;
+	float perceptualRoughness = material.roughnessFactor * metallicRoughnessMap.y;
 
 	// Remapping
 	float3 f0 = metallic * baseColor + (1.f - metallic) * 0.04;
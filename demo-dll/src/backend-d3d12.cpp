@@ -1,4 +1,7 @@
 #include <backend-d3d12.h>
+#if defined(RENDER_BACKEND_NULL)
+#include <backend-null.h>
+#endif
 #include <common.h>
 #include <shadercompiler.h>
 #include <ppltasks.h>
@@ -26,11 +29,13 @@ constexpr uint32_t k_backBufferCount = 2;
 constexpr size_t k_rtvHeapSize = 32;
 constexpr size_t k_dsvHeapSize = 8;
 constexpr size_t k_sharedResourceMemory = 64 * 1024 * 1024;
+constexpr size_t k_transientBufferSlabSize = 8 * 1024 * 1024;
 
 //-----------------------------------------------------------------------------------------------------------------------------------------------
 //														Forward Declarations
 //-----------------------------------------------------------------------------------------------------------------------------------------------
 class FUploadBufferPool;
+class FTransientBufferAllocator;
 class FSharedResourcePool;
 class FBindlessIndexPool;
 
@@ -43,6 +48,7 @@ namespace
 	D3DDescriptorHeap_t* GetDescriptorHeap(const D3D12_DESCRIPTOR_HEAP_TYPE type);
 	uint32_t GetDescriptorSize(const D3D12_DESCRIPTOR_HEAP_TYPE type);
 	FUploadBufferPool* GetUploadBufferPool();
+	FTransientBufferAllocator* GetTransientBufferAllocator();
 	FSharedResourcePool* GetSharedResourcePool();
 	FBindlessIndexPool* GetBindlessPool();
 	concurrency::concurrent_queue<uint32_t>& GetRTVIndexPool();
@@ -530,6 +536,99 @@ private:
 	std::list<std::unique_ptr<FResource>> m_useList;
 };
 
+// Linear sub-allocator for short-lived upload data (constant buffers, dynamic vertices). Each frame in flight owns a persistently
+// mapped slab; allocations are pointer bumps and the whole slab is recycled once the frame fence that last used it has retired.
+class FTransientBufferAllocator
+{
+public:
+	void Initialize(const size_t slabSizeInBytes)
+	{
+		D3D12_HEAP_PROPERTIES heapDesc = {};
+		heapDesc.Type = D3D12_HEAP_TYPE_UPLOAD;
+		heapDesc.MemoryPoolPreference = D3D12_MEMORY_POOL_UNKNOWN;
+
+		D3D12_RESOURCE_DESC resourceDesc = {};
+		resourceDesc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
+		resourceDesc.Width = slabSizeInBytes;
+		resourceDesc.Height = 1;
+		resourceDesc.DepthOrArraySize = 1;
+		resourceDesc.MipLevels = 1;
+		resourceDesc.Format = DXGI_FORMAT_UNKNOWN;
+		resourceDesc.SampleDesc.Count = 1;
+		resourceDesc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
+
+		for (uint32_t slabIndex = 0; slabIndex < k_backBufferCount; ++slabIndex)
+		{
+			FSlab& slab = m_slabs[slabIndex];
+
+			std::wstringstream s;
+			s << L"transient_buffer_slab_" << slabIndex;
+
+			slab.m_buffer = std::make_unique<FResource>();
+			AssertIfFailed(slab.m_buffer->InitCommittedResource(s.str(), heapDesc, resourceDesc, D3D12_RESOURCE_STATE_GENERIC_READ));
+			AssertIfFailed(slab.m_buffer->m_d3dResource->Map(0, nullptr, reinterpret_cast<void**>(&slab.m_mappedPtr)));
+			slab.m_baseAddress = slab.m_buffer->m_d3dResource->GetGPUVirtualAddress();
+			slab.m_offset = 0;
+		}
+
+		m_slabSize = slabSizeInBytes;
+		m_currentSlab = 0;
+	}
+
+	// Returns false if the current slab is exhausted, the caller is then expected to fall back to a pooled buffer
+	bool TryAllocate(const size_t sizeInBytes, FResource*& outBuffer, uint8_t*& outCpuAddress, D3D12_GPU_VIRTUAL_ADDRESS& outGpuAddress)
+	{
+		const size_t alignedSize = (sizeInBytes + D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT - 1) & ~(size_t)(D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT - 1);
+
+		FSlab& slab = m_slabs[m_currentSlab];
+		const size_t offset = slab.m_offset.fetch_add(alignedSize);
+		if (offset + alignedSize > m_slabSize)
+		{
+			return false;
+		}
+
+		outBuffer = slab.m_buffer.get();
+		outCpuAddress = slab.m_mappedPtr + offset;
+		outGpuAddress = slab.m_baseAddress + offset;
+		return true;
+	}
+
+	// Must only be called once the GPU is done with the frame that last used this slab
+	void Recycle(const uint32_t slabIndex)
+	{
+		m_slabs[slabIndex].m_offset = 0;
+		m_currentSlab = slabIndex;
+	}
+
+	void Clear()
+	{
+		for (FSlab& slab : m_slabs)
+		{
+			if (slab.m_buffer)
+			{
+				slab.m_buffer->m_d3dResource->Unmap(0, nullptr);
+				slab.m_buffer.reset();
+			}
+
+			slab.m_mappedPtr = nullptr;
+			slab.m_offset = 0;
+		}
+	}
+
+private:
+	struct FSlab
+	{
+		std::unique_ptr<FResource> m_buffer;
+		uint8_t* m_mappedPtr = nullptr;
+		D3D12_GPU_VIRTUAL_ADDRESS m_baseAddress = 0;
+		std::atomic_size_t m_offset{ 0 };
+	};
+
+	FSlab m_slabs[k_backBufferCount];
+	size_t m_slabSize = 0;
+	uint32_t m_currentSlab = 0;
+};
+
 FResourceUploadContext::FResourceUploadContext(const size_t uploadBufferSizeInBytes) :
 	m_currentOffset{ 0 }
 {
@@ -549,7 +648,8 @@ FResourceUploadContext::FResourceUploadContext(const size_t uploadBufferSizeInBy
 void FResourceUploadContext::UpdateSubresources(
 	D3DResource_t* destinationResource,
 	const std::vector<D3D12_SUBRESOURCE_DATA>& srcData,
-	std::function<void(FCommandList*)> transition)
+	std::function<void(FCommandList*)> transition,
+	const uint32_t firstSubresource)
 {
 	// NOTE layout.Footprint.RowPitch is the D3D12 aligned pitch whereas rowSizeInBytes is the unaligned pitch
 	UINT64 totalBytes = 0;
@@ -558,7 +658,7 @@ void FResourceUploadContext::UpdateSubresources(
 	std::vector<UINT> numRows(srcData.size());
 
 	D3D12_RESOURCE_DESC destinationDesc = destinationResource->GetDesc();
-	GetDevice()->GetCopyableFootprints(&destinationDesc, 0, srcData.size(), m_currentOffset, layouts.data(), numRows.data(), rowSizeInBytes.data(), &totalBytes);
+	GetDevice()->GetCopyableFootprints(&destinationDesc, firstSubresource, srcData.size(), m_currentOffset, layouts.data(), numRows.data(), rowSizeInBytes.data(), &totalBytes);
 
 	size_t capacity = m_sizeInBytes - m_currentOffset;
 	DebugAssert(totalBytes <= capacity, "Upload buffer is too small!");
@@ -612,7 +712,7 @@ void FResourceUploadContext::UpdateSubresources(
 			D3D12_TEXTURE_COPY_LOCATION dstLocation = {};
 			dstLocation.pResource = destinationResource;
 			dstLocation.Type = D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX;
-			dstLocation.SubresourceIndex = i;
+			dstLocation.SubresourceIndex = firstSubresource + i;
 
 			m_copyCommandlist->m_d3dCmdList->CopyTextureRegion(&dstLocation, 0, 0, 0, &srcLocation, nullptr);
 		}
@@ -622,6 +722,22 @@ void FResourceUploadContext::UpdateSubresources(
 	m_pendingTransitions.push_back(transition);
 }
 
+void FResourceUploadContext::UpdateBufferRegion(
+	D3DResource_t* destinationResource,
+	const size_t destinationOffset,
+	const uint8_t* pData,
+	const size_t size)
+{
+	size_t capacity = m_sizeInBytes - m_currentOffset;
+	DebugAssert(size <= capacity, "Upload buffer is too small!");
+
+	memcpy(m_mappedPtr + m_currentOffset, pData, size);
+	m_copyCommandlist->m_d3dCmdList->CopyBufferRegion(destinationResource, destinationOffset, m_uploadBuffer->m_d3dResource, m_currentOffset, size);
+
+	// Keep the next subresource placement aligned
+	m_currentOffset += (size + D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT - 1) & ~(D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT - 1);
+}
+
 D3DFence_t* FResourceUploadContext::SubmitUploads(FCommandList* owningCL)
 {
 	ExecuteCommandlists(D3D12_COMMAND_LIST_TYPE_COPY, { m_copyCommandlist });
@@ -761,7 +877,12 @@ void FResource::UavBarrier(FCommandList* cmdList)
 
 FTransientBuffer::~FTransientBuffer()
 {
-	GetUploadBufferPool()->Retire(m_resource, m_dependentCmdlist);
+	// Linear allocations are recycled along with their frame slab
+	if (!m_isLinearAllocation)
+	{
+		GetUploadBufferPool()->Retire(m_resource, m_dependentCmdlist);
+	}
+
 	m_dependentCmdlist = nullptr;
 }
 #pragma endregion
@@ -1155,6 +1276,7 @@ namespace RenderBackend12
 	winrt::com_ptr<D3DDevice_t> s_d3dDevice;
 
 	D3D12_FEATURE_DATA_D3D12_OPTIONS1 s_waveOpsInfo;
+	D3D12_TILED_RESOURCES_TIER s_tiledResourcesTier;
 
 	winrt::com_ptr<DXGISwapChain_t> s_swapChain;
 	std::unique_ptr<FRenderTexture> s_backBuffers[k_backBufferCount];
@@ -1172,6 +1294,7 @@ namespace RenderBackend12
 
 	FCommandListPool s_commandListPool;
 	FUploadBufferPool s_uploadBufferPool;
+	FTransientBufferAllocator s_transientBufferAllocator;
 	FSharedResourcePool s_sharedResourcePool;
 	FBindlessIndexPool s_bindlessPool;
 
@@ -1220,6 +1343,11 @@ namespace
 		return &RenderBackend12::s_uploadBufferPool;
 	}
 
+	FTransientBufferAllocator* GetTransientBufferAllocator()
+	{
+		return &RenderBackend12::s_transientBufferAllocator;
+	}
+
 	FSharedResourcePool* GetSharedResourcePool()
 	{
 		return &RenderBackend12::s_sharedResourcePool;
@@ -1243,6 +1371,10 @@ namespace
 
 bool RenderBackend12::Initialize(const HWND& windowHandle, const uint32_t resX, const uint32_t resY)
 {
+#if defined(RENDER_BACKEND_NULL)
+	// Headless device, no adapter or swap chain
+	s_d3dDevice = NullBackend::CreateDevice();
+#else
 	UINT dxgiFactoryFlags = 0;
 
 #if defined(_DEBUG)
@@ -1266,12 +1398,17 @@ bool RenderBackend12::Initialize(const HWND& windowHandle, const uint32_t resX,
 		adapter.get(),
 		D3D_FEATURE_LEVEL_12_1,
 		IID_PPV_ARGS(s_d3dDevice.put())));
+#endif
 
 	// Feature Support
 	s_waveOpsInfo = {};
 	AssertIfFailed(s_d3dDevice->CheckFeatureSupport(D3D12_FEATURE_D3D12_OPTIONS1, &s_waveOpsInfo, sizeof(s_waveOpsInfo)));
 	DebugAssert(s_waveOpsInfo.WaveOps == TRUE, "Wave Intrinsics not supported");
 
+	D3D12_FEATURE_DATA_D3D12_OPTIONS options = {};
+	AssertIfFailed(s_d3dDevice->CheckFeatureSupport(D3D12_FEATURE_D3D12_OPTIONS, &options, sizeof(options)));
+	s_tiledResourcesTier = options.TiledResourcesTier;
+
 	// Cache descriptor sizes
 	for (int typeId = 0; typeId < D3D12_DESCRIPTOR_HEAP_TYPE_NUM_TYPES; ++typeId)
 	{
@@ -1349,6 +1486,7 @@ bool RenderBackend12::Initialize(const HWND& windowHandle, const uint32_t resX,
 		}
 	}
 
+#if !defined(RENDER_BACKEND_NULL)
 	// Swap chain
 	DXGI_SWAP_CHAIN_DESC1 swapChainDesc = {};
 	swapChainDesc.Width = resX;
@@ -1371,6 +1509,7 @@ bool RenderBackend12::Initialize(const HWND& windowHandle, const uint32_t resX,
 			swapChain.put()));
 
 	AssertIfFailed(swapChain->QueryInterface(IID_PPV_ARGS(s_swapChain.put())));
+#endif
 
 	D3D12_RENDER_TARGET_VIEW_DESC rtvDesc = {};
 	rtvDesc.Format = Settings::k_backBufferFormat;
@@ -1384,7 +1523,23 @@ bool RenderBackend12::Initialize(const HWND& windowHandle, const uint32_t resX,
 		backBuffer->m_resource = new FResource;
 		backBuffer->m_isDepthStencil = false;
 		backBuffer->m_isSwapChainBuffer = true;
+#if defined(RENDER_BACKEND_NULL)
+		D3D12_HEAP_PROPERTIES heapDesc = {};
+		heapDesc.Type = D3D12_HEAP_TYPE_DEFAULT;
+
+		D3D12_RESOURCE_DESC backBufferDesc = {};
+		backBufferDesc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
+		backBufferDesc.Width = resX;
+		backBufferDesc.Height = resY;
+		backBufferDesc.DepthOrArraySize = 1;
+		backBufferDesc.MipLevels = 1;
+		backBufferDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+		backBufferDesc.SampleDesc.Count = 1;
+		backBufferDesc.Flags = D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET;
+		AssertIfFailed(s_d3dDevice->CreateCommittedResource(&heapDesc, D3D12_HEAP_FLAG_NONE, &backBufferDesc, D3D12_RESOURCE_STATE_PRESENT, nullptr, IID_PPV_ARGS(&backBuffer->m_resource->m_d3dResource)));
+#else
 		AssertIfFailed(s_swapChain->GetBuffer(bufferIdx, IID_PPV_ARGS(&backBuffer->m_resource->m_d3dResource)));
+#endif
 
 		std::wstringstream s;
 		s << L"back_buffer_" << bufferIdx;
@@ -1400,11 +1555,19 @@ bool RenderBackend12::Initialize(const HWND& windowHandle, const uint32_t resX,
 		backBuffer->m_renderTextureIndices.push_back(rtvIndex);
 	}
 
+#if defined(RENDER_BACKEND_NULL)
+	s_currentBufferIndex = 0;
+#else
 	s_currentBufferIndex = s_swapChain->GetCurrentBackBufferIndex();
+#endif
 
 	// Pooled resource memory shared between Render Targets and UAVs
 	s_sharedResourcePool.Initialize(k_sharedResourceMemory);
 
+	// Per-frame upload memory for transient buffers
+	s_transientBufferAllocator.Initialize(k_transientBufferSlabSize);
+	s_transientBufferAllocator.Recycle(s_currentBufferIndex);
+
 	// Frame sync
 	AssertIfFailed(s_d3dDevice->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(s_frameFence.put())));
 
@@ -1445,6 +1608,7 @@ void RenderBackend12::Teardown()
 
 	s_commandListPool.Clear();
 	s_uploadBufferPool.Clear();
+	s_transientBufferAllocator.Clear();
 	s_sharedResourcePool.Clear();
 	s_bindlessPool.Clear();
 
@@ -1455,6 +1619,26 @@ void RenderBackend12::Teardown()
 	s_rtvIndexPool.clear();
 	s_dsvIndexPool.clear();
 
+#if defined(RENDER_BACKEND_NULL)
+	NullBackend::Report();
+
+	// The null objects are freed on their last release so drop the references instead of releasing them manually
+	for (auto& backBuffer : s_backBuffers)
+	{
+		backBuffer.reset();
+	}
+
+	s_frameFence = nullptr;
+	for (auto& descriptorHeap : s_descriptorHeaps)
+	{
+		descriptorHeap = nullptr;
+	}
+
+	s_graphicsQueue = nullptr;
+	s_computeQueue = nullptr;
+	s_copyQueue = nullptr;
+	s_d3dDevice = nullptr;
+#else
 	s_frameFence.get()->Release();
 
 	for (auto& descriptorHeap : s_descriptorHeaps)
@@ -1468,8 +1652,9 @@ void RenderBackend12::Teardown()
 	s_swapChain.get()->Release();
 	s_dxgiFactory.get()->Release();
 	s_d3dDevice.get()->Release();
+#endif
 
-#if _DEBUG
+#if _DEBUG && !defined(RENDER_BACKEND_NULL)
 	HMODULE dxgiDebugDll = GetModuleHandle(L"Dxgidebug.dll");
 	auto DXGIGetDebugInterfaceProc = reinterpret_cast<decltype(DXGIGetDebugInterface)*>(GetProcAddress(dxgiDebugDll, "DXGIGetDebugInterface"));
 
@@ -1672,7 +1857,11 @@ D3DFence_t* RenderBackend12::ExecuteCommandlists(const D3D12_COMMAND_LIST_TYPE c
 
 void RenderBackend12::PresentDisplay()
 {
+#if defined(RENDER_BACKEND_NULL)
+	NullBackend::Present();
+#else
 	s_swapChain->Present(1, 0);
+#endif
 
 	// Signal current frame is done
 	auto currentFenceValue = s_frameFenceValues[s_currentBufferIndex];
@@ -1691,6 +1880,9 @@ void RenderBackend12::PresentDisplay()
 		PIXEndEvent();
 	}
 
+	// The GPU is done with the transient allocations made the last time this buffer index was used
+	s_transientBufferAllocator.Recycle(s_currentBufferIndex);
+
 	// Update fence value for the next frame
 	s_frameFenceValues[s_currentBufferIndex] = currentFenceValue + 1;
 }
@@ -1758,12 +1950,28 @@ std::unique_ptr<FTransientBuffer> RenderBackend12::CreateTransientBuffer(
 {
 	DebugAssert(sizeInBytes != 0);
 
+	auto tempBuffer = std::make_unique<FTransientBuffer>();
+	tempBuffer->m_dependentCmdlist = dependentCL;
+
+	// Fast path: bump allocate from the current frame slab
+	uint8_t* pData;
+	if (s_transientBufferAllocator.TryAllocate(sizeInBytes, tempBuffer->m_resource, pData, tempBuffer->m_gpuAddress))
+	{
+		tempBuffer->m_isLinearAllocation = true;
+
+		if (uploadFunc)
+		{
+			uploadFunc(pData);
+		}
+
+		return std::move(tempBuffer);
+	}
+
 	DWORD n;
 	_BitScanReverse64(&n, sizeInBytes);
 	const size_t powOf2Size = (1 << (n + 1));
 	FResource* buffer = s_uploadBufferPool.GetOrCreate(name, powOf2Size);
 
-	uint8_t* pData;
 	buffer->m_d3dResource->Map(0, nullptr, reinterpret_cast<void**>(&pData));
 
 	if (uploadFunc)
@@ -1772,9 +1980,9 @@ std::unique_ptr<FTransientBuffer> RenderBackend12::CreateTransientBuffer(
 		buffer->m_d3dResource->Unmap(0, nullptr);
 	}
 
-	auto tempBuffer = std::make_unique<FTransientBuffer>();
 	tempBuffer->m_resource = buffer;
-	tempBuffer->m_dependentCmdlist = dependentCL;
+	tempBuffer->m_gpuAddress = buffer->m_d3dResource->GetGPUVirtualAddress();
+	tempBuffer->m_isLinearAllocation = false;
 
 	return std::move(tempBuffer);
 }
@@ -2070,11 +2278,14 @@ std::unique_ptr<FBindlessShaderResource> RenderBackend12::CreateBindlessBuffer(
 		desc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
 		desc.Flags = D3D12_RESOURCE_FLAG_NONE;
 
+		// Without initial data the buffer is left in the common state. Buffers are always implicitly promoted so it can be
+		// filled later from any queue and read by shaders without explicit transitions.
 		newBuffer->m_resource = new FResource;
-		AssertIfFailed(newBuffer->m_resource->InitCommittedResource(name, heapProps, desc, D3D12_RESOURCE_STATE_COPY_DEST));
+		AssertIfFailed(newBuffer->m_resource->InitCommittedResource(name, heapProps, desc, pData ? D3D12_RESOURCE_STATE_COPY_DEST : D3D12_RESOURCE_STATE_COMMON));
 	}
 
 	// Upload buffer data
+	if (pData)
 	{
 		std::vector<D3D12_SUBRESOURCE_DATA> srcData(1);
 		srcData[0].pData = pData;
@@ -2108,6 +2319,167 @@ std::unique_ptr<FBindlessShaderResource> RenderBackend12::CreateBindlessBuffer(
 	return std::move(newBuffer);
 }
 
+// Copies into a sub range of an existing buffer on the given CL. The copy is queue ordered after any work already submitted
+// so the buffer can be patched while earlier frames are still in flight.
+void RenderBackend12::UpdateBindlessBuffer(
+	FCommandList* cmdList,
+	FBindlessShaderResource* buffer,
+	const size_t destOffset,
+	const uint8_t* pData,
+	const size_t size)
+{
+	DebugAssert(size != 0);
+	DebugAssert(destOffset + size <= buffer->m_resource->m_d3dResource->GetDesc().Width, "Buffer update out of range");
+
+	FResource* uploadBuffer = s_uploadBufferPool.GetOrCreate(L"buffer_update", size);
+
+	uint8_t* pMapped;
+	uploadBuffer->m_d3dResource->Map(0, nullptr, reinterpret_cast<void**>(&pMapped));
+	memcpy(pMapped, pData, size);
+	uploadBuffer->m_d3dResource->Unmap(0, nullptr);
+
+	const D3D12_RESOURCE_STATES resourceState = buffer->m_resource->m_subresourceStates[0];
+	buffer->m_resource->Transition(cmdList, D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES, D3D12_RESOURCE_STATE_COPY_DEST);
+	cmdList->m_d3dCmdList->CopyBufferRegion(buffer->m_resource->m_d3dResource, destOffset, uploadBuffer->m_d3dResource, 0, size);
+	buffer->m_resource->Transition(cmdList, D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES, resourceState);
+
+	s_uploadBufferPool.Retire(uploadBuffer, cmdList);
+}
+
+namespace
+{
+	// Runs the callback on a worker thread once the GPU has completed the CL
+	void OnCompleted(const FCommandList* cmdList, std::function<void(void)> callback)
+	{
+		winrt::com_ptr<D3DFence_t> fence = cmdList->m_fence;
+		const size_t fenceValue = cmdList->m_fenceValue;
+
+		auto waitForFenceTask = concurrency::create_task([fence, fenceValue]()
+		{
+			HANDLE event = CreateEventEx(nullptr, nullptr, 0, EVENT_ALL_ACCESS);
+			if (event)
+			{
+				fence->SetEventOnCompletion(fenceValue, event);
+				WaitForSingleObject(event, INFINITE);
+				CloseHandle(event);
+			}
+		});
+
+		waitForFenceTask.then(std::move(callback));
+	}
+}
+
+// Keeps the resource and its descriptor alive until the dependent CL has completed on the GPU
+void RenderBackend12::DeferredRelease(std::unique_ptr<FBindlessShaderResource> resource, const FCommandList* dependentCL)
+{
+	OnCompleted(dependentCL, [releasedResource = resource.release()]()
+	{
+		delete releasedResource;
+	});
+}
+
+std::unique_ptr<FBindlessShaderResource> RenderBackend12::CreateBindlessReservedTexture(
+	const std::wstring& name,
+	const DXGI_FORMAT format,
+	const size_t width,
+	const size_t height,
+	const size_t numMips)
+{
+	auto newTexture = std::make_unique<FBindlessShaderResource>();
+
+	D3D12_RESOURCE_DESC desc = {};
+	desc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
+	desc.Alignment = 0;
+	desc.Width = width;
+	desc.Height = height;
+	desc.DepthOrArraySize = 1;
+	desc.MipLevels = numMips;
+	desc.Format = format;
+	desc.SampleDesc.Count = 1;
+	desc.SampleDesc.Quality = 0;
+	desc.Layout = D3D12_TEXTURE_LAYOUT_64KB_UNDEFINED_SWIZZLE;
+	desc.Flags = D3D12_RESOURCE_FLAG_NONE;
+
+	newTexture->m_resource = new FResource;
+	AssertIfFailed(newTexture->m_resource->InitReservedResource(name, desc, D3D12_RESOURCE_STATE_COPY_DEST));
+
+	return std::move(newTexture);
+}
+
+uint32_t RenderBackend12::GetPackedMipIndex(const FBindlessShaderResource* texture)
+{
+	D3D12_PACKED_MIP_INFO packedMipInfo;
+	GetDevice()->GetResourceTiling(texture->m_resource->m_d3dResource, nullptr, &packedMipInfo, nullptr, nullptr, 0, nullptr);
+	return packedMipInfo.NumStandardMips;
+}
+
+// Standard mips are committed one at a time as they stream in and get a heap each, the packed mips share one
+void RenderBackend12::CommitTextureMips(FBindlessShaderResource* texture, const uint32_t firstMip)
+{
+	FResource* resource = texture->m_resource;
+	const D3D12_RESOURCE_DESC desc = resource->m_d3dResource->GetDesc();
+
+	D3D12_PACKED_MIP_INFO packedMipInfo;
+	UINT tilingCount = desc.MipLevels;
+	D3D12_SUBRESOURCE_TILING tilings[D3D12_REQ_MIP_LEVELS];
+	GetDevice()->GetResourceTiling(resource->m_d3dResource, nullptr, &packedMipInfo, nullptr, &tilingCount, 0, tilings);
+
+	const uint32_t standardMipCount = packedMipInfo.NumStandardMips;
+	resource->m_tileHeaps.resize(standardMipCount + 1);
+
+	auto MapTiles = [resource](winrt::com_ptr<D3DHeap_t>& heap, const uint32_t subresource, const UINT tileCount)
+	{
+		D3D12_HEAP_DESC heapDesc = {};
+		heapDesc.SizeInBytes = tileCount * D3D12_TILED_RESOURCE_TILE_SIZE_IN_BYTES;
+		heapDesc.Properties.Type = D3D12_HEAP_TYPE_DEFAULT;
+		heapDesc.Flags = D3D12_HEAP_FLAG_DENY_BUFFERS | D3D12_HEAP_FLAG_DENY_RT_DS_TEXTURES;
+		AssertIfFailed(GetDevice()->CreateHeap(&heapDesc, IID_PPV_ARGS(heap.put())));
+
+		const D3D12_TILED_RESOURCE_COORDINATE coordinate = { 0, 0, 0, subresource };
+		const D3D12_TILE_REGION_SIZE regionSize = { tileCount, FALSE, 0, 0, 0 };
+		const D3D12_TILE_RANGE_FLAGS rangeFlags = D3D12_TILE_RANGE_FLAG_NONE;
+		const UINT heapOffset = 0;
+		GetCopyQueue()->UpdateTileMappings(resource->m_d3dResource, 1, &coordinate, &regionSize, heap.get(), 1, &rangeFlags, &heapOffset, &tileCount, D3D12_TILE_MAPPING_FLAG_NONE);
+	};
+
+	for (uint32_t mip = firstMip; mip < standardMipCount; ++mip)
+	{
+		if (!resource->m_tileHeaps[mip])
+		{
+			MapTiles(resource->m_tileHeaps[mip], mip, tilings[mip].WidthInTiles * tilings[mip].HeightInTiles * tilings[mip].DepthInTiles);
+		}
+	}
+
+	if (packedMipInfo.NumPackedMips > 0 && !resource->m_tileHeaps[standardMipCount])
+	{
+		MapTiles(resource->m_tileHeaps[standardMipCount], standardMipCount, packedMipInfo.NumTilesForPackedMips);
+	}
+}
+
+void RenderBackend12::SetTextureMostDetailedMip(FBindlessShaderResource* texture, const uint32_t mostDetailedMip, const FCommandList* dependentCL)
+{
+	const D3D12_RESOURCE_DESC desc = texture->m_resource->m_d3dResource->GetDesc();
+	DebugAssert(mostDetailedMip < desc.MipLevels);
+
+	const uint32_t srvIndex = GetBindlessPool()->FetchIndex(BindlessResourceType::Texture2D);
+	D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+	srvDesc.Format = desc.Format;
+	srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
+	srvDesc.Texture2D.MipLevels = desc.MipLevels - mostDetailedMip;
+	srvDesc.Texture2D.MostDetailedMip = mostDetailedMip;
+	srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+	GetDevice()->CreateShaderResourceView(texture->m_resource->m_d3dResource, &srvDesc, GetCPUDescriptor(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, srvIndex));
+
+	const uint32_t previousIndex = std::exchange(texture->m_srvIndex, srvIndex);
+	if (previousIndex != ~0u)
+	{
+		OnCompleted(dependentCL, [previousIndex]()
+		{
+			GetBindlessPool()->ReturnIndex(previousIndex);
+		});
+	}
+}
+
 std::unique_ptr<FBindlessUav> RenderBackend12::CreateBindlessUavTexture(
 	const std::wstring& name,
 	const DXGI_FORMAT format,
@@ -2254,4 +2626,9 @@ uint32_t RenderBackend12::GetLaneCount()
 {
 	return s_waveOpsInfo.WaveLaneCountMin;
 }
+
+bool RenderBackend12::SupportsReservedTextures()
+{
+	return s_tiledResourcesTier != D3D12_TILED_RESOURCES_TIER_NOT_SUPPORTED;
+}
 #pragma endregion
\ No newline at end of file
@@ -0,0 +1,1155 @@
+#include <backend-null.h>
+#include <common.h>
+#include <atomic>
+#include <mutex>
+#include <sstream>
+#include <algorithm>
+
+//-----------------------------------------------------------------------------------------------------------------------------------------------
+//														Constants
+//-----------------------------------------------------------------------------------------------------------------------------------------------
+constexpr uint32_t k_nullDescriptorSize = 32;
+constexpr uint32_t k_nullWaveLaneCount = 32;
+constexpr uint64_t k_nullTimestampFrequency = 1000000;
+constexpr uint64_t k_nullAddressBase = 0x10000;
+constexpr uint64_t k_nullAddressAlignment = D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
+
+//-----------------------------------------------------------------------------------------------------------------------------------------------
+//														Stats
+//-----------------------------------------------------------------------------------------------------------------------------------------------
+
+namespace
+{
+	std::mutex s_statsLock;
+	FNullBackendStats s_totalStats;
+	FNullBackendStats s_frameBeginStats;
+	FNullBackendStats s_lastFrameStats;
+	std::vector<FNullCommand> s_frameCommands;
+	std::vector<FNullCommand> s_lastFrameCommands;
+	std::atomic<uint64_t> s_nextAddress{ k_nullAddressBase };
+
+	uint64_t AlignUp(const uint64_t value, const uint64_t alignment)
+	{
+		return (value + alignment - 1) & ~(alignment - 1);
+	}
+
+	uint64_t AllocateAddressRange(const uint64_t sizeInBytes)
+	{
+		return s_nextAddress.fetch_add(AlignUp(std::max<uint64_t>(sizeInBytes, 1), k_nullAddressAlignment));
+	}
+
+	template<typename Proc>
+	void UpdateStats(Proc&& proc)
+	{
+		const std::lock_guard<std::mutex> lock(s_statsLock);
+		proc(s_totalStats);
+	}
+
+	uint32_t GetSubresourceCount(const D3D12_RESOURCE_DESC& desc)
+	{
+		if (desc.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER)
+		{
+			return 1;
+		}
+
+		uint32_t mipCount = desc.MipLevels;
+		if (mipCount == 0)
+		{
+			uint64_t maxDimension = std::max<uint64_t>(desc.Width, desc.Height);
+			while (maxDimension > 0)
+			{
+				maxDimension >>= 1;
+				++mipCount;
+			}
+		}
+
+		const uint32_t arraySize = desc.Dimension == D3D12_RESOURCE_DIMENSION_TEXTURE3D ? 1 : desc.DepthOrArraySize;
+		return mipCount * arraySize;
+	}
+
+	// Mirrors the D3D12 placement rules: 256B aligned row pitch and 512B aligned subresource offsets
+	uint64_t ComputeCopyableFootprints(
+		const D3D12_RESOURCE_DESC& desc,
+		const uint32_t firstSubresource,
+		const uint32_t numSubresources,
+		const uint64_t baseOffset,
+		D3D12_PLACED_SUBRESOURCE_FOOTPRINT* layouts,
+		UINT* numRows,
+		UINT64* rowSizeInBytes)
+	{
+		if (desc.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER)
+		{
+			if (layouts)
+			{
+				layouts[0].Offset = baseOffset;
+				layouts[0].Footprint = { DXGI_FORMAT_UNKNOWN, (UINT)desc.Width, 1, 1, (UINT)AlignUp(desc.Width, D3D12_TEXTURE_DATA_PITCH_ALIGNMENT) };
+			}
+
+			if (numRows) numRows[0] = 1;
+			if (rowSizeInBytes) rowSizeInBytes[0] = desc.Width;
+			return desc.Width;
+		}
+
+		const uint32_t mipCount = std::max<uint32_t>(desc.MipLevels, 1);
+		const bool isCompressed = DirectX::IsCompressed(desc.Format);
+		uint64_t offset = baseOffset;
+
+		for (uint32_t i = 0; i < numSubresources; ++i)
+		{
+			const uint32_t mip = (firstSubresource + i) % mipCount;
+			const uint32_t width = std::max<uint32_t>((UINT)(desc.Width >> mip), 1);
+			const uint32_t height = std::max<uint32_t>(desc.Height >> mip, 1);
+			const uint32_t depth = desc.Dimension == D3D12_RESOURCE_DIMENSION_TEXTURE3D ? std::max<uint32_t>(desc.DepthOrArraySize >> mip, 1) : 1;
+
+			size_t rowPitch, slicePitch;
+			DirectX::ComputePitch(desc.Format, width, height, rowPitch, slicePitch);
+			const uint32_t rowCount = isCompressed ? std::max<uint32_t>((height + 3) / 4, 1) : height;
+			const uint32_t alignedRowPitch = (uint32_t)AlignUp(rowPitch, D3D12_TEXTURE_DATA_PITCH_ALIGNMENT);
+
+			offset = AlignUp(offset, D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT);
+			if (layouts)
+			{
+				layouts[i].Offset = offset;
+				layouts[i].Footprint = { desc.Format, width, height, depth, alignedRowPitch };
+			}
+
+			if (numRows) numRows[i] = rowCount;
+			if (rowSizeInBytes) rowSizeInBytes[i] = rowPitch;
+
+			offset += (uint64_t)alignedRowPitch * rowCount * depth;
+		}
+
+		return offset - baseOffset;
+	}
+
+	uint64_t ComputeResourceSize(const D3D12_RESOURCE_DESC& desc)
+	{
+		return ComputeCopyableFootprints(desc, 0, GetSubresourceCount(desc), 0, nullptr, nullptr, nullptr);
+	}
+
+	HRESULT QueryNullDevice(REFIID riid, void** ppvDevice);
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------------------------
+//														Null Objects
+//-----------------------------------------------------------------------------------------------------------------------------------------------
+
+namespace
+{
+	template<typename Interface, typename... InterfaceChain>
+	class TNullObject : public Interface
+	{
+	public:
+		HRESULT STDMETHODCALLTYPE QueryInterface(REFIID riid, void** ppvObject) override
+		{
+			if (!ppvObject)
+			{
+				return E_POINTER;
+			}
+
+			if (riid == __uuidof(IUnknown) || ((riid == __uuidof(InterfaceChain)) || ...))
+			{
+				AddRef();
+				*ppvObject = static_cast<Interface*>(this);
+				return S_OK;
+			}
+
+			*ppvObject = nullptr;
+			return E_NOINTERFACE;
+		}
+
+		ULONG STDMETHODCALLTYPE AddRef() override
+		{
+			return ++m_refCount;
+		}
+
+		ULONG STDMETHODCALLTYPE Release() override
+		{
+			const ULONG refCount = --m_refCount;
+			if (refCount == 0)
+			{
+				delete this;
+			}
+
+			return refCount;
+		}
+
+		HRESULT STDMETHODCALLTYPE GetPrivateData(REFGUID guid, UINT* pDataSize, void* pData) override { return DXGI_ERROR_NOT_FOUND; }
+		HRESULT STDMETHODCALLTYPE SetPrivateData(REFGUID guid, UINT DataSize, const void* pData) override { return S_OK; }
+		HRESULT STDMETHODCALLTYPE SetPrivateDataInterface(REFGUID guid, const IUnknown* pData) override { return S_OK; }
+
+		HRESULT STDMETHODCALLTYPE SetName(LPCWSTR Name) override
+		{
+			m_name = Name ? Name : L"";
+			return S_OK;
+		}
+
+	protected:
+		virtual ~TNullObject() = default;
+
+		std::atomic<ULONG> m_refCount{ 1 };
+		std::wstring m_name;
+	};
+
+	template<typename Interface, typename... InterfaceChain>
+	class TNullDeviceChild : public TNullObject<Interface, ID3D12Object, ID3D12DeviceChild, InterfaceChain...>
+	{
+	public:
+		HRESULT STDMETHODCALLTYPE GetDevice(REFIID riid, void** ppvDevice) override
+		{
+			return QueryNullDevice(riid, ppvDevice);
+		}
+	};
+
+	template<typename Object, typename... Args>
+	HRESULT CreateNullObject(REFIID riid, void** ppvObject, Args&&... args)
+	{
+		if (!ppvObject)
+		{
+			// D3D12 allows passing a null output to validate the creation parameters
+			return S_FALSE;
+		}
+
+		Object* obj = new Object(std::forward<Args>(args)...);
+		HRESULT hr = obj->QueryInterface(riid, ppvObject);
+		obj->Release();
+		return hr;
+	}
+
+	class FNullFence final : public TNullDeviceChild<D3DFence_t, ID3D12Pageable, ID3D12Fence, ID3D12Fence1>
+	{
+	public:
+		FNullFence(const UINT64 initialValue, const D3D12_FENCE_FLAGS flags) :
+			m_completedValue{ initialValue },
+			m_flags{ flags }
+		{
+		}
+
+		UINT64 STDMETHODCALLTYPE GetCompletedValue() override
+		{
+			return m_completedValue.load();
+		}
+
+		HRESULT STDMETHODCALLTYPE SetEventOnCompletion(UINT64 Value, HANDLE hEvent) override
+		{
+			const std::lock_guard<std::mutex> lock(m_mutex);
+
+			if (m_completedValue >= Value)
+			{
+				if (hEvent)
+				{
+					SetEvent(hEvent);
+				}
+			}
+			else if (hEvent)
+			{
+				m_pendingEvents.push_back({ Value, hEvent });
+			}
+
+			return S_OK;
+		}
+
+		HRESULT STDMETHODCALLTYPE Signal(UINT64 Value) override
+		{
+			Complete(Value);
+			return S_OK;
+		}
+
+		D3D12_FENCE_FLAGS STDMETHODCALLTYPE GetCreationFlags() override
+		{
+			return m_flags;
+		}
+
+		void Complete(const UINT64 value)
+		{
+			const std::lock_guard<std::mutex> lock(m_mutex);
+			m_completedValue = value;
+
+			for (auto it = m_pendingEvents.begin(); it != m_pendingEvents.end();)
+			{
+				if (it->first <= value)
+				{
+					SetEvent(it->second);
+					it = m_pendingEvents.erase(it);
+				}
+				else
+				{
+					++it;
+				}
+			}
+		}
+
+	private:
+		std::mutex m_mutex;
+		std::atomic<UINT64> m_completedValue;
+		D3D12_FENCE_FLAGS m_flags;
+		std::vector<std::pair<UINT64, HANDLE>> m_pendingEvents;
+	};
+
+	class FNullHeap final : public TNullDeviceChild<D3DHeap_t, ID3D12Pageable, ID3D12Heap>
+	{
+	public:
+		explicit FNullHeap(const D3D12_HEAP_DESC& desc) :
+			m_desc{ desc }
+		{
+			UpdateStats([&desc](FNullBackendStats& stats)
+			{
+				stats.m_liveResourceBytes += desc.SizeInBytes;
+				stats.m_peakResourceBytes = std::max(stats.m_peakResourceBytes, stats.m_liveResourceBytes);
+			});
+		}
+
+		~FNullHeap()
+		{
+			UpdateStats([this](FNullBackendStats& stats)
+			{
+				stats.m_liveResourceBytes -= m_desc.SizeInBytes;
+			});
+		}
+
+		D3D12_HEAP_DESC STDMETHODCALLTYPE GetDesc() override
+		{
+			return m_desc;
+		}
+
+	private:
+		D3D12_HEAP_DESC m_desc;
+	};
+
+	class FNullQueryHeap final : public TNullDeviceChild<ID3D12QueryHeap, ID3D12Pageable, ID3D12QueryHeap>
+	{
+	};
+
+	class FNullResource final : public TNullDeviceChild<D3DResource_t, ID3D12Pageable, ID3D12Resource>
+	{
+	public:
+		FNullResource(const D3D12_RESOURCE_DESC& desc, const D3D12_HEAP_TYPE heapType, const bool isPlaced) :
+			m_desc{ desc },
+			m_heapType{ heapType },
+			m_sizeInBytes{ isPlaced ? 0 : ComputeResourceSize(desc) },
+			m_gpuAddress{ 0 }
+		{
+			if (desc.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER)
+			{
+				m_gpuAddress = AllocateAddressRange(desc.Width);
+
+				// Only CPU visible buffers need backing memory
+				if (heapType == D3D12_HEAP_TYPE_UPLOAD || heapType == D3D12_HEAP_TYPE_READBACK)
+				{
+					m_cpuMemory.resize(desc.Width);
+				}
+			}
+
+			UpdateStats([this](FNullBackendStats& stats)
+			{
+				stats.m_createdResources++;
+				stats.m_liveResources++;
+				stats.m_liveResourceBytes += m_sizeInBytes;
+				stats.m_peakResourceBytes = std::max(stats.m_peakResourceBytes, stats.m_liveResourceBytes);
+			});
+		}
+
+		~FNullResource()
+		{
+			UpdateStats([this](FNullBackendStats& stats)
+			{
+				stats.m_liveResources--;
+				stats.m_liveResourceBytes -= m_sizeInBytes;
+			});
+		}
+
+		HRESULT STDMETHODCALLTYPE Map(UINT Subresource, const D3D12_RANGE* pReadRange, void** ppData) override
+		{
+			if (m_cpuMemory.empty())
+			{
+				return E_INVALIDARG;
+			}
+
+			if (ppData)
+			{
+				*ppData = m_cpuMemory.data();
+			}
+
+			return S_OK;
+		}
+
+		void STDMETHODCALLTYPE Unmap(UINT Subresource, const D3D12_RANGE* pWrittenRange) override
+		{
+		}
+
+		D3D12_RESOURCE_DESC STDMETHODCALLTYPE GetDesc() override
+		{
+			return m_desc;
+		}
+
+		D3D12_GPU_VIRTUAL_ADDRESS STDMETHODCALLTYPE GetGPUVirtualAddress() override
+		{
+			return m_gpuAddress;
+		}
+
+		HRESULT STDMETHODCALLTYPE WriteToSubresource(UINT DstSubresource, const D3D12_BOX* pDstBox, const void* pSrcData, UINT SrcRowPitch, UINT SrcDepthPitch) override
+		{
+			return S_OK;
+		}
+
+		HRESULT STDMETHODCALLTYPE ReadFromSubresource(void* pDstData, UINT DstRowPitch, UINT DstDepthPitch, UINT SrcSubresource, const D3D12_BOX* pSrcBox) override
+		{
+			return S_OK;
+		}
+
+		HRESULT STDMETHODCALLTYPE GetHeapProperties(D3D12_HEAP_PROPERTIES* pHeapProperties, D3D12_HEAP_FLAGS* pHeapFlags) override
+		{
+			if (pHeapProperties)
+			{
+				*pHeapProperties = {};
+				pHeapProperties->Type = m_heapType;
+			}
+
+			if (pHeapFlags)
+			{
+				*pHeapFlags = D3D12_HEAP_FLAG_NONE;
+			}
+
+			return S_OK;
+		}
+
+		uint64_t GetSizeInBytes() const
+		{
+			return m_sizeInBytes;
+		}
+
+	private:
+		D3D12_RESOURCE_DESC m_desc;
+		D3D12_HEAP_TYPE m_heapType;
+		uint64_t m_sizeInBytes;
+		D3D12_GPU_VIRTUAL_ADDRESS m_gpuAddress;
+		std::vector<uint8_t> m_cpuMemory;
+	};
+
+	class FNullDescriptorHeap final : public TNullDeviceChild<D3DDescriptorHeap_t, ID3D12Pageable, ID3D12DescriptorHeap>
+	{
+	public:
+		explicit FNullDescriptorHeap(const D3D12_DESCRIPTOR_HEAP_DESC& desc) :
+			m_desc{ desc },
+			m_baseAddress{ AllocateAddressRange((uint64_t)desc.NumDescriptors * k_nullDescriptorSize) }
+		{
+		}
+
+		D3D12_DESCRIPTOR_HEAP_DESC STDMETHODCALLTYPE GetDesc() override
+		{
+			return m_desc;
+		}
+
+		D3D12_CPU_DESCRIPTOR_HANDLE STDMETHODCALLTYPE GetCPUDescriptorHandleForHeapStart() override
+		{
+			return D3D12_CPU_DESCRIPTOR_HANDLE{ (SIZE_T)m_baseAddress };
+		}
+
+		D3D12_GPU_DESCRIPTOR_HANDLE STDMETHODCALLTYPE GetGPUDescriptorHandleForHeapStart() override
+		{
+			return D3D12_GPU_DESCRIPTOR_HANDLE{ m_baseAddress };
+		}
+
+	private:
+		D3D12_DESCRIPTOR_HEAP_DESC m_desc;
+		uint64_t m_baseAddress;
+	};
+
+	class FNullRootSignature final : public TNullDeviceChild<D3DRootSignature_t, ID3D12RootSignature>
+	{
+	};
+
+	class FNullPipelineState final : public TNullDeviceChild<D3DPipelineState_t, ID3D12Pageable, ID3D12PipelineState>
+	{
+	public:
+		FNullPipelineState()
+		{
+			UpdateStats([](FNullBackendStats& stats) { stats.m_createdPipelineStates++; });
+		}
+
+		HRESULT STDMETHODCALLTYPE GetCachedBlob(ID3DBlob** ppBlob) override
+		{
+			return E_NOTIMPL;
+		}
+	};
+
+	class FNullCommandAllocator final : public TNullDeviceChild<D3DCommandAllocator_t, ID3D12Pageable, ID3D12CommandAllocator>
+	{
+	public:
+		HRESULT STDMETHODCALLTYPE Reset() override
+		{
+			return S_OK;
+		}
+	};
+
+	class FNullCommandList final : public TNullDeviceChild<
+		D3DCommandList_t,
+		ID3D12CommandList,
+		ID3D12GraphicsCommandList,
+		ID3D12GraphicsCommandList1,
+		ID3D12GraphicsCommandList2,
+		ID3D12GraphicsCommandList3,
+		ID3D12GraphicsCommandList4>
+	{
+	public:
+		explicit FNullCommandList(const D3D12_COMMAND_LIST_TYPE type) :
+			m_type{ type },
+			m_isClosed{ false },
+			m_copiedBytes{ 0 }
+		{
+			UpdateStats([](FNullBackendStats& stats) { stats.m_createdCommandLists++; });
+		}
+
+		const std::vector<FNullCommand>& GetCommands() const
+		{
+			return m_commands;
+		}
+
+		uint64_t GetCopiedBytes() const
+		{
+			return m_copiedBytes;
+		}
+
+		// ID3D12CommandList
+		D3D12_COMMAND_LIST_TYPE STDMETHODCALLTYPE GetType() override { return m_type; }
+
+		// ID3D12GraphicsCommandList
+		HRESULT STDMETHODCALLTYPE Close() override
+		{
+			m_isClosed = true;
+			return S_OK;
+		}
+
+		HRESULT STDMETHODCALLTYPE Reset(ID3D12CommandAllocator* pAllocator, ID3D12PipelineState* pInitialState) override
+		{
+			m_commands.clear();
+			m_copiedBytes = 0;
+			m_isClosed = false;
+
+			if (pInitialState)
+			{
+				Record(NullCommandType::SetPipelineState, (uint64_t)pInitialState);
+			}
+
+			return S_OK;
+		}
+
+		void STDMETHODCALLTYPE ClearState(ID3D12PipelineState* pPipelineState) override { Record(NullCommandType::Other); }
+
+		void STDMETHODCALLTYPE DrawInstanced(UINT VertexCountPerInstance, UINT InstanceCount, UINT StartVertexLocation, UINT StartInstanceLocation) override
+		{
+			Record(NullCommandType::Draw, VertexCountPerInstance, InstanceCount);
+		}
+
+		void STDMETHODCALLTYPE DrawIndexedInstanced(UINT IndexCountPerInstance, UINT InstanceCount, UINT StartIndexLocation, INT BaseVertexLocation, UINT StartInstanceLocation) override
+		{
+			Record(NullCommandType::Draw, IndexCountPerInstance, InstanceCount);
+		}
+
+		void STDMETHODCALLTYPE Dispatch(UINT ThreadGroupCountX, UINT ThreadGroupCountY, UINT ThreadGroupCountZ) override
+		{
+			Record(NullCommandType::Dispatch, ThreadGroupCountX, (uint64_t)ThreadGroupCountY * ThreadGroupCountZ);
+		}
+
+		void STDMETHODCALLTYPE CopyBufferRegion(ID3D12Resource* pDstBuffer, UINT64 DstOffset, ID3D12Resource* pSrcBuffer, UINT64 SrcOffset, UINT64 NumBytes) override
+		{
+			RecordCopy(NumBytes);
+		}
+
+		void STDMETHODCALLTYPE CopyTextureRegion(const D3D12_TEXTURE_COPY_LOCATION* pDst, UINT DstX, UINT DstY, UINT DstZ, const D3D12_TEXTURE_COPY_LOCATION* pSrc, const D3D12_BOX* pSrcBox) override
+		{
+			uint64_t numBytes = 0;
+			if (pSrc && pSrc->Type == D3D12_TEXTURE_COPY_TYPE_PLACED_FOOTPRINT)
+			{
+				const D3D12_SUBRESOURCE_FOOTPRINT& footprint = pSrc->PlacedFootprint.Footprint;
+				const uint32_t rowCount = DirectX::IsCompressed(footprint.Format) ? std::max<uint32_t>((footprint.Height + 3) / 4, 1) : footprint.Height;
+				numBytes = (uint64_t)footprint.RowPitch * rowCount * footprint.Depth;
+			}
+
+			RecordCopy(numBytes);
+		}
+
+		void STDMETHODCALLTYPE CopyResource(ID3D12Resource* pDstResource, ID3D12Resource* pSrcResource) override
+		{
+			RecordCopy(pSrcResource ? static_cast<FNullResource*>(pSrcResource)->GetSizeInBytes() : 0);
+		}
+
+		void STDMETHODCALLTYPE CopyTiles(ID3D12Resource* pTiledResource, const D3D12_TILED_RESOURCE_COORDINATE* pTileRegionStartCoordinate, const D3D12_TILE_REGION_SIZE* pTileRegionSize, ID3D12Resource* pBuffer, UINT64 BufferStartOffsetInBytes, D3D12_TILE_COPY_FLAGS Flags) override
+		{
+			RecordCopy(pTileRegionSize ? (uint64_t)pTileRegionSize->NumTiles * D3D12_TILED_RESOURCE_TILE_SIZE_IN_BYTES : 0);
+		}
+
+		void STDMETHODCALLTYPE ResolveSubresource(ID3D12Resource* pDstResource, UINT DstSubresource, ID3D12Resource* pSrcResource, UINT SrcSubresource, DXGI_FORMAT Format) override
+		{
+			Record(NullCommandType::Resolve, DstSubresource, Format);
+		}
+
+		void STDMETHODCALLTYPE IASetPrimitiveTopology(D3D12_PRIMITIVE_TOPOLOGY PrimitiveTopology) override { Record(NullCommandType::SetFixedFunctionState, PrimitiveTopology); }
+		void STDMETHODCALLTYPE RSSetViewports(UINT NumViewports, const D3D12_VIEWPORT* pViewports) override { Record(NullCommandType::SetFixedFunctionState, NumViewports); }
+		void STDMETHODCALLTYPE RSSetScissorRects(UINT NumRects, const D3D12_RECT* pRects) override { Record(NullCommandType::SetFixedFunctionState, NumRects); }
+		void STDMETHODCALLTYPE OMSetBlendFactor(const FLOAT BlendFactor[4]) override { Record(NullCommandType::SetFixedFunctionState); }
+		void STDMETHODCALLTYPE OMSetStencilRef(UINT StencilRef) override { Record(NullCommandType::SetFixedFunctionState, StencilRef); }
+		void STDMETHODCALLTYPE SetPipelineState(ID3D12PipelineState* pPipelineState) override { Record(NullCommandType::SetPipelineState, (uint64_t)pPipelineState); }
+		void STDMETHODCALLTYPE ResourceBarrier(UINT NumBarriers, const D3D12_RESOURCE_BARRIER* pBarriers) override { Record(NullCommandType::Barrier, NumBarriers); }
+		void STDMETHODCALLTYPE ExecuteBundle(ID3D12GraphicsCommandList* pCommandList) override { Record(NullCommandType::Other); }
+
+		void STDMETHODCALLTYPE SetDescriptorHeaps(UINT NumDescriptorHeaps, ID3D12DescriptorHeap* const* ppDescriptorHeaps) override
+		{
+			Record(NullCommandType::SetDescriptorHeaps, NumDescriptorHeaps);
+		}
+
+		void STDMETHODCALLTYPE SetComputeRootSignature(ID3D12RootSignature* pRootSignature) override { Record(NullCommandType::SetRootSignature, (uint64_t)pRootSignature); }
+		void STDMETHODCALLTYPE SetGraphicsRootSignature(ID3D12RootSignature* pRootSignature) override { Record(NullCommandType::SetRootSignature, (uint64_t)pRootSignature); }
+		void STDMETHODCALLTYPE SetComputeRootDescriptorTable(UINT RootParameterIndex, D3D12_GPU_DESCRIPTOR_HANDLE BaseDescriptor) override { Record(NullCommandType::SetRootArgument, RootParameterIndex, BaseDescriptor.ptr); }
+		void STDMETHODCALLTYPE SetGraphicsRootDescriptorTable(UINT RootParameterIndex, D3D12_GPU_DESCRIPTOR_HANDLE BaseDescriptor) override { Record(NullCommandType::SetRootArgument, RootParameterIndex, BaseDescriptor.ptr); }
+		void STDMETHODCALLTYPE SetComputeRoot32BitConstant(UINT RootParameterIndex, UINT SrcData, UINT DestOffsetIn32BitValues) override { Record(NullCommandType::SetRootArgument, RootParameterIndex, SrcData); }
+		void STDMETHODCALLTYPE SetGraphicsRoot32BitConstant(UINT RootParameterIndex, UINT SrcData, UINT DestOffsetIn32BitValues) override { Record(NullCommandType::SetRootArgument, RootParameterIndex, SrcData); }
+		void STDMETHODCALLTYPE SetComputeRoot32BitConstants(UINT RootParameterIndex, UINT Num32BitValuesToSet, const void* pSrcData, UINT DestOffsetIn32BitValues) override { Record(NullCommandType::SetRootArgument, RootParameterIndex, Num32BitValuesToSet); }
+		void STDMETHODCALLTYPE SetGraphicsRoot32BitConstants(UINT RootParameterIndex, UINT Num32BitValuesToSet, const void* pSrcData, UINT DestOffsetIn32BitValues) override { Record(NullCommandType::SetRootArgument, RootParameterIndex, Num32BitValuesToSet); }
+		void STDMETHODCALLTYPE SetComputeRootConstantBufferView(UINT RootParameterIndex, D3D12_GPU_VIRTUAL_ADDRESS BufferLocation) override { Record(NullCommandType::SetRootArgument, RootParameterIndex, BufferLocation); }
+		void STDMETHODCALLTYPE SetGraphicsRootConstantBufferView(UINT RootParameterIndex, D3D12_GPU_VIRTUAL_ADDRESS BufferLocation) override { Record(NullCommandType::SetRootArgument, RootParameterIndex, BufferLocation); }
+		void STDMETHODCALLTYPE SetComputeRootShaderResourceView(UINT RootParameterIndex, D3D12_GPU_VIRTUAL_ADDRESS BufferLocation) override { Record(NullCommandType::SetRootArgument, RootParameterIndex, BufferLocation); }
+		void STDMETHODCALLTYPE SetGraphicsRootShaderResourceView(UINT RootParameterIndex, D3D12_GPU_VIRTUAL_ADDRESS BufferLocation) override { Record(NullCommandType::SetRootArgument, RootParameterIndex, BufferLocation); }
+		void STDMETHODCALLTYPE SetComputeRootUnorderedAccessView(UINT RootParameterIndex, D3D12_GPU_VIRTUAL_ADDRESS BufferLocation) override { Record(NullCommandType::SetRootArgument, RootParameterIndex, BufferLocation); }
+		void STDMETHODCALLTYPE SetGraphicsRootUnorderedAccessView(UINT RootParameterIndex, D3D12_GPU_VIRTUAL_ADDRESS BufferLocation) override { Record(NullCommandType::SetRootArgument, RootParameterIndex, BufferLocation); }
+
+		void STDMETHODCALLTYPE IASetIndexBuffer(const D3D12_INDEX_BUFFER_VIEW* pView) override { Record(NullCommandType::SetFixedFunctionState, pView ? pView->BufferLocation : 0); }
+		void STDMETHODCALLTYPE IASetVertexBuffers(UINT StartSlot, UINT NumViews, const D3D12_VERTEX_BUFFER_VIEW* pViews) override { Record(NullCommandType::SetFixedFunctionState, StartSlot, NumViews); }
+		void STDMETHODCALLTYPE SOSetTargets(UINT StartSlot, UINT NumViews, const D3D12_STREAM_OUTPUT_BUFFER_VIEW* pViews) override { Record(NullCommandType::SetFixedFunctionState, StartSlot, NumViews); }
+
+		void STDMETHODCALLTYPE OMSetRenderTargets(UINT NumRenderTargetDescriptors, const D3D12_CPU_DESCRIPTOR_HANDLE* pRenderTargetDescriptors, BOOL RTsSingleHandleToDescriptorRange, const D3D12_CPU_DESCRIPTOR_HANDLE* pDepthStencilDescriptor) override
+		{
+			Record(NullCommandType::SetRenderTargets, NumRenderTargetDescriptors, pDepthStencilDescriptor ? 1 : 0);
+		}
+
+		void STDMETHODCALLTYPE ClearDepthStencilView(D3D12_CPU_DESCRIPTOR_HANDLE DepthStencilView, D3D12_CLEAR_FLAGS ClearFlags, FLOAT Depth, UINT8 Stencil, UINT NumRects, const D3D12_RECT* pRects) override { Record(NullCommandType::Clear, DepthStencilView.ptr); }
+		void STDMETHODCALLTYPE ClearRenderTargetView(D3D12_CPU_DESCRIPTOR_HANDLE RenderTargetView, const FLOAT ColorRGBA[4], UINT NumRects, const D3D12_RECT* pRects) override { Record(NullCommandType::Clear, RenderTargetView.ptr); }
+		void STDMETHODCALLTYPE ClearUnorderedAccessViewUint(D3D12_GPU_DESCRIPTOR_HANDLE ViewGPUHandleInCurrentHeap, D3D12_CPU_DESCRIPTOR_HANDLE ViewCPUHandle, ID3D12Resource* pResource, const UINT Values[4], UINT NumRects, const D3D12_RECT* pRects) override { Record(NullCommandType::Clear, ViewCPUHandle.ptr); }
+		void STDMETHODCALLTYPE ClearUnorderedAccessViewFloat(D3D12_GPU_DESCRIPTOR_HANDLE ViewGPUHandleInCurrentHeap, D3D12_CPU_DESCRIPTOR_HANDLE ViewCPUHandle, ID3D12Resource* pResource, const FLOAT Values[4], UINT NumRects, const D3D12_RECT* pRects) override { Record(NullCommandType::Clear, ViewCPUHandle.ptr); }
+		void STDMETHODCALLTYPE DiscardResource(ID3D12Resource* pResource, const D3D12_DISCARD_REGION* pRegion) override { Record(NullCommandType::Other); }
+
+		void STDMETHODCALLTYPE BeginQuery(ID3D12QueryHeap* pQueryHeap, D3D12_QUERY_TYPE Type, UINT Index) override { Record(NullCommandType::Query, Type, Index); }
+		void STDMETHODCALLTYPE EndQuery(ID3D12QueryHeap* pQueryHeap, D3D12_QUERY_TYPE Type, UINT Index) override { Record(NullCommandType::Query, Type, Index); }
+		void STDMETHODCALLTYPE ResolveQueryData(ID3D12QueryHeap* pQueryHeap, D3D12_QUERY_TYPE Type, UINT StartIndex, UINT NumQueries, ID3D12Resource* pDestinationBuffer, UINT64 AlignedDestinationBufferOffset) override { Record(NullCommandType::Query, Type, NumQueries); }
+		void STDMETHODCALLTYPE SetPredication(ID3D12Resource* pBuffer, UINT64 AlignedBufferOffset, D3D12_PREDICATION_OP Operation) override { Record(NullCommandType::Other); }
+
+		void STDMETHODCALLTYPE SetMarker(UINT Metadata, const void* pData, UINT Size) override { Record(NullCommandType::Event, Metadata); }
+		void STDMETHODCALLTYPE BeginEvent(UINT Metadata, const void* pData, UINT Size) override { Record(NullCommandType::Event, Metadata); }
+		void STDMETHODCALLTYPE EndEvent() override { Record(NullCommandType::Event); }
+
+		void STDMETHODCALLTYPE ExecuteIndirect(ID3D12CommandSignature* pCommandSignature, UINT MaxCommandCount, ID3D12Resource* pArgumentBuffer, UINT64 ArgumentBufferOffset, ID3D12Resource* pCountBuffer, UINT64 CountBufferOffset) override
+		{
+			Record(NullCommandType::Draw, 0, MaxCommandCount);
+		}
+
+		// ID3D12GraphicsCommandList1
+		void STDMETHODCALLTYPE AtomicCopyBufferUINT(ID3D12Resource* pDstBuffer, UINT64 DstOffset, ID3D12Resource* pSrcBuffer, UINT64 SrcOffset, UINT Dependencies, ID3D12Resource* const* ppDependentResources, const D3D12_SUBRESOURCE_RANGE_UINT64* pDependentSubresourceRanges) override { RecordCopy(sizeof(UINT)); }
+		void STDMETHODCALLTYPE AtomicCopyBufferUINT64(ID3D12Resource* pDstBuffer, UINT64 DstOffset, ID3D12Resource* pSrcBuffer, UINT64 SrcOffset, UINT Dependencies, ID3D12Resource* const* ppDependentResources, const D3D12_SUBRESOURCE_RANGE_UINT64* pDependentSubresourceRanges) override { RecordCopy(sizeof(UINT64)); }
+		void STDMETHODCALLTYPE OMSetDepthBounds(FLOAT Min, FLOAT Max) override { Record(NullCommandType::SetFixedFunctionState); }
+		void STDMETHODCALLTYPE SetSamplePositions(UINT NumSamplesPerPixel, UINT NumPixels, D3D12_SAMPLE_POSITION* pSamplePositions) override { Record(NullCommandType::SetFixedFunctionState); }
+		void STDMETHODCALLTYPE ResolveSubresourceRegion(ID3D12Resource* pDstResource, UINT DstSubresource, UINT DstX, UINT DstY, ID3D12Resource* pSrcResource, UINT SrcSubresource, D3D12_RECT* pSrcRect, DXGI_FORMAT Format, D3D12_RESOLVE_MODE ResolveMode) override { Record(NullCommandType::Resolve, DstSubresource, Format); }
+		void STDMETHODCALLTYPE SetViewInstanceMask(UINT Mask) override { Record(NullCommandType::SetFixedFunctionState, Mask); }
+
+		// ID3D12GraphicsCommandList2
+		void STDMETHODCALLTYPE WriteBufferImmediate(UINT Count, const D3D12_WRITEBUFFERIMMEDIATE_PARAMETER* pParams, const D3D12_WRITEBUFFERIMMEDIATE_MODE* pModes) override { RecordCopy((uint64_t)Count * sizeof(UINT)); }
+
+		// ID3D12GraphicsCommandList3
+		void STDMETHODCALLTYPE SetProtectedResourceSession(ID3D12ProtectedResourceSession* pProtectedResourceSession) override { Record(NullCommandType::Other); }
+
+		// ID3D12GraphicsCommandList4
+		void STDMETHODCALLTYPE BeginRenderPass(UINT NumRenderTargets, const D3D12_RENDER_PASS_RENDER_TARGET_DESC* pRenderTargets, const D3D12_RENDER_PASS_DEPTH_STENCIL_DESC* pDepthStencil, D3D12_RENDER_PASS_FLAGS Flags) override { Record(NullCommandType::SetRenderTargets, NumRenderTargets, pDepthStencil ? 1 : 0); }
+		void STDMETHODCALLTYPE EndRenderPass() override { Record(NullCommandType::SetRenderTargets); }
+		void STDMETHODCALLTYPE InitializeMetaCommand(ID3D12MetaCommand* pMetaCommand, const void* pInitializationParametersData, SIZE_T InitializationParametersDataSizeInBytes) override { Record(NullCommandType::Other); }
+		void STDMETHODCALLTYPE ExecuteMetaCommand(ID3D12MetaCommand* pMetaCommand, const void* pExecutionParametersData, SIZE_T ExecutionParametersDataSizeInBytes) override { Record(NullCommandType::Other); }
+		void STDMETHODCALLTYPE BuildRaytracingAccelerationStructure(const D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_DESC* pDesc, UINT NumPostbuildInfoDescs, const D3D12_RAYTRACING_ACCELERATION_STRUCTURE_POSTBUILD_INFO_DESC* pPostbuildInfoDescs) override { Record(NullCommandType::Other); }
+		void STDMETHODCALLTYPE EmitRaytracingAccelerationStructurePostbuildInfo(const D3D12_RAYTRACING_ACCELERATION_STRUCTURE_POSTBUILD_INFO_DESC* pDesc, UINT NumSourceAccelerationStructures, const D3D12_GPU_VIRTUAL_ADDRESS* pSourceAccelerationStructureData) override { Record(NullCommandType::Other); }
+		void STDMETHODCALLTYPE CopyRaytracingAccelerationStructure(D3D12_GPU_VIRTUAL_ADDRESS DestAccelerationStructureData, D3D12_GPU_VIRTUAL_ADDRESS SourceAccelerationStructureData, D3D12_RAYTRACING_ACCELERATION_STRUCTURE_COPY_MODE Mode) override { Record(NullCommandType::Other); }
+		void STDMETHODCALLTYPE SetPipelineState1(ID3D12StateObject* pStateObject) override { Record(NullCommandType::SetPipelineState, (uint64_t)pStateObject); }
+		void STDMETHODCALLTYPE DispatchRays(const D3D12_DISPATCH_RAYS_DESC* pDesc) override { Record(NullCommandType::Dispatch, pDesc ? pDesc->Width : 0, pDesc ? (uint64_t)pDesc->Height * pDesc->Depth : 0); }
+
+	private:
+		void Record(const NullCommandType type, const uint64_t arg0 = 0, const uint64_t arg1 = 0)
+		{
+			DebugAssert(!m_isClosed, "Recording into a closed command list");
+			m_commands.push_back({ type, m_type, { arg0, arg1 } });
+		}
+
+		void RecordCopy(const uint64_t numBytes)
+		{
+			m_copiedBytes += numBytes;
+			Record(NullCommandType::Copy, numBytes);
+		}
+
+	private:
+		D3D12_COMMAND_LIST_TYPE m_type;
+		bool m_isClosed;
+		uint64_t m_copiedBytes;
+		std::vector<FNullCommand> m_commands;
+	};
+
+	class FNullCommandQueue final : public TNullDeviceChild<D3DCommandQueue_t, ID3D12Pageable, ID3D12CommandQueue>
+	{
+	public:
+		explicit FNullCommandQueue(const D3D12_COMMAND_QUEUE_DESC& desc) :
+			m_desc{ desc }
+		{
+		}
+
+		void STDMETHODCALLTYPE UpdateTileMappings(ID3D12Resource* pResource, UINT NumResourceRegions, const D3D12_TILED_RESOURCE_COORDINATE* pResourceRegionStartCoordinates, const D3D12_TILE_REGION_SIZE* pResourceRegionSizes, ID3D12Heap* pHeap, UINT NumRanges, const D3D12_TILE_RANGE_FLAGS* pRangeFlags, const UINT* pHeapRangeStartOffsets, const UINT* pRangeTileCounts, D3D12_TILE_MAPPING_FLAGS Flags) override
+		{
+		}
+
+		void STDMETHODCALLTYPE CopyTileMappings(ID3D12Resource* pDstResource, const D3D12_TILED_RESOURCE_COORDINATE* pDstRegionStartCoordinate, ID3D12Resource* pSrcResource, const D3D12_TILED_RESOURCE_COORDINATE* pSrcRegionStartCoordinate, const D3D12_TILE_REGION_SIZE* pRegionSize, D3D12_TILE_MAPPING_FLAGS Flags) override
+		{
+		}
+
+		// The null GPU is infinitely fast: the command stream is consumed on submission
+		void STDMETHODCALLTYPE ExecuteCommandLists(UINT NumCommandLists, ID3D12CommandList* const* ppCommandLists) override
+		{
+			const std::lock_guard<std::mutex> lock(s_statsLock);
+
+			for (UINT i = 0; i < NumCommandLists; ++i)
+			{
+				auto cl = static_cast<FNullCommandList*>(ppCommandLists[i]);
+				for (const FNullCommand& cmd : cl->GetCommands())
+				{
+					s_totalStats.m_commandCount[(size_t)cmd.m_type]++;
+				}
+
+				s_frameCommands.insert(s_frameCommands.end(), cl->GetCommands().cbegin(), cl->GetCommands().cend());
+				s_totalStats.m_copiedBytes += cl->GetCopiedBytes();
+				s_totalStats.m_executedCommandLists++;
+			}
+		}
+
+		void STDMETHODCALLTYPE SetMarker(UINT Metadata, const void* pData, UINT Size) override {}
+		void STDMETHODCALLTYPE BeginEvent(UINT Metadata, const void* pData, UINT Size) override {}
+		void STDMETHODCALLTYPE EndEvent() override {}
+
+		HRESULT STDMETHODCALLTYPE Signal(ID3D12Fence* pFence, UINT64 Value) override
+		{
+			UpdateStats([](FNullBackendStats& stats) { stats.m_fenceSignals++; });
+			static_cast<FNullFence*>(pFence)->Complete(Value);
+			return S_OK;
+		}
+
+		HRESULT STDMETHODCALLTYPE Wait(ID3D12Fence* pFence, UINT64 Value) override
+		{
+			return S_OK;
+		}
+
+		HRESULT STDMETHODCALLTYPE GetTimestampFrequency(UINT64* pFrequency) override
+		{
+			*pFrequency = k_nullTimestampFrequency;
+			return S_OK;
+		}
+
+		HRESULT STDMETHODCALLTYPE GetClockCalibration(UINT64* pGpuTimestamp, UINT64* pCpuTimestamp) override
+		{
+			LARGE_INTEGER counter;
+			QueryPerformanceCounter(&counter);
+			*pGpuTimestamp = counter.QuadPart;
+			*pCpuTimestamp = counter.QuadPart;
+			return S_OK;
+		}
+
+		D3D12_COMMAND_QUEUE_DESC STDMETHODCALLTYPE GetDesc() override
+		{
+			return m_desc;
+		}
+
+	private:
+		D3D12_COMMAND_QUEUE_DESC m_desc;
+	};
+
+	class FNullDevice final : public TNullObject<
+		D3DDevice_t,
+		ID3D12Object,
+		ID3D12Device,
+		ID3D12Device1,
+		ID3D12Device2,
+		ID3D12Device3,
+		ID3D12Device4,
+		ID3D12Device5>
+	{
+	public:
+		// ID3D12Device
+		UINT STDMETHODCALLTYPE GetNodeCount() override { return 1; }
+
+		HRESULT STDMETHODCALLTYPE CreateCommandQueue(const D3D12_COMMAND_QUEUE_DESC* pDesc, REFIID riid, void** ppCommandQueue) override
+		{
+			return CreateNullObject<FNullCommandQueue>(riid, ppCommandQueue, *pDesc);
+		}
+
+		HRESULT STDMETHODCALLTYPE CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE type, REFIID riid, void** ppCommandAllocator) override
+		{
+			return CreateNullObject<FNullCommandAllocator>(riid, ppCommandAllocator);
+		}
+
+		HRESULT STDMETHODCALLTYPE CreateGraphicsPipelineState(const D3D12_GRAPHICS_PIPELINE_STATE_DESC* pDesc, REFIID riid, void** ppPipelineState) override
+		{
+			return CreateNullObject<FNullPipelineState>(riid, ppPipelineState);
+		}
+
+		HRESULT STDMETHODCALLTYPE CreateComputePipelineState(const D3D12_COMPUTE_PIPELINE_STATE_DESC* pDesc, REFIID riid, void** ppPipelineState) override
+		{
+			return CreateNullObject<FNullPipelineState>(riid, ppPipelineState);
+		}
+
+		HRESULT STDMETHODCALLTYPE CreateCommandList(UINT nodeMask, D3D12_COMMAND_LIST_TYPE type, ID3D12CommandAllocator* pCommandAllocator, ID3D12PipelineState* pInitialState, REFIID riid, void** ppCommandList) override
+		{
+			return CreateNullObject<FNullCommandList>(riid, ppCommandList, type);
+		}
+
+		HRESULT STDMETHODCALLTYPE CheckFeatureSupport(D3D12_FEATURE Feature, void* pFeatureSupportData, UINT FeatureSupportDataSize) override
+		{
+			switch (Feature)
+			{
+			case D3D12_FEATURE_D3D12_OPTIONS:
+			{
+				auto options = reinterpret_cast<D3D12_FEATURE_DATA_D3D12_OPTIONS*>(pFeatureSupportData);
+				*options = {};
+				options->TiledResourcesTier = D3D12_TILED_RESOURCES_TIER_1;
+				return S_OK;
+			}
+			case D3D12_FEATURE_D3D12_OPTIONS1:
+			{
+				auto options = reinterpret_cast<D3D12_FEATURE_DATA_D3D12_OPTIONS1*>(pFeatureSupportData);
+				*options = {};
+				options->WaveOps = TRUE;
+				options->WaveLaneCountMin = k_nullWaveLaneCount;
+				options->WaveLaneCountMax = k_nullWaveLaneCount;
+				options->TotalLaneCount = k_nullWaveLaneCount;
+				return S_OK;
+			}
+			default:
+				memset(pFeatureSupportData, 0, FeatureSupportDataSize);
+				return S_OK;
+			}
+		}
+
+		HRESULT STDMETHODCALLTYPE CreateDescriptorHeap(const D3D12_DESCRIPTOR_HEAP_DESC* pDescriptorHeapDesc, REFIID riid, void** ppvHeap) override
+		{
+			return CreateNullObject<FNullDescriptorHeap>(riid, ppvHeap, *pDescriptorHeapDesc);
+		}
+
+		UINT STDMETHODCALLTYPE GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE DescriptorHeapType) override
+		{
+			return k_nullDescriptorSize;
+		}
+
+		HRESULT STDMETHODCALLTYPE CreateRootSignature(UINT nodeMask, const void* pBlobWithRootSignature, SIZE_T blobLengthInBytes, REFIID riid, void** ppvRootSignature) override
+		{
+			return CreateNullObject<FNullRootSignature>(riid, ppvRootSignature);
+		}
+
+		void STDMETHODCALLTYPE CreateConstantBufferView(const D3D12_CONSTANT_BUFFER_VIEW_DESC* pDesc, D3D12_CPU_DESCRIPTOR_HANDLE DestDescriptor) override { CountDescriptor(); }
+		void STDMETHODCALLTYPE CreateShaderResourceView(ID3D12Resource* pResource, const D3D12_SHADER_RESOURCE_VIEW_DESC* pDesc, D3D12_CPU_DESCRIPTOR_HANDLE DestDescriptor) override { CountDescriptor(); }
+		void STDMETHODCALLTYPE CreateUnorderedAccessView(ID3D12Resource* pResource, ID3D12Resource* pCounterResource, const D3D12_UNORDERED_ACCESS_VIEW_DESC* pDesc, D3D12_CPU_DESCRIPTOR_HANDLE DestDescriptor) override { CountDescriptor(); }
+		void STDMETHODCALLTYPE CreateRenderTargetView(ID3D12Resource* pResource, const D3D12_RENDER_TARGET_VIEW_DESC* pDesc, D3D12_CPU_DESCRIPTOR_HANDLE DestDescriptor) override { CountDescriptor(); }
+		void STDMETHODCALLTYPE CreateDepthStencilView(ID3D12Resource* pResource, const D3D12_DEPTH_STENCIL_VIEW_DESC* pDesc, D3D12_CPU_DESCRIPTOR_HANDLE DestDescriptor) override { CountDescriptor(); }
+		void STDMETHODCALLTYPE CreateSampler(const D3D12_SAMPLER_DESC* pDesc, D3D12_CPU_DESCRIPTOR_HANDLE DestDescriptor) override { CountDescriptor(); }
+
+		void STDMETHODCALLTYPE CopyDescriptors(UINT NumDestDescriptorRanges, const D3D12_CPU_DESCRIPTOR_HANDLE* pDestDescriptorRangeStarts, const UINT* pDestDescriptorRangeSizes, UINT NumSrcDescriptorRanges, const D3D12_CPU_DESCRIPTOR_HANDLE* pSrcDescriptorRangeStarts, const UINT* pSrcDescriptorRangeSizes, D3D12_DESCRIPTOR_HEAP_TYPE DescriptorHeapsType) override
+		{
+		}
+
+		void STDMETHODCALLTYPE CopyDescriptorsSimple(UINT NumDescriptors, D3D12_CPU_DESCRIPTOR_HANDLE DestDescriptorRangeStart, D3D12_CPU_DESCRIPTOR_HANDLE SrcDescriptorRangeStart, D3D12_DESCRIPTOR_HEAP_TYPE DescriptorHeapsType) override
+		{
+		}
+
+		D3D12_RESOURCE_ALLOCATION_INFO STDMETHODCALLTYPE GetResourceAllocationInfo(UINT visibleMask, UINT numResourceDescs, const D3D12_RESOURCE_DESC* pResourceDescs) override
+		{
+			D3D12_RESOURCE_ALLOCATION_INFO info = { 0, D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT };
+			for (UINT i = 0; i < numResourceDescs; ++i)
+			{
+				info.SizeInBytes = AlignUp(info.SizeInBytes, info.Alignment) + AlignUp(ComputeResourceSize(pResourceDescs[i]), info.Alignment);
+			}
+
+			return info;
+		}
+
+		D3D12_HEAP_PROPERTIES STDMETHODCALLTYPE GetCustomHeapProperties(UINT nodeMask, D3D12_HEAP_TYPE heapType) override
+		{
+			D3D12_HEAP_PROPERTIES props = {};
+			props.Type = D3D12_HEAP_TYPE_CUSTOM;
+			return props;
+		}
+
+		HRESULT STDMETHODCALLTYPE CreateCommittedResource(const D3D12_HEAP_PROPERTIES* pHeapProperties, D3D12_HEAP_FLAGS HeapFlags, const D3D12_RESOURCE_DESC* pDesc, D3D12_RESOURCE_STATES InitialResourceState, const D3D12_CLEAR_VALUE* pOptimizedClearValue, REFIID riidResource, void** ppvResource) override
+		{
+			return CreateNullObject<FNullResource>(riidResource, ppvResource, *pDesc, pHeapProperties->Type, false);
+		}
+
+		HRESULT STDMETHODCALLTYPE CreateHeap(const D3D12_HEAP_DESC* pDesc, REFIID riid, void** ppvHeap) override
+		{
+			return CreateNullObject<FNullHeap>(riid, ppvHeap, *pDesc);
+		}
+
+		HRESULT STDMETHODCALLTYPE CreatePlacedResource(ID3D12Heap* pHeap, UINT64 HeapOffset, const D3D12_RESOURCE_DESC* pDesc, D3D12_RESOURCE_STATES InitialState, const D3D12_CLEAR_VALUE* pOptimizedClearValue, REFIID riid, void** ppvResource) override
+		{
+			// Memory is accounted for by the heap
+			return CreateNullObject<FNullResource>(riid, ppvResource, *pDesc, pHeap->GetDesc().Properties.Type, true);
+		}
+
+		HRESULT STDMETHODCALLTYPE CreateReservedResource(const D3D12_RESOURCE_DESC* pDesc, D3D12_RESOURCE_STATES InitialState, const D3D12_CLEAR_VALUE* pOptimizedClearValue, REFIID riid, void** ppvResource) override
+		{
+			// Memory is accounted for by the heaps that get mapped into the resource
+			return CreateNullObject<FNullResource>(riid, ppvResource, *pDesc, D3D12_HEAP_TYPE_DEFAULT, true);
+		}
+
+		HRESULT STDMETHODCALLTYPE CreateSharedHandle(ID3D12DeviceChild* pObject, const SECURITY_ATTRIBUTES* pAttributes, DWORD Access, LPCWSTR Name, HANDLE* pHandle) override { return E_NOTIMPL; }
+		HRESULT STDMETHODCALLTYPE OpenSharedHandle(HANDLE NTHandle, REFIID riid, void** ppvObj) override { return E_NOTIMPL; }
+		HRESULT STDMETHODCALLTYPE OpenSharedHandleByName(LPCWSTR Name, DWORD Access, HANDLE* pNTHandle) override { return E_NOTIMPL; }
+		HRESULT STDMETHODCALLTYPE MakeResident(UINT NumObjects, ID3D12Pageable* const* ppObjects) override { return S_OK; }
+		HRESULT STDMETHODCALLTYPE Evict(UINT NumObjects, ID3D12Pageable* const* ppObjects) override { return S_OK; }
+
+		HRESULT STDMETHODCALLTYPE CreateFence(UINT64 InitialValue, D3D12_FENCE_FLAGS Flags, REFIID riid, void** ppFence) override
+		{
+			return CreateNullObject<FNullFence>(riid, ppFence, InitialValue, Flags);
+		}
+
+		HRESULT STDMETHODCALLTYPE GetDeviceRemovedReason() override { return S_OK; }
+
+		void STDMETHODCALLTYPE GetCopyableFootprints(const D3D12_RESOURCE_DESC* pResourceDesc, UINT FirstSubresource, UINT NumSubresources, UINT64 BaseOffset, D3D12_PLACED_SUBRESOURCE_FOOTPRINT* pLayouts, UINT* pNumRows, UINT64* pRowSizeInBytes, UINT64* pTotalBytes) override
+		{
+			const uint64_t totalBytes = ComputeCopyableFootprints(*pResourceDesc, FirstSubresource, NumSubresources, BaseOffset, pLayouts, pNumRows, pRowSizeInBytes);
+			if (pTotalBytes)
+			{
+				*pTotalBytes = totalBytes;
+			}
+		}
+
+		HRESULT STDMETHODCALLTYPE CreateQueryHeap(const D3D12_QUERY_HEAP_DESC* pDesc, REFIID riid, void** ppvHeap) override
+		{
+			return CreateNullObject<FNullQueryHeap>(riid, ppvHeap);
+		}
+
+		HRESULT STDMETHODCALLTYPE SetStablePowerState(BOOL Enable) override { return S_OK; }
+		HRESULT STDMETHODCALLTYPE CreateCommandSignature(const D3D12_COMMAND_SIGNATURE_DESC* pDesc, ID3D12RootSignature* pRootSignature, REFIID riid, void** ppvCommandSignature) override { return E_NOTIMPL; }
+
+		void STDMETHODCALLTYPE GetResourceTiling(ID3D12Resource* pTiledResource, UINT* pNumTilesForEntireResource, D3D12_PACKED_MIP_INFO* pPackedMipDesc, D3D12_TILE_SHAPE* pStandardTileShapeForNonPackedMips, UINT* pNumSubresourceTilings, UINT FirstSubresourceTilingToGet, D3D12_SUBRESOURCE_TILING* pSubresourceTilingsForNonPackedMips) override
+		{
+			// Report every mip as packed so that callers map the whole resource in one go
+			const D3D12_RESOURCE_DESC desc = pTiledResource->GetDesc();
+			const UINT numTiles = (UINT)((ComputeResourceSize(desc) + D3D12_TILED_RESOURCE_TILE_SIZE_IN_BYTES - 1) / D3D12_TILED_RESOURCE_TILE_SIZE_IN_BYTES);
+
+			if (pNumTilesForEntireResource) *pNumTilesForEntireResource = numTiles;
+			if (pPackedMipDesc) *pPackedMipDesc = { 0, (UINT8)GetSubresourceCount(desc), numTiles, 0 };
+			if (pStandardTileShapeForNonPackedMips) *pStandardTileShapeForNonPackedMips = { 64, 64, 1 };
+			if (pNumSubresourceTilings) *pNumSubresourceTilings = 0;
+		}
+
+		LUID STDMETHODCALLTYPE GetAdapterLuid() override
+		{
+			return LUID{};
+		}
+
+		// ID3D12Device1
+		HRESULT STDMETHODCALLTYPE CreatePipelineLibrary(const void* pLibraryBlob, SIZE_T BlobLength, REFIID riid, void** ppPipelineLibrary) override { return E_NOTIMPL; }
+
+		HRESULT STDMETHODCALLTYPE SetEventOnMultipleFenceCompletion(ID3D12Fence* const* ppFences, const UINT64* pFenceValues, UINT NumFences, D3D12_MULTIPLE_FENCE_WAIT_FLAGS Flags, HANDLE hEvent) override
+		{
+			// Fences are signaled on submission so waiting on any of them amounts to checking the current values
+			bool signaled = (Flags == D3D12_MULTIPLE_FENCE_WAIT_FLAG_ALL);
+			for (UINT i = 0; i < NumFences; ++i)
+			{
+				const bool fenceSignaled = ppFences[i]->GetCompletedValue() >= pFenceValues[i];
+				signaled = (Flags == D3D12_MULTIPLE_FENCE_WAIT_FLAG_ALL) ? (signaled && fenceSignaled) : (signaled || fenceSignaled);
+			}
+
+			if (signaled && hEvent)
+			{
+				SetEvent(hEvent);
+			}
+
+			return S_OK;
+		}
+
+		HRESULT STDMETHODCALLTYPE SetResidencyPriority(UINT NumObjects, ID3D12Pageable* const* ppObjects, const D3D12_RESIDENCY_PRIORITY* pPriorities) override { return S_OK; }
+
+		// ID3D12Device2
+		HRESULT STDMETHODCALLTYPE CreatePipelineState(const D3D12_PIPELINE_STATE_STREAM_DESC* pDesc, REFIID riid, void** ppPipelineState) override
+		{
+			return CreateNullObject<FNullPipelineState>(riid, ppPipelineState);
+		}
+
+		// ID3D12Device3
+		HRESULT STDMETHODCALLTYPE OpenExistingHeapFromAddress(const void* pAddress, REFIID riid, void** ppvHeap) override { return E_NOTIMPL; }
+		HRESULT STDMETHODCALLTYPE OpenExistingHeapFromFileMapping(HANDLE hFileMapping, REFIID riid, void** ppvHeap) override { return E_NOTIMPL; }
+
+		HRESULT STDMETHODCALLTYPE EnqueueMakeResident(D3D12_RESIDENCY_FLAGS Flags, UINT NumObjects, ID3D12Pageable* const* ppObjects, ID3D12Fence* pFenceToSignal, UINT64 FenceValueToSignal) override
+		{
+			static_cast<FNullFence*>(pFenceToSignal)->Complete(FenceValueToSignal);
+			return S_OK;
+		}
+
+		// ID3D12Device4
+		HRESULT STDMETHODCALLTYPE CreateCommandList1(UINT nodeMask, D3D12_COMMAND_LIST_TYPE type, D3D12_COMMAND_LIST_FLAGS flags, REFIID riid, void** ppCommandList) override
+		{
+			HRESULT hr = CreateNullObject<FNullCommandList>(riid, ppCommandList, type);
+			if (SUCCEEDED(hr) && ppCommandList)
+			{
+				// CreateCommandList1 returns closed command lists
+				static_cast<ID3D12GraphicsCommandList*>(*ppCommandList)->Close();
+			}
+
+			return hr;
+		}
+
+		HRESULT STDMETHODCALLTYPE CreateProtectedResourceSession(const D3D12_PROTECTED_RESOURCE_SESSION_DESC* pDesc, REFIID riid, void** ppSession) override { return E_NOTIMPL; }
+
+		HRESULT STDMETHODCALLTYPE CreateCommittedResource1(const D3D12_HEAP_PROPERTIES* pHeapProperties, D3D12_HEAP_FLAGS HeapFlags, const D3D12_RESOURCE_DESC* pDesc, D3D12_RESOURCE_STATES InitialResourceState, const D3D12_CLEAR_VALUE* pOptimizedClearValue, ID3D12ProtectedResourceSession* pProtectedSession, REFIID riidResource, void** ppvResource) override
+		{
+			return CreateCommittedResource(pHeapProperties, HeapFlags, pDesc, InitialResourceState, pOptimizedClearValue, riidResource, ppvResource);
+		}
+
+		HRESULT STDMETHODCALLTYPE CreateHeap1(const D3D12_HEAP_DESC* pDesc, ID3D12ProtectedResourceSession* pProtectedSession, REFIID riid, void** ppvHeap) override
+		{
+			return CreateHeap(pDesc, riid, ppvHeap);
+		}
+
+		HRESULT STDMETHODCALLTYPE CreateReservedResource1(const D3D12_RESOURCE_DESC* pDesc, D3D12_RESOURCE_STATES InitialState, const D3D12_CLEAR_VALUE* pOptimizedClearValue, ID3D12ProtectedResourceSession* pProtectedSession, REFIID riid, void** ppvResource) override
+		{
+			return CreateReservedResource(pDesc, InitialState, pOptimizedClearValue, riid, ppvResource);
+		}
+
+		D3D12_RESOURCE_ALLOCATION_INFO STDMETHODCALLTYPE GetResourceAllocationInfo1(UINT visibleMask, UINT numResourceDescs, const D3D12_RESOURCE_DESC* pResourceDescs, D3D12_RESOURCE_ALLOCATION_INFO1* pResourceAllocationInfo1) override
+		{
+			return GetResourceAllocationInfo(visibleMask, numResourceDescs, pResourceDescs);
+		}
+
+		// ID3D12Device5
+		HRESULT STDMETHODCALLTYPE CreateLifetimeTracker(ID3D12LifetimeOwner* pOwner, REFIID riid, void** ppvTracker) override { return E_NOTIMPL; }
+		void STDMETHODCALLTYPE RemoveDevice() override {}
+
+		HRESULT STDMETHODCALLTYPE EnumerateMetaCommands(UINT* pNumMetaCommands, D3D12_META_COMMAND_DESC* pDescs) override
+		{
+			*pNumMetaCommands = 0;
+			return S_OK;
+		}
+
+		HRESULT STDMETHODCALLTYPE EnumerateMetaCommandParameters(REFGUID CommandId, D3D12_META_COMMAND_PARAMETER_STAGE Stage, UINT* pTotalStructureSizeInBytes, UINT* pParameterCount, D3D12_META_COMMAND_PARAMETER_DESC* pParameterDescs) override { return E_NOTIMPL; }
+		HRESULT STDMETHODCALLTYPE CreateMetaCommand(REFGUID CommandId, UINT NodeMask, const void* pCreationParametersData, SIZE_T CreationParametersDataSizeInBytes, REFIID riid, void** ppMetaCommand) override { return E_NOTIMPL; }
+		HRESULT STDMETHODCALLTYPE CreateStateObject(const D3D12_STATE_OBJECT_DESC* pDesc, REFIID riid, void** ppStateObject) override { return E_NOTIMPL; }
+
+		void STDMETHODCALLTYPE GetRaytracingAccelerationStructurePrebuildInfo(const D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_INPUTS* pDesc, D3D12_RAYTRACING_ACCELERATION_STRUCTURE_PREBUILD_INFO* pInfo) override
+		{
+			*pInfo = {};
+		}
+
+		D3D12_DRIVER_MATCHING_IDENTIFIER_STATUS STDMETHODCALLTYPE CheckDriverMatchingIdentifier(D3D12_SERIALIZED_DATA_TYPE SerializedDataType, const D3D12_SERIALIZED_DATA_DRIVER_MATCHING_IDENTIFIER* pIdentifierToCheck) override
+		{
+			return D3D12_DRIVER_MATCHING_IDENTIFIER_UNSUPPORTED_TYPE;
+		}
+
+	private:
+		void CountDescriptor()
+		{
+			UpdateStats([](FNullBackendStats& stats) { stats.m_createdDescriptors++; });
+		}
+	};
+
+	FNullDevice* s_nullDevice = nullptr;
+
+	HRESULT QueryNullDevice(REFIID riid, void** ppvDevice)
+	{
+		DebugAssert(s_nullDevice, "Null device has been released");
+		return s_nullDevice->QueryInterface(riid, ppvDevice);
+	}
+
+	FNullBackendStats GetStatsDelta(const FNullBackendStats& end, const FNullBackendStats& begin)
+	{
+		FNullBackendStats delta = end;
+		delta.m_frameCount = end.m_frameCount - begin.m_frameCount;
+		delta.m_executedCommandLists = end.m_executedCommandLists - begin.m_executedCommandLists;
+		delta.m_fenceSignals = end.m_fenceSignals - begin.m_fenceSignals;
+		delta.m_copiedBytes = end.m_copiedBytes - begin.m_copiedBytes;
+		delta.m_createdCommandLists = end.m_createdCommandLists - begin.m_createdCommandLists;
+		delta.m_createdResources = end.m_createdResources - begin.m_createdResources;
+		delta.m_createdPipelineStates = end.m_createdPipelineStates - begin.m_createdPipelineStates;
+		delta.m_createdDescriptors = end.m_createdDescriptors - begin.m_createdDescriptors;
+
+		for (size_t i = 0; i < (size_t)NullCommandType::Count; ++i)
+		{
+			delta.m_commandCount[i] = end.m_commandCount[i] - begin.m_commandCount[i];
+		}
+
+		return delta;
+	}
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------------------------
+//														NullBackend
+//-----------------------------------------------------------------------------------------------------------------------------------------------
+
+winrt::com_ptr<D3DDevice_t> NullBackend::CreateDevice()
+{
+	{
+		const std::lock_guard<std::mutex> lock(s_statsLock);
+		s_totalStats = {};
+		s_frameBeginStats = {};
+		s_lastFrameStats = {};
+		s_frameCommands.clear();
+		s_lastFrameCommands.clear();
+	}
+
+	s_nullDevice = new FNullDevice;
+
+	winrt::com_ptr<D3DDevice_t> device;
+	device.attach(s_nullDevice);
+	return device;
+}
+
+void NullBackend::Present()
+{
+	const std::lock_guard<std::mutex> lock(s_statsLock);
+
+	s_totalStats.m_frameCount++;
+	s_lastFrameStats = GetStatsDelta(s_totalStats, s_frameBeginStats);
+	s_frameBeginStats = s_totalStats;
+
+	s_lastFrameCommands.swap(s_frameCommands);
+	s_frameCommands.clear();
+}
+
+void NullBackend::Report()
+{
+	const FNullBackendStats total = GetTotalStats();
+	const double frameCount = (double)std::max<uint64_t>(total.m_frameCount, 1);
+
+	std::wstringstream out;
+	out << L"*** Null backend : " << total.m_frameCount << L" frames" << std::endl;
+	out << L"    draws/frame          : " << total.m_commandCount[(size_t)NullCommandType::Draw] / frameCount << std::endl;
+	out << L"    dispatches/frame     : " << total.m_commandCount[(size_t)NullCommandType::Dispatch] / frameCount << std::endl;
+	out << L"    barriers/frame       : " << total.m_commandCount[(size_t)NullCommandType::Barrier] / frameCount << std::endl;
+	out << L"    root args/frame      : " << total.m_commandCount[(size_t)NullCommandType::SetRootArgument] / frameCount << std::endl;
+	out << L"    PSO changes/frame    : " << total.m_commandCount[(size_t)NullCommandType::SetPipelineState] / frameCount << std::endl;
+	out << L"    copied bytes/frame   : " << total.m_copiedBytes / frameCount << std::endl;
+	out << L"    executed CLs         : " << total.m_executedCommandLists << std::endl;
+	out << L"    created CLs          : " << total.m_createdCommandLists << std::endl;
+	out << L"    created resources    : " << total.m_createdResources << std::endl;
+	out << L"    created PSOs         : " << total.m_createdPipelineStates << std::endl;
+	out << L"    created descriptors  : " << total.m_createdDescriptors << std::endl;
+	out << L"    live resources       : " << total.m_liveResources << L" (" << total.m_liveResourceBytes << L" bytes)" << std::endl;
+	out << L"    peak resource memory : " << total.m_peakResourceBytes << L" bytes" << std::endl;
+	OutputDebugString(out.str().c_str());
+}
+
+FNullBackendStats NullBackend::GetTotalStats()
+{
+	const std::lock_guard<std::mutex> lock(s_statsLock);
+	return s_totalStats;
+}
+
+FNullBackendStats NullBackend::GetLastFrameStats()
+{
+	const std::lock_guard<std::mutex> lock(s_statsLock);
+	return s_lastFrameStats;
+}
+
+std::vector<FNullCommand> NullBackend::GetLastFrameCommands()
+{
+	const std::lock_guard<std::mutex> lock(s_statsLock);
+	return s_lastFrameCommands;
+}
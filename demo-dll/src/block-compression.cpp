@@ -0,0 +1,1486 @@
+#include <block-compression.h>
+#include <ppl.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <vector>
+
+#define STB_DXT_STATIC
+#define STB_DXT_IMPLEMENTATION
+#include <stb_dxt.h>
+
+#if defined(_M_X64) || defined(__x86_64__)
+#define BLOCK_COMPRESSION_X64 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define AVX2_TARGET
+#define SSE41_TARGET
+#else
+#define AVX2_TARGET __attribute__((target("avx2,fma")))
+#define SSE41_TARGET __attribute__((target("sse4.1")))
+#endif
+#elif defined(_M_ARM64) || defined(__aarch64__)
+#define BLOCK_COMPRESSION_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace
+{
+	constexpr uint32_t k_refineIterations = 2;
+	constexpr uint32_t k_bc7PartitionCandidates = 4; // BC7 mode 1 partitions encoded after the estimation pass
+
+	// 16 pixels stored per channel so that kernels can process several pixels per register
+	struct FBlock
+	{
+		alignas(32) float m_pixels[4][16];
+	};
+
+	struct FPalette
+	{
+		alignas(32) float m_values[4][16];
+		uint32_t m_size;
+	};
+
+	// Writes the index of the nearest palette entry for every pixel, over the channels [firstChannel, firstChannel + channelCount).
+	// Returns the squared error of the pixels in pixelMask.
+	using FitFunction = float(*)(
+		const FBlock& block,
+		const FPalette& palette,
+		const uint32_t firstChannel,
+		const uint32_t channelCount,
+		const uint32_t pixelMask,
+		uint8_t indices[16]);
+
+	float FitScalar(const FBlock& block, const FPalette& palette, const uint32_t firstChannel, const uint32_t channelCount, const uint32_t pixelMask, uint8_t indices[16])
+	{
+		float error = 0.f;
+		for (uint32_t pixel = 0; pixel < 16; ++pixel)
+		{
+			float bestDistance = std::numeric_limits<float>::max();
+			for (uint32_t entry = 0; entry < palette.m_size; ++entry)
+			{
+				float distance = 0.f;
+				for (uint32_t c = firstChannel; c < firstChannel + channelCount; ++c)
+				{
+					const float delta = block.m_pixels[c][pixel] - palette.m_values[c][entry];
+					distance += delta * delta;
+				}
+
+				if (distance < bestDistance)
+				{
+					bestDistance = distance;
+					indices[pixel] = (uint8_t)entry;
+				}
+			}
+
+			error += (pixelMask >> pixel) & 1 ? bestDistance : 0.f;
+		}
+
+		return error;
+	}
+
+#if BLOCK_COMPRESSION_X64
+	bool CpuSupportsAvx2()
+	{
+#if defined(_MSC_VER)
+		int info[4];
+		__cpuid(info, 0);
+		if (info[0] < 7)
+		{
+			return false;
+		}
+
+		__cpuid(info, 1);
+		const bool fma = (info[2] & (1 << 12)) != 0;
+		const bool osxsave = (info[2] & (1 << 27)) != 0;
+		if (!fma || !osxsave || (_xgetbv(0) & 0x6) != 0x6)
+		{
+			return false;
+		}
+
+		__cpuidex(info, 7, 0);
+		return (info[1] & (1 << 5)) != 0;
+#else
+		return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#endif
+	}
+
+	bool CpuSupportsSse41()
+	{
+#if defined(_MSC_VER)
+		int info[4];
+		__cpuid(info, 1);
+		return (info[2] & (1 << 19)) != 0;
+#else
+		return __builtin_cpu_supports("sse4.1");
+#endif
+	}
+
+	AVX2_TARGET float FitAvx2(const FBlock& block, const FPalette& palette, const uint32_t firstChannel, const uint32_t channelCount, const uint32_t pixelMask, uint8_t indices[16])
+	{
+		const __m256i laneBits = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+
+		float error = 0.f;
+		for (uint32_t half = 0; half < 2; ++half)
+		{
+			__m256 pixels[4];
+			for (uint32_t c = 0; c < channelCount; ++c)
+			{
+				pixels[c] = _mm256_load_ps(&block.m_pixels[firstChannel + c][8 * half]);
+			}
+
+			__m256 bestDistance = _mm256_set1_ps(std::numeric_limits<float>::max());
+			__m256 bestIndex = _mm256_setzero_ps();
+			for (uint32_t entry = 0; entry < palette.m_size; ++entry)
+			{
+				__m256 distance = _mm256_setzero_ps();
+				for (uint32_t c = 0; c < channelCount; ++c)
+				{
+					const __m256 delta = _mm256_sub_ps(pixels[c], _mm256_set1_ps(palette.m_values[firstChannel + c][entry]));
+					distance = _mm256_fmadd_ps(delta, delta, distance);
+				}
+
+				const __m256 closer = _mm256_cmp_ps(distance, bestDistance, _CMP_LT_OQ);
+				bestDistance = _mm256_min_ps(distance, bestDistance);
+				bestIndex = _mm256_blendv_ps(bestIndex, _mm256_castsi256_ps(_mm256_set1_epi32(entry)), closer);
+			}
+
+			const __m256i inMask = _mm256_cmpeq_epi32(_mm256_and_si256(_mm256_set1_epi32(pixelMask >> (8 * half)), laneBits), laneBits);
+			bestDistance = _mm256_and_ps(bestDistance, _mm256_castsi256_ps(inMask));
+
+			alignas(32) float distances[8];
+			alignas(32) int32_t laneIndices[8];
+			_mm256_store_ps(distances, bestDistance);
+			_mm256_store_si256((__m256i*)laneIndices, _mm256_castps_si256(bestIndex));
+			for (uint32_t lane = 0; lane < 8; ++lane)
+			{
+				error += distances[lane];
+				indices[8 * half + lane] = (uint8_t)laneIndices[lane];
+			}
+		}
+
+		return error;
+	}
+
+	SSE41_TARGET float FitSse41(const FBlock& block, const FPalette& palette, const uint32_t firstChannel, const uint32_t channelCount, const uint32_t pixelMask, uint8_t indices[16])
+	{
+		const __m128i laneBits = _mm_setr_epi32(1, 2, 4, 8);
+
+		float error = 0.f;
+		for (uint32_t quarter = 0; quarter < 4; ++quarter)
+		{
+			__m128 pixels[4];
+			for (uint32_t c = 0; c < channelCount; ++c)
+			{
+				pixels[c] = _mm_load_ps(&block.m_pixels[firstChannel + c][4 * quarter]);
+			}
+
+			__m128 bestDistance = _mm_set1_ps(std::numeric_limits<float>::max());
+			__m128 bestIndex = _mm_setzero_ps();
+			for (uint32_t entry = 0; entry < palette.m_size; ++entry)
+			{
+				__m128 distance = _mm_setzero_ps();
+				for (uint32_t c = 0; c < channelCount; ++c)
+				{
+					const __m128 delta = _mm_sub_ps(pixels[c], _mm_set1_ps(palette.m_values[firstChannel + c][entry]));
+					distance = _mm_add_ps(_mm_mul_ps(delta, delta), distance);
+				}
+
+				const __m128 closer = _mm_cmplt_ps(distance, bestDistance);
+				bestDistance = _mm_min_ps(distance, bestDistance);
+				bestIndex = _mm_blendv_ps(bestIndex, _mm_castsi128_ps(_mm_set1_epi32(entry)), closer);
+			}
+
+			const __m128i inMask = _mm_cmpeq_epi32(_mm_and_si128(_mm_set1_epi32(pixelMask >> (4 * quarter)), laneBits), laneBits);
+			bestDistance = _mm_and_ps(bestDistance, _mm_castsi128_ps(inMask));
+
+			alignas(16) float distances[4];
+			alignas(16) int32_t laneIndices[4];
+			_mm_store_ps(distances, bestDistance);
+			_mm_store_si128((__m128i*)laneIndices, _mm_castps_si128(bestIndex));
+			for (uint32_t lane = 0; lane < 4; ++lane)
+			{
+				error += distances[lane];
+				indices[4 * quarter + lane] = (uint8_t)laneIndices[lane];
+			}
+		}
+
+		return error;
+	}
+#elif BLOCK_COMPRESSION_NEON
+	float FitNeon(const FBlock& block, const FPalette& palette, const uint32_t firstChannel, const uint32_t channelCount, const uint32_t pixelMask, uint8_t indices[16])
+	{
+		const uint32_t laneBitValues[4] = { 1, 2, 4, 8 };
+		const uint32x4_t laneBits = vld1q_u32(laneBitValues);
+
+		float error = 0.f;
+		for (uint32_t quarter = 0; quarter < 4; ++quarter)
+		{
+			float32x4_t pixels[4];
+			for (uint32_t c = 0; c < channelCount; ++c)
+			{
+				pixels[c] = vld1q_f32(&block.m_pixels[firstChannel + c][4 * quarter]);
+			}
+
+			float32x4_t bestDistance = vdupq_n_f32(std::numeric_limits<float>::max());
+			uint32x4_t bestIndex = vdupq_n_u32(0);
+			for (uint32_t entry = 0; entry < palette.m_size; ++entry)
+			{
+				float32x4_t distance = vdupq_n_f32(0.f);
+				for (uint32_t c = 0; c < channelCount; ++c)
+				{
+					const float32x4_t delta = vsubq_f32(pixels[c], vdupq_n_f32(palette.m_values[firstChannel + c][entry]));
+					distance = vfmaq_f32(distance, delta, delta);
+				}
+
+				const uint32x4_t closer = vcltq_f32(distance, bestDistance);
+				bestDistance = vminq_f32(distance, bestDistance);
+				bestIndex = vbslq_u32(closer, vdupq_n_u32(entry), bestIndex);
+			}
+
+			const uint32x4_t inMask = vtstq_u32(vdupq_n_u32(pixelMask >> (4 * quarter)), laneBits);
+			error += vaddvq_f32(vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(bestDistance), inMask)));
+
+			uint32_t laneIndices[4];
+			vst1q_u32(laneIndices, bestIndex);
+			for (uint32_t lane = 0; lane < 4; ++lane)
+			{
+				indices[4 * quarter + lane] = (uint8_t)laneIndices[lane];
+			}
+		}
+
+		return error;
+	}
+#endif
+
+	FitFunction GetSimdFitFunction()
+	{
+#if BLOCK_COMPRESSION_X64
+		static const FitFunction fit = CpuSupportsAvx2() ? FitAvx2 : CpuSupportsSse41() ? FitSse41 : nullptr;
+		return fit;
+#elif BLOCK_COMPRESSION_NEON
+		return FitNeon;
+#else
+		return nullptr;
+#endif
+	}
+
+	FitFunction GetFitFunction(const bool allowSimd)
+	{
+		const FitFunction simd = allowSimd ? GetSimdFitFunction() : nullptr;
+		return simd ? simd : FitScalar;
+	}
+
+	//-------------------------------------------------------------------------------------------------------------------------------------------
+	// Endpoint fitting shared by every format
+	//-------------------------------------------------------------------------------------------------------------------------------------------
+
+	// Mean of the pixels in pixelMask and the direction along which they vary the most, zero if they are all equal
+	void GetPrincipalAxis(const FBlock& block, const uint32_t firstChannel, const uint32_t channelCount, const uint32_t pixelMask, float mean[4], float axis[4])
+	{
+		float count = 0.f;
+		for (uint32_t c = 0; c < 4; ++c)
+		{
+			mean[c] = 0.f;
+			axis[c] = 0.f;
+		}
+
+		for (uint32_t pixel = 0; pixel < 16; ++pixel)
+		{
+			if ((pixelMask >> pixel) & 1)
+			{
+				count += 1.f;
+				for (uint32_t c = 0; c < channelCount; ++c)
+				{
+					mean[c] += block.m_pixels[firstChannel + c][pixel];
+				}
+			}
+		}
+
+		if (count == 0.f)
+		{
+			return;
+		}
+
+		for (uint32_t c = 0; c < channelCount; ++c)
+		{
+			mean[c] /= count;
+		}
+
+		float covariance[4][4] = {};
+		for (uint32_t pixel = 0; pixel < 16; ++pixel)
+		{
+			if ((pixelMask >> pixel) & 1)
+			{
+				for (uint32_t i = 0; i < channelCount; ++i)
+				{
+					const float di = block.m_pixels[firstChannel + i][pixel] - mean[i];
+					for (uint32_t j = i; j < channelCount; ++j)
+					{
+						covariance[i][j] += di * (block.m_pixels[firstChannel + j][pixel] - mean[j]);
+					}
+				}
+			}
+		}
+
+		// Power iteration starting from the column of the channel with the largest variance
+		uint32_t largest = 0;
+		for (uint32_t i = 0; i < channelCount; ++i)
+		{
+			for (uint32_t j = 0; j < i; ++j)
+			{
+				covariance[i][j] = covariance[j][i];
+			}
+
+			largest = covariance[i][i] > covariance[largest][largest] ? i : largest;
+		}
+
+		if (covariance[largest][largest] <= 0.f)
+		{
+			return;
+		}
+
+		for (uint32_t c = 0; c < channelCount; ++c)
+		{
+			axis[c] = covariance[c][largest];
+		}
+
+		for (int iteration = 0; iteration < 8; ++iteration)
+		{
+			float next[4] = {};
+			float norm = 0.f;
+			for (uint32_t i = 0; i < channelCount; ++i)
+			{
+				for (uint32_t j = 0; j < channelCount; ++j)
+				{
+					next[i] += covariance[i][j] * axis[j];
+				}
+
+				norm = std::max(norm, std::abs(next[i]));
+			}
+
+			if (norm == 0.f)
+			{
+				break;
+			}
+
+			for (uint32_t c = 0; c < channelCount; ++c)
+			{
+				axis[c] = next[c] / norm;
+			}
+		}
+
+		float length = 0.f;
+		for (uint32_t c = 0; c < channelCount; ++c)
+		{
+			length += axis[c] * axis[c];
+		}
+
+		length = std::sqrt(length);
+		for (uint32_t c = 0; c < channelCount; ++c)
+		{
+			axis[c] = length > 0.f ? axis[c] / length : 0.f;
+		}
+	}
+
+	// Endpoints at the extremes of the projection of the pixels on their principal axis
+	void GetAxisEndpoints(const FBlock& block, const uint32_t firstChannel, const uint32_t channelCount, const uint32_t pixelMask, float endpoint0[4], float endpoint1[4])
+	{
+		float mean[4], axis[4];
+		GetPrincipalAxis(block, firstChannel, channelCount, pixelMask, mean, axis);
+
+		float minT = 0.f, maxT = 0.f;
+		for (uint32_t pixel = 0; pixel < 16; ++pixel)
+		{
+			if ((pixelMask >> pixel) & 1)
+			{
+				float t = 0.f;
+				for (uint32_t c = 0; c < channelCount; ++c)
+				{
+					t += (block.m_pixels[firstChannel + c][pixel] - mean[c]) * axis[c];
+				}
+
+				minT = std::min(minT, t);
+				maxT = std::max(maxT, t);
+			}
+		}
+
+		for (uint32_t c = 0; c < channelCount; ++c)
+		{
+			endpoint0[c] = std::clamp(mean[c] + minT * axis[c], 0.f, 255.f);
+			endpoint1[c] = std::clamp(mean[c] + maxT * axis[c], 0.f, 255.f);
+		}
+	}
+
+	// Least squares endpoints for the current indices, where index i interpolates the endpoints with weights[i] in [0, 1].
+	// Returns false if the indices all have the same weight, in which case the system has no unique solution.
+	bool SolveEndpoints(
+		const FBlock& block,
+		const uint32_t firstChannel,
+		const uint32_t channelCount,
+		const uint32_t pixelMask,
+		const uint8_t indices[16],
+		const float* weights,
+		float endpoint0[4],
+		float endpoint1[4])
+	{
+		float a = 0.f, b = 0.f, c = 0.f;
+		float x[4] = {}, y[4] = {};
+		for (uint32_t pixel = 0; pixel < 16; ++pixel)
+		{
+			if ((pixelMask >> pixel) & 1)
+			{
+				const float t = weights[indices[pixel]];
+				a += (1.f - t) * (1.f - t);
+				b += t * (1.f - t);
+				c += t * t;
+				for (uint32_t channel = 0; channel < channelCount; ++channel)
+				{
+					const float value = block.m_pixels[firstChannel + channel][pixel];
+					x[channel] += (1.f - t) * value;
+					y[channel] += t * value;
+				}
+			}
+		}
+
+		const float determinant = a * c - b * b;
+		if (std::abs(determinant) < 1e-6f)
+		{
+			return false;
+		}
+
+		for (uint32_t channel = 0; channel < channelCount; ++channel)
+		{
+			endpoint0[channel] = std::clamp((c * x[channel] - b * y[channel]) / determinant, 0.f, 255.f);
+			endpoint1[channel] = std::clamp((a * y[channel] - b * x[channel]) / determinant, 0.f, 255.f);
+		}
+
+		return true;
+	}
+
+	void LoadBlock(const uint8_t* rgba, FBlock& block)
+	{
+		for (uint32_t pixel = 0; pixel < 16; ++pixel)
+		{
+			for (uint32_t c = 0; c < 4; ++c)
+			{
+				block.m_pixels[c][pixel] = rgba[4 * pixel + c];
+			}
+		}
+	}
+
+	void WriteIndices(uint8_t* dest, const uint8_t indices[16], const uint32_t bitsPerIndex)
+	{
+		uint64_t bits = 0;
+		for (uint32_t pixel = 0; pixel < 16; ++pixel)
+		{
+			bits |= uint64_t(indices[pixel]) << (bitsPerIndex * pixel);
+		}
+
+		for (uint32_t i = 0; i < 2 * bitsPerIndex; ++i)
+		{
+			dest[i] = uint8_t(bits >> (8 * i));
+		}
+	}
+
+	uint64_t ReadBits(const uint8_t* src, const uint32_t byteCount)
+	{
+		uint64_t bits = 0;
+		for (uint32_t i = 0; i < byteCount; ++i)
+		{
+			bits |= uint64_t(src[i]) << (8 * i);
+		}
+
+		return bits;
+	}
+
+	//-------------------------------------------------------------------------------------------------------------------------------------------
+	// BC1
+	//-------------------------------------------------------------------------------------------------------------------------------------------
+
+	constexpr float k_bc1Weights[4] = { 0.f, 1.f, 1.f / 3.f, 2.f / 3.f };
+
+	uint16_t QuantizeRgb565(const float color[3])
+	{
+		const uint32_t r = (uint32_t)std::lround(color[0] * 31.f / 255.f);
+		const uint32_t g = (uint32_t)std::lround(color[1] * 63.f / 255.f);
+		const uint32_t b = (uint32_t)std::lround(color[2] * 31.f / 255.f);
+		return uint16_t(r << 11 | g << 5 | b);
+	}
+
+	void DecodeBc1Colors(const uint16_t color0, const uint16_t color1, uint8_t colors[4][4])
+	{
+		for (uint32_t i = 0; i < 2; ++i)
+		{
+			const uint16_t color = i == 0 ? color0 : color1;
+			const uint32_t r = color >> 11, g = (color >> 5) & 63, b = color & 31;
+			colors[i][0] = uint8_t(r << 3 | r >> 2);
+			colors[i][1] = uint8_t(g << 2 | g >> 4);
+			colors[i][2] = uint8_t(b << 3 | b >> 2);
+			colors[i][3] = 255;
+		}
+
+		for (uint32_t c = 0; c < 3; ++c)
+		{
+			colors[2][c] = color0 > color1 ? uint8_t((2 * colors[0][c] + colors[1][c] + 1) / 3) : uint8_t((colors[0][c] + colors[1][c] + 1) / 2);
+			colors[3][c] = color0 > color1 ? uint8_t((colors[0][c] + 2 * colors[1][c] + 1) / 3) : 0;
+		}
+
+		colors[2][3] = 255;
+		colors[3][3] = color0 > color1 ? 255 : 0;
+	}
+
+	struct FBc1Candidate
+	{
+		float m_error = std::numeric_limits<float>::max();
+		uint16_t m_color0;
+		uint16_t m_color1;
+		uint8_t m_indices[16];
+	};
+
+	// Opaque blocks only use the four color mode, the three color mode decodes index 3 as transparent black
+	void TryBc1Endpoints(const FBlock& block, const float endpoint0[3], const float endpoint1[3], const FitFunction fit, FBc1Candidate& best)
+	{
+		uint16_t color0 = QuantizeRgb565(endpoint0);
+		uint16_t color1 = QuantizeRgb565(endpoint1);
+		if (color0 < color1)
+		{
+			std::swap(color0, color1);
+		}
+
+		uint8_t colors[4][4];
+		DecodeBc1Colors(color0, color1, colors);
+
+		FPalette palette;
+		palette.m_size = color0 == color1 ? 1 : 4;
+		for (uint32_t entry = 0; entry < 4; ++entry)
+		{
+			for (uint32_t c = 0; c < 3; ++c)
+			{
+				palette.m_values[c][entry] = colors[entry][c];
+			}
+		}
+
+		FBc1Candidate candidate;
+		candidate.m_color0 = color0;
+		candidate.m_color1 = color1;
+		candidate.m_error = fit(block, palette, 0, 3, 0xffff, candidate.m_indices);
+		if (candidate.m_error < best.m_error)
+		{
+			best = candidate;
+		}
+	}
+
+	// Endpoint pairs whose first interpolated value is nearest to each 8 bit value, for blocks of a single color that the
+	// endpoints alone cannot represent
+	struct FBc1SingleColorTable
+	{
+		FBc1SingleColorTable()
+		{
+			for (uint32_t channel = 0; channel < 2; ++channel)
+			{
+				const uint32_t bits = channel == 0 ? 5 : 6;
+				for (uint32_t value = 0; value < 256; ++value)
+				{
+					uint32_t bestError = 256;
+					for (uint32_t a = 0; a < (1u << bits); ++a)
+					{
+						for (uint32_t b = 0; b < (1u << bits); ++b)
+						{
+							const uint32_t expandedA = a << (8 - bits) | a >> (2 * bits - 8);
+							const uint32_t expandedB = b << (8 - bits) | b >> (2 * bits - 8);
+							const uint32_t error = (uint32_t)std::abs(int((2 * expandedA + expandedB + 1) / 3) - int(value));
+							if (error < bestError)
+							{
+								bestError = error;
+								m_endpoints[channel][value][0] = uint8_t(a);
+								m_endpoints[channel][value][1] = uint8_t(b);
+							}
+						}
+					}
+				}
+			}
+		}
+
+		uint8_t m_endpoints[2][256][2]; // 5 bit red and blue, 6 bit green
+	};
+
+	bool CompressBc1SingleColor(const FBlock& block, uint8_t* dest)
+	{
+		for (uint32_t c = 0; c < 3; ++c)
+		{
+			if (std::any_of(block.m_pixels[c] + 1, block.m_pixels[c] + 16, [&](const float value) { return value != block.m_pixels[c][0]; }))
+			{
+				return false;
+			}
+		}
+
+		static const FBc1SingleColorTable s_table;
+		const auto& red = s_table.m_endpoints[0][uint32_t(block.m_pixels[0][0])];
+		const auto& green = s_table.m_endpoints[1][uint32_t(block.m_pixels[1][0])];
+		const auto& blue = s_table.m_endpoints[0][uint32_t(block.m_pixels[2][0])];
+		uint16_t color0 = uint16_t(red[0] << 11 | green[0] << 5 | blue[0]);
+		uint16_t color1 = uint16_t(red[1] << 11 | green[1] << 5 | blue[1]);
+
+		// Index 2 is two thirds of color0, index 3 two thirds of color1 once they are swapped
+		uint8_t index = 2;
+		if (color0 < color1)
+		{
+			std::swap(color0, color1);
+			index = 3;
+		}
+		else if (color0 == color1)
+		{
+			index = 0;
+		}
+
+		uint8_t indices[16];
+		std::fill_n(indices, 16, index);
+		dest[0] = uint8_t(color0);
+		dest[1] = uint8_t(color0 >> 8);
+		dest[2] = uint8_t(color1);
+		dest[3] = uint8_t(color1 >> 8);
+		WriteIndices(dest + 4, indices, 2);
+		return true;
+	}
+
+	void CompressBc1(const FBlock& block, uint8_t* dest, const FitFunction fit)
+	{
+		if (CompressBc1SingleColor(block, dest))
+		{
+			return;
+		}
+
+		float endpoint0[4], endpoint1[4];
+		GetAxisEndpoints(block, 0, 3, 0xffff, endpoint0, endpoint1);
+
+		FBc1Candidate best;
+		TryBc1Endpoints(block, endpoint0, endpoint1, fit, best);
+		for (uint32_t iteration = 0; iteration < k_refineIterations && best.m_error > 0.f; ++iteration)
+		{
+			if (!SolveEndpoints(block, 0, 3, 0xffff, best.m_indices, k_bc1Weights, endpoint0, endpoint1))
+			{
+				break;
+			}
+
+			TryBc1Endpoints(block, endpoint0, endpoint1, fit, best);
+		}
+
+		dest[0] = uint8_t(best.m_color0);
+		dest[1] = uint8_t(best.m_color0 >> 8);
+		dest[2] = uint8_t(best.m_color1);
+		dest[3] = uint8_t(best.m_color1 >> 8);
+		WriteIndices(dest + 4, best.m_indices, 2);
+	}
+
+	void DecompressBc1(const uint8_t* src, uint8_t* rgba)
+	{
+		uint8_t colors[4][4];
+		DecodeBc1Colors(uint16_t(src[0] | src[1] << 8), uint16_t(src[2] | src[3] << 8), colors);
+
+		const uint64_t indices = ReadBits(src + 4, 4);
+		for (uint32_t pixel = 0; pixel < 16; ++pixel)
+		{
+			std::copy_n(colors[(indices >> (2 * pixel)) & 3], 4, rgba + 4 * pixel);
+		}
+	}
+
+	//-------------------------------------------------------------------------------------------------------------------------------------------
+	// BC4, also the alpha block of BC3 and the two blocks of BC5
+	//-------------------------------------------------------------------------------------------------------------------------------------------
+
+	constexpr float k_bc4Weights[8] = { 0.f, 1.f, 1.f / 7.f, 2.f / 7.f, 3.f / 7.f, 4.f / 7.f, 5.f / 7.f, 6.f / 7.f };
+
+	void DecodeBc4Values(const uint8_t value0, const uint8_t value1, uint8_t values[8])
+	{
+		values[0] = value0;
+		values[1] = value1;
+		if (value0 > value1)
+		{
+			for (uint32_t i = 2; i < 8; ++i)
+			{
+				values[i] = uint8_t(((8 - i) * value0 + (i - 1) * value1 + 3) / 7);
+			}
+		}
+		else
+		{
+			for (uint32_t i = 2; i < 6; ++i)
+			{
+				values[i] = uint8_t(((6 - i) * value0 + (i - 1) * value1 + 2) / 5);
+			}
+
+			values[6] = 0;
+			values[7] = 255;
+		}
+	}
+
+	struct FBc4Candidate
+	{
+		float m_error = std::numeric_limits<float>::max();
+		uint8_t m_value0;
+		uint8_t m_value1;
+		uint8_t m_indices[16];
+	};
+
+	void TryBc4Endpoints(const FBlock& block, const uint32_t channel, const uint8_t value0, const uint8_t value1, const FitFunction fit, FBc4Candidate& best)
+	{
+		uint8_t values[8];
+		DecodeBc4Values(value0, value1, values);
+
+		FPalette palette;
+		palette.m_size = 8;
+		for (uint32_t entry = 0; entry < 8; ++entry)
+		{
+			palette.m_values[channel][entry] = values[entry];
+		}
+
+		FBc4Candidate candidate;
+		candidate.m_value0 = value0;
+		candidate.m_value1 = value1;
+		candidate.m_error = fit(block, palette, channel, 1, 0xffff, candidate.m_indices);
+		if (candidate.m_error < best.m_error)
+		{
+			best = candidate;
+		}
+	}
+
+	void CompressBc4(const FBlock& block, const uint32_t channel, uint8_t* dest, const FitFunction fit)
+	{
+		const float* values = block.m_pixels[channel];
+		const auto [minValue, maxValue] = std::minmax_element(values, values + 16);
+
+		// Eight interpolated values between the extremes
+		FBc4Candidate best;
+		TryBc4Endpoints(block, channel, uint8_t(*maxValue), uint8_t(*minValue), fit, best);
+		for (uint32_t iteration = 0; iteration < k_refineIterations && best.m_error > 0.f && best.m_value0 > best.m_value1; ++iteration)
+		{
+			float value0, value1;
+			if (!SolveEndpoints(block, channel, 1, 0xffff, best.m_indices, k_bc4Weights, &value0, &value1))
+			{
+				break;
+			}
+
+			const uint8_t quantized0 = uint8_t(std::lround(value0)), quantized1 = uint8_t(std::lround(value1));
+			TryBc4Endpoints(block, channel, std::max(quantized0, quantized1), std::min(quantized0, quantized1), fit, best);
+		}
+
+		// Six interpolated values plus exact 0 and 255, for blocks whose extremes are far from the rest of the pixels
+		if (best.m_error > 0.f && (*minValue == 0.f || *maxValue == 255.f))
+		{
+			float innerMin = 255.f, innerMax = 0.f;
+			for (uint32_t pixel = 0; pixel < 16; ++pixel)
+			{
+				if (values[pixel] != 0.f && values[pixel] != 255.f)
+				{
+					innerMin = std::min(innerMin, values[pixel]);
+					innerMax = std::max(innerMax, values[pixel]);
+				}
+			}
+
+			if (innerMin <= innerMax)
+			{
+				TryBc4Endpoints(block, channel, uint8_t(innerMin), uint8_t(innerMax), fit, best);
+			}
+		}
+
+		dest[0] = best.m_value0;
+		dest[1] = best.m_value1;
+		WriteIndices(dest + 2, best.m_indices, 3);
+	}
+
+	void DecompressBc4(const uint8_t* src, uint8_t* rgba, const uint32_t channel)
+	{
+		uint8_t values[8];
+		DecodeBc4Values(src[0], src[1], values);
+
+		const uint64_t indices = ReadBits(src + 2, 6);
+		for (uint32_t pixel = 0; pixel < 16; ++pixel)
+		{
+			rgba[4 * pixel + channel] = values[(indices >> (3 * pixel)) & 7];
+		}
+	}
+
+	//-------------------------------------------------------------------------------------------------------------------------------------------
+	// BC7
+	//-------------------------------------------------------------------------------------------------------------------------------------------
+
+	constexpr uint32_t k_bc7Weights3[8] = { 0, 9, 18, 27, 37, 46, 55, 64 };
+	constexpr uint32_t k_bc7Weights4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+	// Pixels of the second subset of the two subset partitions, bit i for pixel i
+	constexpr uint16_t k_bc7Partitions2[64] =
+	{
+		0xcccc, 0x8888, 0xeeee, 0xecc8, 0xc880, 0xfeec, 0xfec8, 0xec80,
+		0xc800, 0xffec, 0xfe80, 0xe800, 0xffe8, 0xff00, 0xfff0, 0xf000,
+		0xf710, 0x008e, 0x7100, 0x08ce, 0x008c, 0x7310, 0x3100, 0x8cce,
+		0x088c, 0x3110, 0x6666, 0x366c, 0x17e8, 0x0ff0, 0x718e, 0x399c,
+		0xaaaa, 0xf0f0, 0x5a5a, 0x33cc, 0x3c3c, 0x55aa, 0x9696, 0xa55a,
+		0x73ce, 0x13c8, 0x324c, 0x3bdc, 0x6996, 0xc33c, 0x9966, 0x0660,
+		0x0272, 0x04e4, 0x4e40, 0x2720, 0xc936, 0x936c, 0x39c6, 0x639c,
+		0x9336, 0x9cc6, 0x817e, 0xe718, 0xccf0, 0x0fcc, 0x7744, 0xee22
+	};
+
+	// Anchor pixel of the second subset, whose index has an implicit zero high bit like pixel 0 for the first subset
+	constexpr uint8_t k_bc7Anchors2[64] =
+	{
+		15, 15, 15, 15, 15, 15, 15, 15,
+		15, 15, 15, 15, 15, 15, 15, 15,
+		15,  2,  8,  2,  2,  8,  8, 15,
+		 2,  8,  2,  2,  8,  8,  2,  2,
+		15, 15,  6,  8,  2,  8, 15, 15,
+		 2,  8,  2,  2,  2, 15, 15,  6,
+		 6,  2,  6,  8, 15, 15,  2,  2,
+		15, 15, 15, 15, 15,  2,  2, 15
+	};
+
+	struct FBitWriter
+	{
+		void Write(const uint32_t value, const uint32_t bitCount)
+		{
+			for (uint32_t i = 0; i < bitCount; ++i, ++m_offset)
+			{
+				m_dest[m_offset >> 3] |= uint8_t(((value >> i) & 1) << (m_offset & 7));
+			}
+		}
+
+		uint8_t* m_dest;
+		uint32_t m_offset = 0;
+	};
+
+	struct FBitReader
+	{
+		uint32_t Read(const uint32_t bitCount)
+		{
+			uint32_t value = 0;
+			for (uint32_t i = 0; i < bitCount; ++i, ++m_offset)
+			{
+				value |= uint32_t((m_src[m_offset >> 3] >> (m_offset & 7)) & 1) << i;
+			}
+
+			return value;
+		}
+
+		const uint8_t* m_src;
+		uint32_t m_offset = 0;
+	};
+
+	uint8_t Interpolate(const uint32_t value0, const uint32_t value1, const uint32_t weight)
+	{
+		return uint8_t(((64 - weight) * value0 + weight * value1 + 32) >> 6);
+	}
+
+	// Mode 6 endpoints are 7 bits plus a p-bit per endpoint, mode 1 endpoints 6 bits plus a p-bit shared by the subset
+	uint8_t ExpandMode6(const uint32_t quantized, const uint32_t pBit)
+	{
+		return uint8_t(quantized << 1 | pBit);
+	}
+
+	uint8_t ExpandMode1(const uint32_t quantized, const uint32_t pBit)
+	{
+		const uint32_t value = quantized << 1 | pBit;
+		return uint8_t(value << 1 | value >> 6);
+	}
+
+	uint8_t QuantizeMode6(const float value, const uint32_t pBit)
+	{
+		return uint8_t(std::clamp(std::lround((value - pBit) * 0.5f), 0l, 127l));
+	}
+
+	uint8_t QuantizeMode1(const float value, const uint32_t pBit)
+	{
+		// The expansion is not linear, pick the nearest of the neighbouring codes
+		const long estimate = std::lround((value * 127.f / 255.f - pBit) * 0.5f);
+		uint8_t best = 0;
+		float bestDelta = std::numeric_limits<float>::max();
+		for (long quantized = std::max(estimate - 1, 0l); quantized <= std::min(estimate + 1, 63l); ++quantized)
+		{
+			const float delta = std::abs(ExpandMode1(quantized, pBit) - value);
+			if (delta < bestDelta)
+			{
+				bestDelta = delta;
+				best = uint8_t(quantized);
+			}
+		}
+
+		return best;
+	}
+
+	struct FBc7Subset
+	{
+		float m_error = std::numeric_limits<float>::max();
+		uint8_t m_endpoints[2][4]; // quantized, without p-bits
+		uint8_t m_pBits[2];
+	};
+
+	struct FBc7Block
+	{
+		float m_error = std::numeric_limits<float>::max();
+		uint32_t m_mode;
+		uint32_t m_partition;
+		FBc7Subset m_subsets[2];
+		uint8_t m_indices[16];
+	};
+
+	void GetBc7Palette(const FBc7Subset& subset, const uint32_t mode, FPalette& palette)
+	{
+		const uint32_t* weights = mode == 6 ? k_bc7Weights4 : k_bc7Weights3;
+		palette.m_size = mode == 6 ? 16 : 8;
+		for (uint32_t c = 0; c < 4; ++c)
+		{
+			uint8_t endpoints[2];
+			for (uint32_t i = 0; i < 2; ++i)
+			{
+				endpoints[i] = c == 3 && mode == 1 ? 255 :
+					mode == 6 ? ExpandMode6(subset.m_endpoints[i][c], subset.m_pBits[i]) : ExpandMode1(subset.m_endpoints[i][c], subset.m_pBits[i]);
+			}
+
+			for (uint32_t entry = 0; entry < palette.m_size; ++entry)
+			{
+				palette.m_values[c][entry] = Interpolate(endpoints[0], endpoints[1], weights[entry]);
+			}
+		}
+	}
+
+	// Quantizes the endpoints of a subset with every p-bit combination the mode allows and keeps the best fit in subset,
+	// writing the indices of the subset's pixels
+	void TryBc7Endpoints(
+		const FBlock& block,
+		const uint32_t mode,
+		const uint32_t pixelMask,
+		const float endpoint0[4],
+		const float endpoint1[4],
+		const FitFunction fit,
+		FBc7Subset& subset,
+		uint8_t indices[16])
+	{
+		const uint32_t channelCount = mode == 6 ? 4 : 3;
+		for (uint32_t pBits = 0; pBits < (mode == 6 ? 4u : 2u); ++pBits)
+		{
+			FBc7Subset candidate;
+			candidate.m_pBits[0] = pBits & 1;
+			candidate.m_pBits[1] = mode == 6 ? pBits >> 1 : pBits & 1;
+			for (uint32_t c = 0; c < 4; ++c)
+			{
+				for (uint32_t i = 0; i < 2; ++i)
+				{
+					const float value = c < channelCount ? (i == 0 ? endpoint0[c] : endpoint1[c]) : 255.f;
+					candidate.m_endpoints[i][c] = mode == 6 ? QuantizeMode6(value, candidate.m_pBits[i]) : QuantizeMode1(value, candidate.m_pBits[i]);
+				}
+			}
+
+			FPalette palette;
+			GetBc7Palette(candidate, mode, palette);
+
+			uint8_t candidateIndices[16];
+			candidate.m_error = fit(block, palette, 0, channelCount, pixelMask, candidateIndices);
+			if (candidate.m_error < subset.m_error)
+			{
+				subset = candidate;
+				for (uint32_t pixel = 0; pixel < 16; ++pixel)
+				{
+					indices[pixel] = (pixelMask >> pixel) & 1 ? candidateIndices[pixel] : indices[pixel];
+				}
+			}
+		}
+	}
+
+	void EncodeBc7Subset(const FBlock& block, const uint32_t mode, const uint32_t pixelMask, const FitFunction fit, FBc7Subset& subset, uint8_t indices[16])
+	{
+		const uint32_t channelCount = mode == 6 ? 4 : 3;
+		const uint32_t* weights = mode == 6 ? k_bc7Weights4 : k_bc7Weights3;
+
+		float normalizedWeights[16];
+		for (uint32_t i = 0; i < (mode == 6 ? 16u : 8u); ++i)
+		{
+			normalizedWeights[i] = weights[i] / 64.f;
+		}
+
+		float endpoint0[4], endpoint1[4];
+		GetAxisEndpoints(block, 0, channelCount, pixelMask, endpoint0, endpoint1);
+		TryBc7Endpoints(block, mode, pixelMask, endpoint0, endpoint1, fit, subset, indices);
+		for (uint32_t iteration = 0; iteration < k_refineIterations && subset.m_error > 0.f; ++iteration)
+		{
+			if (!SolveEndpoints(block, 0, channelCount, pixelMask, indices, normalizedWeights, endpoint0, endpoint1))
+			{
+				break;
+			}
+
+			TryBc7Endpoints(block, mode, pixelMask, endpoint0, endpoint1, fit, subset, indices);
+		}
+	}
+
+	// Squared distance of the subset's pixels to their principal axis, the error of a subset with unquantized endpoints and
+	// continuous indices
+	float EstimateSubsetError(const FBlock& block, const uint32_t pixelMask)
+	{
+		float mean[4], axis[4];
+		GetPrincipalAxis(block, 0, 3, pixelMask, mean, axis);
+
+		float error = 0.f;
+		for (uint32_t pixel = 0; pixel < 16; ++pixel)
+		{
+			if ((pixelMask >> pixel) & 1)
+			{
+				float delta[3], t = 0.f;
+				for (uint32_t c = 0; c < 3; ++c)
+				{
+					delta[c] = block.m_pixels[c][pixel] - mean[c];
+					t += delta[c] * axis[c];
+				}
+
+				for (uint32_t c = 0; c < 3; ++c)
+				{
+					error += (delta[c] - t * axis[c]) * (delta[c] - t * axis[c]);
+				}
+			}
+		}
+
+		return error;
+	}
+
+	void EncodeBc7Mode1(const FBlock& block, const FitFunction fit, FBc7Block& best)
+	{
+		// Rank the partitions by how well a line fits each subset, then encode the most promising ones
+		std::pair<float, uint32_t> ranking[64];
+		for (uint32_t partition = 0; partition < 64; ++partition)
+		{
+			const uint32_t mask1 = k_bc7Partitions2[partition];
+			ranking[partition] = { EstimateSubsetError(block, ~mask1 & 0xffff) + EstimateSubsetError(block, mask1), partition };
+		}
+
+		std::partial_sort(ranking, ranking + k_bc7PartitionCandidates, ranking + 64);
+		for (uint32_t candidateIndex = 0; candidateIndex < k_bc7PartitionCandidates; ++candidateIndex)
+		{
+			FBc7Block candidate;
+			candidate.m_mode = 1;
+			candidate.m_partition = ranking[candidateIndex].second;
+
+			const uint32_t mask1 = k_bc7Partitions2[candidate.m_partition];
+			EncodeBc7Subset(block, 1, ~mask1 & 0xffff, fit, candidate.m_subsets[0], candidate.m_indices);
+			EncodeBc7Subset(block, 1, mask1, fit, candidate.m_subsets[1], candidate.m_indices);
+			candidate.m_error = candidate.m_subsets[0].m_error + candidate.m_subsets[1].m_error;
+			if (candidate.m_error < best.m_error)
+			{
+				best = candidate;
+			}
+		}
+	}
+
+	// Swaps the endpoints of a subset whose anchor index has its high bit set, since that bit is not stored
+	void FixBc7Anchor(FBc7Block& block, const uint32_t subsetIndex, const uint32_t anchor, const uint32_t pixelMask, const uint32_t indexBits)
+	{
+		const uint32_t highBit = 1u << (indexBits - 1);
+		if ((block.m_indices[anchor] & highBit) == 0)
+		{
+			return;
+		}
+
+		FBc7Subset& subset = block.m_subsets[subsetIndex];
+		std::swap(subset.m_endpoints[0], subset.m_endpoints[1]);
+		std::swap(subset.m_pBits[0], subset.m_pBits[1]);
+		for (uint32_t pixel = 0; pixel < 16; ++pixel)
+		{
+			if ((pixelMask >> pixel) & 1)
+			{
+				block.m_indices[pixel] = uint8_t((2 * highBit - 1) - block.m_indices[pixel]);
+			}
+		}
+	}
+
+	void CompressBc7(const FBlock& block, uint8_t* dest, const FitFunction fit)
+	{
+		// Mode 6 for every block, mode 1 competes for opaque blocks
+		FBc7Block best;
+		best.m_mode = 6;
+		best.m_partition = 0;
+		EncodeBc7Subset(block, 6, 0xffff, fit, best.m_subsets[0], best.m_indices);
+		best.m_error = best.m_subsets[0].m_error;
+
+		const bool opaque = std::all_of(block.m_pixels[3], block.m_pixels[3] + 16, [](const float alpha) { return alpha == 255.f; });
+		if (opaque && best.m_error > 0.f)
+		{
+			EncodeBc7Mode1(block, fit, best);
+		}
+
+		std::fill_n(dest, 16, uint8_t(0));
+		FBitWriter writer = { dest };
+		writer.Write(1u << best.m_mode, best.m_mode + 1);
+		if (best.m_mode == 6)
+		{
+			FixBc7Anchor(best, 0, 0, 0xffff, 4);
+
+			const FBc7Subset& subset = best.m_subsets[0];
+			for (uint32_t c = 0; c < 4; ++c)
+			{
+				writer.Write(subset.m_endpoints[0][c], 7);
+				writer.Write(subset.m_endpoints[1][c], 7);
+			}
+
+			writer.Write(subset.m_pBits[0], 1);
+			writer.Write(subset.m_pBits[1], 1);
+			for (uint32_t pixel = 0; pixel < 16; ++pixel)
+			{
+				writer.Write(best.m_indices[pixel], pixel == 0 ? 3 : 4);
+			}
+		}
+		else
+		{
+			const uint32_t mask1 = k_bc7Partitions2[best.m_partition];
+			const uint32_t anchor = k_bc7Anchors2[best.m_partition];
+			FixBc7Anchor(best, 0, 0, ~mask1 & 0xffff, 3);
+			FixBc7Anchor(best, 1, anchor, mask1, 3);
+
+			writer.Write(best.m_partition, 6);
+			for (uint32_t c = 0; c < 3; ++c)
+			{
+				for (const FBc7Subset& subset : best.m_subsets)
+				{
+					writer.Write(subset.m_endpoints[0][c], 6);
+					writer.Write(subset.m_endpoints[1][c], 6);
+				}
+			}
+
+			writer.Write(best.m_subsets[0].m_pBits[0], 1);
+			writer.Write(best.m_subsets[1].m_pBits[0], 1);
+			for (uint32_t pixel = 0; pixel < 16; ++pixel)
+			{
+				writer.Write(best.m_indices[pixel], pixel == 0 || pixel == anchor ? 2 : 3);
+			}
+		}
+	}
+
+	void DecompressBc7(const uint8_t* src, uint8_t* rgba)
+	{
+		FBitReader reader = { src };
+		uint32_t mode = 0;
+		while (mode < 8 && reader.Read(1) == 0)
+		{
+			mode++;
+		}
+
+		if (mode != 1 && mode != 6)
+		{
+			std::fill_n(rgba, 64, uint8_t(0));
+			return;
+		}
+
+		FBc7Block block;
+		block.m_mode = mode;
+		uint32_t mask1 = 0, anchor = 0;
+		if (mode == 6)
+		{
+			for (uint32_t c = 0; c < 4; ++c)
+			{
+				block.m_subsets[0].m_endpoints[0][c] = uint8_t(reader.Read(7));
+				block.m_subsets[0].m_endpoints[1][c] = uint8_t(reader.Read(7));
+			}
+
+			block.m_subsets[0].m_pBits[0] = uint8_t(reader.Read(1));
+			block.m_subsets[0].m_pBits[1] = uint8_t(reader.Read(1));
+			for (uint32_t pixel = 0; pixel < 16; ++pixel)
+			{
+				block.m_indices[pixel] = uint8_t(reader.Read(pixel == 0 ? 3 : 4));
+			}
+		}
+		else
+		{
+			block.m_partition = reader.Read(6);
+			mask1 = k_bc7Partitions2[block.m_partition];
+			anchor = k_bc7Anchors2[block.m_partition];
+			for (uint32_t c = 0; c < 3; ++c)
+			{
+				for (FBc7Subset& subset : block.m_subsets)
+				{
+					subset.m_endpoints[0][c] = uint8_t(reader.Read(6));
+					subset.m_endpoints[1][c] = uint8_t(reader.Read(6));
+				}
+			}
+
+			for (FBc7Subset& subset : block.m_subsets)
+			{
+				subset.m_pBits[0] = subset.m_pBits[1] = uint8_t(reader.Read(1));
+			}
+
+			for (uint32_t pixel = 0; pixel < 16; ++pixel)
+			{
+				block.m_indices[pixel] = uint8_t(reader.Read(pixel == 0 || pixel == anchor ? 2 : 3));
+			}
+		}
+
+		FPalette palettes[2];
+		GetBc7Palette(block.m_subsets[0], mode, palettes[0]);
+		if (mode == 1)
+		{
+			GetBc7Palette(block.m_subsets[1], mode, palettes[1]);
+		}
+
+		for (uint32_t pixel = 0; pixel < 16; ++pixel)
+		{
+			const FPalette& palette = palettes[(mask1 >> pixel) & 1];
+			for (uint32_t c = 0; c < 4; ++c)
+			{
+				rgba[4 * pixel + c] = uint8_t(palette.m_values[c][block.m_indices[pixel]]);
+			}
+		}
+	}
+
+	//-------------------------------------------------------------------------------------------------------------------------------------------
+	// Images
+	//-------------------------------------------------------------------------------------------------------------------------------------------
+
+	// Copies the block at (blockX, blockY), clamping to the last row and column of the image
+	void GatherBlock(const uint8_t* rgba, const uint32_t width, const uint32_t height, const size_t rowPitch, const uint32_t blockX, const uint32_t blockY, uint8_t pixels[64])
+	{
+		for (uint32_t y = 0; y < 4; ++y)
+		{
+			const uint8_t* row = rgba + std::min(4 * blockY + y, height - 1) * rowPitch;
+			for (uint32_t x = 0; x < 4; ++x)
+			{
+				std::copy_n(row + 4 * std::min(4 * blockX + x, width - 1), 4, pixels + 16 * y + 4 * x);
+			}
+		}
+	}
+
+	template<typename TCompressBlock>
+	void CompressImage(
+		const uint8_t* rgba,
+		const uint32_t width,
+		const uint32_t height,
+		const size_t rowPitch,
+		uint8_t* dest,
+		const size_t destRowPitch,
+		const size_t blockSize,
+		TCompressBlock&& compressBlock)
+	{
+		const uint32_t blocksX = (width + 3) / 4;
+		const uint32_t blocksY = (height + 3) / 4;
+		concurrency::parallel_for(0u, blocksY, [&](const uint32_t blockY)
+		{
+			uint8_t pixels[64];
+			for (uint32_t blockX = 0; blockX < blocksX; ++blockX)
+			{
+				GatherBlock(rgba, width, height, rowPitch, blockX, blockY, pixels);
+				compressBlock(pixels, dest + blockY * destRowPitch + blockX * blockSize);
+			}
+		});
+	}
+
+	void CompressBlockStb(const BlockCompression::Format format, const uint8_t* rgba, uint8_t* dest)
+	{
+		uint8_t channels[32];
+		switch (format)
+		{
+		case BlockCompression::Format::BC1:
+			stb_compress_dxt_block(dest, rgba, 0, STB_DXT_HIGHQUAL);
+			break;
+		case BlockCompression::Format::BC4:
+			for (uint32_t pixel = 0; pixel < 16; ++pixel)
+			{
+				channels[pixel] = rgba[4 * pixel];
+			}
+
+			stb_compress_bc4_block(dest, channels);
+			break;
+		case BlockCompression::Format::BC5:
+			for (uint32_t pixel = 0; pixel < 16; ++pixel)
+			{
+				channels[2 * pixel] = rgba[4 * pixel];
+				channels[2 * pixel + 1] = rgba[4 * pixel + 1];
+			}
+
+			stb_compress_bc5_block(dest, channels);
+			break;
+		default:
+			stb_compress_dxt_block(dest, rgba, 1, STB_DXT_HIGHQUAL);
+			break;
+		}
+	}
+}
+
+size_t BlockCompression::GetBlockSize(const Format format)
+{
+	return format == Format::BC1 || format == Format::BC4 ? 8 : 16;
+}
+
+bool BlockCompression::HasSimdSupport()
+{
+	return GetSimdFitFunction() != nullptr;
+}
+
+void BlockCompression::CompressBlock(const Format format, const uint8_t* rgba, uint8_t* dest, const bool allowSimd)
+{
+	const FitFunction fit = GetFitFunction(allowSimd);
+
+	FBlock block;
+	LoadBlock(rgba, block);
+	switch (format)
+	{
+	case Format::BC1:
+		CompressBc1(block, dest, fit);
+		break;
+	case Format::BC3:
+		CompressBc4(block, 3, dest, fit);
+		CompressBc1(block, dest + 8, fit);
+		break;
+	case Format::BC4:
+		CompressBc4(block, 0, dest, fit);
+		break;
+	case Format::BC5:
+		CompressBc4(block, 0, dest, fit);
+		CompressBc4(block, 1, dest + 8, fit);
+		break;
+	case Format::BC7:
+		CompressBc7(block, dest, fit);
+		break;
+	}
+}
+
+void BlockCompression::DecompressBlock(const Format format, const uint8_t* block, uint8_t* rgba)
+{
+	for (uint32_t pixel = 0; pixel < 16; ++pixel)
+	{
+		rgba[4 * pixel + 0] = rgba[4 * pixel + 1] = rgba[4 * pixel + 2] = 0;
+		rgba[4 * pixel + 3] = 255;
+	}
+
+	switch (format)
+	{
+	case Format::BC1:
+		DecompressBc1(block, rgba);
+		break;
+	case Format::BC3:
+		DecompressBc1(block + 8, rgba);
+		DecompressBc4(block, rgba, 3);
+		break;
+	case Format::BC4:
+		DecompressBc4(block, rgba, 0);
+		break;
+	case Format::BC5:
+		DecompressBc4(block, rgba, 0);
+		DecompressBc4(block + 8, rgba, 1);
+		break;
+	case Format::BC7:
+		DecompressBc7(block, rgba);
+		break;
+	}
+}
+
+void BlockCompression::Compress(
+	const Format format,
+	const uint8_t* rgba,
+	const uint32_t width,
+	const uint32_t height,
+	const size_t rowPitch,
+	uint8_t* dest,
+	const size_t destRowPitch,
+	const bool allowSimd)
+{
+	CompressImage(rgba, width, height, rowPitch, dest, destRowPitch, GetBlockSize(format), [format, allowSimd](const uint8_t* pixels, uint8_t* block)
+	{
+		CompressBlock(format, pixels, block, allowSimd);
+	});
+}
+
+BlockCompression::Benchmark::FResult BlockCompression::Benchmark::Run(const Format format, const uint32_t size, const bool allowSimd)
+{
+	using Clock = std::chrono::high_resolution_clock;
+
+	// Smooth gradients, a grid of flat colored cells with hard edges and noisy areas, with a radial alpha ramp
+	std::mt19937 rng{ 1 };
+	std::uniform_int_distribution<int> noise{ -24, 24 };
+	std::vector<uint8_t> image(4 * size_t(size) * size);
+	for (uint32_t y = 0; y < size; ++y)
+	{
+		for (uint32_t x = 0; x < size; ++x)
+		{
+			const float u = (x + 0.5f) / size, v = (y + 0.5f) / size;
+			int color[4] =
+			{
+				int(255.f * u),
+				int(255.f * v),
+				int(127.5f + 127.5f * std::sin(12.f * u + 7.f * v)),
+				int(255.f * std::clamp(1.5f - 2.f * std::hypot(u - 0.5f, v - 0.5f), 0.f, 1.f))
+			};
+
+			if ((x / 24 + y / 40) % 3 == 0)
+			{
+				color[0] = 64 * ((x / 24) % 4);
+				color[1] = 255 - color[0];
+				color[2] = 96 * ((y / 40) % 3);
+			}
+
+			if (v > 0.5f)
+			{
+				const int delta = noise(rng);
+				color[0] += delta;
+				color[1] += delta / 2;
+				color[2] -= delta;
+			}
+
+			for (uint32_t c = 0; c < 4; ++c)
+			{
+				image[4 * (size_t(y) * size + x) + c] = uint8_t(std::clamp(color[c], 0, 255));
+			}
+		}
+	}
+
+	const size_t rowPitch = 4 * size_t(size);
+	const size_t blockSize = GetBlockSize(format);
+	const size_t destRowPitch = blockSize * ((size + 3) / 4);
+	std::vector<uint8_t> compressed(destRowPitch * ((size + 3) / 4));
+
+	// Best of several runs, in megapixels per second
+	const auto measure = [&](auto&& compressBlock)
+	{
+		double bestTime = std::numeric_limits<double>::max();
+		for (int run = 0; run < 3; ++run)
+		{
+			const auto start = Clock::now();
+			CompressImage(image.data(), size, size, rowPitch, compressed.data(), destRowPitch, blockSize, compressBlock);
+			bestTime = std::min(bestTime, std::chrono::duration<double, std::micro>(Clock::now() - start).count());
+		}
+
+		return double(size) * size / std::max(bestTime, 1e-3);
+	};
+
+	// Over the channels the format stores
+	const auto measurePsnr = [&](const Format decodeFormat)
+	{
+		const uint32_t channelCount = decodeFormat == Format::BC4 ? 1 : decodeFormat == Format::BC5 ? 2 : decodeFormat == Format::BC1 ? 3 : 4;
+
+		double squaredError = 0.0;
+		uint8_t pixels[64], decoded[64];
+		for (uint32_t blockY = 0; blockY < (size + 3) / 4; ++blockY)
+		{
+			for (uint32_t blockX = 0; blockX < (size + 3) / 4; ++blockX)
+			{
+				GatherBlock(image.data(), size, size, rowPitch, blockX, blockY, pixels);
+				DecompressBlock(decodeFormat, &compressed[blockY * destRowPitch + blockX * blockSize], decoded);
+				for (uint32_t pixel = 0; pixel < 16; ++pixel)
+				{
+					for (uint32_t c = 0; c < channelCount; ++c)
+					{
+						const double delta = double(pixels[4 * pixel + c]) - decoded[4 * pixel + c];
+						squaredError += delta * delta;
+					}
+				}
+			}
+		}
+
+		const double meanSquaredError = squaredError / (16.0 * channelCount * ((size + 3) / 4) * ((size + 3) / 4));
+		return meanSquaredError > 0.0 ? 10.0 * std::log10(255.0 * 255.0 / meanSquaredError) : std::numeric_limits<double>::infinity();
+	};
+
+	FResult result = {};
+	result.m_throughput = measure([format, allowSimd](const uint8_t* pixels, uint8_t* block) { CompressBlock(format, pixels, block, allowSimd); });
+	result.m_psnr = measurePsnr(format);
+
+	const Format stbFormat = format == Format::BC7 ? Format::BC3 : format;
+	result.m_stbThroughput = measure([stbFormat](const uint8_t* pixels, uint8_t* block) { CompressBlockStb(stbFormat, pixels, block); });
+	result.m_stbPsnr = measurePsnr(stbFormat);
+	return result;
+}
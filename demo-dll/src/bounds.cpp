@@ -0,0 +1,511 @@
+#include <bounds.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <random>
+
+#if defined(_M_X64) || defined(__x86_64__)
+#define BOUNDS_AVX2 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define AVX2_TARGET
+#else
+#define AVX2_TARGET __attribute__((target("avx2,fma")))
+#endif
+#elif defined(_M_ARM64) || defined(__aarch64__)
+#define BOUNDS_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace
+{
+	// Affine transform followed by the root transform. Only the first three columns are used.
+	void ComposeTransform(float dest[16], const float* m, const float root[16])
+	{
+		for (int i = 0; i < 4; ++i)
+		{
+			for (int j = 0; j < 3; ++j)
+			{
+				dest[i * 4 + j] = m[i * 4 + 0] * root[0 * 4 + j] + m[i * 4 + 1] * root[1 * 4 + j] + m[i * 4 + 2] * root[2 * 4 + j] + (i == 3 ? root[3 * 4 + j] : 0.f);
+			}
+		}
+	}
+
+	void TransformBoxesScalar(Bounds::FBoxSoA& dest, const Bounds::FBoxSoA& src, const float* transforms, const float root[16], const size_t begin, Bounds::FAabb& aabb)
+	{
+		for (size_t i = begin; i < src.Size(); ++i)
+		{
+			float w[16];
+			ComposeTransform(w, transforms + i * 16, root);
+
+			const float center[3] = { src.m_centerX[i], src.m_centerY[i], src.m_centerZ[i] };
+			const float extents[3] = { src.m_extentX[i], src.m_extentY[i], src.m_extentZ[i] };
+			float newCenter[3], newExtents[3];
+			for (int j = 0; j < 3; ++j)
+			{
+				newCenter[j] = center[0] * w[j] + center[1] * w[4 + j] + center[2] * w[8 + j] + w[12 + j];
+				newExtents[j] = extents[0] * std::abs(w[j]) + extents[1] * std::abs(w[4 + j]) + extents[2] * std::abs(w[8 + j]);
+				aabb.m_min[j] = std::min(aabb.m_min[j], newCenter[j] - newExtents[j]);
+				aabb.m_max[j] = std::max(aabb.m_max[j], newCenter[j] + newExtents[j]);
+			}
+
+			dest.Set(i, newCenter, newExtents);
+		}
+	}
+
+	size_t CullBoxesScalar(uint32_t* visibleIndices, const Bounds::FBoxSoA& boxes, const size_t begin, const size_t end, const float planes[][4], const size_t planeCount)
+	{
+		size_t visibleCount = 0;
+		for (size_t i = begin; i < end; ++i)
+		{
+			bool visible = true;
+			for (size_t p = 0; p < planeCount && visible; ++p)
+			{
+				const float* plane = planes[p];
+				const float distance = plane[0] * boxes.m_centerX[i] + plane[1] * boxes.m_centerY[i] + plane[2] * boxes.m_centerZ[i] + plane[3];
+				const float radius = std::abs(plane[0]) * boxes.m_extentX[i] + std::abs(plane[1]) * boxes.m_extentY[i] + std::abs(plane[2]) * boxes.m_extentZ[i];
+				visible = distance + radius >= 0.f;
+			}
+
+			visibleIndices[visibleCount] = (uint32_t)i;
+			visibleCount += visible ? 1 : 0;
+		}
+
+		return visibleCount;
+	}
+
+#if BOUNDS_AVX2
+	bool CpuSupportsAvx2()
+	{
+#if defined(_MSC_VER)
+		int info[4];
+		__cpuid(info, 0);
+		if (info[0] < 7)
+		{
+			return false;
+		}
+
+		__cpuid(info, 1);
+		const bool fma = (info[2] & (1 << 12)) != 0;
+		const bool osxsave = (info[2] & (1 << 27)) != 0;
+		if (!fma || !osxsave || (_xgetbv(0) & 0x6) != 0x6)
+		{
+			return false;
+		}
+
+		__cpuidex(info, 7, 0);
+		return (info[1] & (1 << 5)) != 0;
+#else
+		return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#endif
+	}
+
+	AVX2_TARGET __m256 HorizontalMin(__m256 v)
+	{
+		v = _mm256_min_ps(v, _mm256_permute2f128_ps(v, v, 1));
+		v = _mm256_min_ps(v, _mm256_shuffle_ps(v, v, _MM_SHUFFLE(1, 0, 3, 2)));
+		return _mm256_min_ps(v, _mm256_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1)));
+	}
+
+	AVX2_TARGET __m256 HorizontalMax(__m256 v)
+	{
+		v = _mm256_max_ps(v, _mm256_permute2f128_ps(v, v, 1));
+		v = _mm256_max_ps(v, _mm256_shuffle_ps(v, v, _MM_SHUFFLE(1, 0, 3, 2)));
+		return _mm256_max_ps(v, _mm256_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1)));
+	}
+
+	// Eight boxes per iteration, one per lane. The per box transforms are gathered column by column and composed with the
+	// root transform in registers.
+	AVX2_TARGET size_t TransformBoxesAvx2(Bounds::FBoxSoA& dest, const Bounds::FBoxSoA& src, const float* transforms, const float root[16], Bounds::FAabb& aabb)
+	{
+		const __m256i laneOffsets = _mm256_setr_epi32(0, 16, 32, 48, 64, 80, 96, 112);
+		const __m256 absMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+
+		__m256 minBounds[3], maxBounds[3];
+		for (int j = 0; j < 3; ++j)
+		{
+			minBounds[j] = _mm256_set1_ps(aabb.m_min[j]);
+			maxBounds[j] = _mm256_set1_ps(aabb.m_max[j]);
+		}
+
+		const size_t count = src.Size() & ~size_t(7);
+		for (size_t i = 0; i < count; i += 8)
+		{
+			const float* m = transforms + i * 16;
+
+			// w = m * root, row by row
+			__m256 w[4][3];
+			for (int row = 0; row < 4; ++row)
+			{
+				const __m256 m0 = _mm256_i32gather_ps(m + row * 4 + 0, laneOffsets, 4);
+				const __m256 m1 = _mm256_i32gather_ps(m + row * 4 + 1, laneOffsets, 4);
+				const __m256 m2 = _mm256_i32gather_ps(m + row * 4 + 2, laneOffsets, 4);
+				for (int j = 0; j < 3; ++j)
+				{
+					__m256 r = row == 3 ? _mm256_set1_ps(root[12 + j]) : _mm256_setzero_ps();
+					r = _mm256_fmadd_ps(m0, _mm256_set1_ps(root[0 + j]), r);
+					r = _mm256_fmadd_ps(m1, _mm256_set1_ps(root[4 + j]), r);
+					w[row][j] = _mm256_fmadd_ps(m2, _mm256_set1_ps(root[8 + j]), r);
+				}
+			}
+
+			const __m256 cx = _mm256_loadu_ps(&src.m_centerX[i]);
+			const __m256 cy = _mm256_loadu_ps(&src.m_centerY[i]);
+			const __m256 cz = _mm256_loadu_ps(&src.m_centerZ[i]);
+			const __m256 ex = _mm256_loadu_ps(&src.m_extentX[i]);
+			const __m256 ey = _mm256_loadu_ps(&src.m_extentY[i]);
+			const __m256 ez = _mm256_loadu_ps(&src.m_extentZ[i]);
+
+			__m256 newCenter[3], newExtents[3];
+			for (int j = 0; j < 3; ++j)
+			{
+				newCenter[j] = _mm256_fmadd_ps(cx, w[0][j], _mm256_fmadd_ps(cy, w[1][j], _mm256_fmadd_ps(cz, w[2][j], w[3][j])));
+				newExtents[j] = _mm256_fmadd_ps(ex, _mm256_and_ps(w[0][j], absMask),
+					_mm256_fmadd_ps(ey, _mm256_and_ps(w[1][j], absMask), _mm256_mul_ps(ez, _mm256_and_ps(w[2][j], absMask))));
+				minBounds[j] = _mm256_min_ps(minBounds[j], _mm256_sub_ps(newCenter[j], newExtents[j]));
+				maxBounds[j] = _mm256_max_ps(maxBounds[j], _mm256_add_ps(newCenter[j], newExtents[j]));
+			}
+
+			_mm256_storeu_ps(&dest.m_centerX[i], newCenter[0]);
+			_mm256_storeu_ps(&dest.m_centerY[i], newCenter[1]);
+			_mm256_storeu_ps(&dest.m_centerZ[i], newCenter[2]);
+			_mm256_storeu_ps(&dest.m_extentX[i], newExtents[0]);
+			_mm256_storeu_ps(&dest.m_extentY[i], newExtents[1]);
+			_mm256_storeu_ps(&dest.m_extentZ[i], newExtents[2]);
+		}
+
+		for (int j = 0; j < 3; ++j)
+		{
+			aabb.m_min[j] = _mm256_cvtss_f32(HorizontalMin(minBounds[j]));
+			aabb.m_max[j] = _mm256_cvtss_f32(HorizontalMax(maxBounds[j]));
+		}
+
+		return count;
+	}
+
+	// Eight boxes per iteration against every plane, then a branchless compaction of the visible lanes
+	AVX2_TARGET size_t CullBoxesAvx2(uint32_t* visibleIndices, const Bounds::FBoxSoA& boxes, const size_t begin, const size_t end, const float planes[][4], const size_t planeCount)
+	{
+		const __m256 absMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+
+		size_t visibleCount = 0;
+		for (size_t i = begin; i < end; i += 8)
+		{
+			const __m256 cx = _mm256_loadu_ps(&boxes.m_centerX[i]);
+			const __m256 cy = _mm256_loadu_ps(&boxes.m_centerY[i]);
+			const __m256 cz = _mm256_loadu_ps(&boxes.m_centerZ[i]);
+			const __m256 ex = _mm256_loadu_ps(&boxes.m_extentX[i]);
+			const __m256 ey = _mm256_loadu_ps(&boxes.m_extentY[i]);
+			const __m256 ez = _mm256_loadu_ps(&boxes.m_extentZ[i]);
+
+			__m256 visible = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+			for (size_t p = 0; p < planeCount; ++p)
+			{
+				const __m256 a = _mm256_set1_ps(planes[p][0]);
+				const __m256 b = _mm256_set1_ps(planes[p][1]);
+				const __m256 c = _mm256_set1_ps(planes[p][2]);
+				__m256 distance = _mm256_fmadd_ps(cx, a, _mm256_fmadd_ps(cy, b, _mm256_fmadd_ps(cz, c, _mm256_set1_ps(planes[p][3]))));
+				distance = _mm256_fmadd_ps(ex, _mm256_and_ps(a, absMask), distance);
+				distance = _mm256_fmadd_ps(ey, _mm256_and_ps(b, absMask), distance);
+				distance = _mm256_fmadd_ps(ez, _mm256_and_ps(c, absMask), distance);
+				visible = _mm256_and_ps(visible, _mm256_cmp_ps(distance, _mm256_setzero_ps(), _CMP_GE_OQ));
+			}
+
+			const uint32_t mask = (uint32_t)_mm256_movemask_ps(visible);
+			for (uint32_t lane = 0; lane < 8; ++lane)
+			{
+				visibleIndices[visibleCount] = (uint32_t)i + lane;
+				visibleCount += (mask >> lane) & 1;
+			}
+		}
+
+		return visibleCount;
+	}
+#endif
+
+#if BOUNDS_NEON
+	// Four boxes per iteration, one per lane. Each row of the four transforms is loaded and transposed so that every
+	// register holds one matrix element for all four boxes.
+	size_t TransformBoxesNeon(Bounds::FBoxSoA& dest, const Bounds::FBoxSoA& src, const float* transforms, const float root[16], Bounds::FAabb& aabb)
+	{
+		float32x4_t minBounds[3], maxBounds[3];
+		for (int j = 0; j < 3; ++j)
+		{
+			minBounds[j] = vdupq_n_f32(aabb.m_min[j]);
+			maxBounds[j] = vdupq_n_f32(aabb.m_max[j]);
+		}
+
+		const size_t count = src.Size() & ~size_t(3);
+		for (size_t i = 0; i < count; i += 4)
+		{
+			const float* m = transforms + i * 16;
+
+			float32x4_t w[4][3];
+			for (int row = 0; row < 4; ++row)
+			{
+				const float32x4x2_t t01 = vtrnq_f32(vld1q_f32(m + 0 * 16 + row * 4), vld1q_f32(m + 1 * 16 + row * 4));
+				const float32x4x2_t t23 = vtrnq_f32(vld1q_f32(m + 2 * 16 + row * 4), vld1q_f32(m + 3 * 16 + row * 4));
+				const float32x4_t m0 = vcombine_f32(vget_low_f32(t01.val[0]), vget_low_f32(t23.val[0]));
+				const float32x4_t m1 = vcombine_f32(vget_low_f32(t01.val[1]), vget_low_f32(t23.val[1]));
+				const float32x4_t m2 = vcombine_f32(vget_high_f32(t01.val[0]), vget_high_f32(t23.val[0]));
+				for (int j = 0; j < 3; ++j)
+				{
+					float32x4_t r = vdupq_n_f32(row == 3 ? root[12 + j] : 0.f);
+					r = vfmaq_f32(r, m0, vdupq_n_f32(root[0 + j]));
+					r = vfmaq_f32(r, m1, vdupq_n_f32(root[4 + j]));
+					w[row][j] = vfmaq_f32(r, m2, vdupq_n_f32(root[8 + j]));
+				}
+			}
+
+			const float32x4_t cx = vld1q_f32(&src.m_centerX[i]);
+			const float32x4_t cy = vld1q_f32(&src.m_centerY[i]);
+			const float32x4_t cz = vld1q_f32(&src.m_centerZ[i]);
+			const float32x4_t ex = vld1q_f32(&src.m_extentX[i]);
+			const float32x4_t ey = vld1q_f32(&src.m_extentY[i]);
+			const float32x4_t ez = vld1q_f32(&src.m_extentZ[i]);
+
+			float32x4_t newCenter[3], newExtents[3];
+			for (int j = 0; j < 3; ++j)
+			{
+				newCenter[j] = vfmaq_f32(vfmaq_f32(vfmaq_f32(w[3][j], cz, w[2][j]), cy, w[1][j]), cx, w[0][j]);
+				newExtents[j] = vfmaq_f32(vfmaq_f32(vmulq_f32(ez, vabsq_f32(w[2][j])), ey, vabsq_f32(w[1][j])), ex, vabsq_f32(w[0][j]));
+				minBounds[j] = vminq_f32(minBounds[j], vsubq_f32(newCenter[j], newExtents[j]));
+				maxBounds[j] = vmaxq_f32(maxBounds[j], vaddq_f32(newCenter[j], newExtents[j]));
+			}
+
+			vst1q_f32(&dest.m_centerX[i], newCenter[0]);
+			vst1q_f32(&dest.m_centerY[i], newCenter[1]);
+			vst1q_f32(&dest.m_centerZ[i], newCenter[2]);
+			vst1q_f32(&dest.m_extentX[i], newExtents[0]);
+			vst1q_f32(&dest.m_extentY[i], newExtents[1]);
+			vst1q_f32(&dest.m_extentZ[i], newExtents[2]);
+		}
+
+		for (int j = 0; j < 3; ++j)
+		{
+			aabb.m_min[j] = vminvq_f32(minBounds[j]);
+			aabb.m_max[j] = vmaxvq_f32(maxBounds[j]);
+		}
+
+		return count;
+	}
+
+	// Four boxes per iteration against every plane, then a branchless compaction of the visible lanes
+	size_t CullBoxesNeon(uint32_t* visibleIndices, const Bounds::FBoxSoA& boxes, const size_t begin, const size_t end, const float planes[][4], const size_t planeCount)
+	{
+		size_t visibleCount = 0;
+		for (size_t i = begin; i < end; i += 4)
+		{
+			const float32x4_t cx = vld1q_f32(&boxes.m_centerX[i]);
+			const float32x4_t cy = vld1q_f32(&boxes.m_centerY[i]);
+			const float32x4_t cz = vld1q_f32(&boxes.m_centerZ[i]);
+			const float32x4_t ex = vld1q_f32(&boxes.m_extentX[i]);
+			const float32x4_t ey = vld1q_f32(&boxes.m_extentY[i]);
+			const float32x4_t ez = vld1q_f32(&boxes.m_extentZ[i]);
+
+			uint32x4_t visible = vdupq_n_u32(~0u);
+			for (size_t p = 0; p < planeCount; ++p)
+			{
+				float32x4_t distance = vdupq_n_f32(planes[p][3]);
+				distance = vfmaq_f32(distance, cx, vdupq_n_f32(planes[p][0]));
+				distance = vfmaq_f32(distance, cy, vdupq_n_f32(planes[p][1]));
+				distance = vfmaq_f32(distance, cz, vdupq_n_f32(planes[p][2]));
+				distance = vfmaq_f32(distance, ex, vdupq_n_f32(std::abs(planes[p][0])));
+				distance = vfmaq_f32(distance, ey, vdupq_n_f32(std::abs(planes[p][1])));
+				distance = vfmaq_f32(distance, ez, vdupq_n_f32(std::abs(planes[p][2])));
+				visible = vandq_u32(visible, vcgeq_f32(distance, vdupq_n_f32(0.f)));
+			}
+
+			uint32_t mask[4];
+			vst1q_u32(mask, visible);
+			for (uint32_t lane = 0; lane < 4; ++lane)
+			{
+				visibleIndices[visibleCount] = (uint32_t)i + lane;
+				visibleCount += mask[lane] & 1;
+			}
+		}
+
+		return visibleCount;
+	}
+#endif
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------------------------
+//														Box SoA
+//-----------------------------------------------------------------------------------------------------------------------------------------------
+
+void Bounds::FBoxSoA::Resize(const size_t count)
+{
+	m_centerX.resize(count);
+	m_centerY.resize(count);
+	m_centerZ.resize(count);
+	m_extentX.resize(count);
+	m_extentY.resize(count);
+	m_extentZ.resize(count);
+}
+
+void Bounds::FBoxSoA::Clear()
+{
+	Resize(0);
+}
+
+void Bounds::FBoxSoA::Set(const size_t index, const float center[3], const float extents[3])
+{
+	m_centerX[index] = center[0];
+	m_centerY[index] = center[1];
+	m_centerZ[index] = center[2];
+	m_extentX[index] = extents[0];
+	m_extentY[index] = extents[1];
+	m_extentZ[index] = extents[2];
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------------------------
+//														Transform
+//-----------------------------------------------------------------------------------------------------------------------------------------------
+
+bool Bounds::HasSimdSupport()
+{
+#if BOUNDS_AVX2
+	static const bool avx2 = CpuSupportsAvx2();
+	return avx2;
+#elif BOUNDS_NEON
+	return true;
+#else
+	return false;
+#endif
+}
+
+Bounds::FAabb Bounds::TransformBoxes(FBoxSoA& dest, const FBoxSoA& src, const float* transforms, const float root[16], const bool allowSimd)
+{
+	constexpr float inf = std::numeric_limits<float>::infinity();
+	FAabb aabb = { { inf, inf, inf }, { -inf, -inf, -inf } };
+	dest.Resize(src.Size());
+
+	// The SIMD kernels stop at the last full batch of boxes and the scalar loop finishes the rest
+	size_t begin = 0;
+	if (allowSimd && HasSimdSupport())
+	{
+#if BOUNDS_AVX2
+		begin = TransformBoxesAvx2(dest, src, transforms, root, aabb);
+#elif BOUNDS_NEON
+		begin = TransformBoxesNeon(dest, src, transforms, root, aabb);
+#endif
+	}
+
+	TransformBoxesScalar(dest, src, transforms, root, begin, aabb);
+	return aabb;
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------------------------
+//														Culling
+//-----------------------------------------------------------------------------------------------------------------------------------------------
+
+size_t Bounds::GetFrustumPlanes(float planes[6][4], const float viewProjection[16])
+{
+	// Gribb-Hartmann extraction for row vectors, the planes are combinations of the projection columns
+	auto GetColumn = [viewProjection](const int column, float dest[4])
+	{
+		for (int row = 0; row < 4; ++row)
+		{
+			dest[row] = viewProjection[row * 4 + column];
+		}
+	};
+
+	float x[4], y[4], z[4], w[4];
+	GetColumn(0, x);
+	GetColumn(1, y);
+	GetColumn(2, z);
+	GetColumn(3, w);
+
+	size_t planeCount = 0;
+	for (int i = 0; i < 6; ++i)
+	{
+		float* plane = planes[planeCount];
+		for (int j = 0; j < 4; ++j)
+		{
+			switch (i)
+			{
+			case 0: plane[j] = w[j] + x[j]; break;
+			case 1: plane[j] = w[j] - x[j]; break;
+			case 2: plane[j] = w[j] + y[j]; break;
+			case 3: plane[j] = w[j] - y[j]; break;
+			case 4: plane[j] = z[j]; break;
+			case 5: plane[j] = w[j] - z[j]; break;
+			}
+		}
+
+		const float length = std::sqrt(plane[0] * plane[0] + plane[1] * plane[1] + plane[2] * plane[2]);
+		if (length > 1e-6f * std::abs(plane[3]) && length > 0.f)
+		{
+			for (int j = 0; j < 4; ++j)
+			{
+				plane[j] /= length;
+			}
+
+			planeCount++;
+		}
+	}
+
+	return planeCount;
+}
+
+size_t Bounds::CullBoxes(uint32_t* visibleIndices, const FBoxSoA& boxes, const size_t begin, const size_t end, const float planes[][4], const size_t planeCount, const bool allowSimd)
+{
+	// The SIMD kernels stop at the last full batch of boxes and the scalar loop finishes the rest
+	size_t visibleCount = 0;
+	size_t simdEnd = begin;
+	if (allowSimd && HasSimdSupport())
+	{
+#if BOUNDS_AVX2
+		simdEnd = begin + ((end - begin) & ~size_t(7));
+		visibleCount = CullBoxesAvx2(visibleIndices, boxes, begin, simdEnd, planes, planeCount);
+#elif BOUNDS_NEON
+		simdEnd = begin + ((end - begin) & ~size_t(3));
+		visibleCount = CullBoxesNeon(visibleIndices, boxes, begin, simdEnd, planes, planeCount);
+#endif
+	}
+
+	return visibleCount + CullBoxesScalar(visibleIndices + visibleCount, boxes, simdEnd, end, planes, planeCount);
+}
+
+float Bounds::MeasureTransformThroughput(const size_t boxCount, const bool allowSimd)
+{
+	// Rotation, scale and translation per box, the kind of transforms a scene graph produces
+	std::mt19937 rng{ 1 };
+	std::uniform_real_distribution<float> dist{ -1.f, 1.f };
+
+	FBoxSoA src, dest;
+	src.Resize(boxCount);
+	std::vector<float> transforms(boxCount * 16);
+	for (size_t i = 0; i < boxCount; ++i)
+	{
+		const float center[3] = { dist(rng), dist(rng), dist(rng) };
+		const float extents[3] = { 1.f + dist(rng), 1.f + dist(rng), 1.f + dist(rng) };
+		src.Set(i, center, extents);
+
+		const float angle = 3.14159265f * dist(rng);
+		const float scale = 1.5f + dist(rng);
+		const float c = std::cos(angle) * scale;
+		const float s = std::sin(angle) * scale;
+		const float transform[16] = { c, 0.f, -s, 0.f, 0.f, scale, 0.f, 0.f, s, 0.f, c, 0.f, 100.f * dist(rng), 100.f * dist(rng), 100.f * dist(rng), 1.f };
+		std::copy(std::begin(transform), std::end(transform), &transforms[i * 16]);
+	}
+
+	const float root[16] = { 0.f, 1.f, 0.f, 0.f, -1.f, 0.f, 0.f, 0.f, 0.f, 0.f, 1.f, 0.f, 0.f, 0.f, 0.f, 1.f };
+
+	// Best of several runs, after a warm up run that brings the data into the cache
+	TransformBoxes(dest, src, transforms.data(), root, allowSimd);
+
+	double bestTime = std::numeric_limits<double>::max();
+	for (int run = 0; run < 16; ++run)
+	{
+		const auto start = std::chrono::high_resolution_clock::now();
+		TransformBoxes(dest, src, transforms.data(), root, allowSimd);
+		const std::chrono::duration<double, std::micro> time = std::chrono::high_resolution_clock::now() - start;
+		bestTime = std::min(bestTime, time.count());
+	}
+
+	return (float)(boxCount / std::max(bestTime, 1e-3));
+}
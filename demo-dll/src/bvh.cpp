@@ -0,0 +1,450 @@
+#include <bvh.h>
+#include <ppl.h>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <random>
+
+namespace
+{
+	constexpr uint32_t k_binCount = 16;
+	constexpr uint32_t k_maxLeafSize = 4;
+	constexpr uint32_t k_maxSahDepth = 40; // deeper nodes are split at the median so that traversal stacks stay bounded
+	constexpr uint32_t k_parallelBuildThreshold = 4096; // primitives
+
+	struct FAabb
+	{
+		float m_min[3] = { std::numeric_limits<float>::max(), std::numeric_limits<float>::max(), std::numeric_limits<float>::max() };
+		float m_max[3] = { -std::numeric_limits<float>::max(), -std::numeric_limits<float>::max(), -std::numeric_limits<float>::max() };
+
+		void Grow(const float min[3], const float max[3])
+		{
+			for (int i = 0; i < 3; ++i)
+			{
+				m_min[i] = std::min(m_min[i], min[i]);
+				m_max[i] = std::max(m_max[i], max[i]);
+			}
+		}
+
+		void Grow(const FAabb& other)
+		{
+			Grow(other.m_min, other.m_max);
+		}
+
+		float GetHalfArea() const
+		{
+			const float dx = m_max[0] - m_min[0];
+			const float dy = m_max[1] - m_min[1];
+			const float dz = m_max[2] - m_min[2];
+			return dx < 0.f ? 0.f : dx * dy + dy * dz + dz * dx;
+		}
+	};
+
+	void GetBox(const Bounds::FBoxSoA& boxes, const uint32_t box, float min[3], float max[3])
+	{
+		min[0] = boxes.m_centerX[box] - boxes.m_extentX[box];
+		min[1] = boxes.m_centerY[box] - boxes.m_extentY[box];
+		min[2] = boxes.m_centerZ[box] - boxes.m_extentZ[box];
+		max[0] = boxes.m_centerX[box] + boxes.m_extentX[box];
+		max[1] = boxes.m_centerY[box] + boxes.m_extentY[box];
+		max[2] = boxes.m_centerZ[box] + boxes.m_extentZ[box];
+	}
+
+	// Entry distance of the ray into the box, infinity if it misses
+	float IntersectBox(const float origin[3], const float invDirection[3], const float maxDistance, const float min[3], const float max[3])
+	{
+		float tMin = 0.f;
+		float tMax = maxDistance;
+		for (int i = 0; i < 3; ++i)
+		{
+			const float t0 = (min[i] - origin[i]) * invDirection[i];
+			const float t1 = (max[i] - origin[i]) * invDirection[i];
+			tMin = std::max(tMin, std::min(t0, t1));
+			tMax = std::min(tMax, std::max(t0, t1));
+		}
+
+		return tMin <= tMax ? tMin : std::numeric_limits<float>::infinity();
+	}
+
+	// Primitives are copied next to their bounds so that the build partitions contiguous memory
+	struct FBuildPrimitive
+	{
+		float m_min[3];
+		float m_max[3];
+		float m_center[3];
+		uint32_t m_index;
+	};
+
+	struct FBvhBuilder
+	{
+		void BuildNode(const uint32_t nodeIndex, const uint32_t first, const uint32_t count, const uint32_t depth)
+		{
+			FBvh::FNode& node = m_nodes[nodeIndex];
+			node.m_first = first;
+			node.m_count = count;
+			node.m_left = 0;
+
+			FBuildPrimitive* begin = &m_buildPrimitives[first];
+			FBuildPrimitive* end = begin + count;
+
+			FAabb bounds, centerBounds;
+			for (const FBuildPrimitive* primitive = begin; primitive != end; ++primitive)
+			{
+				bounds.Grow(primitive->m_min, primitive->m_max);
+				centerBounds.Grow(primitive->m_center, primitive->m_center);
+			}
+
+			std::copy_n(bounds.m_min, 3, node.m_min);
+			std::copy_n(bounds.m_max, 3, node.m_max);
+
+			if (count <= 2)
+			{
+				return;
+			}
+
+			// Binned SAH over the three axes at once, splitting between bins. Small nodes use fewer bins.
+			const uint32_t binCount = std::min(k_binCount, count);
+			float binScales[3];
+			for (int axis = 0; axis < 3; ++axis)
+			{
+				const float extent = centerBounds.m_max[axis] - centerBounds.m_min[axis];
+				binScales[axis] = extent > 0.f ? binCount / extent : 0.f;
+			}
+
+			FAabb binBounds[3][k_binCount];
+			uint32_t binCounts[3][k_binCount] = {};
+			if (depth < k_maxSahDepth)
+			{
+				for (const FBuildPrimitive* primitive = begin; primitive != end; ++primitive)
+				{
+					for (int axis = 0; axis < 3; ++axis)
+					{
+						const uint32_t bin = GetBin(*primitive, axis, centerBounds.m_min[axis], binScales[axis], binCount);
+						binBounds[axis][bin].Grow(primitive->m_min, primitive->m_max);
+						binCounts[axis][bin]++;
+					}
+				}
+			}
+
+			float bestCost = std::numeric_limits<float>::max();
+			int bestAxis = -1;
+			uint32_t bestSplit = 0;
+			for (int axis = 0; axis < 3 && depth < k_maxSahDepth; ++axis)
+			{
+				if (binScales[axis] == 0.f)
+				{
+					continue;
+				}
+
+				// Sweep from the right to get the cost of every right side, then from the left
+				float rightCosts[k_binCount];
+				FAabb right;
+				uint32_t rightCount = 0;
+				for (uint32_t bin = binCount - 1; bin > 0; --bin)
+				{
+					right.Grow(binBounds[axis][bin]);
+					rightCount += binCounts[axis][bin];
+					rightCosts[bin] = right.GetHalfArea() * rightCount;
+				}
+
+				FAabb left;
+				uint32_t leftCount = 0;
+				for (uint32_t split = 1; split < binCount; ++split)
+				{
+					left.Grow(binBounds[axis][split - 1]);
+					leftCount += binCounts[axis][split - 1];
+					const float cost = left.GetHalfArea() * leftCount + rightCosts[split];
+					if (leftCount > 0 && leftCount < count && cost < bestCost)
+					{
+						bestCost = cost;
+						bestAxis = axis;
+						bestSplit = split;
+					}
+				}
+			}
+
+			// Traversal costs as much as one box test
+			const float leafCost = bounds.GetHalfArea() * count;
+			if (count <= k_maxLeafSize && bestCost >= leafCost - bounds.GetHalfArea())
+			{
+				return;
+			}
+
+			FBuildPrimitive* middle = nullptr;
+			if (bestAxis >= 0)
+			{
+				middle = std::partition(begin, end, [&](const FBuildPrimitive& primitive)
+				{
+					return GetBin(primitive, bestAxis, centerBounds.m_min[bestAxis], binScales[bestAxis], binCount) < bestSplit;
+				});
+			}
+			else
+			{
+				// Too deep or every center in the same place, split at the median of the largest axis
+				int axis = 0;
+				for (int i = 1; i < 3; ++i)
+				{
+					axis = centerBounds.m_max[i] - centerBounds.m_min[i] > centerBounds.m_max[axis] - centerBounds.m_min[axis] ? i : axis;
+				}
+
+				middle = begin + count / 2;
+				std::nth_element(begin, middle, end, [axis](const FBuildPrimitive& a, const FBuildPrimitive& b)
+				{
+					return a.m_center[axis] < b.m_center[axis];
+				});
+			}
+
+			const uint32_t leftCount = (uint32_t)(middle - begin);
+			const uint32_t left = m_nodeCount.fetch_add(2);
+			node.m_left = left;
+
+			auto BuildLeft = [=, this] { BuildNode(left, first, leftCount, depth + 1); };
+			auto BuildRight = [=, this] { BuildNode(left + 1, first + leftCount, count - leftCount, depth + 1); };
+			if (count > k_parallelBuildThreshold)
+			{
+				concurrency::parallel_invoke(BuildLeft, BuildRight);
+			}
+			else
+			{
+				BuildLeft();
+				BuildRight();
+			}
+		}
+
+		static uint32_t GetBin(const FBuildPrimitive& primitive, const int axis, const float minCenter, const float binScale, const uint32_t binCount)
+		{
+			return std::min((uint32_t)((primitive.m_center[axis] - minCenter) * binScale), binCount - 1);
+		}
+
+		std::vector<FBvh::FNode>& m_nodes;
+		std::vector<FBuildPrimitive> m_buildPrimitives;
+		std::atomic<uint32_t> m_nodeCount;
+	};
+}
+
+void FBvh::Build(const Bounds::FBoxSoA& boxes)
+{
+	Clear();
+
+	const size_t count = boxes.Size();
+	if (count == 0)
+	{
+		return;
+	}
+
+	// A binary tree with leaves of at least one primitive has at most 2n - 1 nodes
+	m_nodes.resize(2 * count - 1);
+
+	// Node 0 is the root, its children are allocated from m_nodeCount on
+	FBvhBuilder builder{ m_nodes, std::vector<FBuildPrimitive>(count), 1 };
+	concurrency::parallel_for(size_t(0), count, size_t(k_parallelBuildThreshold), [&](const size_t begin)
+	{
+		for (size_t i = begin; i < std::min(begin + k_parallelBuildThreshold, count); ++i)
+		{
+			FBuildPrimitive& primitive = builder.m_buildPrimitives[i];
+			GetBox(boxes, (uint32_t)i, primitive.m_min, primitive.m_max);
+			primitive.m_center[0] = boxes.m_centerX[i];
+			primitive.m_center[1] = boxes.m_centerY[i];
+			primitive.m_center[2] = boxes.m_centerZ[i];
+			primitive.m_index = (uint32_t)i;
+		}
+	});
+
+	builder.BuildNode(0, 0, (uint32_t)count, 0);
+	m_nodes.resize(builder.m_nodeCount);
+
+	m_primitives.resize(count);
+	for (size_t i = 0; i < count; ++i)
+	{
+		m_primitives[i] = builder.m_buildPrimitives[i].m_index;
+	}
+
+	m_buildCost = GetCost();
+}
+
+float FBvh::Refit(const Bounds::FBoxSoA& boxes)
+{
+	// Children are always allocated after their parent
+	for (size_t i = m_nodes.size(); i-- > 0;)
+	{
+		FNode& node = m_nodes[i];
+		FAabb bounds;
+		if (node.m_left == 0)
+		{
+			for (uint32_t j = node.m_first; j < node.m_first + node.m_count; ++j)
+			{
+				float min[3], max[3];
+				GetBox(boxes, m_primitives[j], min, max);
+				bounds.Grow(min, max);
+			}
+		}
+		else
+		{
+			bounds.Grow(m_nodes[node.m_left].m_min, m_nodes[node.m_left].m_max);
+			bounds.Grow(m_nodes[node.m_left + 1].m_min, m_nodes[node.m_left + 1].m_max);
+		}
+
+		std::copy_n(bounds.m_min, 3, node.m_min);
+		std::copy_n(bounds.m_max, 3, node.m_max);
+	}
+
+	return m_buildCost > 0.f ? GetCost() / m_buildCost : 1.f;
+}
+
+void FBvh::Clear()
+{
+	m_nodes.clear();
+	m_primitives.clear();
+	m_buildCost = 0.f;
+}
+
+float FBvh::GetCost() const
+{
+	// Expected number of node and box tests for a ray through the root, up to the root area which cancels out in the ratio
+	float cost = 0.f;
+	for (const FNode& node : m_nodes)
+	{
+		FAabb bounds;
+		bounds.Grow(node.m_min, node.m_max);
+		cost += bounds.GetHalfArea() * (node.m_left == 0 ? node.m_count : 1);
+	}
+
+	return cost;
+}
+
+bool FBvh::Raycast(const float origin[3], const float direction[3], const float maxDistance, const Bounds::FBoxSoA& boxes, uint32_t& hitIndex, float& hitDistance) const
+{
+	if (m_nodes.empty())
+	{
+		return false;
+	}
+
+	const float invDirection[3] = { 1.f / direction[0], 1.f / direction[1], 1.f / direction[2] };
+	float nearest = maxDistance;
+	bool hit = false;
+
+	uint32_t stack[64];
+	uint32_t stackSize = 0;
+	stack[stackSize++] = 0;
+	while (stackSize > 0)
+	{
+		const FNode& node = m_nodes[stack[--stackSize]];
+		if (node.m_left == 0)
+		{
+			for (uint32_t i = node.m_first; i < node.m_first + node.m_count; ++i)
+			{
+				float min[3], max[3];
+				GetBox(boxes, m_primitives[i], min, max);
+				const float distance = IntersectBox(origin, invDirection, nearest, min, max);
+				if (distance < nearest)
+				{
+					nearest = distance;
+					hitIndex = m_primitives[i];
+					hit = true;
+				}
+			}
+
+			continue;
+		}
+
+		// Visit the nearest child first so that the farther one is more likely to be pruned
+		const FNode& left = m_nodes[node.m_left];
+		const FNode& right = m_nodes[node.m_left + 1];
+		const float leftDistance = IntersectBox(origin, invDirection, nearest, left.m_min, left.m_max);
+		const float rightDistance = IntersectBox(origin, invDirection, nearest, right.m_min, right.m_max);
+		const bool leftFirst = leftDistance <= rightDistance;
+		const float farDistance = leftFirst ? rightDistance : leftDistance;
+		const float nearDistance = leftFirst ? leftDistance : rightDistance;
+		if (farDistance < nearest)
+		{
+			stack[stackSize++] = leftFirst ? node.m_left + 1 : node.m_left;
+		}
+
+		if (nearDistance < nearest)
+		{
+			stack[stackSize++] = leftFirst ? node.m_left : node.m_left + 1;
+		}
+	}
+
+	hitDistance = nearest;
+	return hit;
+}
+
+BvhBenchmark::FResult BvhBenchmark::Run(const size_t boxCount)
+{
+	using Clock = std::chrono::high_resolution_clock;
+	const float sceneSize = 10.f * std::cbrt((float)boxCount);
+
+	std::mt19937 rng{ 1 };
+	std::uniform_real_distribution<float> position{ 0.f, sceneSize };
+	std::uniform_real_distribution<float> extent{ 0.5f, 2.f };
+
+	Bounds::FBoxSoA boxes;
+	boxes.Resize(boxCount);
+	for (size_t i = 0; i < boxCount; ++i)
+	{
+		const float center[3] = { position(rng), position(rng), position(rng) };
+		const float extents[3] = { extent(rng), extent(rng), extent(rng) };
+		boxes.Set(i, center, extents);
+	}
+
+	FResult result = {};
+	FBvh bvh;
+	auto start = Clock::now();
+	bvh.Build(boxes);
+	result.m_buildTime = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+	for (size_t i = 0; i < boxCount; ++i)
+	{
+		boxes.m_centerX[i] += 0.1f;
+	}
+
+	start = Clock::now();
+	bvh.Refit(boxes);
+	result.m_refitTime = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+	// Box queries covering an eighth of the scene
+	constexpr int queryCount = 16;
+	std::vector<uint32_t> results(boxCount);
+	std::uniform_real_distribution<float> queryPosition{ 0.f, 0.5f * sceneSize };
+	start = Clock::now();
+	for (int query = 0; query < queryCount; ++query)
+	{
+		const float queryMin[3] = { queryPosition(rng), queryPosition(rng), queryPosition(rng) };
+		const float queryMax[3] = { queryMin[0] + 0.5f * sceneSize, queryMin[1] + 0.5f * sceneSize, queryMin[2] + 0.5f * sceneSize };
+		bvh.Cull(results.data(), boxes, [&](const float min[3], const float max[3])
+		{
+			bool inside = true;
+			for (int i = 0; i < 3; ++i)
+			{
+				if (max[i] < queryMin[i] || min[i] > queryMax[i])
+				{
+					return FBvh::Containment::Outside;
+				}
+
+				inside = inside && min[i] >= queryMin[i] && max[i] <= queryMax[i];
+			}
+
+			return inside ? FBvh::Containment::Inside : FBvh::Containment::Intersects;
+		});
+	}
+
+	result.m_cullTime = std::chrono::duration<double, std::micro>(Clock::now() - start).count() / queryCount;
+
+	// Rays from inside the scene in random directions
+	constexpr int rayCount = 1000;
+	std::uniform_real_distribution<float> direction{ -1.f, 1.f };
+	start = Clock::now();
+	for (int ray = 0; ray < rayCount; ++ray)
+	{
+		const float rayOrigin[3] = { position(rng), position(rng), position(rng) };
+		const float rayDirection[3] = { direction(rng), direction(rng), direction(rng) };
+		uint32_t hitIndex;
+		float hitDistance;
+		bvh.Raycast(rayOrigin, rayDirection, std::numeric_limits<float>::infinity(), boxes, hitIndex, hitDistance);
+	}
+
+	result.m_raycastTime = std::chrono::duration<double, std::micro>(Clock::now() - start).count() / rayCount;
+	return result;
+}
@@ -0,0 +1,209 @@
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#include <content-index.h>
+#include <common.h>
+#include <algorithm>
+#include <atomic>
+#include <shared_mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace
+{
+	std::shared_mutex s_indexMutex;
+	std::unordered_map<std::wstring, std::vector<std::filesystem::path>> s_index;
+	std::atomic<uint64_t> s_changeCount = 0;
+
+	std::thread s_watcherThread;
+	HANDLE s_directoryHandle = INVALID_HANDLE_VALUE;
+	HANDLE s_stopEvent = nullptr;
+
+	void AddFile(const std::filesystem::path& filepath)
+	{
+		std::vector<std::filesystem::path>& paths = s_index[filepath.filename().wstring()];
+		if (std::find(paths.cbegin(), paths.cend(), filepath) == paths.cend())
+		{
+			paths.push_back(filepath);
+		}
+	}
+
+	void RemoveFile(const std::filesystem::path& filepath)
+	{
+		auto it = s_index.find(filepath.filename().wstring());
+		if (it != s_index.end())
+		{
+			std::erase(it->second, filepath);
+			if (it->second.empty())
+			{
+				s_index.erase(it);
+			}
+		}
+	}
+
+	// Never throws since it runs on the watcher thread. Files that vanish or are locked during the walk are skipped, and the
+	// walk ends early if the directory itself goes away. The notifications that follow bring the index up to date.
+	void AddDirectory(const std::filesystem::path& directory)
+	{
+		std::error_code ec;
+		const std::filesystem::recursive_directory_iterator end;
+		for (std::filesystem::recursive_directory_iterator it{ directory, std::filesystem::directory_options::skip_permission_denied, ec }; !ec && it != end; it.increment(ec))
+		{
+			std::error_code fileEc;
+			if (it->is_regular_file(fileEc))
+			{
+				AddFile(it->path().lexically_normal());
+			}
+		}
+	}
+
+	void Rebuild()
+	{
+		std::unique_lock lock{ s_indexMutex };
+		s_index.clear();
+		AddDirectory(CONTENT_DIR);
+	}
+
+	// Applies change notifications to the index until the stop event is signaled
+	void WatchContentDir()
+	{
+		alignas(DWORD) uint8_t buffer[64 * 1024];
+		OVERLAPPED overlapped = {};
+		overlapped.hEvent = CreateEvent(nullptr, TRUE, FALSE, nullptr);
+
+		constexpr DWORD notifyFilter = FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_DIR_NAME | FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_SIZE;
+		while (ReadDirectoryChangesW(s_directoryHandle, buffer, sizeof(buffer), TRUE, notifyFilter, nullptr, &overlapped, nullptr))
+		{
+			HANDLE waitHandles[] = { s_stopEvent, overlapped.hEvent };
+			if (WaitForMultipleObjects(2, waitHandles, FALSE, INFINITE) != WAIT_OBJECT_0 + 1)
+			{
+				CancelIo(s_directoryHandle);
+				break;
+			}
+
+			DWORD bytesReturned = 0;
+			GetOverlappedResult(s_directoryHandle, &overlapped, &bytesReturned, FALSE);
+			ResetEvent(overlapped.hEvent);
+
+			// The notification buffer overflowed, the only way to catch up is a full rescan
+			if (bytesReturned == 0)
+			{
+				Rebuild();
+				s_changeCount++;
+				continue;
+			}
+
+			std::unique_lock lock{ s_indexMutex };
+			const FILE_NOTIFY_INFORMATION* info = (const FILE_NOTIFY_INFORMATION*)buffer;
+			while (true)
+			{
+				const std::filesystem::path filepath = (std::filesystem::path{ CONTENT_DIR } / std::wstring{ info->FileName, info->FileNameLength / sizeof(wchar_t) }).lexically_normal();
+
+				switch (info->Action)
+				{
+				case FILE_ACTION_ADDED:
+				case FILE_ACTION_RENAMED_NEW_NAME:
+				{
+					std::error_code ec;
+					if (std::filesystem::is_regular_file(filepath, ec))
+					{
+						AddFile(filepath);
+					}
+					else if (std::filesystem::is_directory(filepath, ec))
+					{
+						// A directory moved into the tree only notifies for the directory itself
+						AddDirectory(filepath);
+					}
+					break;
+				}
+
+				case FILE_ACTION_REMOVED:
+				case FILE_ACTION_RENAMED_OLD_NAME:
+					RemoveFile(filepath);
+
+					// The path may have been a directory, drop everything below it
+					for (auto& [filename, paths] : s_index)
+					{
+						std::erase_if(paths, [&filepath](const std::filesystem::path& p)
+						{
+							return p.native().starts_with(filepath.native() + std::filesystem::path::preferred_separator);
+						});
+					}
+					std::erase_if(s_index, [](const auto& entry) { return entry.second.empty(); });
+					break;
+				}
+
+				if (info->NextEntryOffset == 0)
+				{
+					break;
+				}
+
+				info = (const FILE_NOTIFY_INFORMATION*)((const uint8_t*)info + info->NextEntryOffset);
+			}
+
+			s_changeCount++;
+		}
+
+		CloseHandle(overlapped.hEvent);
+	}
+}
+
+bool ContentIndex::Initialize()
+{
+	Rebuild();
+
+	s_directoryHandle = CreateFileW(
+		std::filesystem::path{ CONTENT_DIR }.c_str(),
+		FILE_LIST_DIRECTORY,
+		FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+		nullptr,
+		OPEN_EXISTING,
+		FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED,
+		nullptr);
+
+	if (s_directoryHandle == INVALID_HANDLE_VALUE)
+	{
+		// The index still works, it just won't see files added while running
+		return false;
+	}
+
+	s_stopEvent = CreateEvent(nullptr, TRUE, FALSE, nullptr);
+	s_watcherThread = std::thread{ WatchContentDir };
+	return true;
+}
+
+void ContentIndex::Teardown()
+{
+	if (s_watcherThread.joinable())
+	{
+		SetEvent(s_stopEvent);
+		s_watcherThread.join();
+	}
+
+	if (s_stopEvent)
+	{
+		CloseHandle(s_stopEvent);
+		s_stopEvent = nullptr;
+	}
+
+	if (s_directoryHandle != INVALID_HANDLE_VALUE)
+	{
+		CloseHandle(s_directoryHandle);
+		s_directoryHandle = INVALID_HANDLE_VALUE;
+	}
+
+	std::unique_lock lock{ s_indexMutex };
+	s_index.clear();
+}
+
+std::filesystem::path ContentIndex::Find(const std::wstring& filename)
+{
+	std::shared_lock lock{ s_indexMutex };
+	auto it = s_index.find(filename);
+	return it != s_index.cend() ? it->second.front() : std::filesystem::path{};
+}
+
+uint64_t ContentIndex::GetChangeCount()
+{
+	return s_changeCount;
+}
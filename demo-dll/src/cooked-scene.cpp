@@ -0,0 +1,244 @@
+#include <cooked-scene.h>
+#include <common.h>
+#include <fstream>
+
+namespace
+{
+	constexpr size_t AlignUp(const size_t value, const size_t alignment)
+	{
+		return (value + alignment - 1) & ~(alignment - 1);
+	}
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------------------------
+//														Cooked Scene
+//-----------------------------------------------------------------------------------------------------------------------------------------------
+
+FCookedScene::~FCookedScene()
+{
+	Close();
+}
+
+bool FCookedScene::Open(const std::filesystem::path& filepath)
+{
+	Close();
+
+	m_file = CreateFileW(filepath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (m_file == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+
+	LARGE_INTEGER fileSize = {};
+	if (!GetFileSizeEx(m_file, &fileSize) || (size_t)fileSize.QuadPart < sizeof(CookedScene::FHeader))
+	{
+		Close();
+		return false;
+	}
+
+	m_sizeInBytes = (size_t)fileSize.QuadPart;
+	m_mapping = CreateFileMappingW(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	m_view = m_mapping ? (const uint8_t*)MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+	if (!m_view)
+	{
+		Close();
+		return false;
+	}
+
+	// Reject files from older cooks or truncated writes
+	const CookedScene::FHeader* header = GetHeader();
+	bool valid = header->m_magic == CookedScene::k_magic && header->m_version == CookedScene::k_version;
+	for (const CookedScene::FSectionEntry& section : header->m_sections)
+	{
+		valid = valid && section.m_offset % CookedScene::k_sectionAlignment == 0 && section.m_offset + section.m_size <= m_sizeInBytes;
+	}
+
+	if (!valid)
+	{
+		Close();
+	}
+
+	return valid;
+}
+
+void FCookedScene::Close()
+{
+	if (m_view)
+	{
+		UnmapViewOfFile(m_view);
+		m_view = nullptr;
+	}
+
+	if (m_mapping)
+	{
+		CloseHandle(m_mapping);
+		m_mapping = nullptr;
+	}
+
+	if (m_file != INVALID_HANDLE_VALUE)
+	{
+		CloseHandle(m_file);
+		m_file = INVALID_HANDLE_VALUE;
+	}
+
+	m_sizeInBytes = 0;
+}
+
+bool FCookedScene::IsUpToDate() const
+{
+	for (const CookedScene::FDependency& dependency : GetSection<CookedScene::FDependency>(CookedScene::Section::Dependencies))
+	{
+		std::error_code ec;
+		const std::filesystem::path filepath{ GetString(dependency.m_pathOffset) };
+		const auto lastWriteTime = std::filesystem::last_write_time(filepath, ec);
+		const uintmax_t size = ec ? 0 : std::filesystem::file_size(filepath, ec);
+
+		if (ec || lastWriteTime.time_since_epoch().count() != dependency.m_lastWriteTime || size != dependency.m_size)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+const CookedScene::FHeader* FCookedScene::GetHeader() const
+{
+	DebugAssert(m_view != nullptr, "Cooked scene is not open");
+	return (const CookedScene::FHeader*)m_view;
+}
+
+std::span<const uint8_t> FCookedScene::GetSectionData(const CookedScene::Section section) const
+{
+	const CookedScene::FSectionEntry& entry = GetHeader()->m_sections[(size_t)section];
+	return { m_view + entry.m_offset, (size_t)entry.m_size };
+}
+
+const char* FCookedScene::GetString(const uint32_t offset) const
+{
+	std::span<const uint8_t> strings = GetSectionData(CookedScene::Section::Strings);
+	DebugAssert(offset < strings.size(), "Invalid string offset");
+	return (const char*)strings.data() + offset;
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------------------------
+//														Cooked Scene Writer
+//-----------------------------------------------------------------------------------------------------------------------------------------------
+
+FCookedSceneWriter::FCookedSceneWriter()
+{
+	// Offset 0 is always the empty string
+	AddString({});
+}
+
+uint32_t FCookedSceneWriter::AddString(const std::string& str)
+{
+	std::vector<uint8_t>& strings = m_sections[(size_t)CookedScene::Section::Strings];
+	const uint32_t offset = (uint32_t)strings.size();
+	strings.insert(strings.end(), str.cbegin(), str.cend());
+	strings.push_back('\0');
+	return offset;
+}
+
+void FCookedSceneWriter::AddDependency(const std::filesystem::path& filepath)
+{
+	CookedScene::FDependency dependency = {};
+	dependency.m_pathOffset = AddString(filepath.string());
+	dependency.m_lastWriteTime = std::filesystem::last_write_time(filepath).time_since_epoch().count();
+	dependency.m_size = std::filesystem::file_size(filepath);
+	Append(CookedScene::Section::Dependencies, &dependency, sizeof(dependency));
+}
+
+void FCookedSceneWriter::Append(const CookedScene::Section section, const void* data, const size_t sizeInBytes)
+{
+	std::vector<uint8_t>& dest = m_sections[(size_t)section];
+	dest.insert(dest.end(), (const uint8_t*)data, (const uint8_t*)data + sizeInBytes);
+}
+
+bool FCookedSceneWriter::Write(const std::filesystem::path& filepath, const DirectX::BoundingBox& sceneBounds, const uint32_t flags) const
+{
+	CookedScene::FHeader header = {};
+	header.m_magic = CookedScene::k_magic;
+	header.m_version = CookedScene::k_version;
+	header.m_flags = flags;
+	header.m_sceneBounds = sceneBounds;
+
+	size_t offset = AlignUp(sizeof(header), CookedScene::k_sectionAlignment);
+	for (size_t i = 0; i < (size_t)CookedScene::Section::Count; ++i)
+	{
+		header.m_sections[i].m_offset = offset;
+		header.m_sections[i].m_size = m_sections[i].size();
+		offset = AlignUp(offset + m_sections[i].size(), CookedScene::k_sectionAlignment);
+	}
+
+	// Write to a temporary file first so that an interrupted cook never leaves a valid looking scene behind
+	std::error_code ec;
+	std::filesystem::create_directories(filepath.parent_path(), ec);
+
+	std::filesystem::path tempFilepath = filepath;
+	tempFilepath += ".tmp";
+
+	{
+		std::ofstream file{ tempFilepath, std::ios::binary | std::ios::trunc };
+		if (!file)
+		{
+			return false;
+		}
+
+		const char padding[CookedScene::k_sectionAlignment] = {};
+		file.write((const char*)&header, sizeof(header));
+		file.write(padding, AlignUp(sizeof(header), CookedScene::k_sectionAlignment) - sizeof(header));
+
+		for (const std::vector<uint8_t>& section : m_sections)
+		{
+			file.write((const char*)section.data(), section.size());
+			file.write(padding, AlignUp(section.size(), CookedScene::k_sectionAlignment) - section.size());
+		}
+
+		if (!file)
+		{
+			return false;
+		}
+	}
+
+	std::filesystem::rename(tempFilepath, filepath, ec);
+	return !ec;
+}
+
+std::filesystem::path CookedScene::GetCookedFilepath(const std::string& sceneFilename)
+{
+	return std::filesystem::path{ CACHE_DIR } / (sceneFilename + ".dscene");
+}
+
+std::vector<CookedScene::FByteRange> CookedScene::GetMeshGeometryRanges(const FMesh& mesh, std::span<const MeshOptimizer::FMeshlet> meshlets, const uint32_t flags)
+{
+	const bool quantized = (flags & QuantizedVertices) != 0;
+	const size_t positionStride = quantized ? 4 * sizeof(uint16_t) : 3 * sizeof(float);
+	const size_t normalStride = quantized ? 2 * sizeof(uint16_t) : 3 * sizeof(float);
+	const size_t uvStride = quantized ? 2 * sizeof(uint16_t) : 2 * sizeof(float);
+	const size_t indexSize = mesh.m_indexFormat == DXGI_FORMAT_R16_UINT ? sizeof(uint16_t) : sizeof(uint32_t);
+
+	std::vector<FByteRange> ranges;
+
+	// Index ranges are dword padded
+	for (uint32_t lod = 0; lod < mesh.m_lodCount; ++lod)
+	{
+		ranges.push_back({ Section::IndexData, mesh.m_lods[lod].m_indexOffset * indexSize, AlignUp(mesh.m_lods[lod].m_indexCount * indexSize, 4) });
+	}
+
+	ranges.push_back({ Section::PositionData, mesh.m_positionOffset * positionStride, mesh.m_vertexCount * positionStride });
+	ranges.push_back({ Section::NormalData, mesh.m_normalOffset * normalStride, mesh.m_vertexCount * normalStride });
+	ranges.push_back({ Section::UvData, mesh.m_uvOffset * uvStride, mesh.m_vertexCount * uvStride });
+
+	if (mesh.m_meshletCount > 0)
+	{
+		const MeshOptimizer::FMeshlet& first = meshlets[mesh.m_meshletOffset];
+		const MeshOptimizer::FMeshlet& last = meshlets[mesh.m_meshletOffset + mesh.m_meshletCount - 1];
+		ranges.push_back({ Section::Meshlets, mesh.m_meshletOffset * sizeof(MeshOptimizer::FMeshlet), mesh.m_meshletCount * sizeof(MeshOptimizer::FMeshlet) });
+		ranges.push_back({ Section::MeshletBounds, mesh.m_meshletOffset * sizeof(MeshOptimizer::FMeshletBounds), mesh.m_meshletCount * sizeof(MeshOptimizer::FMeshletBounds) });
+		ranges.push_back({ Section::MeshletVertices, first.m_vertexOffset * sizeof(uint32_t), (last.m_vertexOffset + last.m_vertexCount - first.m_vertexOffset) * sizeof(uint32_t) });
+		ranges.push_back({ Section::MeshletTriangles, first.m_triangleOffset * sizeof(uint32_t), (last.m_triangleOffset + last.m_triangleCount - first.m_triangleOffset) * sizeof(uint32_t) });
+	}
+
+	return ranges;
+}
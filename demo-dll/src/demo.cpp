@@ -7,8 +7,27 @@
 #include <imgui_impl_win32.h>
 #include <common.h>
 #include <sstream>
+#include <cooked-scene.h>
+#include <mesh-optimizer.h>
+#include <bounds.h>
+#include <occlusion.h>
+#include <bvh.h>
+#include <block-compression.h>
+#include <mip-chain.h>
 #include <tiny_gltf.h>
 #include <concurrent_unordered_map.h>
+#include <concurrent_queue.h>
+#include <ppl.h>
+#include <ppltasks.h>
+#include <map>
+#include <span>
+#include <fstream>
+#include <iomanip>
+#include <spookyhash_api.h>
+#include <DirectXPackedVector.h>
+#include <algorithm>
+#include <chrono>
+#include <atomic>
 
 namespace
 {
@@ -21,6 +40,67 @@ namespace
 			0.f,						0.f,					n,		0.f
 		};
 	}
+
+	// Maps v from [bias, bias + 65535 * scale] to the full unorm16 range
+	uint16_t QuantizeUnorm16(const float v, const float bias, const float scale)
+	{
+		return scale > 0.f ? (uint16_t)std::clamp<long>(std::lround((v - bias) / scale), 0, 65535) : 0;
+	}
+
+	// Octahedral encoding of a unit vector stored as snorm16x2, x in the low half
+	uint32_t PackOctahedralSnorm16(Vector3 n)
+	{
+		const float l1 = std::abs(n.x) + std::abs(n.y) + std::abs(n.z);
+		if (l1 == 0.f)
+		{
+			return 0;
+		}
+
+		n /= l1;
+		Vector2 oct = n.z >= 0.f ? Vector2{ n.x, n.y } :
+			Vector2{ (1.f - std::abs(n.y)) * (n.x >= 0.f ? 1.f : -1.f), (1.f - std::abs(n.x)) * (n.y >= 0.f ? 1.f : -1.f) };
+
+		auto ToSnorm16 = [](const float v) { return (uint32_t)(uint16_t)(int16_t)std::lround(std::clamp(v, -1.f, 1.f) * 32767.f); };
+		return ToSnorm16(oct.x) | (ToSnorm16(oct.y) << 16);
+	}
+
+	// Settings that change the cooked output. A cooked scene built with other settings is recooked.
+	uint32_t GetSceneCookFlags()
+	{
+		return (Settings::k_quantizeVertices ? CookedScene::QuantizedVertices : 0) |
+			(Settings::k_optimizeOverdraw ? CookedScene::OverdrawOptimized : 0) |
+			(Settings::k_meshLodCount << CookedScene::LodCountShift);
+	}
+
+	int64_t GetLastWriteTime(const std::filesystem::path& filepath)
+	{
+		std::error_code ec;
+		const auto lastWriteTime = std::filesystem::last_write_time(filepath, ec);
+		return ec ? 0 : lastWriteTime.time_since_epoch().count();
+	}
+
+	// Object space box of every instance, taken from the bounds of its mesh
+	void GetInstanceBounds(Bounds::FBoxSoA& dest, const std::span<const DirectX::BoundingBox> meshBounds, const std::span<const uint32_t> instanceMeshIndices)
+	{
+		dest.Resize(instanceMeshIndices.size());
+		for (size_t i = 0; i < instanceMeshIndices.size(); ++i)
+		{
+			const DirectX::BoundingBox& bounds = meshBounds[instanceMeshIndices[i]];
+			dest.Set(i, &bounds.Center.x, &bounds.Extents.x);
+		}
+	}
+
+	DirectX::BoundingBox ToBoundingBox(const Bounds::FAabb& aabb)
+	{
+		if (aabb.m_min[0] > aabb.m_max[0])
+		{
+			return {};
+		}
+
+		DirectX::BoundingBox bounds;
+		DirectX::BoundingBox::CreateFromPoints(bounds, DirectX::XMVectorSet(aabb.m_min[0], aabb.m_min[1], aabb.m_min[2], 0.f), DirectX::XMVectorSet(aabb.m_max[0], aabb.m_max[1], aabb.m_max[2], 0.f));
+		return bounds;
+	}
 }
 
 //-----------------------------------------------------------------------------------------------------------------------------------------------
@@ -38,11 +118,58 @@ struct FTextureCache
 		const DirectX::Image* images,
 		const size_t imageCount);
 
+	// Mips of a block compressed texture, from m_firstMip to the last one
+	struct FCompressedTexture
+	{
+		DirectX::TexMetadata m_metadata; // of the whole mip chain
+		DirectX::ScratchImage m_mips;
+		uint32_t m_firstMip = 0;
+		std::filesystem::path m_cachedFilepath; // whole mip chain, empty if it could not be written to the disk cache
+	};
+
+	// Returns false and logs the file if it cannot be read or decoded
+	bool LoadCompressedTexture2D(
+		const std::filesystem::path& filepath,
+		const uint64_t byteOffset,
+		const uint64_t byteSize,
+		const CookedScene::TextureUsage usage,
+		FCompressedTexture& texture,
+		const uint32_t maxMipSize = ~0u);
+
+	// Mips [firstMip, firstMip + mipCount) of a texture in the disk cache, see FCompressedTexture::m_cachedFilepath
+	static DirectX::ScratchImage LoadCompressedMips(
+		const std::filesystem::path& filepath,
+		const DirectX::TexMetadata& metadata,
+		const uint32_t firstMip,
+		const uint32_t mipCount);
+
+	// Creates the texture with the mips that were loaded and streams the more detailed ones in from the disk cache as they
+	// are requested, see FScene::StreamTextures. Textures that are fully loaded or cannot be streamed go through CacheTexture2D.
+	uint32_t CacheStreamingTexture2D(
+		FResourceUploadContext* uploadContext,
+		const std::wstring& name,
+		const FCompressedTexture& texture);
+
 	FLightProbe CacheHdrTexture(const std::wstring& name);
 
+	// Drops a cached texture. It is released once the GPU has completed dependentCL and everything submitted before it.
+	void Evict(const std::wstring& name, const FCommandList* dependentCL);
+
 	void Clear();
 
 	concurrency::concurrent_unordered_map<std::wstring, std::unique_ptr<FBindlessShaderResource>> m_cachedTextures;
+
+	struct FStreamingTexture
+	{
+		DirectX::TexMetadata m_metadata;
+		std::filesystem::path m_cachedFilepath;
+		uint32_t m_residentMip; // most detailed mip exposed by the SRV
+		uint32_t m_requestedMip; // most detailed mip resident or being read from disk
+		concurrency::task<std::shared_ptr<DirectX::ScratchImage>> m_pendingMips; // [m_requestedMip, m_residentMip)
+	};
+
+	// Render thread only
+	std::map<std::wstring, FStreamingTexture> m_streamingTextures;
 };
 
 //-----------------------------------------------------------------------------------------------------------------------------------------------
@@ -135,6 +262,11 @@ namespace Demo
 	FController s_controller;
 	FTextureCache s_textureCache;
 	float s_aspectRatio;
+	uint32_t s_resY;
+	uint64_t s_contentChangeCount;
+	uint64_t s_pendingContentChangeCount;
+	std::chrono::steady_clock::time_point s_pendingContentChangeTime;
+	bool s_resetViewOnLoad;
 
 	const FScene* GetScene()
 	{
@@ -150,11 +282,13 @@ namespace Demo
 bool Demo::Initialize(const HWND& windowHandle, const uint32_t resX, const uint32_t resY)
 {
 	s_aspectRatio = resX / (float)resY;
+	s_resY = resY;
 
 	Profiling::Initialize();
 
 	bool ok = RenderBackend12::Initialize(windowHandle, resX, resY);
 	ok = ok && ShaderCompiler::Initialize();
+	ContentIndex::Initialize();
 
 	IMGUI_CHECKVERSION();
 	ImGui::CreateContext();
@@ -167,13 +301,41 @@ bool Demo::Initialize(const HWND& windowHandle, const uint32_t resX, const uint3
 void Demo::Tick(float deltaTime)
 {
 	// Reload scene file if required
+	const uint64_t contentChangeCount = ContentIndex::GetChangeCount();
 	if (s_scene.m_sceneFilename.empty() ||
 		s_scene.m_sceneFilename != Settings::k_sceneFilename)
 	{
+		s_contentChangeCount = s_pendingContentChangeCount = contentChangeCount;
+		s_resetViewOnLoad = true;
 		RenderBackend12::FlushGPU();
 		s_scene.Reload(Settings::k_sceneFilename);
 		s_view.Reset(s_scene);
 	}
+	else if (!s_scene.IsLoading() && contentChangeCount != s_pendingContentChangeCount)
+	{
+		// Editors save in several writes, wait for the content to settle before reloading. Edits made during a load are
+		// picked up once it completes.
+		s_pendingContentChangeCount = contentChangeCount;
+		s_pendingContentChangeTime = std::chrono::steady_clock::now();
+	}
+	else if (!s_scene.IsLoading() && s_pendingContentChangeCount != s_contentChangeCount &&
+		std::chrono::steady_clock::now() - s_pendingContentChangeTime > std::chrono::milliseconds(250))
+	{
+		// Patch the scene in place and only flush the GPU when the scene layout changed
+		s_contentChangeCount = s_pendingContentChangeCount;
+		if (!s_scene.HotReload())
+		{
+			RenderBackend12::FlushGPU();
+			s_scene.Reload(s_scene.m_sceneFilename);
+		}
+	}
+
+	// Publish what has been loaded since the last frame. The view is placed as soon as the scene cameras are known.
+	if (s_scene.Stream() && s_resetViewOnLoad)
+	{
+		s_view.Reset(s_scene);
+		s_resetViewOnLoad = false;
+	}
 
 	// Tick components
 	s_controller.Tick(deltaTime);
@@ -200,8 +362,11 @@ void Demo::Tick(float deltaTime)
 
 		// Rotate to view space, apply view space rotation and then rotate back to world space
 		s_scene.m_rootTransform = rotation;
+		s_scene.UpdateWorldBounds();
 	}
 
+	s_scene.StreamTextures(s_view, s_resY);
+
 	{
 		FCommandList* cmdList = RenderBackend12::FetchCommandlist(D3D12_COMMAND_LIST_TYPE_DIRECT);
 		FResourceUploadContext uploader{ 32 * 1024 * 1024 };
@@ -266,29 +431,131 @@ void Demo::Teardown(HWND& windowHandle)
 	{
 		RenderBackend12::Teardown();
 		ShaderCompiler::Teardown();
+		ContentIndex::Teardown();
 		ImGui_ImplWin32_Shutdown();
 		ImGui::DestroyContext();
 		Profiling::Teardown();
 	}
 }
 
+Demo::LoadState Demo::GetLoadState()
+{
+	// The scene is only requested by the first Tick
+	if (s_scene.m_sceneFilename.empty() || s_scene.IsLoading())
+	{
+		return LoadState::Loading;
+	}
+
+	return s_scene.m_loadFailed ? LoadState::Failed : LoadState::Loaded;
+}
+
 void Demo::OnMouseMove(WPARAM buttonState, int x, int y)
 {
 	s_controller.MouseMove(buttonState, POINT{ x, y });
 }
 
 //-----------------------------------------------------------------------------------------------------------------------------------------------
-//														Scene
+//														Scene Cooker
 //-----------------------------------------------------------------------------------------------------------------------------------------------
 
-void FScene::Reload(const std::string& filename)
+// Imports a glTF scene and writes it out as a cooked scene. The node walk only records work items and reserves
+// their output ranges, the attribute copies then run in parallel. Ranges are assigned in walk order so the cooked
+// output does not depend on scheduling.
+struct FSceneCooker
+{
+	bool Cook(const std::string& filename, const std::filesystem::path& cookedFilepath);
+
+private:
+	struct FPrimitiveWorkItem
+	{
+		size_t m_meshRecordIndex;
+		int m_indexAccessor;
+		int m_positionAccessor;
+		int m_normalAccessor;
+		int m_uvAccessor;
+	};
+
+	struct FPrimitiveStats
+	{
+		size_t m_triangleCount;
+		MeshOptimizer::FVertexCacheStats m_before;
+		MeshOptimizer::FVertexCacheStats m_after;
+	};
+
+	// Meshlets of a single primitive, with offsets relative to the primitive until they are merged
+	struct FPrimitiveMeshlets
+	{
+		std::vector<MeshOptimizer::FMeshlet> m_meshlets;
+		std::vector<MeshOptimizer::FMeshletBounds> m_bounds;
+		std::vector<uint32_t> m_vertices;
+		std::vector<uint32_t> m_triangles;
+	};
+
+	void LoadNode(int nodeIndex, const tinygltf::Model& model, const Matrix& transform);
+	void LoadMesh(int meshIndex, const tinygltf::Model& model, const Matrix& transform);
+	void LoadCamera(int cameraIndex, const tinygltf::Model& model, const Matrix& transform);
+	uint32_t LoadMaterial(const int materialIndex, const tinygltf::Model& model);
+	int32_t LoadTexture(const tinygltf::Image& image, const tinygltf::Model& model, const CookedScene::TextureUsage usage);
+	int32_t LoadSampler(const tinygltf::Sampler& sampler);
+	void ProcessPrimitive(const FPrimitiveWorkItem& item, const tinygltf::Model& model);
+
+private:
+	FCookedSceneWriter m_writer;
+	std::filesystem::path m_sourceDir;
+	std::vector<FPrimitiveWorkItem> m_primitives;
+	std::vector<FPrimitiveStats> m_primitiveStats;
+	std::vector<FPrimitiveMeshlets> m_primitiveMeshlets;
+	std::vector<std::vector<std::vector<uint32_t>>> m_primitiveLods; // LOD 1 and up of every primitive
+
+	// Output vertex layout
+	const bool m_quantizeVertices = Settings::k_quantizeVertices;
+	const bool m_optimizeOverdraw = Settings::k_optimizeOverdraw;
+	const uint32_t m_lodCount = Settings::k_meshLodCount;
+	static_assert(Settings::k_meshLodCount >= 1 && Settings::k_meshLodCount <= MeshOptimizer::k_maxLodCount);
+	const float m_lodMaxError = 0.1f; // relative to the mesh bounds
+	const size_t m_positionStride = m_quantizeVertices ? 4 * sizeof(uint16_t) : 3 * sizeof(float);
+	const size_t m_normalStride = m_quantizeVertices ? 2 * sizeof(uint16_t) : 3 * sizeof(float);
+	const size_t m_uvStride = m_quantizeVertices ? 2 * sizeof(uint16_t) : 2 * sizeof(float);
+	size_t m_vertexCount = 0;
+
+	std::vector<CookedScene::FMesh> m_meshes;
+	std::vector<CookedScene::FInstance> m_instances;
+	std::map<int, std::pair<size_t, size_t>> m_meshLookup; // glTF mesh to its first mesh record and primitive count
+	std::vector<DirectX::BoundingBox> m_meshBounds;
+	std::vector<CookedScene::FCamera> m_cameras;
+	std::vector<CookedScene::FTexture> m_textures;
+	std::map<std::pair<std::string, CookedScene::TextureUsage>, int32_t> m_textureLookup;
+	std::vector<CookedScene::FMaterial> m_materials;
+	std::map<int, uint32_t> m_materialLookup; // glTF material to its deduplicated record
+
+	std::vector<uint8_t> m_indexData;
+	size_t m_indexBytes32 = 0; // index data size if every index had been widened to 32 bits
+	std::vector<uint8_t> m_positionData;
+	std::vector<uint8_t> m_normalData;
+	std::vector<uint8_t> m_uvData;
+
+	std::vector<MeshOptimizer::FMeshlet> m_meshlets;
+	std::vector<MeshOptimizer::FMeshletBounds> m_meshletBounds;
+	std::vector<uint32_t> m_meshletVertices;
+	std::vector<uint32_t> m_meshletTriangles;
+};
+
+bool FSceneCooker::Cook(const std::string& filename, const std::filesystem::path& cookedFilepath)
 {
 	tinygltf::TinyGLTF loader;
 	std::string errors, warnings;
 
+	// Keep the parser from decoding images serially. External image files are not even read, see TINYGLTF_NO_EXTERNAL_IMAGE,
+	// and images stored in buffers are located from their buffer view by LoadTexture.
+	loader.SetImageLoader([](tinygltf::Image*, const int, std::string*, std::string*, int, int, const unsigned char*, int, void*)
+	{
+		return true;
+	}, nullptr);
+
 	// Load GLTF
 	tinygltf::Model model;
-	bool ok = loader.LoadASCIIFromFile(&model, &errors, &warnings, GetFilepathA(filename));
+	const std::string filepath = GetFilepathA(filename);
+	bool ok = loader.LoadASCIIFromFile(&model, &errors, &warnings, filepath);
 
 	if (!warnings.empty())
 	{
@@ -301,23 +568,22 @@ void FScene::Reload(const std::string& filename)
 	}
 
 	DebugAssert(ok, "Failed to parse glTF");
-	m_sceneFilename = filename;
-
-	// Clear previous scene
-	Clear();
+	if (!ok)
+	{
+		return false;
+	}
 
-	// Scratch data 
-	size_t maxSize = 0;
+	// Any change to the glTF or to its external buffers invalidates the cooked scene
+	m_sourceDir = std::filesystem::path{ filepath }.parent_path();
+	m_writer.AddDependency(filepath);
 	for (const tinygltf::Buffer& buf : model.buffers)
 	{
-		maxSize += buf.data.size();
+		if (!buf.uri.empty() && buf.uri.rfind("data:", 0) != 0)
+		{
+			m_writer.AddDependency(m_sourceDir / buf.uri);
+		}
 	}
 
-	m_scratchIndexBuffer = new uint8_t[maxSize];
-	m_scratchPositionBuffer = new uint8_t[maxSize];
-	m_scratchNormalBuffer = new uint8_t[maxSize];
-	m_scratchUvBuffer = new uint8_t[maxSize];
-
 	// GlTF uses a right handed coordinate. Use the following root transform to convert it to LH.
 	Matrix RH2LH = Matrix
 	{
@@ -330,337 +596,1599 @@ void FScene::Reload(const std::string& filename)
 	// See https://github.com/KhronosGroup/glTF-Tutorials/blob/master/gltfTutorial/gltfTutorial_003_MinimalGltfFile.md
 	for (const tinygltf::Scene& scene : model.scenes)
 	{
-		for (const int nodeIndex : scene.nodes)
+		for (const int nodeIndex : scene.nodes)
+		{
+			LoadNode(nodeIndex, model, RH2LH);
+		}
+	}
+
+	// Optimize and copy vertex attributes and compute object space bounds. Each primitive writes to its own reserved range.
+	const auto processStart = std::chrono::high_resolution_clock::now();
+	m_meshBounds.resize(m_meshes.size());
+	m_primitiveStats.resize(m_meshes.size());
+	m_primitiveMeshlets.resize(m_meshes.size());
+	m_primitiveLods.resize(m_meshes.size());
+	concurrency::parallel_for(size_t(0), m_primitives.size(), [this, &model](const size_t i)
+	{
+		ProcessPrimitive(m_primitives[i], model);
+	});
+	const std::chrono::duration<double, std::milli> processTime = std::chrono::high_resolution_clock::now() - processStart;
+
+	// Append the LOD indices after all the source meshes, at the index width of their mesh
+	for (size_t meshIndex = 0; meshIndex < m_meshes.size(); ++meshIndex)
+	{
+		CookedScene::FMesh& mesh = m_meshes[meshIndex];
+		const size_t indexSize = mesh.m_indexFormat == DXGI_FORMAT_R16_UINT ? sizeof(uint16_t) : sizeof(uint32_t);
+
+		for (uint32_t lod = 1; lod < mesh.m_lodCount; ++lod)
+		{
+			const std::vector<uint32_t>& lodIndices = m_primitiveLods[meshIndex][lod - 1];
+			mesh.m_lods[lod].m_indexOffset = (uint32_t)(m_indexData.size() / indexSize);
+
+			const size_t offset = m_indexData.size();
+			m_indexData.resize(offset + ((lodIndices.size() * indexSize + 3) & ~3ull));
+			m_indexBytes32 += lodIndices.size() * sizeof(uint32_t);
+			for (size_t i = 0; i < lodIndices.size(); ++i)
+			{
+				if (indexSize == sizeof(uint16_t))
+				{
+					((uint16_t*)&m_indexData[offset])[i] = (uint16_t)lodIndices[i];
+				}
+				else
+				{
+					((uint32_t*)&m_indexData[offset])[i] = lodIndices[i];
+				}
+			}
+		}
+	}
+
+	// Merge the per primitive meshlets in mesh order
+	for (size_t meshIndex = 0; meshIndex < m_meshes.size(); ++meshIndex)
+	{
+		const FPrimitiveMeshlets& primitiveMeshlets = m_primitiveMeshlets[meshIndex];
+		m_meshes[meshIndex].m_meshletOffset = (uint32_t)m_meshlets.size();
+		m_meshes[meshIndex].m_meshletCount = (uint32_t)primitiveMeshlets.m_meshlets.size();
+
+		for (MeshOptimizer::FMeshlet meshlet : primitiveMeshlets.m_meshlets)
+		{
+			meshlet.m_vertexOffset += (uint32_t)m_meshletVertices.size();
+			meshlet.m_triangleOffset += (uint32_t)m_meshletTriangles.size();
+			m_meshlets.push_back(meshlet);
+		}
+
+		m_meshletBounds.insert(m_meshletBounds.end(), primitiveMeshlets.m_bounds.cbegin(), primitiveMeshlets.m_bounds.cend());
+		m_meshletVertices.insert(m_meshletVertices.end(), primitiveMeshlets.m_vertices.cbegin(), primitiveMeshlets.m_vertices.cend());
+		m_meshletTriangles.insert(m_meshletTriangles.end(), primitiveMeshlets.m_triangles.cbegin(), primitiveMeshlets.m_triangles.cend());
+	}
+
+	// Geometry hashes let a hot reload tell which meshes need to be patched
+	const uint8_t* sectionData[(size_t)CookedScene::Section::Count] = {};
+	sectionData[(size_t)CookedScene::Section::IndexData] = m_indexData.data();
+	sectionData[(size_t)CookedScene::Section::PositionData] = m_positionData.data();
+	sectionData[(size_t)CookedScene::Section::NormalData] = m_normalData.data();
+	sectionData[(size_t)CookedScene::Section::UvData] = m_uvData.data();
+	sectionData[(size_t)CookedScene::Section::Meshlets] = (const uint8_t*)m_meshlets.data();
+	sectionData[(size_t)CookedScene::Section::MeshletBounds] = (const uint8_t*)m_meshletBounds.data();
+	sectionData[(size_t)CookedScene::Section::MeshletVertices] = (const uint8_t*)m_meshletVertices.data();
+	sectionData[(size_t)CookedScene::Section::MeshletTriangles] = (const uint8_t*)m_meshletTriangles.data();
+
+	concurrency::parallel_for(size_t(0), m_meshes.size(), [this, &sectionData](const size_t meshIndex)
+	{
+		uint64_t hash1{}, hash2{};
+		spookyhash_context context;
+		spookyhash_context_init(&context, hash1, hash2);
+		for (const CookedScene::FByteRange& range : CookedScene::GetMeshGeometryRanges(m_meshes[meshIndex], m_meshlets, GetSceneCookFlags()))
+		{
+			spookyhash_update(&context, sectionData[(size_t)range.m_section] + range.m_offset, range.m_size);
+		}
+		spookyhash_final(&context, &hash1, &hash2);
+		m_meshes[meshIndex].m_geometryHash = hash1;
+	});
+
+	// Group instances by mesh so that every mesh can be drawn with a single instanced draw
+	std::stable_sort(m_instances.begin(), m_instances.end(), [](const CookedScene::FInstance& a, const CookedScene::FInstance& b)
+	{
+		return a.m_meshIndex < b.m_meshIndex;
+	});
+
+	// Scene bounds
+	std::vector<uint32_t> instanceMeshIndices(m_instances.size());
+	std::vector<Matrix> instanceTransforms(m_instances.size());
+	for (size_t i = 0; i < m_instances.size(); ++i)
+	{
+		instanceMeshIndices[i] = m_instances[i].m_meshIndex;
+		instanceTransforms[i] = Matrix{ m_instances[i].m_localToWorld };
+	}
+
+	Bounds::FBoxSoA instanceBounds, instanceWorldBounds;
+	GetInstanceBounds(instanceBounds, m_meshBounds, instanceMeshIndices);
+	const DirectX::BoundingBox sceneBounds = ToBoundingBox(Bounds::TransformBoxes(instanceWorldBounds, instanceBounds, (const float*)instanceTransforms.data(), (const float*)&Matrix::Identity));
+
+	std::stringstream report;
+	report << "Cooked " << filename << ": index data " << m_indexData.size() / 1024 << " KB (" << m_indexBytes32 / 1024 << " KB as 32 bit indices, "
+		<< (m_indexBytes32 ? 100 * (m_indexBytes32 - m_indexData.size()) / m_indexBytes32 : 0) << "% saved)\n";
+	report << "Cooked " << filename << ": vertex data " << (m_positionData.size() + m_normalData.size() + m_uvData.size()) / 1024 << " KB ("
+		<< m_vertexCount * 8 * sizeof(float) / 1024 << " KB as float attributes)\n";
+	report << "Cooked " << filename << ": " << m_instances.size() << " instances of " << m_meshes.size() << " meshes\n";
+
+	// Scene wide vertex cache efficiency, weighted by triangle and vertex counts
+	double missesBefore = 0.0, missesAfter = 0.0, triangleCount = 0.0;
+	for (const FPrimitiveStats& stats : m_primitiveStats)
+	{
+		missesBefore += stats.m_before.m_acmr * stats.m_triangleCount;
+		missesAfter += stats.m_after.m_acmr * stats.m_triangleCount;
+		triangleCount += stats.m_triangleCount;
+	}
+
+	if (triangleCount > 0.0)
+	{
+		report << "Cooked " << filename << ": ACMR " << missesBefore / triangleCount << " -> " << missesAfter / triangleCount
+			<< ", ATVR " << missesBefore / m_vertexCount << " -> " << missesAfter / m_vertexCount
+			<< " (" << m_primitives.size() << " primitives processed in " << processTime.count() << " ms)\n";
+	}
+
+	std::vector<size_t> lodTriangleCounts(m_lodCount, 0);
+	for (const CookedScene::FMesh& mesh : m_meshes)
+	{
+		for (uint32_t lod = 0; lod < mesh.m_lodCount; ++lod)
+		{
+			lodTriangleCounts[lod] += mesh.m_lods[lod].m_indexCount / 3;
+		}
+	}
+
+	report << "Cooked " << filename << ": triangles per LOD";
+	for (const size_t triangleCount : lodTriangleCounts)
+	{
+		report << " " << triangleCount;
+	}
+	report << "\n";
+
+	if (!m_meshlets.empty())
+	{
+		report << "Cooked " << filename << ": " << m_meshlets.size() << " meshlets, " << (double)m_meshletVertices.size() / m_meshlets.size() << " vertices and "
+			<< (double)m_meshletTriangles.size() / m_meshlets.size() << " triangles on average\n";
+	}
+
+	OutputDebugStringA(report.str().c_str());
+
+	m_writer.Append(CookedScene::Section::Textures, m_textures);
+	m_writer.Append(CookedScene::Section::Materials, m_materials);
+	m_writer.Append(CookedScene::Section::Meshes, m_meshes);
+	m_writer.Append(CookedScene::Section::Instances, m_instances);
+	m_writer.Append(CookedScene::Section::Bounds, m_meshBounds);
+	m_writer.Append(CookedScene::Section::Cameras, m_cameras);
+	m_writer.Append(CookedScene::Section::IndexData, m_indexData);
+	m_writer.Append(CookedScene::Section::PositionData, m_positionData);
+	m_writer.Append(CookedScene::Section::NormalData, m_normalData);
+	m_writer.Append(CookedScene::Section::UvData, m_uvData);
+	m_writer.Append(CookedScene::Section::Meshlets, m_meshlets);
+	m_writer.Append(CookedScene::Section::MeshletBounds, m_meshletBounds);
+	m_writer.Append(CookedScene::Section::MeshletVertices, m_meshletVertices);
+	m_writer.Append(CookedScene::Section::MeshletTriangles, m_meshletTriangles);
+
+	return m_writer.Write(cookedFilepath, sceneBounds, GetSceneCookFlags());
+}
+
+void FSceneCooker::LoadNode(int nodeIndex, const tinygltf::Model& model, const Matrix& parentTransform)
+{
+	const tinygltf::Node& node = model.nodes[nodeIndex];
+	
+	// Transform (GLTF uses column-major storage)
+	Matrix nodeTransform = Matrix::Identity;
+	if (!node.matrix.empty())
+	{
+		const auto& m = node.matrix;
+		nodeTransform = Matrix { 
+			(float)m[0], (float)m[1], (float)m[2], (float)m[3],
+			(float)m[4], (float)m[5], (float)m[6], (float)m[7],
+			(float)m[8], (float)m[9], (float)m[10],(float)m[11],
+			(float)m[12], (float)m[13], (float)m[14],(float)m[15]
+		};
+	}
+	else if (!node.translation.empty() || !node.rotation.empty() || !node.scale.empty())
+	{
+		Matrix translation = !node.translation.empty() ? Matrix::CreateTranslation(Vector3{ (float*)node.translation.data() }) : Matrix::Identity;
+		Matrix rotation = !node.rotation.empty() ? Matrix::CreateFromQuaternion(Quaternion{ (float*)node.rotation.data() }) : Matrix::Identity;
+		Matrix scale = !node.scale.empty() ? Matrix::CreateScale(Vector3{ (float*)node.scale.data() }) : Matrix::Identity;
+
+		nodeTransform = scale * rotation * translation;
+	}
+
+	if (node.camera != -1)
+	{
+		LoadCamera(node.camera, model, nodeTransform * parentTransform);
+	}
+
+	if (node.mesh != -1)
+	{
+		LoadMesh(node.mesh, model, nodeTransform * parentTransform);
+	}
+
+	for (const int childIndex : node.children)
+	{
+		LoadNode(childIndex, model, nodeTransform * parentTransform);
+	}
+}
+
+void FSceneCooker::LoadMesh(int meshIndex, const tinygltf::Model& model, const Matrix& parentTransform)
+{
+	const tinygltf::Mesh& mesh = model.meshes[meshIndex];
+
+	auto AddInstance = [this, &parentTransform](const size_t meshRecordIndex)
+	{
+		CookedScene::FInstance instance = {};
+		instance.m_localToWorld = parentTransform;
+		instance.m_meshIndex = (uint32_t)meshRecordIndex;
+		m_instances.push_back(instance);
+	};
+
+	// Meshes referenced by several nodes are cooked once and instanced
+	auto meshIt = m_meshLookup.find(meshIndex);
+	if (meshIt != m_meshLookup.cend())
+	{
+		for (size_t i = 0; i < meshIt->second.second; ++i)
+		{
+			AddInstance(meshIt->second.first + i);
+		}
+
+		return;
+	}
+
+	const size_t firstMeshRecord = m_meshes.size();
+
+	// Each primitive is a separate render mesh with its own vertex and index buffers
+	for (const tinygltf::Primitive& primitive : mesh.primitives)
+	{
+		// Index data
+		const tinygltf::Accessor& indexAccessor = model.accessors[primitive.indices];
+
+		// FLOAT3 position data
+		auto posIt = primitive.attributes.find("POSITION");
+		DebugAssert(posIt != primitive.attributes.cend());
+		const tinygltf::Accessor& positionAccessor = model.accessors[posIt->second];
+		const size_t positionSize = tinygltf::GetComponentSizeInBytes(positionAccessor.componentType) * tinygltf::GetNumComponentsInType(positionAccessor.type);
+		DebugAssert(positionSize == 3 * sizeof(float));
+
+		// FLOAT3 normal data
+		auto normalIt = primitive.attributes.find("NORMAL");
+		DebugAssert(normalIt != primitive.attributes.cend());
+		const tinygltf::Accessor& normalAccessor = model.accessors[normalIt->second];
+		const size_t normalSize = tinygltf::GetComponentSizeInBytes(normalAccessor.componentType) * tinygltf::GetNumComponentsInType(normalAccessor.type);
+		DebugAssert(normalSize == 3 * sizeof(float));
+
+		// FLOAT2 UV data
+		auto uvIt = primitive.attributes.find("TEXCOORD_0");
+		DebugAssert(uvIt != primitive.attributes.cend());
+		const tinygltf::Accessor& uvAccessor = model.accessors[uvIt->second];
+		const size_t uvSize = tinygltf::GetComponentSizeInBytes(uvAccessor.componentType) * tinygltf::GetNumComponentsInType(uvAccessor.type);
+		DebugAssert(uvSize == 2 * sizeof(float));
+
+		// Meshes that can address all their vertices with 16 bits keep 16 bit indices, everything else is widened to 32 bits
+		const size_t indexSize = positionAccessor.count < 65536 ? sizeof(uint16_t) : sizeof(uint32_t);
+
+		CookedScene::FMesh newMesh = {};
+		newMesh.m_nameOffset = m_writer.AddString(mesh.name);
+		newMesh.m_lodCount = 1;
+		newMesh.m_lods[0].m_indexOffset = (uint32_t)(m_indexData.size() / indexSize);
+		newMesh.m_lods[0].m_indexCount = (uint32_t)indexAccessor.count;
+		newMesh.m_indexFormat = indexSize == sizeof(uint16_t) ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT;
+		newMesh.m_positionOffset = (uint32_t)(m_positionData.size() / m_positionStride);
+		newMesh.m_normalOffset = (uint32_t)(m_normalData.size() / m_normalStride);
+		newMesh.m_uvOffset = (uint32_t)(m_uvData.size() / m_uvStride);
+		newMesh.m_vertexCount = (uint32_t)positionAccessor.count;
+		newMesh.m_materialIndex = LoadMaterial(primitive.material, model);
+		m_primitives.push_back({ m_meshes.size(), primitive.indices, posIt->second, normalIt->second, uvIt->second });
+		m_meshes.push_back(newMesh);
+		AddInstance(m_meshes.size() - 1);
+
+		// Reserve the output ranges, the data itself is copied by ProcessPrimitive. Index ranges are padded to a dword so that
+		// every mesh starts on a 4 byte boundary whatever the width of its neighbours.
+		m_indexData.resize(m_indexData.size() + ((indexAccessor.count * indexSize + 3) & ~3ull));
+		m_indexBytes32 += indexAccessor.count * sizeof(uint32_t);
+		m_positionData.resize(m_positionData.size() + positionAccessor.count * m_positionStride);
+		m_normalData.resize(m_normalData.size() + normalAccessor.count * m_normalStride);
+		m_uvData.resize(m_uvData.size() + uvAccessor.count * m_uvStride);
+		m_vertexCount += positionAccessor.count;
+	}
+
+	m_meshLookup[meshIndex] = { firstMeshRecord, m_meshes.size() - firstMeshRecord };
+}
+
+void FSceneCooker::ProcessPrimitive(const FPrimitiveWorkItem& item, const tinygltf::Model& model)
+{
+	auto ReadIndices = [&model](const tinygltf::Accessor& accessor) -> std::vector<uint32_t>
+	{
+		const tinygltf::BufferView& bufferView = model.bufferViews[accessor.bufferView];
+		const size_t srcSize = tinygltf::GetComponentSizeInBytes(accessor.componentType);
+		const size_t srcStride = accessor.ByteStride(bufferView);
+
+		std::vector<uint32_t> indices(accessor.count);
+		const uint8_t* pSrc = &model.buffers[bufferView.buffer].data[bufferView.byteOffset + accessor.byteOffset];
+		for (size_t i = 0; i < accessor.count; ++i, pSrc += srcStride)
+		{
+			indices[i] = srcSize == 1 ? *pSrc : (srcSize == 2 ? *(const uint16_t*)pSrc : *(const uint32_t*)pSrc);
+		}
+
+		return indices;
+	};
+
+	auto ReadAttribute = [&model]<typename T>(const tinygltf::Accessor& accessor, std::vector<T>& dest)
+	{
+		const tinygltf::BufferView& bufferView = model.bufferViews[accessor.bufferView];
+		const size_t srcStride = accessor.ByteStride(bufferView);
+
+		dest.resize(accessor.count);
+		const uint8_t* pSrc = &model.buffers[bufferView.buffer].data[bufferView.byteOffset + accessor.byteOffset];
+		for (size_t i = 0; i < accessor.count; ++i)
+		{
+			memcpy(&dest[i], pSrc + i * srcStride, sizeof(T));
+		}
+	};
+
+	CookedScene::FMesh& mesh = m_meshes[item.m_meshRecordIndex];
+
+	// Gather source data
+	std::vector<uint32_t> indices = ReadIndices(model.accessors[item.m_indexAccessor]);
+	std::vector<DirectX::XMFLOAT3> positions;
+	std::vector<DirectX::XMFLOAT3> normals;
+	std::vector<DirectX::XMFLOAT2> uvs;
+	ReadAttribute(model.accessors[item.m_positionAccessor], positions);
+	ReadAttribute(model.accessors[item.m_normalAccessor], normals);
+	ReadAttribute(model.accessors[item.m_uvAccessor], uvs);
+
+	const size_t vertexCount = positions.size();
+	DirectX::BoundingBox bounds = {};
+	DirectX::BoundingBox::CreateFromPoints(bounds, vertexCount, positions.data(), sizeof(DirectX::XMFLOAT3));
+	m_meshBounds[item.m_meshRecordIndex] = bounds;
+
+	// Texel density for texture streaming. The halves of the triangle areas cancel out.
+	double uvArea = 0.0, surfaceArea = 0.0;
+	for (size_t i = 0; i + 2 < indices.size(); i += 3)
+	{
+		const Vector3 p0{ positions[indices[i]] }, p1{ positions[indices[i + 1]] }, p2{ positions[indices[i + 2]] };
+		const Vector2 uv0{ uvs[indices[i]] }, uv1{ uvs[indices[i + 1]] }, uv2{ uvs[indices[i + 2]] };
+		surfaceArea += (p1 - p0).Cross(p2 - p0).Length();
+		uvArea += std::abs((uv1.x - uv0.x) * (uv2.y - uv0.y) - (uv2.x - uv0.x) * (uv1.y - uv0.y));
+	}
+
+	mesh.m_uvDensity = surfaceArea > 0.0 ? (float)std::sqrt(uvArea / surfaceArea) : 0.f;
+
+	// Reorder triangles for post-transform cache reuse, then optionally by cluster for overdraw, and finally renumber
+	// vertices in order of first use for fetch locality
+	FPrimitiveStats& stats = m_primitiveStats[item.m_meshRecordIndex];
+	stats.m_triangleCount = indices.size() / 3;
+	stats.m_before = MeshOptimizer::AnalyzeVertexCache(indices.data(), indices.size(), vertexCount);
+
+	std::vector<uint32_t> clusters;
+	std::vector<uint32_t> optimizedIndices(indices.size());
+	MeshOptimizer::OptimizeVertexCache(optimizedIndices.data(), indices.data(), indices.size(), vertexCount, MeshOptimizer::k_vertexCacheSize, m_optimizeOverdraw ? &clusters : nullptr);
+
+	if (m_optimizeOverdraw)
+	{
+		MeshOptimizer::OptimizeOverdraw(indices.data(), optimizedIndices.data(), optimizedIndices.size(), &positions[0].x, sizeof(DirectX::XMFLOAT3), vertexCount, clusters);
+		std::swap(indices, optimizedIndices);
+	}
+
+	std::vector<uint32_t> remap;
+	MeshOptimizer::OptimizeVertexFetch(remap, optimizedIndices.data(), optimizedIndices.size(), vertexCount);
+	stats.m_after = MeshOptimizer::AnalyzeVertexCache(optimizedIndices.data(), optimizedIndices.size(), vertexCount);
+
+	// Meshlets, built from the final triangle order so that they inherit its locality
+	std::vector<DirectX::XMFLOAT3> remappedPositions(vertexCount);
+	for (size_t v = 0; v < vertexCount; ++v)
+	{
+		remappedPositions[remap[v]] = positions[v];
+	}
+
+	FPrimitiveMeshlets& meshlets = m_primitiveMeshlets[item.m_meshRecordIndex];
+	MeshOptimizer::BuildMeshlets(meshlets.m_meshlets, meshlets.m_vertices, meshlets.m_triangles, optimizedIndices.data(), optimizedIndices.size(), vertexCount);
+	meshlets.m_bounds.resize(meshlets.m_meshlets.size());
+	for (size_t i = 0; i < meshlets.m_meshlets.size(); ++i)
+	{
+		meshlets.m_bounds[i] = MeshOptimizer::ComputeMeshletBounds(meshlets.m_meshlets[i], meshlets.m_vertices.data(), meshlets.m_triangles.data(), &remappedPositions[0].x, sizeof(DirectX::XMFLOAT3));
+	}
+
+	// LOD chain. Every level halves the triangle count of the previous one until the error bound or the
+	// mesh topology stops the simplification.
+	std::vector<std::vector<uint32_t>>& lods = m_primitiveLods[item.m_meshRecordIndex];
+	lods.reserve(m_lodCount - 1);
+	std::vector<uint32_t> simplifiedIndices(optimizedIndices.size());
+	const std::vector<uint32_t>* sourceIndices = &optimizedIndices;
+	const float maxError = m_lodMaxError * Vector3{ bounds.Extents }.Length();
+
+	for (uint32_t lod = 1; lod < m_lodCount; ++lod)
+	{
+		float error = 0.f;
+		const size_t indexCount = MeshOptimizer::Simplify(
+			simplifiedIndices.data(),
+			sourceIndices->data(),
+			sourceIndices->size(),
+			&remappedPositions[0].x,
+			sizeof(DirectX::XMFLOAT3),
+			vertexCount,
+			sourceIndices->size() / 6 * 3,
+			maxError,
+			&error);
+
+		// Not worth a LOD of its own
+		if (indexCount == 0 || indexCount > 9 * sourceIndices->size() / 10)
+		{
+			break;
+		}
+
+		std::vector<uint32_t>& lodIndices = lods.emplace_back(indexCount);
+		MeshOptimizer::OptimizeVertexCache(lodIndices.data(), simplifiedIndices.data(), indexCount, vertexCount);
+
+		mesh.m_lods[lod].m_indexCount = (uint32_t)indexCount;
+		mesh.m_lods[lod].m_error = std::max(error, mesh.m_lods[lod - 1].m_error);
+		mesh.m_lodCount = lod + 1;
+		sourceIndices = &lodIndices;
+	}
+
+	// Indices
+	uint8_t* indexDest = m_indexData.data() + mesh.m_lods[0].m_indexOffset * (mesh.m_indexFormat == DXGI_FORMAT_R16_UINT ? sizeof(uint16_t) : sizeof(uint32_t));
+	for (size_t i = 0; i < optimizedIndices.size(); ++i)
+	{
+		if (mesh.m_indexFormat == DXGI_FORMAT_R16_UINT)
+		{
+			((uint16_t*)indexDest)[i] = (uint16_t)optimizedIndices[i];
+		}
+		else
+		{
+			((uint32_t*)indexDest)[i] = optimizedIndices[i];
+		}
+	}
+
+	// Vertex attributes, written to their remapped slots
+	uint8_t* positionDest = m_positionData.data() + mesh.m_positionOffset * m_positionStride;
+	uint8_t* normalDest = m_normalData.data() + mesh.m_normalOffset * m_normalStride;
+	uint8_t* uvDest = m_uvData.data() + mesh.m_uvOffset * m_uvStride;
+
+	if (!m_quantizeVertices)
+	{
+		mesh.m_positionScale = DirectX::XMFLOAT3{ 1.f, 1.f, 1.f };
+		mesh.m_positionBias = DirectX::XMFLOAT3{ 0.f, 0.f, 0.f };
+
+		for (size_t v = 0; v < vertexCount; ++v)
+		{
+			memcpy(positionDest + remap[v] * m_positionStride, &positions[v], m_positionStride);
+			memcpy(normalDest + remap[v] * m_normalStride, &normals[v], m_normalStride);
+			memcpy(uvDest + remap[v] * m_uvStride, &uvs[v], m_uvStride);
+		}
+
+		return;
+	}
+
+	// Positions are normalized to the mesh bounds
+	const Vector3 bias = Vector3{ bounds.Center } - Vector3{ bounds.Extents };
+	const Vector3 scale = 2.f * Vector3{ bounds.Extents } / 65535.f;
+	mesh.m_positionScale = scale;
+	mesh.m_positionBias = bias;
+
+	for (size_t v = 0; v < vertexCount; ++v)
+	{
+		uint16_t* position = (uint16_t*)(positionDest + remap[v] * m_positionStride);
+		position[0] = QuantizeUnorm16(positions[v].x, bias.x, scale.x);
+		position[1] = QuantizeUnorm16(positions[v].y, bias.y, scale.y);
+		position[2] = QuantizeUnorm16(positions[v].z, bias.z, scale.z);
+		position[3] = 0;
+
+		*(uint32_t*)(normalDest + remap[v] * m_normalStride) = PackOctahedralSnorm16(Vector3{ normals[v] });
+
+		uint16_t* uv = (uint16_t*)(uvDest + remap[v] * m_uvStride);
+		uv[0] = DirectX::PackedVector::XMConvertFloatToHalf(uvs[v].x);
+		uv[1] = DirectX::PackedVector::XMConvertFloatToHalf(uvs[v].y);
+	}
+}
+
+uint32_t FSceneCooker::LoadMaterial(const int materialIndex, const tinygltf::Model& model)
+{
+	auto search = m_materialLookup.find(materialIndex);
+	if (search != m_materialLookup.cend())
+	{
+		return search->second;
+	}
+
+	// Primitives without a material use the glTF defaults, which the parser fills in for emissive
+	tinygltf::Material defaultMaterial;
+	defaultMaterial.emissiveFactor = { 0.0, 0.0, 0.0 };
+	const tinygltf::Material& material = materialIndex != -1 ? model.materials[materialIndex] : defaultMaterial;
+
+	CookedScene::FMaterial newMaterial = {};
+	newMaterial.m_emissiveFactor = DirectX::XMFLOAT3{ (float)material.emissiveFactor[0], (float)material.emissiveFactor[1], (float)material.emissiveFactor[2] };
+	newMaterial.m_baseColorFactor = DirectX::XMFLOAT3{ (float)material.pbrMetallicRoughness.baseColorFactor[0], (float)material.pbrMetallicRoughness.baseColorFactor[1], (float)material.pbrMetallicRoughness.baseColorFactor[2] };
+	newMaterial.m_metallicFactor = (float)material.pbrMetallicRoughness.metallicFactor;
+	newMaterial.m_roughnessFactor = (float)material.pbrMetallicRoughness.roughnessFactor;
+	newMaterial.m_baseColorTexture = material.pbrMetallicRoughness.baseColorTexture.index != -1 ? LoadTexture(model.images[model.textures[material.pbrMetallicRoughness.baseColorTexture.index].source], model, CookedScene::TextureUsage::BaseColor) : -1;
+	newMaterial.m_metallicRoughnessTexture = material.pbrMetallicRoughness.metallicRoughnessTexture.index != -1 ? LoadTexture(model.images[model.textures[material.pbrMetallicRoughness.metallicRoughnessTexture.index].source], model, CookedScene::TextureUsage::MetallicRoughness) : -1;
+	newMaterial.m_normalTexture = material.normalTexture.index != -1 ? LoadTexture(model.images[model.textures[material.normalTexture.index].source], model, CookedScene::TextureUsage::Normal) : -1;
+	newMaterial.m_baseColorSampler = material.pbrMetallicRoughness.baseColorTexture.index != -1 ? LoadSampler(model.samplers[model.textures[material.pbrMetallicRoughness.baseColorTexture.index].sampler]) : -1;
+	newMaterial.m_metallicRoughnessSampler = material.pbrMetallicRoughness.metallicRoughnessTexture.index != -1 ? LoadSampler(model.samplers[model.textures[material.pbrMetallicRoughness.metallicRoughnessTexture.index].sampler]) : -1;
+	newMaterial.m_normalSampler = material.normalTexture.index != -1 ? LoadSampler(model.samplers[model.textures[material.normalTexture.index].sampler]) : -1;
+
+	// glTF materials that only differ by name share a record, which keeps the name of the first one
+	constexpr size_t parametersOffset = offsetof(CookedScene::FMaterial, m_emissiveFactor);
+	auto duplicate = std::find_if(m_materials.cbegin(), m_materials.cend(), [&newMaterial](const CookedScene::FMaterial& other)
+	{
+		return memcmp((const uint8_t*)&other + parametersOffset, (const uint8_t*)&newMaterial + parametersOffset, sizeof(CookedScene::FMaterial) - parametersOffset) == 0;
+	});
+
+	if (duplicate == m_materials.cend())
+	{
+		newMaterial.m_nameOffset = m_writer.AddString(material.name);
+		m_materials.push_back(newMaterial);
+		duplicate = m_materials.cend() - 1;
+	}
+
+	const uint32_t cookedIndex = (uint32_t)(duplicate - m_materials.cbegin());
+	m_materialLookup[materialIndex] = cookedIndex;
+	return cookedIndex;
+}
+
+// Images are left undecoded by the glTF parser, only their location is cooked. The streamer decodes them on worker threads
+// and only when the compressed texture cache misses.
+int32_t FSceneCooker::LoadTexture(const tinygltf::Image& image, const tinygltf::Model& model, const CookedScene::TextureUsage usage)
+{
+	// External image file, or a byte range of an external buffer
+	std::string uri = image.uri;
+	std::filesystem::path path = m_sourceDir / image.uri;
+	uint64_t byteOffset = 0, byteSize = 0;
+	if (image.bufferView != -1)
+	{
+		const tinygltf::BufferView& bufferView = model.bufferViews[image.bufferView];
+		const tinygltf::Buffer& buffer = model.buffers[bufferView.buffer];
+		uri = buffer.uri + "#" + std::to_string(image.bufferView);
+		path = m_sourceDir / buffer.uri;
+		byteOffset = bufferView.byteOffset;
+		byteSize = bufferView.byteLength;
+		DebugAssert(!buffer.uri.empty() && buffer.uri.rfind("data:", 0) != 0, "Images in embedded buffers are not yet supported.");
+	}
+
+	DebugAssert(!uri.empty(), "Embedded image data is not yet supported.");
+
+	auto search = m_textureLookup.find({ uri, usage });
+	if (search != m_textureLookup.cend())
+	{
+		return search->second;
+	}
+
+	CookedScene::FTexture newTexture = {};
+	newTexture.m_uriOffset = m_writer.AddString(uri);
+	newTexture.m_pathOffset = m_writer.AddString(path.string());
+	newTexture.m_usage = usage;
+	newTexture.m_byteOffset = byteOffset;
+	newTexture.m_byteSize = byteSize;
+
+	const int32_t textureIndex = (int32_t)m_textures.size();
+	m_textures.push_back(newTexture);
+	m_textureLookup[{ uri, usage }] = textureIndex;
+	return textureIndex;
+}
+
+int32_t FSceneCooker::LoadSampler(const tinygltf::Sampler& sampler)
+{
+	return -1;
+}
+
+void FSceneCooker::LoadCamera(int cameraIndex, const tinygltf::Model& model, const Matrix& transform)
+{
+	CookedScene::FCamera newCamera = {};
+	newCamera.m_viewTransform = transform;
+	
+	if (model.cameras[cameraIndex].type == "perspective")
+	{
+		std::stringstream s;
+		s << "perspective_cam_" << m_cameras.size();
+		newCamera.m_nameOffset = m_writer.AddString(s.str());
+
+		const tinygltf::PerspectiveCamera& cam = model.cameras[cameraIndex].perspective;
+		newCamera.m_projectionTransform = GetReverseZInfinitePerspectiveFovLH(cam.yfov, cam.aspectRatio, cam.znear);
+	}
+	else
+	{
+		std::stringstream s;
+		s << "ortho_cam_" << m_cameras.size();
+		newCamera.m_nameOffset = m_writer.AddString(s.str());
+
+		const tinygltf::OrthographicCamera& cam = model.cameras[cameraIndex].orthographic;
+		newCamera.m_projectionTransform = Matrix::CreateOrthographic(cam.xmag, cam.ymag, cam.znear, cam.zfar);
+	}
+
+	m_cameras.push_back(newCamera);
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------------------------
+//														Scene
+//-----------------------------------------------------------------------------------------------------------------------------------------------
+
+namespace
+{
+	// An image used by several material slots is compressed once per slot, so the slot is part of the cache name
+	std::wstring GetTextureName(const FCookedScene& cookedScene, const CookedScene::FTexture& texture)
+	{
+		const std::string uri = cookedScene.GetString(texture.m_uriOffset);
+		const wchar_t* suffixes[] = { L"", L" (normal)", L" (metallic roughness)" };
+		return std::wstring{ uri.begin(), uri.end() } + suffixes[(uint32_t)texture.m_usage];
+	}
+
+	// Bindless index of a cached texture, or of the placeholder for its slot if it failed to load. The placeholders are
+	// cached with the scene layout.
+	int GetTextureIndex(const std::wstring& name, const CookedScene::TextureUsage usage)
+	{
+		const FTextureCache& textureCache = Demo::s_textureCache;
+		auto search = textureCache.m_cachedTextures.find(name);
+		if (search == textureCache.m_cachedTextures.cend())
+		{
+			search = textureCache.m_cachedTextures.find(usage == CookedScene::TextureUsage::Normal ? L"placeholder_normal_texture" : L"placeholder_texture");
+		}
+
+		return RenderBackend12::GetDescriptorTableOffset(BindlessDescriptorType::Texture2D, search->second->m_srvIndex);
+	}
+
+	// Bytes used by every mip of a block compressed texture, with blockSize bytes per 4x4 block
+	size_t GetBlockCompressedSize(const D3D12_RESOURCE_DESC& desc, const size_t blockSize, const uint32_t firstMip = 0)
+	{
+		size_t size = 0;
+		for (uint32_t mip = firstMip; mip < desc.MipLevels; ++mip)
+		{
+			const size_t width = std::max<size_t>(desc.Width >> mip, 1);
+			const size_t height = std::max<size_t>(desc.Height >> mip, 1);
+			size += blockSize * ((width + 3) / 4) * ((height + 3) / 4);
+		}
+
+		return size;
+	}
+
+	FMaterial CreateMaterial(const CookedScene::FMaterial& material, const std::vector<int>& textureIndices)
+	{
+		auto GetTextureIndex = [&textureIndices](const int32_t cookedIndex)
+		{
+			return cookedIndex != -1 ? textureIndices[cookedIndex] : -1;
+		};
+
+		FMaterial newMaterial = {};
+		newMaterial.m_emissiveFactor = Vector3{ material.m_emissiveFactor };
+		newMaterial.m_metallicFactor = material.m_metallicFactor;
+		newMaterial.m_baseColorFactor = Vector3{ material.m_baseColorFactor };
+		newMaterial.m_roughnessFactor = material.m_roughnessFactor;
+		newMaterial.m_baseColorTextureIndex = GetTextureIndex(material.m_baseColorTexture);
+		newMaterial.m_metallicRoughnessTextureIndex = GetTextureIndex(material.m_metallicRoughnessTexture);
+		newMaterial.m_normalTextureIndex = GetTextureIndex(material.m_normalTexture);
+		newMaterial.m_baseColorSamplerIndex = material.m_baseColorSampler;
+		newMaterial.m_metallicRoughnessSamplerIndex = material.m_metallicRoughnessSampler;
+		newMaterial.m_normalSamplerIndex = material.m_normalSampler;
+		return newMaterial;
+	}
+
+	std::vector<FMaterial> CreateMaterials(std::span<const CookedScene::FMaterial> materials, const std::vector<int>& textureIndices)
+	{
+		std::vector<FMaterial> newMaterials;
+		for (const CookedScene::FMaterial& material : materials)
+		{
+			newMaterials.push_back(CreateMaterial(material, textureIndices));
+		}
+
+		return newMaterials;
+	}
+
+	FRenderMesh CreateRenderMesh(const FCookedScene& cookedScene, const CookedScene::FMesh& mesh)
+	{
+		FRenderMesh newMesh = {};
+		newMesh.m_name = cookedScene.GetString(mesh.m_nameOffset);
+		newMesh.m_indexFormat = (DXGI_FORMAT)mesh.m_indexFormat;
+		newMesh.m_positionOffset = mesh.m_positionOffset;
+		newMesh.m_normalOffset = mesh.m_normalOffset;
+		newMesh.m_uvOffset = mesh.m_uvOffset;
+		newMesh.m_vertexCount = mesh.m_vertexCount;
+		newMesh.m_meshletOffset = mesh.m_meshletOffset;
+		newMesh.m_meshletCount = mesh.m_meshletCount;
+		newMesh.m_positionScale = Vector3{ mesh.m_positionScale };
+		newMesh.m_positionBias = Vector3{ mesh.m_positionBias };
+		newMesh.m_geometryHash = mesh.m_geometryHash;
+		newMesh.m_materialIndex = mesh.m_materialIndex;
+		newMesh.m_uvDensity = mesh.m_uvDensity;
+
+		newMesh.m_lodCount = mesh.m_lodCount;
+		for (uint32_t lod = 0; lod < mesh.m_lodCount; ++lod)
+		{
+			newMesh.m_lods[lod] = { mesh.m_lods[lod].m_indexOffset, mesh.m_lods[lod].m_indexCount, mesh.m_lods[lod].m_error };
+		}
+
+		return newMesh;
+	}
+
+	FCamera CreateCamera(const FCookedScene& cookedScene, const CookedScene::FCamera& camera)
+	{
+		FCamera newCamera = {};
+		newCamera.m_name = cookedScene.GetString(camera.m_nameOffset);
+		newCamera.m_viewTransform = Matrix{ camera.m_viewTransform };
+		newCamera.m_projectionTransform = Matrix{ camera.m_projectionTransform };
+		return newCamera;
+	}
+
+	// Coarsest LOD that stays close to the mesh surface, with the vertices it uses compacted and decoded to float. Meshes that
+	// are small relative to the scene or too detailed to rasterize cheaply get no occluder.
+	Occlusion::FOccluder CreateOccluder(const FCookedScene& cookedScene, const CookedScene::FMesh& mesh, const DirectX::BoundingBox& meshBounds, const DirectX::BoundingBox& sceneBounds)
+	{
+		const float maxError = 0.01f; // relative to the mesh bounds
+		const float meshSize = 2.f * Vector3{ meshBounds.Extents }.Length();
+		if (meshSize < Settings::k_occluderMinSize * 2.f * Vector3{ sceneBounds.Extents }.Length())
+		{
+			return {};
+		}
+
+		uint32_t lod = 0;
+		while (lod + 1 < mesh.m_lodCount && mesh.m_lods[lod + 1].m_error <= maxError * meshSize)
+		{
+			lod++;
+		}
+
+		const CookedScene::FMeshLod& meshLod = mesh.m_lods[lod];
+		if (meshLod.m_indexCount / 3 > Settings::k_maxOccluderTriangles)
+		{
+			return {};
+		}
+
+		const uint8_t* indexData = cookedScene.GetSectionData(CookedScene::Section::IndexData).data();
+		const uint8_t* positionData = cookedScene.GetSectionData(CookedScene::Section::PositionData).data();
+		const bool quantized = (cookedScene.GetHeader()->m_flags & CookedScene::QuantizedVertices) != 0;
+
+		Occlusion::FOccluder occluder;
+		occluder.m_indices.reserve(meshLod.m_indexCount);
+		std::vector<uint32_t> remap(mesh.m_vertexCount, ~0u);
+		for (uint32_t i = 0; i < meshLod.m_indexCount; ++i)
+		{
+			const uint32_t index = mesh.m_indexFormat == DXGI_FORMAT_R16_UINT ?
+				((const uint16_t*)indexData)[meshLod.m_indexOffset + i] :
+				((const uint32_t*)indexData)[meshLod.m_indexOffset + i];
+
+			if (remap[index] == ~0u)
+			{
+				remap[index] = (uint32_t)occluder.m_positions.size() / 3;
+				for (int j = 0; j < 3; ++j)
+				{
+					const float scale = (&mesh.m_positionScale.x)[j];
+					const float bias = (&mesh.m_positionBias.x)[j];
+					occluder.m_positions.push_back(quantized ?
+						((const uint16_t*)positionData)[(mesh.m_positionOffset + index) * 4 + j] * scale + bias :
+						((const float*)positionData)[(mesh.m_positionOffset + index) * 3 + j]);
+				}
+			}
+
+			occluder.m_indices.push_back(remap[index]);
+		}
+
+		return occluder;
+	}
+
+	size_t GetUploadSize(const DirectX::ScratchImage& scratch)
+	{
+		size_t uploadSize = 0;
+		for (size_t i = 0; i < scratch.GetImageCount(); ++i)
+		{
+			const DirectX::Image& image = scratch.GetImages()[i];
+			const size_t alignedPitch = (image.rowPitch + D3D12_TEXTURE_DATA_PITCH_ALIGNMENT - 1) & ~(D3D12_TEXTURE_DATA_PITCH_ALIGNMENT - 1);
+			uploadSize += alignedPitch * (image.slicePitch / image.rowPitch) + D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT;
+		}
+
+		return uploadSize;
+	}
+
+	constexpr size_t AlignUploadSize(const size_t size)
+	{
+		return (size + D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT - 1) & ~(D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT - 1);
+	}
+}
+
+// Background half of a scene load. The job cooks or maps the scene and decodes textures, the render thread then consumes
+// its output through FScene::Stream. Meshes are staged here until their geometry has been uploaded.
+struct FSceneStreamer
+{
+	void Load(const std::string& filename);
+
+	FCookedScene m_cookedScene;
+	concurrency::task<void> m_job;
+	std::atomic<bool> m_sceneOpened = false;
+	std::atomic<bool> m_failed = false; // set instead of m_sceneOpened if the scene could not be cooked or opened
+	std::atomic<bool> m_cancelled = false;
+
+	// Written by the job before the scene is flagged as opened
+	std::vector<std::wstring> m_textureNames;
+	std::vector<FTextureCache::FCompressedTexture> m_textureImages;
+	concurrency::concurrent_queue<size_t> m_decodedTextures;
+
+	// Render thread state
+	bool m_layoutPublished = false;
+	std::vector<FRenderMesh> m_stagedMeshes;
+	std::vector<int> m_textureIndices;
+	size_t m_publishedMeshCount = 0;
+	size_t m_publishedTextureCount = 0;
+	size_t m_uploadedBytes = 0;
+	std::chrono::high_resolution_clock::time_point m_startTime;
+	std::chrono::duration<double, std::milli> m_timeToLayout;
+};
+
+void FSceneStreamer::Load(const std::string& filename)
+{
+	// Cook the glTF source unless an up to date cooked scene already exists
+	const std::filesystem::path cookedFilepath = CookedScene::GetCookedFilepath(filename);
+	if (!m_cookedScene.Open(cookedFilepath) || !m_cookedScene.IsUpToDate() || m_cookedScene.GetHeader()->m_flags != GetSceneCookFlags())
+	{
+		m_cookedScene.Close();
+
+		// A failed cook may leave a stale or missing cooked file behind, never open it
+		FSceneCooker cooker;
+		const bool ok = cooker.Cook(filename, cookedFilepath) && m_cookedScene.Open(cookedFilepath);
+		DebugAssert(ok, "Failed to cook scene");
+		if (!ok)
+		{
+			m_failed = true;
+			return;
+		}
+	}
+
+	std::span<const CookedScene::FTexture> textures = m_cookedScene.GetSection<CookedScene::FTexture>(CookedScene::Section::Textures);
+	m_textureNames.resize(textures.size());
+	m_textureImages.resize(textures.size());
+	for (size_t i = 0; i < textures.size(); ++i)
+	{
+		m_textureNames[i] = GetTextureName(m_cookedScene, textures[i]);
+	}
+
+	m_sceneOpened = true;
+
+	// Decode, mip and compress textures in parallel and hand each one over as soon as it is ready. Textures already resident
+	// in the texture cache are skipped and the others are read back from the disk cache when possible. Only the mip tails are
+	// kept when the larger mips can be streamed in afterwards.
+	const uint32_t maxMipSize = RenderBackend12::SupportsReservedTextures() ? Settings::k_textureStreamingTailSize : ~0u;
+	concurrency::parallel_for(size_t(0), textures.size(), [this, &textures, maxMipSize](const size_t i)
+	{
+		if (m_cancelled)
+		{
+			return;
+		}
+
+		if (Demo::s_textureCache.m_cachedTextures.count(m_textureNames[i]) == 0)
+		{
+			Demo::s_textureCache.LoadCompressedTexture2D(m_cookedScene.GetString(textures[i].m_pathOffset), textures[i].m_byteOffset, textures[i].m_byteSize, textures[i].m_usage, m_textureImages[i], maxMipSize);
+		}
+
+		m_decodedTextures.push(i);
+	});
+}
+
+void FScene::Reload(const std::string& filename)
+{
+	Clear();
+
+	m_sceneFilename = filename;
+	m_loadFailed = false;
+	m_streamer = std::make_shared<FSceneStreamer>();
+	m_streamer->m_startTime = std::chrono::high_resolution_clock::now();
+	m_streamer->m_job = concurrency::create_task([streamer = m_streamer, filename]()
+	{
+		streamer->Load(filename);
+	});
+}
+
+bool FScene::Stream()
+{
+	// The scene stays empty until its content changes again, which triggers a full reload
+	if (m_streamer && m_streamer->m_failed)
+	{
+		OutputDebugStringA(("Failed to load " + m_sceneFilename + "\n").c_str());
+		m_streamer->m_job.wait();
+		m_streamer.reset();
+		m_loadFailed = true;
+		return false;
+	}
+
+	if (!m_streamer || !m_streamer->m_sceneOpened)
+	{
+		return false;
+	}
+
+	FSceneStreamer& streamer = *m_streamer;
+	const FCookedScene& cookedScene = streamer.m_cookedScene;
+	std::span<const CookedScene::FMesh> meshes = cookedScene.GetSection<CookedScene::FMesh>(CookedScene::Section::Meshes);
+	std::span<const CookedScene::FTexture> textures = cookedScene.GetSection<CookedScene::FTexture>(CookedScene::Section::Textures);
+	std::span<const CookedScene::FMaterial> materials = cookedScene.GetSection<CookedScene::FMaterial>(CookedScene::Section::Materials);
+	std::span<const CookedScene::FInstance> instances = cookedScene.GetSection<CookedScene::FInstance>(CookedScene::Section::Instances);
+	std::span<const MeshOptimizer::FMeshlet> meshlets = cookedScene.GetSection<MeshOptimizer::FMeshlet>(CookedScene::Section::Meshlets);
+	const uint32_t flags = cookedScene.GetHeader()->m_flags;
+
+	// Pick this frame's work. At least one item is always taken so that loading progresses whatever the budget.
+	const bool publishLayout = !streamer.m_layoutPublished;
+	size_t uploadSize = publishLayout ? AlignUploadSize(instances.size() * sizeof(Matrix)) + 2 * D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT : 0;
+
+	std::vector<size_t> readyTextures;
+	size_t readyTextureIndex;
+	while (uploadSize < Settings::k_sceneStreamingBudget && streamer.m_decodedTextures.try_pop(readyTextureIndex))
+	{
+		readyTextures.push_back(readyTextureIndex);
+		uploadSize += GetUploadSize(streamer.m_textureImages[readyTextureIndex].m_mips);
+	}
+
+	size_t meshEnd = streamer.m_publishedMeshCount;
+	while (meshEnd < meshes.size())
+	{
+		size_t meshUploadSize = 0;
+		for (const CookedScene::FByteRange& range : CookedScene::GetMeshGeometryRanges(meshes[meshEnd], meshlets, flags))
+		{
+			meshUploadSize += AlignUploadSize(range.m_size);
+		}
+
+		if (uploadSize > 0 && uploadSize + meshUploadSize > Settings::k_sceneStreamingBudget)
+		{
+			break;
+		}
+
+		uploadSize += meshUploadSize;
+		meshEnd++;
+	}
+
+	if (uploadSize == 0)
+	{
+		return false;
+	}
+
+	FResourceUploadContext uploader{ uploadSize };
+
+	// Scene layout. Geometry buffers are allocated at their final size and filled mesh by mesh, everything that is
+	// small or CPU side only is published in one go.
+	if (publishLayout)
+	{
+		m_instanceTransforms.resize(instances.size());
+		m_instanceMeshIndices.resize(instances.size());
+		for (size_t i = 0; i < instances.size(); ++i)
+		{
+			m_instanceTransforms[i] = Matrix{ instances[i].m_localToWorld };
+			m_instanceMeshIndices[i] = instances[i].m_meshIndex;
+		}
+
+		auto CreateSceneBuffer = [&cookedScene](const std::wstring& name, const CookedScene::Section section)
+		{
+			return RenderBackend12::CreateBindlessBuffer(name, cookedScene.GetSectionData(section).size(), D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+		};
+
+		m_instanceTransformBuffer = RenderBackend12::CreateBindlessBuffer(L"scene_instance_transform_buffer", m_instanceTransforms.size() * sizeof(Matrix), D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+		uploader.UpdateBufferRegion(m_instanceTransformBuffer->m_resource->m_d3dResource, 0, (const uint8_t*)m_instanceTransforms.data(), m_instanceTransforms.size() * sizeof(Matrix));
+
+		// Filled below once the texture indices are known
+		m_materialBuffer = RenderBackend12::CreateBindlessBuffer(L"scene_material_buffer", materials.size() * sizeof(FMaterial), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+
+		m_meshIndexBuffer = CreateSceneBuffer(L"scene_index_buffer", CookedScene::Section::IndexData);
+		m_meshPositionBuffer = CreateSceneBuffer(L"scene_position_buffer", CookedScene::Section::PositionData);
+		m_meshNormalBuffer = CreateSceneBuffer(L"scene_normal_buffer", CookedScene::Section::NormalData);
+		m_meshUvBuffer = CreateSceneBuffer(L"scene_uv_buffer", CookedScene::Section::UvData);
+		m_meshletBuffer = CreateSceneBuffer(L"scene_meshlet_buffer", CookedScene::Section::Meshlets);
+		m_meshletBoundsBuffer = CreateSceneBuffer(L"scene_meshlet_bounds_buffer", CookedScene::Section::MeshletBounds);
+		m_meshletVertexBuffer = CreateSceneBuffer(L"scene_meshlet_vertex_buffer", CookedScene::Section::MeshletVertices);
+		m_meshletTriangleBuffer = CreateSceneBuffer(L"scene_meshlet_triangle_buffer", CookedScene::Section::MeshletTriangles);
+
+		// Stand-ins for the textures that are still loading, white or a flat tangent space normal
+		auto CachePlaceholder = [&uploader](const std::wstring& name, const uint32_t pixel)
+		{
+			DirectX::Image placeholder = {};
+			placeholder.width = 1;
+			placeholder.height = 1;
+			placeholder.format = DXGI_FORMAT_R8G8B8A8_UNORM;
+			placeholder.rowPitch = sizeof(pixel);
+			placeholder.slicePitch = sizeof(pixel);
+			placeholder.pixels = (uint8_t*)&pixel;
+			return (int)Demo::s_textureCache.CacheTexture2D(&uploader, name, placeholder.format, 1, 1, &placeholder, 1);
+		};
+
+		const int placeholderIndex = CachePlaceholder(L"placeholder_texture", 0xffffffff);
+		const int normalPlaceholderIndex = CachePlaceholder(L"placeholder_normal_texture", 0xffff8080);
+		streamer.m_textureIndices.resize(textures.size());
+		for (size_t i = 0; i < textures.size(); ++i)
+		{
+			streamer.m_textureIndices[i] = textures[i].m_usage == CookedScene::TextureUsage::Normal ? normalPlaceholderIndex : placeholderIndex;
+		}
+
+		// Meshes are staged with their instance ranges and published once their geometry is resident
+		for (const CookedScene::FMesh& mesh : meshes)
+		{
+			streamer.m_stagedMeshes.push_back(CreateRenderMesh(cookedScene, mesh));
+		}
+
+		for (size_t i = 0; i < m_instanceMeshIndices.size(); ++i)
+		{
+			FRenderMesh& mesh = streamer.m_stagedMeshes[m_instanceMeshIndices[i]];
+			mesh.m_instanceOffset = mesh.m_instanceCount == 0 ? (uint32_t)i : mesh.m_instanceOffset;
+			mesh.m_instanceCount++;
+		}
+
+		std::span<const DirectX::BoundingBox> bounds = cookedScene.GetSection<DirectX::BoundingBox>(CookedScene::Section::Bounds);
+		m_meshBounds.assign(bounds.begin(), bounds.end());
+		GetInstanceBounds(m_instanceBounds, m_meshBounds, m_instanceMeshIndices);
+		m_meshlets.assign(meshlets.begin(), meshlets.end());
+
+		std::span<const MeshOptimizer::FMeshletBounds> meshletBounds = cookedScene.GetSection<MeshOptimizer::FMeshletBounds>(CookedScene::Section::MeshletBounds);
+		m_meshletBounds.assign(meshletBounds.begin(), meshletBounds.end());
+
+		m_sceneBounds = cookedScene.GetHeader()->m_sceneBounds;
+		m_quantizedVertices = (flags & CookedScene::QuantizedVertices) != 0;
+
+		for (const CookedScene::FCamera& camera : cookedScene.GetSection<CookedScene::FCamera>(CookedScene::Section::Cameras))
+		{
+			m_cameras.push_back(CreateCamera(cookedScene, camera));
+		}
+
+		streamer.m_layoutPublished = true;
+		streamer.m_timeToLayout = std::chrono::high_resolution_clock::now() - streamer.m_startTime;
+	}
+
+	// Textures. The ones that failed to load keep their placeholder and are retried by the next hot reload.
+	for (const size_t i : readyTextures)
+	{
+		if (streamer.m_textureImages[i].m_mips.GetImageCount() > 0)
+		{
+			Demo::s_textureCache.CacheStreamingTexture2D(&uploader, streamer.m_textureNames[i], streamer.m_textureImages[i]);
+
+			m_textureTimestamps[streamer.m_textureNames[i]] = GetLastWriteTime(cookedScene.GetString(textures[i].m_pathOffset));
+		}
+		else if (Demo::s_textureCache.m_cachedTextures.count(streamer.m_textureNames[i]) != 0 && !m_textureTimestamps.contains(streamer.m_textureNames[i]))
+		{
+			m_textureTimestamps[streamer.m_textureNames[i]] = GetLastWriteTime(cookedScene.GetString(textures[i].m_pathOffset));
+		}
+
+		streamer.m_textureIndices[i] = GetTextureIndex(streamer.m_textureNames[i], textures[i].m_usage);
+	}
+
+	// Mesh geometry, in mesh order
+	const std::pair<CookedScene::Section, FBindlessShaderResource*> geometryBuffers[] =
+	{
+		{ CookedScene::Section::IndexData, m_meshIndexBuffer.get() },
+		{ CookedScene::Section::PositionData, m_meshPositionBuffer.get() },
+		{ CookedScene::Section::NormalData, m_meshNormalBuffer.get() },
+		{ CookedScene::Section::UvData, m_meshUvBuffer.get() },
+		{ CookedScene::Section::Meshlets, m_meshletBuffer.get() },
+		{ CookedScene::Section::MeshletBounds, m_meshletBoundsBuffer.get() },
+		{ CookedScene::Section::MeshletVertices, m_meshletVertexBuffer.get() },
+		{ CookedScene::Section::MeshletTriangles, m_meshletTriangleBuffer.get() }
+	};
+
+	for (size_t meshIndex = streamer.m_publishedMeshCount; meshIndex < meshEnd; ++meshIndex)
+	{
+		for (const CookedScene::FByteRange& range : CookedScene::GetMeshGeometryRanges(meshes[meshIndex], meshlets, flags))
+		{
+			if (range.m_size > 0)
+			{
+				FBindlessShaderResource* buffer = std::find_if(std::cbegin(geometryBuffers), std::cend(geometryBuffers), [&range](const auto& entry) { return entry.first == range.m_section; })->second;
+				uploader.UpdateBufferRegion(buffer->m_resource->m_d3dResource, range.m_offset, cookedScene.GetSectionData(range.m_section).data() + range.m_offset, range.m_size);
+			}
+		}
+	}
+
+	// Frames recorded after this submission are queue ordered after the copies, so the new content can be published right away
+	FCommandList* cmdList = RenderBackend12::FetchCommandlist(D3D12_COMMAND_LIST_TYPE_DIRECT);
+	uploader.SubmitUploads(cmdList);
+
+	// The material table is uploaded with the layout and again whenever textures replace their placeholders. The update is
+	// recorded on the direct CL so that frames in flight keep reading the previous indices.
+	if ((publishLayout || !readyTextures.empty()) && !materials.empty())
+	{
+		m_materials = CreateMaterials(materials, streamer.m_textureIndices);
+		RenderBackend12::UpdateBindlessBuffer(cmdList, m_materialBuffer.get(), 0, (const uint8_t*)m_materials.data(), m_materials.size() * sizeof(FMaterial));
+	}
+
+	RenderBackend12::ExecuteCommandlists(D3D12_COMMAND_LIST_TYPE_DIRECT, { cmdList });
+
+	for (size_t meshIndex = streamer.m_publishedMeshCount; meshIndex < meshEnd; ++meshIndex)
+	{
+		m_meshGeo.push_back(streamer.m_stagedMeshes[meshIndex]);
+		m_occluders.push_back(CreateOccluder(cookedScene, meshes[meshIndex], m_meshBounds[meshIndex], m_sceneBounds));
+	}
+
+	for (const size_t i : readyTextures)
+	{
+		streamer.m_textureImages[i].m_mips.Release();
+	}
+
+	streamer.m_publishedMeshCount = meshEnd;
+	streamer.m_publishedTextureCount += readyTextures.size();
+	streamer.m_uploadedBytes += uploadSize;
+
+	// Done, the light probe is cached across loads so it only delays the first scene
+	if (streamer.m_publishedMeshCount == meshes.size() && streamer.m_publishedTextureCount == textures.size())
+	{
+		m_globalLightProbe = Demo::s_textureCache.CacheHdrTexture(L"lilienstein_2k.hdr");
+
+		// Texture memory against compressing every texture to BC3 regardless of its usage, and what is resident until the
+		// detailed mips stream in
+		size_t textureBytes = 0, textureBytesBc3 = 0, residentTextureBytes = 0;
+		for (const std::wstring& name : streamer.m_textureNames)
+		{
+			const auto cachedTexture = Demo::s_textureCache.m_cachedTextures.find(name);
+			if (cachedTexture == Demo::s_textureCache.m_cachedTextures.cend())
+			{
+				continue;
+			}
+
+			const D3D12_RESOURCE_DESC desc = cachedTexture->second->m_resource->m_d3dResource->GetDesc();
+			const auto streamingTexture = Demo::s_textureCache.m_streamingTextures.find(name);
+			const uint32_t residentMip = streamingTexture != Demo::s_textureCache.m_streamingTextures.cend() ? streamingTexture->second.m_residentMip : 0;
+			textureBytes += GetBlockCompressedSize(desc, DirectX::BitsPerPixel(desc.Format) * 2);
+			textureBytesBc3 += GetBlockCompressedSize(desc, 16);
+			residentTextureBytes += GetBlockCompressedSize(desc, DirectX::BitsPerPixel(desc.Format) * 2, residentMip);
+		}
+
+		const std::chrono::duration<double, std::milli> loadTime = std::chrono::high_resolution_clock::now() - streamer.m_startTime;
+		std::stringstream report;
+		report << "Streamed " << m_sceneFilename << ": layout after " << streamer.m_timeToLayout.count() << " ms, " << meshes.size() << " meshes and "
+			<< textures.size() << " textures in " << loadTime.count() << " ms (" << streamer.m_uploadedBytes / (1024 * 1024) << " MB uploaded, "
+			<< streamer.m_uploadedBytes / (1024.0 * 1024.0) / (loadTime.count() / 1000.0) << " MB/s)\n";
+		report << "Streamed " << m_sceneFilename << ": texture memory " << textureBytes / 1024 << " KB (" << textureBytesBc3 / 1024 << " KB as BC3), "
+			<< residentTextureBytes / 1024 << " KB resident\n";
+		OutputDebugStringA(report.str().c_str());
+
+		streamer.m_job.wait();
+		m_streamer.reset();
+	}
+
+	return publishLayout;
+}
+
+bool FScene::IsLoading() const
+{
+	return m_streamer != nullptr;
+}
+
+void FScene::UpdateWorldBounds()
+{
+	m_rotatedSceneBounds = ToBoundingBox(Bounds::TransformBoxes(m_instanceWorldBounds, m_instanceBounds, (const float*)m_instanceTransforms.data(), (const float*)&m_rootTransform));
+
+	// Rebuild when the instances change, or when the transforms moved the boxes so far that the refitted tree got too slow
+	if (m_instanceBvh.GetPrimitiveCount() != m_instanceWorldBounds.Size() ||
+		m_instanceBvh.Refit(m_instanceWorldBounds) > Settings::k_bvhRebuildThreshold)
+	{
+		m_instanceBvh.Build(m_instanceWorldBounds);
+	}
+}
+
+void FScene::StreamTextures(const FView& view, const uint32_t resY)
+{
+	// Material texture indices are rebuilt from the streamer's until the load completes
+	FTextureCache& textureCache = Demo::s_textureCache;
+	if (IsLoading() || textureCache.m_streamingTextures.empty())
+	{
+		return;
+	}
+
+	std::map<int, std::pair<const std::wstring*, FTextureCache::FStreamingTexture*>> streamingTextures; // by descriptor table offset
+	for (auto& [name, texture] : textureCache.m_streamingTextures)
+	{
+		const auto cachedTexture = textureCache.m_cachedTextures.find(name);
+		if (cachedTexture != textureCache.m_cachedTextures.cend())
+		{
+			const int textureIndex = RenderBackend12::GetDescriptorTableOffset(BindlessDescriptorType::Texture2D, cachedTexture->second->m_srvIndex);
+			streamingTextures[textureIndex] = { &name, &texture };
+		}
+	}
+
+	// About one texel per pixel. A mesh covers its texture size times its UV density in texels per object space unit, and the
+	// closest instance decides how many pixels an object space unit covers on screen.
+	std::map<FTextureCache::FStreamingTexture*, uint32_t> wantedMips;
+	for (const FRenderMesh& mesh : m_meshGeo)
+	{
+		if (mesh.m_uvDensity <= 0.f || mesh.m_instanceCount == 0)
+		{
+			continue;
+		}
+
+		float pixelsPerUnit = 0.f;
+		for (uint32_t instanceIndex = mesh.m_instanceOffset; instanceIndex < mesh.m_instanceOffset + mesh.m_instanceCount; ++instanceIndex)
+		{
+			const Matrix& localToWorld = m_instanceTransforms[instanceIndex];
+			const Vector3 center{ m_instanceWorldBounds.m_centerX[instanceIndex], m_instanceWorldBounds.m_centerY[instanceIndex], m_instanceWorldBounds.m_centerZ[instanceIndex] };
+			const Vector3 extents{ m_instanceWorldBounds.m_extentX[instanceIndex], m_instanceWorldBounds.m_extentY[instanceIndex], m_instanceWorldBounds.m_extentZ[instanceIndex] };
+
+			const float distance = (center - view.m_position).Length() - extents.Length();
+			if (distance <= 0.f)
+			{
+				pixelsPerUnit = std::numeric_limits<float>::max();
+				break;
+			}
+
+			const float worldScale = std::sqrt(std::max({ localToWorld.Right().LengthSquared(), localToWorld.Up().LengthSquared(), localToWorld.Backward().LengthSquared() }));
+			pixelsPerUnit = std::max(pixelsPerUnit, 0.5f * resY * view.m_projectionTransform._22 * worldScale / distance);
+		}
+
+		const FMaterial& material = m_materials[mesh.m_materialIndex];
+		for (const int textureIndex : { material.m_baseColorTextureIndex, material.m_metallicRoughnessTextureIndex, material.m_normalTextureIndex })
+		{
+			auto search = streamingTextures.find(textureIndex);
+			if (search == streamingTextures.cend())
+			{
+				continue;
+			}
+
+			FTextureCache::FStreamingTexture* texture = search->second.second;
+			const float texelsPerUnit = std::sqrt(float(texture->m_metadata.width * texture->m_metadata.height)) * mesh.m_uvDensity;
+			const uint32_t mip = (uint32_t)std::clamp(std::floor(std::log2(texelsPerUnit / pixelsPerUnit)), 0.f, float(texture->m_metadata.mipLevels - 1));
+			wantedMips[texture] = wantedMips.contains(texture) ? std::min(wantedMips[texture], mip) : mip;
+		}
+	}
+
+	// Read the missing mips on the thread pool, one request in flight per texture. Resident mips are kept for the lifetime of
+	// the texture.
+	for (auto& [texture, wantedMip] : wantedMips)
+	{
+		if (wantedMip < texture->m_residentMip && texture->m_requestedMip == texture->m_residentMip)
+		{
+			texture->m_requestedMip = wantedMip;
+			texture->m_pendingMips = concurrency::create_task([filepath = texture->m_cachedFilepath, metadata = texture->m_metadata, firstMip = wantedMip, mipCount = texture->m_residentMip - wantedMip]()
+			{
+				return std::make_shared<DirectX::ScratchImage>(FTextureCache::LoadCompressedMips(filepath, metadata, firstMip, mipCount));
+			});
+		}
+	}
+
+	// Pick the mips that have been read. At least one texture is always taken so that streaming progresses whatever the budget.
+	struct FReadyMips
+	{
+		FBindlessShaderResource* m_resource;
+		FTextureCache::FStreamingTexture* m_texture;
+		std::shared_ptr<DirectX::ScratchImage> m_mips;
+	};
+
+	std::vector<FReadyMips> readyMips;
+	size_t uploadSize = 0;
+	for (auto& [name, texture] : textureCache.m_streamingTextures)
+	{
+		const auto cachedTexture = textureCache.m_cachedTextures.find(name);
+		if (cachedTexture != textureCache.m_cachedTextures.cend() && texture.m_requestedMip < texture.m_residentMip && texture.m_pendingMips.is_done())
+		{
+			std::shared_ptr<DirectX::ScratchImage> mips = texture.m_pendingMips.get();
+			const size_t mipsUploadSize = GetUploadSize(*mips);
+			if (uploadSize > 0 && uploadSize + mipsUploadSize > Settings::k_textureStreamingBudget)
+			{
+				break;
+			}
+
+			uploadSize += mipsUploadSize;
+			readyMips.push_back({ cachedTexture->second.get(), &texture, std::move(mips) });
+		}
+	}
+
+	if (readyMips.empty())
+	{
+		return;
+	}
+
+	// Mips above the resident ones are still in the copy destination state, they are copied to while the others are sampled
+	FResourceUploadContext uploader{ uploadSize };
+	for (const FReadyMips& ready : readyMips)
+	{
+		const uint32_t firstMip = ready.m_texture->m_requestedMip;
+		RenderBackend12::CommitTextureMips(ready.m_resource, firstMip);
+
+		std::vector<D3D12_SUBRESOURCE_DATA> srcData(ready.m_mips->GetImageCount());
+		for (size_t i = 0; i < srcData.size(); ++i)
+		{
+			const DirectX::Image& image = ready.m_mips->GetImages()[i];
+			srcData[i] = { image.pixels, (LONG_PTR)image.rowPitch, (LONG_PTR)image.slicePitch };
+		}
+
+		uploader.UpdateSubresources(
+			ready.m_resource->m_resource->m_d3dResource,
+			srcData,
+			[resource = ready.m_resource->m_resource, firstMip, residentMip = ready.m_texture->m_residentMip](FCommandList* cmdList)
+			{
+				for (uint32_t mip = firstMip; mip < residentMip; ++mip)
+				{
+					resource->Transition(cmdList, mip, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE | D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+				}
+			},
+			firstMip);
+	}
+
+	FCommandList* cmdList = RenderBackend12::FetchCommandlist(D3D12_COMMAND_LIST_TYPE_DIRECT);
+	uploader.SubmitUploads(cmdList);
+
+	// The textures move to new descriptors that expose the streamed mips. The material table is patched on the same CL so that
+	// frames in flight keep sampling the previous descriptors until they are recycled.
+	std::map<int, int> movedTextures;
+	for (const FReadyMips& ready : readyMips)
+	{
+		const int previousIndex = RenderBackend12::GetDescriptorTableOffset(BindlessDescriptorType::Texture2D, ready.m_resource->m_srvIndex);
+		RenderBackend12::SetTextureMostDetailedMip(ready.m_resource, ready.m_texture->m_requestedMip, cmdList);
+		movedTextures[previousIndex] = RenderBackend12::GetDescriptorTableOffset(BindlessDescriptorType::Texture2D, ready.m_resource->m_srvIndex);
+		ready.m_texture->m_residentMip = ready.m_texture->m_requestedMip;
+	}
+
+	for (FMaterial& material : m_materials)
+	{
+		for (int* textureIndex : { &material.m_baseColorTextureIndex, &material.m_metallicRoughnessTextureIndex, &material.m_normalTextureIndex })
+		{
+			auto search = movedTextures.find(*textureIndex);
+			*textureIndex = search != movedTextures.cend() ? search->second : *textureIndex;
+		}
+	}
+
+	if (!m_materials.empty())
+	{
+		RenderBackend12::UpdateBindlessBuffer(cmdList, m_materialBuffer.get(), 0, (const uint8_t*)m_materials.data(), m_materials.size() * sizeof(FMaterial));
+	}
+
+	RenderBackend12::ExecuteCommandlists(D3D12_COMMAND_LIST_TYPE_DIRECT, { cmdList });
+}
+
+bool FScene::HotReload()
+{
+	// Recook if the glTF changed. The cooked layout is deterministic so unchanged meshes keep their offsets and hashes.
+	const std::filesystem::path cookedFilepath = CookedScene::GetCookedFilepath(m_sceneFilename);
+	FCookedScene cookedScene;
+	bool sceneChanged = false;
+	if (!cookedScene.Open(cookedFilepath) || !cookedScene.IsUpToDate() || cookedScene.GetHeader()->m_flags != GetSceneCookFlags())
+	{
+		cookedScene.Close();
+
+		FSceneCooker cooker;
+		if (!cooker.Cook(m_sceneFilename, cookedFilepath) || !cookedScene.Open(cookedFilepath))
 		{
-			LoadNode(nodeIndex, model, RH2LH);
+			// Most likely a partially saved file, keep the current scene until the next change
+			return true;
 		}
+
+		sceneChanged = true;
 	}
 
-	// Scene bounds
-	std::vector<DirectX::BoundingBox> meshWorldBounds(m_meshBounds.size());
-	for (int i = 0; i < m_meshBounds.size(); ++i)
+	// Textures that are new to the scene or whose source image changed on disk
+	std::span<const CookedScene::FTexture> textures = cookedScene.GetSection<CookedScene::FTexture>(CookedScene::Section::Textures);
+	std::vector<std::wstring> textureNames(textures.size());
+	std::vector<int64_t> textureTimestamps(textures.size());
+	std::vector<size_t> staleTextures;
+	for (size_t i = 0; i < textures.size(); ++i)
 	{
-		m_meshBounds[i].Transform(meshWorldBounds[i], m_meshTransforms[i]);
+		textureNames[i] = GetTextureName(cookedScene, textures[i]);
+		textureTimestamps[i] = GetLastWriteTime(cookedScene.GetString(textures[i].m_pathOffset));
+
+		auto search = m_textureTimestamps.find(textureNames[i]);
+		if (search == m_textureTimestamps.cend() || search->second != textureTimestamps[i] || Demo::s_textureCache.m_cachedTextures.count(textureNames[i]) == 0)
+		{
+			staleTextures.push_back(i);
+		}
 	}
 
-	m_sceneBounds = meshWorldBounds[0];
-	for (const auto& bb : meshWorldBounds)
+	if (!sceneChanged && staleTextures.empty())
 	{
-		DirectX::BoundingBox::CreateMerged(m_sceneBounds, m_sceneBounds, bb);
+		return true;
 	}
 
-	// Create and upload scene buffers
-	FResourceUploadContext uploader{ maxSize };
-	m_meshIndexBuffer = RenderBackend12::CreateBindlessBuffer(
-		L"scene_index_buffer",
-		m_scratchIndexBufferOffset,
-		D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE,
-		m_scratchIndexBuffer,
-		&uploader);
+	// All patches are recorded on a direct CL so that they land after the frames already in flight
+	FCommandList* cmdList = RenderBackend12::FetchCommandlist(D3D12_COMMAND_LIST_TYPE_DIRECT);
 
-	m_meshPositionBuffer = RenderBackend12::CreateBindlessBuffer(
-		L"scene_position_buffer",
-		m_scratchPositionBufferOffset,
-		D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE,
-		m_scratchPositionBuffer,
-		&uploader);
+	// Replace stale textures. The old resources stay alive until the GPU is done with the frames that reference them.
+	if (!staleTextures.empty())
+	{
+		const uint32_t maxMipSize = RenderBackend12::SupportsReservedTextures() ? Settings::k_textureStreamingTailSize : ~0u;
+		std::vector<FTextureCache::FCompressedTexture> textureImages(staleTextures.size());
+		std::vector<uint8_t> loaded(staleTextures.size());
+		concurrency::parallel_for(size_t(0), staleTextures.size(), [&](const size_t i)
+		{
+			const CookedScene::FTexture& texture = textures[staleTextures[i]];
+			loaded[i] = Demo::s_textureCache.LoadCompressedTexture2D(cookedScene.GetString(texture.m_pathOffset), texture.m_byteOffset, texture.m_byteSize, texture.m_usage, textureImages[i], maxMipSize);
+		});
 
-	m_meshNormalBuffer = RenderBackend12::CreateBindlessBuffer(
-		L"scene_normal_buffer",
-		m_scratchNormalBufferOffset,
-		D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE,
-		m_scratchNormalBuffer,
-		&uploader);
+		size_t uploadSize = 0;
+		for (const FTextureCache::FCompressedTexture& texture : textureImages)
+		{
+			uploadSize += GetUploadSize(texture.m_mips);
+		}
 
-	m_meshUvBuffer = RenderBackend12::CreateBindlessBuffer(
-		L"scene_uv_buffer",
-		m_scratchUvBufferOffset,
-		D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE,
-		m_scratchUvBuffer,
-		&uploader);
+		FResourceUploadContext uploader{ uploadSize };
+		for (size_t i = 0; i < staleTextures.size(); ++i)
+		{
+			// A texture that failed to load keeps its previous version, or the placeholder, until its next change
+			if (!loaded[i])
+			{
+				continue;
+			}
 
-	FCommandList* cmdList = RenderBackend12::FetchCommandlist(D3D12_COMMAND_LIST_TYPE_DIRECT);
-	uploader.SubmitUploads(cmdList);
-	RenderBackend12::ExecuteCommandlists(D3D12_COMMAND_LIST_TYPE_DIRECT, { cmdList });
+			const std::wstring& name = textureNames[staleTextures[i]];
+			Demo::s_textureCache.Evict(name, cmdList);
+			Demo::s_textureCache.CacheStreamingTexture2D(&uploader, name, textureImages[i]);
 
-	delete[] m_scratchIndexBuffer;
-	delete[] m_scratchPositionBuffer;
-	delete[] m_scratchNormalBuffer;
-	delete[] m_scratchUvBuffer;
+			m_textureTimestamps[name] = textureTimestamps[staleTextures[i]];
+		}
 
-	m_globalLightProbe = Demo::s_textureCache.CacheHdrTexture(L"lilienstein_2k.hdr");
-}
+		uploader.SubmitUploads(cmdList);
+	}
 
-void FScene::LoadNode(int nodeIndex, const tinygltf::Model& model, const Matrix& parentTransform)
-{
-	const tinygltf::Node& node = model.nodes[nodeIndex];
-	
-	// Transform (GLTF uses column-major storage)
-	Matrix nodeTransform = Matrix::Identity;
-	if (!node.matrix.empty())
+	std::vector<int> textureIndices(textures.size());
+	for (size_t i = 0; i < textures.size(); ++i)
 	{
-		const auto& m = node.matrix;
-		nodeTransform = Matrix { 
-			(float)m[0], (float)m[1], (float)m[2], (float)m[3],
-			(float)m[4], (float)m[5], (float)m[6], (float)m[7],
-			(float)m[8], (float)m[9], (float)m[10],(float)m[11],
-			(float)m[12], (float)m[13], (float)m[14],(float)m[15]
-		};
+		textureIndices[i] = GetTextureIndex(textureNames[i], textures[i].m_usage);
 	}
-	else if (!node.translation.empty() || !node.rotation.empty() || !node.scale.empty())
+
+	// Patching in place requires the exact same buffer layout: same meshes at the same offsets, same meshlet
+	// partition and same instance to mesh mapping. Anything else goes through a full reload.
+	std::span<const CookedScene::FMesh> meshes = cookedScene.GetSection<CookedScene::FMesh>(CookedScene::Section::Meshes);
+	std::span<const CookedScene::FMaterial> materials = cookedScene.GetSection<CookedScene::FMaterial>(CookedScene::Section::Materials);
+	std::span<const CookedScene::FInstance> instances = cookedScene.GetSection<CookedScene::FInstance>(CookedScene::Section::Instances);
+	std::span<const MeshOptimizer::FMeshlet> meshlets = cookedScene.GetSection<MeshOptimizer::FMeshlet>(CookedScene::Section::Meshlets);
+	const uint32_t flags = cookedScene.GetHeader()->m_flags;
+
+	const std::pair<CookedScene::Section, FBindlessShaderResource*> geometryBuffers[] =
 	{
-		Matrix translation = !node.translation.empty() ? Matrix::CreateTranslation(Vector3{ (float*)node.translation.data() }) : Matrix::Identity;
-		Matrix rotation = !node.rotation.empty() ? Matrix::CreateFromQuaternion(Quaternion{ (float*)node.rotation.data() }) : Matrix::Identity;
-		Matrix scale = !node.scale.empty() ? Matrix::CreateScale(Vector3{ (float*)node.scale.data() }) : Matrix::Identity;
+		{ CookedScene::Section::IndexData, m_meshIndexBuffer.get() },
+		{ CookedScene::Section::PositionData, m_meshPositionBuffer.get() },
+		{ CookedScene::Section::NormalData, m_meshNormalBuffer.get() },
+		{ CookedScene::Section::UvData, m_meshUvBuffer.get() },
+		{ CookedScene::Section::Meshlets, m_meshletBuffer.get() },
+		{ CookedScene::Section::MeshletBounds, m_meshletBoundsBuffer.get() },
+		{ CookedScene::Section::MeshletVertices, m_meshletVertexBuffer.get() },
+		{ CookedScene::Section::MeshletTriangles, m_meshletTriangleBuffer.get() }
+	};
 
-		nodeTransform = scale * rotation * translation;
+	bool compatible = meshes.size() == m_meshGeo.size() && instances.size() == m_instanceMeshIndices.size() && meshlets.size() == m_meshlets.size() &&
+		materials.size() == m_materials.size();
+	for (const auto& [section, buffer] : geometryBuffers)
+	{
+		compatible = compatible && cookedScene.GetSectionData(section).size() == buffer->m_resource->m_d3dResource->GetDesc().Width;
 	}
 
-	if (node.camera != -1)
+	for (size_t i = 0; compatible && i < meshes.size(); ++i)
 	{
-		LoadCamera(node.camera, model, nodeTransform * parentTransform);
+		const CookedScene::FMesh& mesh = meshes[i];
+		const FRenderMesh& loadedMesh = m_meshGeo[i];
+		compatible = mesh.m_indexFormat == (uint32_t)loadedMesh.m_indexFormat &&
+			mesh.m_positionOffset == loadedMesh.m_positionOffset &&
+			mesh.m_normalOffset == loadedMesh.m_normalOffset &&
+			mesh.m_uvOffset == loadedMesh.m_uvOffset &&
+			mesh.m_vertexCount == loadedMesh.m_vertexCount &&
+			mesh.m_meshletOffset == loadedMesh.m_meshletOffset &&
+			mesh.m_meshletCount == loadedMesh.m_meshletCount &&
+			mesh.m_lodCount == loadedMesh.m_lodCount;
+
+		for (uint32_t lod = 0; compatible && lod < mesh.m_lodCount; ++lod)
+		{
+			compatible = mesh.m_lods[lod].m_indexOffset == loadedMesh.m_lods[lod].m_indexOffset &&
+				mesh.m_lods[lod].m_indexCount == loadedMesh.m_lods[lod].m_indexCount;
+		}
 	}
 
-	if (node.mesh != -1)
+	for (size_t i = 0; compatible && i < meshlets.size(); ++i)
 	{
-		LoadMesh(node.mesh, model, nodeTransform * parentTransform);
+		compatible = memcmp(&meshlets[i], &m_meshlets[i], sizeof(MeshOptimizer::FMeshlet)) == 0;
 	}
 
-	for (const int childIndex : node.children)
+	for (size_t i = 0; compatible && i < instances.size(); ++i)
 	{
-		LoadNode(childIndex, model, nodeTransform * parentTransform);
+		compatible = instances[i].m_meshIndex == m_instanceMeshIndices[i];
 	}
-}
 
-void FScene::LoadMesh(int meshIndex, const tinygltf::Model& model, const Matrix& parentTransform)
-{
-	auto CopyIndexData = [&model](const tinygltf::Accessor& accessor, uint8_t* copyDest) -> size_t
+	if (!compatible)
 	{
-		size_t bytesCopied = 0;
-		const tinygltf::BufferView& bufferView = model.bufferViews[accessor.bufferView];
-		size_t dataSize = tinygltf::GetComponentSizeInBytes(accessor.componentType) * tinygltf::GetNumComponentsInType(accessor.type);
-		size_t dataStride = accessor.ByteStride(bufferView);
-
-		const uint8_t* pSrc = &model.buffers[bufferView.buffer].data[bufferView.byteOffset + accessor.byteOffset];
-		uint32_t* indexDest = (uint32_t*)copyDest;
+		RenderBackend12::ExecuteCommandlists(D3D12_COMMAND_LIST_TYPE_DIRECT, { cmdList });
+		return false;
+	}
 
-		if (dataSize == 2)
+	// Geometry of the meshes whose content changed
+	size_t patchedMeshCount = 0, patchedBytes = 0;
+	for (size_t i = 0; i < meshes.size(); ++i)
+	{
+		if (meshes[i].m_geometryHash == m_meshGeo[i].m_geometryHash)
 		{
-			// 16-bit indices
-			auto pSrc = (const uint16_t*)&model.buffers[bufferView.buffer].data[bufferView.byteOffset + accessor.byteOffset];
-			uint32_t* pDest = (uint32_t*)copyDest;
-
-			for (int i = 0; i < accessor.count; ++i)
-			{
-				*(pDest++) = *(pSrc++);
-				bytesCopied += sizeof(uint32_t);
-			}
+			continue;
 		}
-		else
-		{
-			// 32-bit indices
-			auto pSrc = (const uint32_t*)&model.buffers[bufferView.buffer].data[bufferView.byteOffset + accessor.byteOffset];
-			uint32_t* pDest = (uint32_t*)copyDest;
 
-			for (int i = 0; i < accessor.count; ++i)
+		for (const CookedScene::FByteRange& range : CookedScene::GetMeshGeometryRanges(meshes[i], meshlets, flags))
+		{
+			if (range.m_size > 0)
 			{
-				*(pDest++) = *(pSrc++);
-				bytesCopied += sizeof(uint32_t);
+				FBindlessShaderResource* buffer = std::find_if(std::cbegin(geometryBuffers), std::cend(geometryBuffers), [&range](const auto& entry) { return entry.first == range.m_section; })->second;
+				RenderBackend12::UpdateBindlessBuffer(cmdList, buffer, range.m_offset, cookedScene.GetSectionData(range.m_section).data() + range.m_offset, range.m_size);
+				patchedBytes += range.m_size;
 			}
 		}
 
-		return bytesCopied;
-	};
+		patchedMeshCount++;
+	}
 
-	auto CopyBufferData = [&model](const tinygltf::Accessor& accessor, const uint32_t dataSize, uint8_t* copyDest) -> size_t
+	// Node transforms, one copy per run of changed instances
+	size_t patchedInstanceCount = 0;
+	for (size_t i = 0; i < instances.size();)
 	{
-		size_t bytesCopied = 0;
-		const tinygltf::BufferView& bufferView = model.bufferViews[accessor.bufferView];
-		size_t dataStride = accessor.ByteStride(bufferView);
+		size_t end = i;
+		while (end < instances.size() && Matrix{ instances[end].m_localToWorld } != m_instanceTransforms[end])
+		{
+			m_instanceTransforms[end] = Matrix{ instances[end].m_localToWorld };
+			end++;
+		}
 
-		const uint8_t* pSrc = &model.buffers[bufferView.buffer].data[bufferView.byteOffset + accessor.byteOffset];
-		for (int i = 0; i < accessor.count; ++i)
+		if (end > i)
 		{
-			memcpy(copyDest + i * dataSize, pSrc + i * dataStride, dataSize);
-			bytesCopied += dataSize;
+			RenderBackend12::UpdateBindlessBuffer(cmdList, m_instanceTransformBuffer.get(), i * sizeof(Matrix), (const uint8_t*)&m_instanceTransforms[i], (end - i) * sizeof(Matrix));
+			patchedInstanceCount += end - i;
 		}
 
-		return bytesCopied;
-	};
+		i = end + 1;
+	}
 
-	auto CalcBounds = [&model](int positionAccessorIndex) -> DirectX::BoundingBox
+	// Material table, whole since it is small. Also picks up the indices of replaced textures.
+	std::vector<FMaterial> newMaterials = CreateMaterials(materials, textureIndices);
+	const bool materialsChanged = !newMaterials.empty() && memcmp(newMaterials.data(), m_materials.data(), newMaterials.size() * sizeof(FMaterial)) != 0;
+	if (materialsChanged)
 	{
-		const tinygltf::Accessor& accessor = model.accessors[positionAccessorIndex];
-		const tinygltf::BufferView& bufferView = model.bufferViews[accessor.bufferView];
-
-		size_t dataSize = tinygltf::GetComponentSizeInBytes(accessor.componentType) * tinygltf::GetNumComponentsInType(accessor.type);
-		size_t dataStride = accessor.ByteStride(bufferView);
-
-		const uint8_t* pData = &model.buffers[bufferView.buffer].data[bufferView.byteOffset + accessor.byteOffset];
-
-		DirectX::BoundingBox bb = {};
-		DirectX::BoundingBox::CreateFromPoints(bb, accessor.count, (DirectX::XMFLOAT3*)pData, dataStride);
-		return bb;
-	};
-
+		RenderBackend12::UpdateBindlessBuffer(cmdList, m_materialBuffer.get(), 0, (const uint8_t*)newMaterials.data(), newMaterials.size() * sizeof(FMaterial));
+		m_materials = std::move(newMaterials);
+	}
 
-	const tinygltf::Mesh& mesh = model.meshes[meshIndex];
+	RenderBackend12::ExecuteCommandlists(D3D12_COMMAND_LIST_TYPE_DIRECT, { cmdList });
 
-	// Each primitive is a separate render mesh with its own vertex and index buffers
-	for (const tinygltf::Primitive& primitive : mesh.primitives)
+	// LOD errors, dequantization and occluders are CPU side only
+	std::span<const DirectX::BoundingBox> bounds = cookedScene.GetSection<DirectX::BoundingBox>(CookedScene::Section::Bounds);
+	for (size_t i = 0; i < meshes.size(); ++i)
 	{
-		// Index data (converted to uint32_t)
-		const tinygltf::Accessor& indexAccessor = model.accessors[primitive.indices];
-
-		// FLOAT3 position data
-		auto posIt = primitive.attributes.find("POSITION");
-		DebugAssert(posIt != primitive.attributes.cend());
-		const tinygltf::Accessor& positionAccessor = model.accessors[posIt->second];
-		const size_t positionSize = tinygltf::GetComponentSizeInBytes(positionAccessor.componentType) * tinygltf::GetNumComponentsInType(positionAccessor.type);
-		DebugAssert(positionSize == 3 * sizeof(float));
-
-		// FLOAT3 normal data
-		auto normalIt = primitive.attributes.find("NORMAL");
-		DebugAssert(normalIt != primitive.attributes.cend());
-		const tinygltf::Accessor& normalAccessor = model.accessors[normalIt->second];
-		const size_t normalSize = tinygltf::GetComponentSizeInBytes(normalAccessor.componentType) * tinygltf::GetNumComponentsInType(normalAccessor.type);
-		DebugAssert(normalSize == 3 * sizeof(float));
-
-		// FLOAT2 UV data
-		auto uvIt = primitive.attributes.find("TEXCOORD_0");
-		DebugAssert(uvIt != primitive.attributes.cend());
-		const tinygltf::Accessor& uvAccessor = model.accessors[uvIt->second];
-		const size_t uvSize = tinygltf::GetComponentSizeInBytes(uvAccessor.componentType) * tinygltf::GetNumComponentsInType(uvAccessor.type);
-		DebugAssert(uvSize == 2 * sizeof(float));
-
-		tinygltf::Material material = model.materials[primitive.material];
+		if (meshes[i].m_geometryHash != m_meshGeo[i].m_geometryHash)
+		{
+			m_occluders[i] = CreateOccluder(cookedScene, meshes[i], bounds[i], cookedScene.GetHeader()->m_sceneBounds);
+		}
 
-		FRenderMesh newMesh = {};
-		newMesh.m_name = mesh.name;
-		newMesh.m_indexOffset = m_scratchIndexBufferOffset / sizeof(uint32_t);
-		newMesh.m_positionOffset = m_scratchPositionBufferOffset / positionSize;
-		newMesh.m_normalOffset = m_scratchNormalBufferOffset / normalSize;
-		newMesh.m_uvOffset = m_scratchUvBufferOffset / uvSize;
-		newMesh.m_indexCount = indexAccessor.count;
-		newMesh.m_materialName = material.name;
-		newMesh.m_emissiveFactor = Vector3{ (float)material.emissiveFactor[0], (float)material.emissiveFactor[1], (float)material.emissiveFactor[2] };
-		newMesh.m_baseColorFactor = Vector3{ (float)material.pbrMetallicRoughness.baseColorFactor[0], (float)material.pbrMetallicRoughness.baseColorFactor[1], (float)material.pbrMetallicRoughness.baseColorFactor[2] };
-		newMesh.m_metallicFactor = (float)material.pbrMetallicRoughness.metallicFactor;
-		newMesh.m_roughnessFactor = (float)material.pbrMetallicRoughness.roughnessFactor;
-		newMesh.m_baseColorTextureIndex = material.pbrMetallicRoughness.baseColorTexture.index != -1 ? LoadTexture(model.images[model.textures[material.pbrMetallicRoughness.baseColorTexture.index].source], true) : -1;
-		newMesh.m_metallicRoughnessTextureIndex = material.pbrMetallicRoughness.metallicRoughnessTexture.index != -1 ? LoadTexture(model.images[model.textures[material.pbrMetallicRoughness.metallicRoughnessTexture.index].source], false) : -1;
-		newMesh.m_normalTextureIndex = material.normalTexture.index != -1 ? LoadTexture(model.images[model.textures[material.normalTexture.index].source], false) : -1;
-		newMesh.m_baseColorSamplerIndex = material.pbrMetallicRoughness.baseColorTexture.index != -1 ? LoadSampler(model.samplers[model.textures[material.pbrMetallicRoughness.baseColorTexture.index].sampler]) : -1;
-		newMesh.m_metallicRoughnessSamplerIndex = material.pbrMetallicRoughness.metallicRoughnessTexture.index != -1 ? LoadSampler(model.samplers[model.textures[material.pbrMetallicRoughness.metallicRoughnessTexture.index].sampler]) : -1;
-		newMesh.m_normalSamplerIndex = material.normalTexture.index != -1 ? LoadSampler(model.samplers[model.textures[material.normalTexture.index].sampler]) : -1;
-		m_meshGeo.push_back(newMesh);
-		m_meshTransforms.push_back(parentTransform);
-
-		m_scratchIndexBufferOffset += CopyIndexData(indexAccessor, m_scratchIndexBuffer + m_scratchIndexBufferOffset);
-		m_scratchPositionBufferOffset += CopyBufferData(positionAccessor, positionSize, m_scratchPositionBuffer + m_scratchPositionBufferOffset);
-		m_scratchNormalBufferOffset += CopyBufferData(normalAccessor, normalSize, m_scratchNormalBuffer + m_scratchNormalBufferOffset);
-		m_scratchUvBufferOffset += CopyBufferData(uvAccessor, uvSize, m_scratchUvBuffer + m_scratchUvBufferOffset);
-
-		m_meshBounds.push_back(CalcBounds(posIt->second));
+		FRenderMesh newMesh = CreateRenderMesh(cookedScene, meshes[i]);
+		newMesh.m_instanceOffset = m_meshGeo[i].m_instanceOffset;
+		newMesh.m_instanceCount = m_meshGeo[i].m_instanceCount;
+		m_meshGeo[i] = newMesh;
 	}
-}
-
-int FScene::LoadTexture(const tinygltf::Image& image, const bool srgb)
-{
-	DebugAssert(!image.uri.empty(), "Embedded image data is not yet supported.");
-
-	DXGI_FORMAT srcFormat = DXGI_FORMAT_UNKNOWN;
-	DXGI_FORMAT compressedFormat = DXGI_FORMAT_UNKNOWN;
-	if (image.pixel_type == TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE && image.component == 4)
-	{
-		srcFormat = srgb ? DXGI_FORMAT_R8G8B8A8_UNORM_SRGB : DXGI_FORMAT_R8G8B8A8_UNORM;
-		compressedFormat = srgb ? DXGI_FORMAT_BC3_UNORM_SRGB : DXGI_FORMAT_BC3_UNORM;
-	}
-
-	// Source image
-	size_t bpp = (image.bits * image.component) / 8;
-	DirectX::Image srcImage = {};
-	srcImage.width = image.width;
-	srcImage.height = image.height;
-	srcImage.format = srcFormat;
-	srcImage.rowPitch = bpp * image.width;
-	srcImage.slicePitch = srcImage.rowPitch * image.height;
-	srcImage.pixels = (uint8_t*)image.image.data();
-
-	// Calculate mips upto 4x4 for block compression
-	int numMips = 0;
-	size_t width = image.width, height = image.height; 
-	while (width >= 4 && height >= 4)
-	{
-		numMips++;
-		width = width >> 1;
-		height = height >> 1;
-	}
-
-	// Generate mips
-	DirectX::ScratchImage mipchain = {};
-	AssertIfFailed(DirectX::GenerateMipMaps(srcImage, DirectX::TEX_FILTER_LINEAR, numMips, mipchain));
-
-	// Block compression
-	DirectX::ScratchImage compressedScratch;
-	AssertIfFailed(DirectX::Compress(mipchain.GetImages(), numMips, mipchain.GetMetadata(), compressedFormat, DirectX::TEX_COMPRESS_PARALLEL, DirectX::TEX_THRESHOLD_DEFAULT, compressedScratch));
-
-	std::wstring name{ image.uri.begin(), image.uri.end() };
-	FResourceUploadContext uploader{ compressedScratch.GetPixelsSize() };
-	uint32_t bindlessIndex = Demo::s_textureCache.CacheTexture2D(
-		&uploader,
-		name,
-		compressedFormat,
-		srcImage.width,
-		srcImage.height,
-		compressedScratch.GetImages(),
-		compressedScratch.GetImageCount());
 
-	FCommandList* cmdList = RenderBackend12::FetchCommandlist(D3D12_COMMAND_LIST_TYPE_DIRECT);
-	uploader.SubmitUploads(cmdList);
-	RenderBackend12::ExecuteCommandlists(D3D12_COMMAND_LIST_TYPE_DIRECT, { cmdList });
+	m_meshBounds.assign(bounds.begin(), bounds.end());
+	GetInstanceBounds(m_instanceBounds, m_meshBounds, m_instanceMeshIndices);
 
-	return bindlessIndex;
-}
+	std::span<const MeshOptimizer::FMeshletBounds> meshletBounds = cookedScene.GetSection<MeshOptimizer::FMeshletBounds>(CookedScene::Section::MeshletBounds);
+	m_meshletBounds.assign(meshletBounds.begin(), meshletBounds.end());
 
-int FScene::LoadSampler(const tinygltf::Sampler& sampler)
-{
-	return -1;
-}
+	m_sceneBounds = cookedScene.GetHeader()->m_sceneBounds;
 
-void FScene::LoadCamera(int cameraIndex, const tinygltf::Model& model, const Matrix& transform)
-{
-	FCamera newCamera = {};
-	newCamera.m_viewTransform = transform;
-	
-	if (model.cameras[cameraIndex].type == "perspective")
+	m_cameras.clear();
+	for (const CookedScene::FCamera& camera : cookedScene.GetSection<CookedScene::FCamera>(CookedScene::Section::Cameras))
 	{
-		std::stringstream s;
-		s << "perspective_cam_" << m_cameras.size();
-		newCamera.m_name = s.str();
-
-		const tinygltf::PerspectiveCamera& cam = model.cameras[cameraIndex].perspective;
-		newCamera.m_projectionTransform = GetReverseZInfinitePerspectiveFovLH(cam.yfov, cam.aspectRatio, cam.znear);
+		m_cameras.push_back(CreateCamera(cookedScene, camera));
 	}
-	else
-	{
-		std::stringstream s;
-		s << "ortho_cam_" << m_cameras.size();
-		newCamera.m_name = s.str();
 
-		const tinygltf::OrthographicCamera& cam = model.cameras[cameraIndex].orthographic;
-		newCamera.m_projectionTransform = Matrix::CreateOrthographic(cam.xmag, cam.ymag, cam.znear, cam.zfar);
-	}
+	std::stringstream report;
+	report << "Hot reloaded " << m_sceneFilename << ": " << patchedMeshCount << " meshes (" << patchedBytes / 1024 << " KB), "
+		<< patchedInstanceCount << " instances, " << staleTextures.size() << " textures" << (materialsChanged ? ", materials" : "") << "\n";
+	OutputDebugStringA(report.str().c_str());
 
-	m_cameras.push_back(newCamera);
+	return true;
 }
 
 void FScene::Clear()
 {
+	if (m_streamer)
+	{
+		m_streamer->m_cancelled = true;
+		m_streamer->m_job.wait();
+		m_streamer.reset();
+	}
+
 	m_cameras.clear();
 	m_meshGeo.clear();
-	m_meshTransforms.clear();
+	m_occluders.clear();
+	m_instanceTransforms.clear();
+	m_instanceMeshIndices.clear();
+	m_materials.clear();
 	m_meshBounds.clear();
+	m_instanceBounds.Clear();
+	m_instanceWorldBounds.Clear();
+	m_instanceBvh.Clear();
+	m_meshlets.clear();
+	m_meshletBounds.clear();
+	m_meshIndexBuffer.reset();
+	m_meshPositionBuffer.reset();
+	m_meshNormalBuffer.reset();
+	m_meshUvBuffer.reset();
+	m_instanceTransformBuffer.reset();
+	m_materialBuffer.reset();
+	m_meshletBuffer.reset();
+	m_meshletBoundsBuffer.reset();
+	m_meshletVertexBuffer.reset();
+	m_meshletTriangleBuffer.reset();
+	m_globalLightProbe = { -1, -1, -1 };
 }
 
 //-----------------------------------------------------------------------------------------------------------------------------------------------
@@ -806,6 +2334,292 @@ uint32_t FTextureCache::CacheTexture2D(
 	}
 }
 
+namespace
+{
+	BlockCompression::Format GetBlockCompressionFormat(const DXGI_FORMAT format)
+	{
+		switch (format)
+		{
+		case DXGI_FORMAT_BC1_UNORM:
+		case DXGI_FORMAT_BC1_UNORM_SRGB:
+			return BlockCompression::Format::BC1;
+		case DXGI_FORMAT_BC3_UNORM:
+		case DXGI_FORMAT_BC3_UNORM_SRGB:
+			return BlockCompression::Format::BC3;
+		case DXGI_FORMAT_BC4_UNORM:
+			return BlockCompression::Format::BC4;
+		case DXGI_FORMAT_BC5_UNORM:
+			return BlockCompression::Format::BC5;
+		case DXGI_FORMAT_BC7_UNORM:
+		case DXGI_FORMAT_BC7_UNORM_SRGB:
+			return BlockCompression::Format::BC7;
+		default:
+			DebugAssert(false, "Unsupported block compressed format");
+			return BlockCompression::Format::BC7;
+		}
+	}
+
+	// Normal and metallic roughness maps only need two channels, BC5 keeps them at the precision of BC4 each instead
+	// of spending half of a BC3 block on an unused alpha channel
+	DXGI_FORMAT GetTextureFormat(const CookedScene::TextureUsage usage)
+	{
+		switch (usage)
+		{
+		case CookedScene::TextureUsage::BaseColor:
+			return Settings::k_baseColorTextureFormat;
+		default:
+			return DXGI_FORMAT_BC5_UNORM;
+		}
+	}
+
+	// Fills the mips of a scratch image from its first one
+	void GenerateMips(DirectX::ScratchImage& mipchain, const MipChain::Format format)
+	{
+		std::vector<MipChain::FImage> mips(mipchain.GetMetadata().mipLevels);
+		for (size_t mip = 0; mip < mips.size(); ++mip)
+		{
+			const DirectX::Image* image = mipchain.GetImage(mip, 0, 0);
+			mips[mip] = MipChain::FImage{ image->pixels, (uint32_t)image->width, (uint32_t)image->height, image->rowPitch };
+		}
+
+		MipChain::Generate(mips.data(), (uint32_t)mips.size(), format, Settings::k_kaiserMipFilter ? MipChain::Filter::Kaiser : MipChain::Filter::Box);
+	}
+}
+
+// Block compressed mip chain built from an image file, in the format of the material slot it is sampled from. The result is
+// kept in a content addressed disk cache so that decoding, mip generation and compression only run when the source image or
+// the build settings change. CPU only and safe to call from multiple threads, the caller uploads the returned images
+// through CacheTexture2D or CacheStreamingTexture2D. Only the mips no larger than maxMipSize are returned when the others can
+// be read back from the disk cache later.
+bool FTextureCache::LoadCompressedTexture2D(
+	const std::filesystem::path& filepath,
+	const uint64_t byteOffset,
+	const uint64_t byteSize,
+	const CookedScene::TextureUsage usage,
+	FCompressedTexture& texture,
+	const uint32_t maxMipSize)
+{
+	const DXGI_FORMAT compressedFormat = GetTextureFormat(usage);
+
+	// Source bytes, the whole file unless the image is stored in a range of it
+	std::ifstream file{ filepath, std::ios::binary | std::ios::ate };
+	const uint64_t fileSize = file.good() ? (uint64_t)file.tellg() : 0;
+	const uint64_t srcSize = byteSize != 0 ? byteSize : fileSize - std::min(byteOffset, fileSize);
+	std::vector<uint8_t> srcBytes;
+	if (srcSize > 0 && byteOffset + srcSize <= fileSize)
+	{
+		srcBytes.resize(srcSize);
+		file.seekg(byteOffset);
+		file.read((char*)srcBytes.data(), srcBytes.size());
+	}
+
+	if (srcBytes.empty() || !file.good())
+	{
+		OutputDebugStringW((L"Failed to read texture " + filepath.wstring() + L"\n").c_str());
+		return false;
+	}
+
+	// Everything that affects the compressed output is part of the cache key. Bump the version when the build itself changes.
+	struct FBuildSettings
+	{
+		uint32_t m_version;
+		uint32_t m_format;
+		uint32_t m_usage;
+		uint32_t m_mipFilter;
+		uint32_t m_minMipSize;
+		uint32_t m_encoderVersion;
+	};
+
+	const FBuildSettings settings = { 4, (uint32_t)compressedFormat, (uint32_t)usage, (uint32_t)Settings::k_kaiserMipFilter, 4, BlockCompression::k_version };
+
+	uint64_t hash1{}, hash2{};
+	spookyhash_context context;
+	spookyhash_context_init(&context, hash1, hash2);
+	spookyhash_update(&context, srcBytes.data(), srcBytes.size());
+	spookyhash_update(&context, &settings, sizeof(settings));
+	spookyhash_final(&context, &hash1, &hash2);
+
+	std::wstringstream cachedFilename;
+	cachedFilename << std::hex << std::setfill(L'0') << std::setw(16) << hash1 << std::setw(16) << hash2 << L".dds";
+	const std::filesystem::path cachedFilepath = std::filesystem::path{ CACHE_DIR } / L"textures" / cachedFilename.str();
+
+	auto GetFirstMip = [maxMipSize](const DirectX::TexMetadata& metadata)
+	{
+		uint32_t firstMip = 0;
+		while (firstMip + 1 < metadata.mipLevels && std::max(metadata.width, metadata.height) >> firstMip > maxMipSize)
+		{
+			firstMip++;
+		}
+
+		return firstMip;
+	};
+
+	const bool cacheHit = SUCCEEDED(DirectX::GetMetadataFromDDSFile(cachedFilepath.c_str(), DirectX::DDS_FLAGS_NONE, texture.m_metadata)) &&
+		texture.m_metadata.format == compressedFormat;
+
+	if (cacheHit)
+	{
+		texture.m_firstMip = GetFirstMip(texture.m_metadata);
+		texture.m_mips = LoadCompressedMips(cachedFilepath, texture.m_metadata, texture.m_firstMip, (uint32_t)texture.m_metadata.mipLevels - texture.m_firstMip);
+		texture.m_cachedFilepath = cachedFilepath;
+	}
+	else
+	{
+		int width, height, channels;
+		uint8_t* pixels = stbi_load_from_memory(srcBytes.data(), (int)srcBytes.size(), &width, &height, &channels, 4);
+		if (!pixels)
+		{
+			OutputDebugStringW((L"Failed to decode texture " + filepath.wstring() + L"\n").c_str());
+			return false;
+		}
+
+		// glTF stores metalness in blue and roughness in green, move them to the two channels BC5 keeps
+		if (usage == CookedScene::TextureUsage::MetallicRoughness)
+		{
+			for (size_t i = 0; i < size_t(width) * height; ++i)
+			{
+				pixels[4 * i] = pixels[4 * i + 2];
+			}
+		}
+
+		// Calculate mips upto 4x4 for block compression
+		int numMips = 0;
+		size_t mipWidth = width, mipHeight = height;
+		while (mipWidth >= settings.m_minMipSize && mipHeight >= settings.m_minMipSize)
+		{
+			numMips++;
+			mipWidth = mipWidth >> 1;
+			mipHeight = mipHeight >> 1;
+		}
+
+		// Generate mips, sRGB color is filtered in linear space
+		constexpr size_t bpp = 4;
+		const bool srgb = DirectX::IsSRGB(compressedFormat);
+		DirectX::ScratchImage mipchain = {};
+		AssertIfFailed(mipchain.Initialize2D(srgb ? DXGI_FORMAT_R8G8B8A8_UNORM_SRGB : DXGI_FORMAT_R8G8B8A8_UNORM, width, height, 1, numMips));
+		const DirectX::Image* srcImage = mipchain.GetImage(0, 0, 0);
+		for (int y = 0; y < height; ++y)
+		{
+			memcpy(srcImage->pixels + y * srcImage->rowPitch, pixels + y * bpp * width, bpp * width);
+		}
+
+		stbi_image_free(pixels);
+		GenerateMips(mipchain, srgb ? MipChain::Format::RGBA8Srgb : MipChain::Format::RGBA8);
+
+		// Block compression, sRGB formats store the same bits as their linear counterpart
+		DirectX::ScratchImage compressedScratch;
+		AssertIfFailed(compressedScratch.Initialize2D(compressedFormat, width, height, 1, numMips));
+		for (int mip = 0; mip < numMips; ++mip)
+		{
+			const DirectX::Image* src = mipchain.GetImage(mip, 0, 0);
+			const DirectX::Image* dest = compressedScratch.GetImage(mip, 0, 0);
+			BlockCompression::Compress(GetBlockCompressionFormat(compressedFormat), src->pixels, (uint32_t)src->width, (uint32_t)src->height, src->rowPitch, dest->pixels, dest->rowPitch);
+		}
+
+		texture.m_metadata = compressedScratch.GetMetadata();
+
+		// Persist for the next run. Written to a temporary file first so that a partial write is never picked up.
+		std::error_code ec;
+		std::filesystem::create_directories(cachedFilepath.parent_path(), ec);
+
+		std::filesystem::path tempFilepath = cachedFilepath;
+		tempFilepath += L".tmp";
+		if (SUCCEEDED(DirectX::SaveToDDSFile(compressedScratch.GetImages(), compressedScratch.GetImageCount(), texture.m_metadata, DirectX::DDS_FLAGS_NONE, tempFilepath.c_str())))
+		{
+			std::filesystem::rename(tempFilepath, cachedFilepath, ec);
+			texture.m_cachedFilepath = ec ? std::filesystem::path{} : cachedFilepath;
+		}
+
+		// The detailed mips can only be dropped if they can be read back
+		texture.m_firstMip = texture.m_cachedFilepath.empty() ? 0 : GetFirstMip(texture.m_metadata);
+		if (texture.m_firstMip > 0)
+		{
+			const DirectX::Image* firstImage = compressedScratch.GetImage(texture.m_firstMip, 0, 0);
+			AssertIfFailed(texture.m_mips.Initialize2D(compressedFormat, firstImage->width, firstImage->height, 1, texture.m_metadata.mipLevels - texture.m_firstMip));
+			memcpy(texture.m_mips.GetPixels(), firstImage->pixels, texture.m_mips.GetPixelsSize());
+		}
+		else
+		{
+			texture.m_mips = std::move(compressedScratch);
+		}
+	}
+
+	return true;
+}
+
+// Mips are stored contiguously after the DDS header, as in a ScratchImage, so a range of them is read in one go
+DirectX::ScratchImage FTextureCache::LoadCompressedMips(
+	const std::filesystem::path& filepath,
+	const DirectX::TexMetadata& metadata,
+	const uint32_t firstMip,
+	const uint32_t mipCount)
+{
+	std::ifstream file{ filepath, std::ios::binary };
+	DebugAssert(file.good(), "Failed to open cached texture");
+
+	// Magic and DDS_HEADER, followed by a DDS_HEADER_DXT10 when the pixel format's FourCC says so
+	uint8_t header[128] = {};
+	file.read((char*)header, sizeof(header));
+	size_t offset = sizeof(header) + (memcmp(header + 84, "DX10", 4) == 0 ? 20 : 0);
+	for (uint32_t mip = 0; mip < firstMip; ++mip)
+	{
+		size_t rowPitch, slicePitch;
+		AssertIfFailed(DirectX::ComputePitch(metadata.format, std::max<size_t>(metadata.width >> mip, 1), std::max<size_t>(metadata.height >> mip, 1), rowPitch, slicePitch));
+		offset += slicePitch;
+	}
+
+	DirectX::ScratchImage mips;
+	AssertIfFailed(mips.Initialize2D(metadata.format, std::max<size_t>(metadata.width >> firstMip, 1), std::max<size_t>(metadata.height >> firstMip, 1), 1, mipCount));
+	file.seekg(offset);
+	file.read((char*)mips.GetPixels(), mips.GetPixelsSize());
+	DebugAssert(file.good(), "Truncated cached texture");
+
+	return mips;
+}
+
+// Reserved texture with the loaded mips committed. The standard mips above them are left without memory until they stream in.
+uint32_t FTextureCache::CacheStreamingTexture2D(
+	FResourceUploadContext* uploadContext,
+	const std::wstring& name,
+	const FCompressedTexture& texture)
+{
+	const DirectX::TexMetadata& metadata = texture.m_metadata;
+	if (m_cachedTextures.count(name) != 0 || texture.m_firstMip == 0 || !RenderBackend12::SupportsReservedTextures())
+	{
+		DebugAssert(texture.m_firstMip == 0 || m_cachedTextures.count(name) != 0, "Texture mips are missing");
+		return CacheTexture2D(uploadContext, name, metadata.format, (int)metadata.width, (int)metadata.height, texture.m_mips.GetImages(), texture.m_mips.GetImageCount());
+	}
+
+	std::unique_ptr<FBindlessShaderResource> newTexture = RenderBackend12::CreateBindlessReservedTexture(name, metadata.format, metadata.width, metadata.height, metadata.mipLevels);
+	RenderBackend12::CommitTextureMips(newTexture.get(), texture.m_firstMip);
+
+	std::vector<D3D12_SUBRESOURCE_DATA> srcData(texture.m_mips.GetImageCount());
+	for (size_t i = 0; i < srcData.size(); ++i)
+	{
+		const DirectX::Image& image = texture.m_mips.GetImages()[i];
+		srcData[i] = { image.pixels, (LONG_PTR)image.rowPitch, (LONG_PTR)image.slicePitch };
+	}
+
+	// Mips that are not resident stay in the copy destination state so that they can be streamed in while the others are sampled
+	uploadContext->UpdateSubresources(
+		newTexture->m_resource->m_d3dResource,
+		srcData,
+		[resource = newTexture->m_resource, firstMip = texture.m_firstMip, mipCount = (uint32_t)metadata.mipLevels](FCommandList* cmdList)
+		{
+			for (uint32_t mip = firstMip; mip < mipCount; ++mip)
+			{
+				resource->Transition(cmdList, mip, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE | D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+			}
+		},
+		texture.m_firstMip);
+
+	RenderBackend12::SetTextureMostDetailedMip(newTexture.get(), texture.m_firstMip, nullptr);
+
+	m_streamingTextures[name] = FStreamingTexture{ metadata, texture.m_cachedFilepath, texture.m_firstMip, texture.m_firstMip };
+	m_cachedTextures[name] = std::move(newTexture);
+	return RenderBackend12::GetDescriptorTableOffset(BindlessDescriptorType::Texture2D, m_cachedTextures[name]->m_srvIndex);
+}
+
 FLightProbe FTextureCache::CacheHdrTexture(const std::wstring& name)
 {
 	const std::wstring envmapTextureName = name + L".envmap";
@@ -841,8 +2655,17 @@ FLightProbe FTextureCache::CacheHdrTexture(const std::wstring& name)
 		}
 
 		// Generate mips
+		DebugAssert(metadata.format == DXGI_FORMAT_R32G32B32A32_FLOAT, "Unexpected HDR format");
 		DirectX::ScratchImage mipchain = {};
-		AssertIfFailed(DirectX::GenerateMipMaps(*scratch.GetImage(0,0,0), DirectX::TEX_FILTER_LINEAR, numMips, mipchain));
+		AssertIfFailed(mipchain.Initialize2D(metadata.format, metadata.width, metadata.height, 1, numMips));
+		const DirectX::Image* srcImage = scratch.GetImage(0, 0, 0);
+		const DirectX::Image* destImage = mipchain.GetImage(0, 0, 0);
+		for (size_t y = 0; y < metadata.height; ++y)
+		{
+			memcpy(destImage->pixels + y * destImage->rowPitch, srcImage->pixels + y * srcImage->rowPitch, destImage->rowPitch);
+		}
+
+		GenerateMips(mipchain, MipChain::Format::RGBA32Float);
 
 		// Create the equirectangular source texture
 		FResourceUploadContext uploadContext{ mipchain.GetPixelsSize() };
@@ -1116,9 +2939,23 @@ FLightProbe FTextureCache::CacheHdrTexture(const std::wstring& name)
 	}
 }
 
+void FTextureCache::Evict(const std::wstring& name, const FCommandList* dependentCL)
+{
+	auto search = m_cachedTextures.find(name);
+	if (search != m_cachedTextures.end())
+	{
+		RenderBackend12::DeferredRelease(std::move(search->second), dependentCL);
+		m_cachedTextures.unsafe_erase(name);
+	}
+
+	// Mips still being read are dropped when they complete
+	m_streamingTextures.erase(name);
+}
+
 void FTextureCache::Clear()
 {
 	m_cachedTextures.clear();
+	m_streamingTextures.clear();
 }
 
 //-----------------------------------------------------------------------------------------------------------------------------------------------
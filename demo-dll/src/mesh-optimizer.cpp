@@ -0,0 +1,1046 @@
+#include <mesh-optimizer.h>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <chrono>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace
+{
+	// FIFO cache simulation. A vertex is resident if it was one of the last cacheSize vertices to be transformed.
+	struct FFifoCache
+	{
+		FFifoCache(const size_t vertexCount, const uint32_t cacheSize) :
+			m_timestamps(vertexCount, -(int64_t)cacheSize - 1),
+			m_cacheSize{ cacheSize }
+		{
+		}
+
+		// Returns true on a cache miss
+		bool Access(const uint32_t vertex)
+		{
+			if (m_time - m_timestamps[vertex] > m_cacheSize)
+			{
+				m_timestamps[vertex] = m_time++;
+				return true;
+			}
+
+			return false;
+		}
+
+		void Reset()
+		{
+			m_time += m_cacheSize + 1;
+		}
+
+		std::vector<int64_t> m_timestamps;
+		int64_t m_time = 0;
+		uint32_t m_cacheSize;
+	};
+
+	// Vertex to triangle adjacency in compressed row form
+	struct FTriangleAdjacency
+	{
+		FTriangleAdjacency(const uint32_t* indices, const size_t indexCount, const size_t vertexCount) :
+			m_offsets(vertexCount + 1, 0),
+			m_triangles(indexCount)
+		{
+			for (size_t i = 0; i < indexCount; ++i)
+			{
+				m_offsets[indices[i] + 1]++;
+			}
+
+			std::partial_sum(m_offsets.begin(), m_offsets.end(), m_offsets.begin());
+
+			std::vector<uint32_t> cursor(m_offsets.begin(), m_offsets.end() - 1);
+			for (size_t i = 0; i < indexCount; ++i)
+			{
+				m_triangles[cursor[indices[i]]++] = (uint32_t)(i / 3);
+			}
+		}
+
+		uint32_t Degree(const uint32_t vertex) const
+		{
+			return m_offsets[vertex + 1] - m_offsets[vertex];
+		}
+
+		std::vector<uint32_t> m_offsets;
+		std::vector<uint32_t> m_triangles;
+	};
+
+	struct FFloat3
+	{
+		float x, y, z;
+
+		FFloat3 operator+(const FFloat3& o) const { return { x + o.x, y + o.y, z + o.z }; }
+		FFloat3 operator-(const FFloat3& o) const { return { x - o.x, y - o.y, z - o.z }; }
+		FFloat3 operator*(const float s) const { return { x * s, y * s, z * s }; }
+		bool operator==(const FFloat3& o) const { return x == o.x && y == o.y && z == o.z; }
+		float Dot(const FFloat3& o) const { return x * o.x + y * o.y + z * o.z; }
+		FFloat3 Cross(const FFloat3& o) const { return { y * o.z - z * o.y, z * o.x - x * o.z, x * o.y - y * o.x }; }
+		float Length() const { return std::sqrt(Dot(*this)); }
+	};
+
+	// Sum of weighted squared distances to a set of planes, stored as the upper half of a symmetric 4x4 matrix
+	struct FQuadric
+	{
+		float a00, a11, a22, a10, a20, a21;
+		float b0, b1, b2;
+		float c;
+		float w;
+
+		static FQuadric FromPlane(const FFloat3& n, const float d, const float weight)
+		{
+			FQuadric q;
+			q.a00 = weight * n.x * n.x;
+			q.a11 = weight * n.y * n.y;
+			q.a22 = weight * n.z * n.z;
+			q.a10 = weight * n.y * n.x;
+			q.a20 = weight * n.z * n.x;
+			q.a21 = weight * n.z * n.y;
+			q.b0 = weight * n.x * d;
+			q.b1 = weight * n.y * d;
+			q.b2 = weight * n.z * d;
+			q.c = weight * d * d;
+			q.w = weight;
+			return q;
+		}
+
+		void operator+=(const FQuadric& o)
+		{
+			a00 += o.a00; a11 += o.a11; a22 += o.a22;
+			a10 += o.a10; a20 += o.a20; a21 += o.a21;
+			b0 += o.b0; b1 += o.b1; b2 += o.b2;
+			c += o.c;
+			w += o.w;
+		}
+
+		// Mean squared distance of p to the planes
+		float Error(const FFloat3& p) const
+		{
+			const float rx = a00 * p.x + a10 * p.y + a20 * p.z + 2.f * b0;
+			const float ry = a10 * p.x + a11 * p.y + a21 * p.z + 2.f * b1;
+			const float rz = a20 * p.x + a21 * p.y + a22 * p.z + 2.f * b2;
+			const float error = rx * p.x + ry * p.y + rz * p.z + c;
+			return w > 0.f ? std::abs(error) / w : 0.f;
+		}
+	};
+}
+
+MeshOptimizer::FVertexCacheStats MeshOptimizer::AnalyzeVertexCache(const uint32_t* indices, const size_t indexCount, const size_t vertexCount, const uint32_t cacheSize)
+{
+	FFifoCache cache{ vertexCount, cacheSize };
+	std::vector<bool> referenced(vertexCount, false);
+	size_t misses = 0, referencedCount = 0;
+
+	for (size_t i = 0; i < indexCount; ++i)
+	{
+		misses += cache.Access(indices[i]) ? 1 : 0;
+
+		if (!referenced[indices[i]])
+		{
+			referenced[indices[i]] = true;
+			referencedCount++;
+		}
+	}
+
+	FVertexCacheStats stats = {};
+	stats.m_acmr = indexCount ? misses / (indexCount / 3.f) : 0.f;
+	stats.m_atvr = referencedCount ? misses / (float)referencedCount : 0.f;
+	return stats;
+}
+
+void MeshOptimizer::OptimizeVertexCache(
+	uint32_t* destIndices,
+	const uint32_t* indices,
+	const size_t indexCount,
+	const size_t vertexCount,
+	const uint32_t cacheSize,
+	std::vector<uint32_t>* clusters)
+{
+	const FTriangleAdjacency adjacency{ indices, indexCount, vertexCount };
+
+	std::vector<uint32_t> liveTriangles(vertexCount);
+	for (uint32_t v = 0; v < vertexCount; ++v)
+	{
+		liveTriangles[v] = adjacency.Degree(v);
+	}
+
+	std::vector<int64_t> cacheTimestamps(vertexCount, 0);
+	std::vector<bool> emitted(indexCount / 3, false);
+	std::vector<uint32_t> deadEnds;
+	std::vector<uint32_t> candidates;
+
+	int64_t time = cacheSize + 1;
+	size_t outputCount = 0;
+	uint32_t cursor = 0;
+
+	// Next vertex with live triangles, from the dead end stack first and then in input order
+	auto SkipDeadEnd = [&]() -> int64_t
+	{
+		while (!deadEnds.empty())
+		{
+			const uint32_t v = deadEnds.back();
+			deadEnds.pop_back();
+
+			if (liveTriangles[v] > 0)
+			{
+				return v;
+			}
+		}
+
+		for (; cursor < vertexCount; ++cursor)
+		{
+			if (liveTriangles[cursor] > 0)
+			{
+				return cursor;
+			}
+		}
+
+		return -1;
+	};
+
+	if (clusters)
+	{
+		clusters->clear();
+	}
+
+	int64_t fanningVertex = SkipDeadEnd();
+	bool hardBoundary = true;
+
+	while (fanningVertex >= 0)
+	{
+		if (clusters && hardBoundary)
+		{
+			clusters->push_back((uint32_t)outputCount);
+		}
+
+		// Emit all live triangles around the fanning vertex
+		candidates.clear();
+		const uint32_t f = (uint32_t)fanningVertex;
+		for (uint32_t i = adjacency.m_offsets[f]; i < adjacency.m_offsets[f + 1]; ++i)
+		{
+			const uint32_t t = adjacency.m_triangles[i];
+			if (emitted[t])
+			{
+				continue;
+			}
+
+			for (uint32_t k = 0; k < 3; ++k)
+			{
+				const uint32_t v = indices[3 * t + k];
+				destIndices[outputCount++] = v;
+				deadEnds.push_back(v);
+				candidates.push_back(v);
+				liveTriangles[v]--;
+
+				if (time - cacheTimestamps[v] > cacheSize)
+				{
+					cacheTimestamps[v] = time++;
+				}
+			}
+
+			emitted[t] = true;
+		}
+
+		// Prefer the candidate that has been in the cache the longest and that will still be in the cache once its
+		// remaining triangles have been emitted
+		int64_t best = -1;
+		int64_t bestPriority = -1;
+		for (const uint32_t v : candidates)
+		{
+			if (liveTriangles[v] > 0)
+			{
+				int64_t priority = 0;
+				if (time - cacheTimestamps[v] + 2 * liveTriangles[v] <= cacheSize)
+				{
+					priority = time - cacheTimestamps[v];
+				}
+
+				if (priority > bestPriority)
+				{
+					bestPriority = priority;
+					best = v;
+				}
+			}
+		}
+
+		hardBoundary = best < 0;
+		fanningVertex = hardBoundary ? SkipDeadEnd() : best;
+	}
+}
+
+void MeshOptimizer::OptimizeOverdraw(
+	uint32_t* destIndices,
+	const uint32_t* indices,
+	const size_t indexCount,
+	const float* positions,
+	const size_t positionStride,
+	const size_t vertexCount,
+	const std::vector<uint32_t>& clusters,
+	const float threshold,
+	const uint32_t cacheSize)
+{
+	auto GetPosition = [positions, positionStride](const uint32_t v) -> FFloat3
+	{
+		const float* p = (const float*)((const uint8_t*)positions + v * positionStride);
+		return { p[0], p[1], p[2] };
+	};
+
+	// Split clusters at soft boundaries, wherever the cluster so far reuses vertices about as well as the whole mesh
+	const float meshAcmr = AnalyzeVertexCache(indices, indexCount, vertexCount, cacheSize).m_acmr;
+	std::vector<uint32_t> splitClusters;
+	FFifoCache cache{ vertexCount, cacheSize };
+
+	for (size_t c = 0; c < clusters.size(); ++c)
+	{
+		const size_t begin = clusters[c];
+		const size_t end = c + 1 < clusters.size() ? clusters[c + 1] : indexCount;
+
+		size_t clusterBegin = begin;
+		size_t misses = 0;
+		cache.Reset();
+		splitClusters.push_back((uint32_t)begin);
+
+		for (size_t i = begin; i < end; i += 3)
+		{
+			misses += cache.Access(indices[i + 0]) ? 1 : 0;
+			misses += cache.Access(indices[i + 1]) ? 1 : 0;
+			misses += cache.Access(indices[i + 2]) ? 1 : 0;
+
+			const size_t triangleCount = (i + 3 - clusterBegin) / 3;
+			if (i + 3 < end && misses <= threshold * meshAcmr * triangleCount)
+			{
+				clusterBegin = i + 3;
+				misses = 0;
+				cache.Reset();
+				splitClusters.push_back((uint32_t)clusterBegin);
+			}
+		}
+	}
+
+	// Area weighted centroid and normal of every cluster
+	struct FCluster
+	{
+		uint32_t m_begin;
+		uint32_t m_end;
+		FFloat3 m_centroid;
+		FFloat3 m_normal;
+		float m_area;
+		float m_sortKey;
+	};
+
+	std::vector<FCluster> clusterData(splitClusters.size());
+	FFloat3 meshCentroid = {};
+	float meshArea = 0.f;
+
+	for (size_t c = 0; c < splitClusters.size(); ++c)
+	{
+		FCluster& cluster = clusterData[c];
+		cluster = {};
+		cluster.m_begin = splitClusters[c];
+		cluster.m_end = c + 1 < splitClusters.size() ? splitClusters[c + 1] : (uint32_t)indexCount;
+
+		for (uint32_t i = cluster.m_begin; i < cluster.m_end; i += 3)
+		{
+			const FFloat3 p0 = GetPosition(indices[i + 0]);
+			const FFloat3 p1 = GetPosition(indices[i + 1]);
+			const FFloat3 p2 = GetPosition(indices[i + 2]);
+			const FFloat3 n = (p1 - p0).Cross(p2 - p0);
+			const float area = 0.5f * std::sqrt(n.Dot(n));
+
+			cluster.m_centroid = cluster.m_centroid + (p0 + p1 + p2) * (area / 3.f);
+			cluster.m_normal = cluster.m_normal + n;
+			cluster.m_area += area;
+		}
+
+		meshCentroid = meshCentroid + cluster.m_centroid;
+		meshArea += cluster.m_area;
+
+		if (cluster.m_area > 0.f)
+		{
+			cluster.m_centroid = cluster.m_centroid * (1.f / cluster.m_area);
+		}
+	}
+
+	if (meshArea > 0.f)
+	{
+		meshCentroid = meshCentroid * (1.f / meshArea);
+	}
+
+	// Clusters facing away from the mesh center are the most likely to occlude the others, draw them first
+	for (FCluster& cluster : clusterData)
+	{
+		const float normalLength = std::sqrt(cluster.m_normal.Dot(cluster.m_normal));
+		cluster.m_sortKey = normalLength > 0.f ? (cluster.m_centroid - meshCentroid).Dot(cluster.m_normal) / normalLength : 0.f;
+	}
+
+	std::stable_sort(clusterData.begin(), clusterData.end(), [](const FCluster& a, const FCluster& b)
+	{
+		return a.m_sortKey > b.m_sortKey;
+	});
+
+	size_t outputCount = 0;
+	for (const FCluster& cluster : clusterData)
+	{
+		std::copy(indices + cluster.m_begin, indices + cluster.m_end, destIndices + outputCount);
+		outputCount += cluster.m_end - cluster.m_begin;
+	}
+}
+
+void MeshOptimizer::OptimizeVertexFetch(std::vector<uint32_t>& remap, uint32_t* indices, const size_t indexCount, const size_t vertexCount)
+{
+	remap.assign(vertexCount, ~0u);
+	uint32_t nextVertex = 0;
+
+	for (size_t i = 0; i < indexCount; ++i)
+	{
+		uint32_t& newIndex = remap[indices[i]];
+		if (newIndex == ~0u)
+		{
+			newIndex = nextVertex++;
+		}
+
+		indices[i] = newIndex;
+	}
+
+	for (uint32_t& newIndex : remap)
+	{
+		if (newIndex == ~0u)
+		{
+			newIndex = nextVertex++;
+		}
+	}
+}
+
+void MeshOptimizer::BuildMeshlets(
+	std::vector<FMeshlet>& meshlets,
+	std::vector<uint32_t>& meshletVertices,
+	std::vector<uint32_t>& meshletTriangles,
+	const uint32_t* indices,
+	const size_t indexCount,
+	const size_t vertexCount,
+	const uint32_t maxVertices,
+	const uint32_t maxTriangles)
+{
+	meshlets.clear();
+	meshletVertices.clear();
+	meshletTriangles.clear();
+
+	// Local index of every mesh vertex in the meshlet being built, ~0 if it is not part of it
+	std::vector<uint32_t> localIndex(vertexCount, ~0u);
+	FMeshlet meshlet = {};
+
+	auto Flush = [&]()
+	{
+		for (uint32_t i = 0; i < meshlet.m_vertexCount; ++i)
+		{
+			localIndex[meshletVertices[meshlet.m_vertexOffset + i]] = ~0u;
+		}
+
+		meshlets.push_back(meshlet);
+		meshlet = {};
+		meshlet.m_vertexOffset = (uint32_t)meshletVertices.size();
+		meshlet.m_triangleOffset = (uint32_t)meshletTriangles.size();
+	};
+
+	auto AddVertex = [&](const uint32_t v) -> uint32_t
+	{
+		if (localIndex[v] == ~0u)
+		{
+			localIndex[v] = meshlet.m_vertexCount++;
+			meshletVertices.push_back(v);
+		}
+
+		return localIndex[v];
+	};
+
+	for (size_t i = 0; i < indexCount; i += 3)
+	{
+		const uint32_t a = indices[i + 0], b = indices[i + 1], c = indices[i + 2];
+		const uint32_t newVertices =
+			(localIndex[a] == ~0u ? 1 : 0) +
+			(localIndex[b] == ~0u && b != a ? 1 : 0) +
+			(localIndex[c] == ~0u && c != a && c != b ? 1 : 0);
+
+		if (meshlet.m_vertexCount + newVertices > maxVertices || meshlet.m_triangleCount == maxTriangles)
+		{
+			Flush();
+		}
+
+		const uint32_t la = AddVertex(a);
+		const uint32_t lb = AddVertex(b);
+		const uint32_t lc = AddVertex(c);
+		meshletTriangles.push_back(la | (lb << 8) | (lc << 16));
+		meshlet.m_triangleCount++;
+	}
+
+	if (meshlet.m_triangleCount > 0)
+	{
+		Flush();
+	}
+}
+
+MeshOptimizer::FMeshletBounds MeshOptimizer::ComputeMeshletBounds(
+	const FMeshlet& meshlet,
+	const uint32_t* meshletVertices,
+	const uint32_t* meshletTriangles,
+	const float* positions,
+	const size_t positionStride)
+{
+	auto GetPosition = [&](const uint32_t localVertex) -> FFloat3
+	{
+		const float* p = (const float*)((const uint8_t*)positions + meshletVertices[meshlet.m_vertexOffset + localVertex] * positionStride);
+		return { p[0], p[1], p[2] };
+	};
+
+	FMeshletBounds bounds = {};
+
+	// Ritter's bounding sphere: start from the two most distant extremes found from an arbitrary vertex, then grow to fit
+	// any vertex left outside
+	auto Farthest = [&](const FFloat3& from) -> FFloat3
+	{
+		FFloat3 result = from;
+		float maxDistance = -1.f;
+		for (uint32_t i = 0; i < meshlet.m_vertexCount; ++i)
+		{
+			const float distance = (GetPosition(i) - from).Length();
+			if (distance > maxDistance)
+			{
+				maxDistance = distance;
+				result = GetPosition(i);
+			}
+		}
+
+		return result;
+	};
+
+	const FFloat3 p0 = Farthest(GetPosition(0));
+	const FFloat3 p1 = Farthest(p0);
+	FFloat3 center = (p0 + p1) * 0.5f;
+	float radius = (p1 - p0).Length() * 0.5f;
+
+	for (uint32_t i = 0; i < meshlet.m_vertexCount; ++i)
+	{
+		const FFloat3 p = GetPosition(i);
+		const float distance = (p - center).Length();
+		if (distance > radius)
+		{
+			const float newRadius = 0.5f * (radius + distance);
+			center = center + (p - center) * ((newRadius - radius) / distance);
+			radius = newRadius;
+		}
+	}
+
+	bounds.m_center[0] = center.x;
+	bounds.m_center[1] = center.y;
+	bounds.m_center[2] = center.z;
+	bounds.m_radius = radius;
+
+	// Normal cone around the average triangle normal. Degenerate triangles are ignored.
+	std::vector<FFloat3> normals;
+	std::vector<FFloat3> corners;
+	normals.reserve(meshlet.m_triangleCount);
+	corners.reserve(meshlet.m_triangleCount);
+	FFloat3 axis = {};
+
+	for (uint32_t t = 0; t < meshlet.m_triangleCount; ++t)
+	{
+		const uint32_t packed = meshletTriangles[meshlet.m_triangleOffset + t];
+		const FFloat3 a = GetPosition(packed & 0xff);
+		const FFloat3 b = GetPosition((packed >> 8) & 0xff);
+		const FFloat3 c = GetPosition((packed >> 16) & 0xff);
+		const FFloat3 n = (b - a).Cross(c - a);
+		const float length = n.Length();
+		if (length > 0.f)
+		{
+			normals.push_back(n * (1.f / length));
+			corners.push_back(a);
+			axis = axis + normals.back();
+		}
+	}
+
+	const float axisLength = axis.Length();
+	float minDot = 1.f;
+	if (axisLength > 0.f)
+	{
+		axis = axis * (1.f / axisLength);
+		for (const FFloat3& n : normals)
+		{
+			minDot = std::min(minDot, n.Dot(axis));
+		}
+	}
+
+	bounds.m_coneAxis[0] = axis.x;
+	bounds.m_coneAxis[1] = axis.y;
+	bounds.m_coneAxis[2] = axis.z;
+
+	// A cone wider than a hemisphere, or no usable normal at all, can never be culled
+	if (axisLength == 0.f || minDot <= 0.f)
+	{
+		bounds.m_coneApex[0] = center.x;
+		bounds.m_coneApex[1] = center.y;
+		bounds.m_coneApex[2] = center.z;
+		bounds.m_coneCutoff = 1.f;
+		return bounds;
+	}
+
+	// Move the apex back along the axis until it lies behind the plane of every triangle
+	float maxT = 0.f;
+	for (size_t i = 0; i < normals.size(); ++i)
+	{
+		const float t = (center - corners[i]).Dot(normals[i]) / normals[i].Dot(axis);
+		maxT = std::max(maxT, t);
+	}
+
+	const FFloat3 apex = center - axis * maxT;
+	bounds.m_coneApex[0] = apex.x;
+	bounds.m_coneApex[1] = apex.y;
+	bounds.m_coneApex[2] = apex.z;
+	bounds.m_coneCutoff = std::sqrt(1.f - minDot * minDot);
+	return bounds;
+}
+
+size_t MeshOptimizer::Simplify(
+	uint32_t* destIndices,
+	const uint32_t* indices,
+	const size_t indexCount,
+	const float* positions,
+	const size_t positionStride,
+	const size_t vertexCount,
+	const size_t targetIndexCount,
+	const float targetError,
+	float* resultError)
+{
+	enum class VertexKind : uint8_t
+	{
+		Manifold,
+		Border,
+		Locked
+	};
+
+	// -0 becomes +0 so that positions comparing equal also hash the same
+	auto Canonicalize = [](const float x)
+	{
+		return x == 0.f ? 0.f : x;
+	};
+
+	std::vector<FFloat3> vertexPositions(vertexCount);
+	for (size_t v = 0; v < vertexCount; ++v)
+	{
+		const float* p = (const float*)((const uint8_t*)positions + v * positionStride);
+		vertexPositions[v] = { Canonicalize(p[0]), Canonicalize(p[1]), Canonicalize(p[2]) };
+	}
+
+	// Vertices split along attribute seams share a position. Topology is evaluated on these welded positions.
+	struct FPositionHash
+	{
+		size_t operator()(const FFloat3& p) const
+		{
+			const uint32_t* bits = (const uint32_t*)&p;
+			return (bits[0] * 73856093u) ^ (bits[1] * 19349663u) ^ (bits[2] * 83492791u);
+		}
+	};
+
+	struct FPositionEqual
+	{
+		bool operator()(const FFloat3& a, const FFloat3& b) const
+		{
+			return a == b;
+		}
+	};
+
+	std::vector<uint32_t> weld(vertexCount);
+	std::vector<uint32_t> wedgeCount(vertexCount, 0);
+	std::vector<bool> referenced(vertexCount, false);
+	for (size_t i = 0; i < indexCount; ++i)
+	{
+		referenced[indices[i]] = true;
+	}
+
+	std::unordered_map<FFloat3, uint32_t, FPositionHash, FPositionEqual> positionLookup;
+	for (uint32_t v = 0; v < vertexCount; ++v)
+	{
+		weld[v] = v;
+		if (referenced[v])
+		{
+			weld[v] = positionLookup.emplace(vertexPositions[v], v).first->second;
+			wedgeCount[weld[v]]++;
+		}
+	}
+
+	auto EdgeKey = [](const uint32_t a, const uint32_t b)
+	{
+		return ((uint64_t)a << 32) | b;
+	};
+
+	// Directed edges without a twin are open borders
+	std::unordered_set<uint64_t> edges;
+	edges.reserve(indexCount);
+	for (size_t i = 0; i < indexCount; i += 3)
+	{
+		for (size_t k = 0; k < 3; ++k)
+		{
+			edges.insert(EdgeKey(weld[indices[i + k]], weld[indices[i + (k + 1) % 3]]));
+		}
+	}
+
+	auto IsBorderEdge = [&](const uint32_t a, const uint32_t b)
+	{
+		return edges.count(EdgeKey(weld[b], weld[a])) == 0;
+	};
+
+	std::vector<uint32_t> borderIn(vertexCount, 0);
+	std::vector<uint32_t> borderOut(vertexCount, 0);
+	for (const uint64_t edge : edges)
+	{
+		const uint32_t a = (uint32_t)(edge >> 32);
+		const uint32_t b = (uint32_t)edge;
+		if (edges.count(EdgeKey(b, a)) == 0)
+		{
+			borderOut[a]++;
+			borderIn[b]++;
+		}
+	}
+
+	std::vector<VertexKind> kind(vertexCount, VertexKind::Locked);
+	for (uint32_t v = 0; v < vertexCount; ++v)
+	{
+		const uint32_t w = weld[v];
+		if (wedgeCount[w] == 1)
+		{
+			if (borderIn[w] == 0 && borderOut[w] == 0)
+			{
+				kind[v] = VertexKind::Manifold;
+			}
+			else if (borderIn[w] == 1 && borderOut[w] == 1)
+			{
+				kind[v] = VertexKind::Border;
+			}
+		}
+	}
+
+	// Area weighted triangle planes, plus planes perpendicular to every open border so that borders keep their shape
+	constexpr float k_borderWeight = 10.f;
+	std::vector<FQuadric> quadrics(vertexCount, FQuadric{});
+	for (size_t i = 0; i < indexCount; i += 3)
+	{
+		const FFloat3 p0 = vertexPositions[indices[i + 0]];
+		const FFloat3 p1 = vertexPositions[indices[i + 1]];
+		const FFloat3 p2 = vertexPositions[indices[i + 2]];
+		FFloat3 n = (p1 - p0).Cross(p2 - p0);
+		const float length = n.Length();
+		if (length == 0.f)
+		{
+			continue;
+		}
+
+		n = n * (1.f / length);
+		const FQuadric q = FQuadric::FromPlane(n, -n.Dot(p0), 0.5f * length);
+		for (size_t k = 0; k < 3; ++k)
+		{
+			quadrics[indices[i + k]] += q;
+		}
+
+		for (size_t k = 0; k < 3; ++k)
+		{
+			const uint32_t a = indices[i + k];
+			const uint32_t b = indices[i + (k + 1) % 3];
+			if (IsBorderEdge(a, b))
+			{
+				const FFloat3 edge = vertexPositions[b] - vertexPositions[a];
+				const float edgeLength = edge.Length();
+				FFloat3 borderNormal = edge.Cross(n);
+				const float borderNormalLength = borderNormal.Length();
+				if (borderNormalLength > 0.f)
+				{
+					borderNormal = borderNormal * (1.f / borderNormalLength);
+					const FQuadric bq = FQuadric::FromPlane(borderNormal, -borderNormal.Dot(vertexPositions[a]), k_borderWeight * edgeLength * edgeLength);
+					quadrics[a] += bq;
+					quadrics[b] += bq;
+				}
+			}
+		}
+	}
+
+	struct FCollapse
+	{
+		uint32_t m_from;
+		uint32_t m_to;
+		float m_error;
+	};
+
+	std::vector<uint32_t> current(indices, indices + indexCount);
+	std::vector<FCollapse> collapses;
+	std::vector<bool> collapseLocked(vertexCount);
+	std::vector<uint32_t> collapseTarget(vertexCount);
+	const float maxError = targetError * targetError;
+	float appliedError = 0.f;
+
+	while (current.size() > targetIndexCount)
+	{
+		const FTriangleAdjacency adjacency{ current.data(), current.size(), vertexCount };
+
+		// Cheapest collapse of every movable vertex onto one of its neighbours. Movable vertices have a single wedge, so their
+		// adjacency covers the whole fan, and an edge to a neighbour is a border if only one triangle of the fan shares it.
+		collapses.clear();
+		for (uint32_t from = 0; from < vertexCount; ++from)
+		{
+			if (kind[from] == VertexKind::Locked || adjacency.Degree(from) == 0)
+			{
+				continue;
+			}
+
+			FCollapse best = { from, from, std::numeric_limits<float>::max() };
+			for (uint32_t j = adjacency.m_offsets[from]; j < adjacency.m_offsets[from + 1]; ++j)
+			{
+				const uint32_t* tri = &current[3 * adjacency.m_triangles[j]];
+				for (size_t k = 0; k < 3; ++k)
+				{
+					const uint32_t to = tri[k];
+					if (to == from)
+					{
+						continue;
+					}
+
+					if (kind[from] == VertexKind::Border)
+					{
+						size_t sharedTriangles = 0;
+						for (uint32_t n = adjacency.m_offsets[from]; n < adjacency.m_offsets[from + 1]; ++n)
+						{
+							const uint32_t* other = &current[3 * adjacency.m_triangles[n]];
+							sharedTriangles += (weld[other[0]] == weld[to] || weld[other[1]] == weld[to] || weld[other[2]] == weld[to]) ? 1 : 0;
+						}
+
+						if (sharedTriangles != 1)
+						{
+							continue;
+						}
+					}
+
+					const float error = quadrics[from].Error(vertexPositions[to]);
+					if (error < best.m_error)
+					{
+						best = { from, to, error };
+					}
+				}
+			}
+
+			if (best.m_to != from)
+			{
+				collapses.push_back(best);
+			}
+		}
+
+		std::sort(collapses.begin(), collapses.end(), [](const FCollapse& x, const FCollapse& y)
+		{
+			return x.m_error < y.m_error;
+		});
+
+		// Apply the cheapest collapses, touching every vertex at most once per pass
+		std::fill(collapseLocked.begin(), collapseLocked.end(), false);
+		std::iota(collapseTarget.begin(), collapseTarget.end(), 0);
+		const size_t trianglesToRemove = (current.size() - targetIndexCount) / 3;
+		size_t removedTriangles = 0;
+		size_t appliedCollapses = 0;
+
+		for (const FCollapse& collapse : collapses)
+		{
+			if (collapse.m_error > maxError || removedTriangles >= trianglesToRemove)
+			{
+				break;
+			}
+
+			const uint32_t from = collapse.m_from;
+			const uint32_t to = collapse.m_to;
+			if (collapseLocked[weld[from]] || collapseLocked[weld[to]])
+			{
+				continue;
+			}
+
+			// Reject collapses that would flip any of the remaining triangles around the source vertex or leave one with
+			// coincident corners
+			bool flipped = false;
+			size_t sharedTriangles = 0;
+			for (uint32_t j = adjacency.m_offsets[from]; j < adjacency.m_offsets[from + 1] && !flipped; ++j)
+			{
+				const uint32_t* tri = &current[3 * adjacency.m_triangles[j]];
+				if (weld[tri[0]] == weld[to] || weld[tri[1]] == weld[to] || weld[tri[2]] == weld[to])
+				{
+					sharedTriangles++;
+					continue;
+				}
+
+				const FFloat3 p0 = vertexPositions[tri[0]], p1 = vertexPositions[tri[1]], p2 = vertexPositions[tri[2]];
+				const FFloat3 q0 = tri[0] == from ? vertexPositions[to] : p0;
+				const FFloat3 q1 = tri[1] == from ? vertexPositions[to] : p1;
+				const FFloat3 q2 = tri[2] == from ? vertexPositions[to] : p2;
+				const FFloat3 before = (p1 - p0).Cross(p2 - p0);
+				const FFloat3 after = (q1 - q0).Cross(q2 - q0);
+				flipped = q0 == q1 || q1 == q2 || q2 == q0 || before.Dot(after) <= 0.25f * before.Length() * after.Length();
+			}
+
+			if (flipped)
+			{
+				continue;
+			}
+
+			collapseTarget[from] = to;
+			collapseLocked[weld[from]] = true;
+			collapseLocked[weld[to]] = true;
+			quadrics[to] += quadrics[from];
+			appliedError = std::max(appliedError, collapse.m_error);
+			removedTriangles += sharedTriangles;
+			appliedCollapses++;
+		}
+
+		if (appliedCollapses == 0)
+		{
+			break;
+		}
+
+		// Rewrite the index buffer and drop the triangles that became degenerate
+		size_t writeCount = 0;
+		for (size_t i = 0; i < current.size(); i += 3)
+		{
+			const uint32_t a = collapseTarget[current[i + 0]];
+			const uint32_t b = collapseTarget[current[i + 1]];
+			const uint32_t c = collapseTarget[current[i + 2]];
+			if (weld[a] != weld[b] && weld[b] != weld[c] && weld[c] != weld[a])
+			{
+				current[writeCount++] = a;
+				current[writeCount++] = b;
+				current[writeCount++] = c;
+			}
+		}
+
+		current.resize(writeCount);
+	}
+
+	if (resultError)
+	{
+		*resultError = std::sqrt(appliedError);
+	}
+
+	std::copy(current.begin(), current.end(), destIndices);
+	return current.size();
+}
+
+MeshOptimizer::FTestMesh MeshOptimizer::CreateTestMesh(const uint32_t rings, const uint32_t segments)
+{
+	constexpr float pi = 3.14159265358979f;
+
+	FTestMesh mesh;
+	mesh.m_positions.reserve(3 * (rings + 1) * (segments + 1));
+	for (uint32_t ring = 0; ring <= rings; ++ring)
+	{
+		const float theta = pi * ring / rings;
+		const float sinTheta = ring == 0 || ring == rings ? 0.f : std::sin(theta);
+		for (uint32_t segment = 0; segment <= segments; ++segment)
+		{
+			const float phi = 2.f * pi * (segment % segments) / segments;
+			const float radius = 1.f + 0.05f * std::sin(8.f * theta) * std::sin(8.f * phi);
+			mesh.m_positions.push_back(radius * sinTheta * std::cos(phi));
+			mesh.m_positions.push_back(radius * std::cos(theta));
+			mesh.m_positions.push_back(radius * sinTheta * std::sin(phi));
+		}
+	}
+
+	// The triangles touching the poles would be degenerate on one side
+	for (uint32_t ring = 0; ring < rings; ++ring)
+	{
+		for (uint32_t segment = 0; segment < segments; ++segment)
+		{
+			const uint32_t a = ring * (segments + 1) + segment;
+			const uint32_t b = a + 1;
+			const uint32_t c = a + segments + 1;
+			const uint32_t d = c + 1;
+
+			if (ring > 0)
+			{
+				mesh.m_indices.insert(mesh.m_indices.end(), { a, b, c });
+			}
+
+			if (ring < rings - 1)
+			{
+				mesh.m_indices.insert(mesh.m_indices.end(), { b, d, c });
+			}
+		}
+	}
+
+	return mesh;
+}
+
+MeshOptimizer::Benchmark::FMeshletResult MeshOptimizer::Benchmark::RunMeshlets(const std::vector<FTestMesh>& meshes)
+{
+	using Clock = std::chrono::high_resolution_clock;
+	constexpr float pi = 3.14159265358979f;
+
+	FMeshletResult result = {};
+	size_t vertexSum = 0, culledSum = 0, viewSum = 0;
+	for (const FTestMesh& mesh : meshes)
+	{
+		const size_t vertexCount = mesh.m_positions.size() / 3;
+		std::vector<uint32_t> indices(mesh.m_indices.size());
+		OptimizeVertexCache(indices.data(), mesh.m_indices.data(), indices.size(), vertexCount);
+
+		const Clock::time_point start = Clock::now();
+		std::vector<FMeshlet> meshlets;
+		std::vector<uint32_t> meshletVertices, meshletTriangles;
+		BuildMeshlets(meshlets, meshletVertices, meshletTriangles, indices.data(), indices.size(), vertexCount);
+
+		std::vector<FMeshletBounds> bounds(meshlets.size());
+		for (size_t i = 0; i < meshlets.size(); ++i)
+		{
+			bounds[i] = ComputeMeshletBounds(meshlets[i], meshletVertices.data(), meshletTriangles.data(), mesh.m_positions.data(), 3 * sizeof(float));
+		}
+
+		result.m_buildTime += std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+		result.m_triangleCount += indices.size() / 3;
+		result.m_meshletCount += meshlets.size();
+		vertexSum += meshletVertices.size();
+
+		// Views spread evenly on a sphere three times the size of the mesh's, along a Fibonacci spiral
+		constexpr float maxFloat = std::numeric_limits<float>::max();
+		FFloat3 boundsMin = { maxFloat, maxFloat, maxFloat }, boundsMax = { -maxFloat, -maxFloat, -maxFloat };
+		for (size_t v = 0; v < vertexCount; ++v)
+		{
+			const float* p = &mesh.m_positions[3 * v];
+			boundsMin = { std::min(boundsMin.x, p[0]), std::min(boundsMin.y, p[1]), std::min(boundsMin.z, p[2]) };
+			boundsMax = { std::max(boundsMax.x, p[0]), std::max(boundsMax.y, p[1]), std::max(boundsMax.z, p[2]) };
+		}
+
+		const FFloat3 center = (boundsMin + boundsMax) * 0.5f;
+		const float viewDistance = 1.5f * (boundsMax - boundsMin).Length();
+
+		constexpr uint32_t viewCount = 64;
+		for (uint32_t view = 0; view < viewCount; ++view)
+		{
+			const float y = 1.f - 2.f * (view + 0.5f) / viewCount;
+			const float r = std::sqrt(1.f - y * y);
+			const float phi = pi * (3.f - std::sqrt(5.f)) * view;
+			const FFloat3 viewPosition = center + FFloat3{ r * std::cos(phi), y, r * std::sin(phi) } * viewDistance;
+
+			for (const FMeshletBounds& meshletBounds : bounds)
+			{
+				const FFloat3 apex = { meshletBounds.m_coneApex[0], meshletBounds.m_coneApex[1], meshletBounds.m_coneApex[2] };
+				const FFloat3 axis = { meshletBounds.m_coneAxis[0], meshletBounds.m_coneAxis[1], meshletBounds.m_coneAxis[2] };
+				const FFloat3 viewToApex = apex - viewPosition;
+				culledSum += viewToApex.Dot(axis) >= meshletBounds.m_coneCutoff * viewToApex.Length() ? 1 : 0;
+			}
+		}
+
+		viewSum += viewCount * meshlets.size();
+	}
+
+	if (result.m_meshletCount > 0)
+	{
+		result.m_vertexFill = vertexSum / double(result.m_meshletCount * k_maxMeshletVertices);
+		result.m_triangleFill = result.m_triangleCount / double(result.m_meshletCount * k_maxMeshletTriangles);
+		result.m_coneCulledFraction = culledSum / double(viewSum);
+	}
+
+	return result;
+}
@@ -0,0 +1,606 @@
+#include <mip-chain.h>
+#include <ppl.h>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <vector>
+
+#if defined(_M_X64) || defined(__x86_64__)
+#define MIP_CHAIN_X64 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define AVX2_TARGET
+#else
+#define AVX2_TARGET __attribute__((target("avx2,fma")))
+#endif
+#elif defined(_M_ARM64) || defined(__aarch64__)
+#define MIP_CHAIN_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace
+{
+	constexpr uint32_t k_maxTaps = 8;
+	constexpr float k_kaiserAlpha = 4.f;
+	constexpr float k_kaiserWidth = 2.f; // destination pixels on each side of the center
+	constexpr uint32_t k_parallelRowThreshold = 32; // smaller mips are filtered on the calling thread
+	constexpr uint32_t k_alphaScaleIterations = 12;
+
+	// Separable filter for a 2:1 reduction. Destination pixel x reads source pixels [2x + m_firstOffset, 2x + m_firstOffset + m_tapCount).
+	struct FKernel
+	{
+		int32_t m_firstOffset;
+		uint32_t m_tapCount;
+		float m_weights[k_maxTaps];
+	};
+
+	// Linear RGBA, 4 floats per pixel without padding
+	struct FLevel
+	{
+		uint32_t m_width = 0;
+		uint32_t m_height = 0;
+		std::vector<float> m_pixels;
+	};
+
+	// Filters a row of source pixels into destWidth pixels
+	using RowFunction = void(*)(const float* src, const uint32_t srcWidth, float* dest, const uint32_t destWidth, const FKernel& kernel);
+
+	// dest[i] = sum of weights[tap] * rows[tap][i], count is a multiple of 4
+	using ColumnFunction = void(*)(const float* const* rows, const FKernel& kernel, float* dest, const uint32_t count);
+
+	struct FFunctions
+	{
+		RowFunction m_row;
+		ColumnFunction m_column;
+	};
+
+	float BesselI0(const float x)
+	{
+		float sum = 1.f, term = 1.f;
+		for (uint32_t k = 1; k < 32 && term > 1e-8f * sum; ++k)
+		{
+			const float factor = x / (2.f * k);
+			term *= factor * factor;
+			sum += term;
+		}
+
+		return sum;
+	}
+
+	FKernel MakeKernel(const MipChain::Filter filter)
+	{
+		if (filter == MipChain::Filter::Box)
+		{
+			return FKernel{ 0, 2, { 0.5f, 0.5f } };
+		}
+
+		// Source pixel 2x + offset is (offset - 0.5) source pixels away from the center of destination pixel x
+		constexpr float pi = 3.14159265358979f;
+		FKernel kernel{ 1 - int32_t(k_maxTaps / 2), k_maxTaps, {} };
+		float sum = 0.f;
+		for (uint32_t tap = 0; tap < kernel.m_tapCount; ++tap)
+		{
+			const float t = (kernel.m_firstOffset + int32_t(tap) - 0.5f) / 2.f;
+			const float sinc = std::sin(pi * t) / (pi * t);
+			const float x = t / k_kaiserWidth;
+			const float window = BesselI0(k_kaiserAlpha * std::sqrt(std::max(1.f - x * x, 0.f))) / BesselI0(k_kaiserAlpha);
+			kernel.m_weights[tap] = sinc * window;
+			sum += kernel.m_weights[tap];
+		}
+
+		for (uint32_t tap = 0; tap < kernel.m_tapCount; ++tap)
+		{
+			kernel.m_weights[tap] /= sum;
+		}
+
+		return kernel;
+	}
+
+	const FKernel& GetKernel(const MipChain::Filter filter)
+	{
+		static const FKernel box = MakeKernel(MipChain::Filter::Box);
+		static const FKernel kaiser = MakeKernel(MipChain::Filter::Kaiser);
+		return filter == MipChain::Filter::Box ? box : kaiser;
+	}
+
+	// 8-bit sRGB to linear
+	const std::array<float, 256>& GetSrgbToLinearTable()
+	{
+		static const std::array<float, 256> table = []
+		{
+			std::array<float, 256> values;
+			for (uint32_t i = 0; i < 256; ++i)
+			{
+				const float c = i / 255.f;
+				values[i] = c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+			}
+
+			return values;
+		}();
+
+		return table;
+	}
+
+	// Linear values half way between consecutive sRGB codes so that encoding rounds exactly in sRGB space, and the code at the
+	// start of 4096 linear buckets to skip most of the search
+	struct FSrgbEncoder
+	{
+		static constexpr uint32_t k_bucketCount = 4096;
+
+		float m_thresholds[255];
+		uint8_t m_bucketCodes[k_bucketCount];
+	};
+
+	const FSrgbEncoder& GetSrgbEncoder()
+	{
+		static const FSrgbEncoder encoder = []
+		{
+			FSrgbEncoder values;
+			for (uint32_t i = 0; i < 255; ++i)
+			{
+				const float c = (i + 0.5f) / 255.f;
+				values.m_thresholds[i] = c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+			}
+
+			for (uint32_t bucket = 0; bucket < FSrgbEncoder::k_bucketCount; ++bucket)
+			{
+				const float value = bucket / float(FSrgbEncoder::k_bucketCount - 1);
+				values.m_bucketCodes[bucket] = uint8_t(std::upper_bound(values.m_thresholds, values.m_thresholds + 255, value) - values.m_thresholds);
+			}
+
+			return values;
+		}();
+
+		return encoder;
+	}
+
+	uint8_t LinearToSrgb(const float value, const FSrgbEncoder& encoder)
+	{
+		const float clamped = std::clamp(value, 0.f, 1.f);
+		uint32_t code = encoder.m_bucketCodes[uint32_t(clamped * (FSrgbEncoder::k_bucketCount - 1))];
+		while (code < 255 && clamped >= encoder.m_thresholds[code])
+		{
+			++code;
+		}
+
+		return uint8_t(code);
+	}
+
+	uint8_t LinearToUnorm(const float value)
+	{
+		return uint8_t(std::clamp(value, 0.f, 1.f) * 255.f + 0.5f);
+	}
+
+	template<typename TFunction>
+	void ForEachRow(const uint32_t rowCount, TFunction&& function)
+	{
+		if (rowCount < k_parallelRowThreshold)
+		{
+			for (uint32_t row = 0; row < rowCount; ++row)
+			{
+				function(row);
+			}
+		}
+		else
+		{
+			concurrency::parallel_for(0u, rowCount, function);
+		}
+	}
+
+	void FilterPixelScalar(const float* src, const uint32_t srcWidth, const uint32_t x, float* dest, const FKernel& kernel)
+	{
+		float sum[4] = {};
+		for (uint32_t tap = 0; tap < kernel.m_tapCount; ++tap)
+		{
+			const int32_t sx = std::clamp(int32_t(2 * x) + kernel.m_firstOffset + int32_t(tap), 0, int32_t(srcWidth) - 1);
+			for (uint32_t c = 0; c < 4; ++c)
+			{
+				sum[c] += kernel.m_weights[tap] * src[4 * sx + c];
+			}
+		}
+
+		std::memcpy(dest + 4 * x, sum, sizeof(sum));
+	}
+
+	void FilterRowScalar(const float* src, const uint32_t srcWidth, float* dest, const uint32_t destWidth, const FKernel& kernel)
+	{
+		for (uint32_t x = 0; x < destWidth; ++x)
+		{
+			FilterPixelScalar(src, srcWidth, x, dest, kernel);
+		}
+	}
+
+	void FilterColumnScalar(const float* const* rows, const FKernel& kernel, float* dest, const uint32_t count)
+	{
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			float sum = 0.f;
+			for (uint32_t tap = 0; tap < kernel.m_tapCount; ++tap)
+			{
+				sum += kernel.m_weights[tap] * rows[tap][i];
+			}
+
+			dest[i] = sum;
+		}
+	}
+
+	// Destination pixels whose taps are all inside the source row, the others clamp to the edges
+	void GetInteriorRange(const uint32_t srcWidth, const uint32_t destWidth, const FKernel& kernel, uint32_t& begin, uint32_t& end)
+	{
+		begin = std::min(uint32_t(std::max(-kernel.m_firstOffset + 1, 0) / 2), destWidth);
+		const int32_t lastTwice = int32_t(srcWidth) - kernel.m_firstOffset - int32_t(kernel.m_tapCount);
+		end = lastTwice < 0 ? begin : std::max(begin, std::min(destWidth, uint32_t(lastTwice / 2 + 1)));
+	}
+
+#if MIP_CHAIN_X64
+	bool CpuSupportsAvx2()
+	{
+#if defined(_MSC_VER)
+		int info[4];
+		__cpuid(info, 0);
+		if (info[0] < 7)
+		{
+			return false;
+		}
+
+		__cpuid(info, 1);
+		const bool fma = (info[2] & (1 << 12)) != 0;
+		const bool osxsave = (info[2] & (1 << 27)) != 0;
+		if (!fma || !osxsave || (_xgetbv(0) & 0x6) != 0x6)
+		{
+			return false;
+		}
+
+		__cpuidex(info, 7, 0);
+		return (info[1] & (1 << 5)) != 0;
+#else
+		return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#endif
+	}
+
+	// One pixel per register, SSE2 is part of x64
+	void FilterRowSse(const float* src, const uint32_t srcWidth, float* dest, const uint32_t destWidth, const FKernel& kernel)
+	{
+		uint32_t begin, end;
+		GetInteriorRange(srcWidth, destWidth, kernel, begin, end);
+		for (uint32_t x = 0; x < begin; ++x)
+		{
+			FilterPixelScalar(src, srcWidth, x, dest, kernel);
+		}
+
+		for (uint32_t x = begin; x < end; ++x)
+		{
+			const float* taps = src + 4 * (int32_t(2 * x) + kernel.m_firstOffset);
+			__m128 sum = _mm_mul_ps(_mm_set1_ps(kernel.m_weights[0]), _mm_loadu_ps(taps));
+			for (uint32_t tap = 1; tap < kernel.m_tapCount; ++tap)
+			{
+				sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(kernel.m_weights[tap]), _mm_loadu_ps(taps + 4 * tap)));
+			}
+
+			_mm_storeu_ps(dest + 4 * x, sum);
+		}
+
+		for (uint32_t x = end; x < destWidth; ++x)
+		{
+			FilterPixelScalar(src, srcWidth, x, dest, kernel);
+		}
+	}
+
+	void FilterColumnSse(const float* const* rows, const FKernel& kernel, float* dest, const uint32_t count)
+	{
+		for (uint32_t i = 0; i < count; i += 4)
+		{
+			__m128 sum = _mm_mul_ps(_mm_set1_ps(kernel.m_weights[0]), _mm_loadu_ps(rows[0] + i));
+			for (uint32_t tap = 1; tap < kernel.m_tapCount; ++tap)
+			{
+				sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(kernel.m_weights[tap]), _mm_loadu_ps(rows[tap] + i)));
+			}
+
+			_mm_storeu_ps(dest + i, sum);
+		}
+	}
+
+	AVX2_TARGET void FilterColumnAvx2(const float* const* rows, const FKernel& kernel, float* dest, const uint32_t count)
+	{
+		uint32_t i = 0;
+		for (; i + 8 <= count; i += 8)
+		{
+			__m256 sum = _mm256_mul_ps(_mm256_set1_ps(kernel.m_weights[0]), _mm256_loadu_ps(rows[0] + i));
+			for (uint32_t tap = 1; tap < kernel.m_tapCount; ++tap)
+			{
+				sum = _mm256_fmadd_ps(_mm256_set1_ps(kernel.m_weights[tap]), _mm256_loadu_ps(rows[tap] + i), sum);
+			}
+
+			_mm256_storeu_ps(dest + i, sum);
+		}
+
+		if (i < count)
+		{
+			const float* tail[k_maxTaps];
+			for (uint32_t tap = 0; tap < kernel.m_tapCount; ++tap)
+			{
+				tail[tap] = rows[tap] + i;
+			}
+
+			FilterColumnSse(tail, kernel, dest + i, count - i);
+		}
+	}
+
+	const FFunctions* GetSimdFunctions()
+	{
+		static const FFunctions functions = { FilterRowSse, CpuSupportsAvx2() ? FilterColumnAvx2 : FilterColumnSse };
+		return &functions;
+	}
+#elif MIP_CHAIN_NEON
+	void FilterRowNeon(const float* src, const uint32_t srcWidth, float* dest, const uint32_t destWidth, const FKernel& kernel)
+	{
+		uint32_t begin, end;
+		GetInteriorRange(srcWidth, destWidth, kernel, begin, end);
+		for (uint32_t x = 0; x < begin; ++x)
+		{
+			FilterPixelScalar(src, srcWidth, x, dest, kernel);
+		}
+
+		for (uint32_t x = begin; x < end; ++x)
+		{
+			const float* taps = src + 4 * (int32_t(2 * x) + kernel.m_firstOffset);
+			float32x4_t sum = vmulq_n_f32(vld1q_f32(taps), kernel.m_weights[0]);
+			for (uint32_t tap = 1; tap < kernel.m_tapCount; ++tap)
+			{
+				sum = vfmaq_n_f32(sum, vld1q_f32(taps + 4 * tap), kernel.m_weights[tap]);
+			}
+
+			vst1q_f32(dest + 4 * x, sum);
+		}
+
+		for (uint32_t x = end; x < destWidth; ++x)
+		{
+			FilterPixelScalar(src, srcWidth, x, dest, kernel);
+		}
+	}
+
+	void FilterColumnNeon(const float* const* rows, const FKernel& kernel, float* dest, const uint32_t count)
+	{
+		for (uint32_t i = 0; i < count; i += 4)
+		{
+			float32x4_t sum = vmulq_n_f32(vld1q_f32(rows[0] + i), kernel.m_weights[0]);
+			for (uint32_t tap = 1; tap < kernel.m_tapCount; ++tap)
+			{
+				sum = vfmaq_n_f32(sum, vld1q_f32(rows[tap] + i), kernel.m_weights[tap]);
+			}
+
+			vst1q_f32(dest + i, sum);
+		}
+	}
+
+	const FFunctions* GetSimdFunctions()
+	{
+		static const FFunctions functions = { FilterRowNeon, FilterColumnNeon };
+		return &functions;
+	}
+#else
+	const FFunctions* GetSimdFunctions()
+	{
+		return nullptr;
+	}
+#endif
+
+	FFunctions GetFunctions(const bool allowSimd)
+	{
+		const FFunctions* simd = allowSimd ? GetSimdFunctions() : nullptr;
+		return simd ? *simd : FFunctions{ FilterRowScalar, FilterColumnScalar };
+	}
+
+	void LoadLevel(const MipChain::FImage& image, const MipChain::Format format, FLevel& level)
+	{
+		level.m_width = image.m_width;
+		level.m_height = image.m_height;
+		level.m_pixels.resize(4 * size_t(image.m_width) * image.m_height);
+
+		const std::array<float, 256>& srgbToLinear = GetSrgbToLinearTable();
+		ForEachRow(image.m_height, [&](const uint32_t y)
+		{
+			const uint8_t* src = image.m_pixels + y * image.m_rowPitch;
+			float* dest = level.m_pixels.data() + 4 * size_t(y) * image.m_width;
+			switch (format)
+			{
+			case MipChain::Format::RGBA32Float:
+				std::memcpy(dest, src, 4 * sizeof(float) * image.m_width);
+				break;
+			case MipChain::Format::RGBA8Srgb:
+				for (uint32_t i = 0; i < 4 * image.m_width; ++i)
+				{
+					dest[i] = i % 4 == 3 ? src[i] / 255.f : srgbToLinear[src[i]];
+				}
+				break;
+			default:
+				for (uint32_t i = 0; i < 4 * image.m_width; ++i)
+				{
+					dest[i] = src[i] / 255.f;
+				}
+				break;
+			}
+		});
+	}
+
+	// Negative lobes of the Kaiser filter can push values out of range, they are clamped here rather than between mips
+	void StoreLevel(const FLevel& level, const MipChain::Format format, const float alphaScale, const MipChain::FImage& image)
+	{
+		const FSrgbEncoder& srgbEncoder = GetSrgbEncoder();
+		ForEachRow(image.m_height, [&](const uint32_t y)
+		{
+			const float* src = level.m_pixels.data() + 4 * size_t(y) * level.m_width;
+			uint8_t* dest = image.m_pixels + y * image.m_rowPitch;
+			switch (format)
+			{
+			case MipChain::Format::RGBA32Float:
+				for (uint32_t i = 0; i < 4 * level.m_width; ++i)
+				{
+					const float value = std::max(i % 4 == 3 ? src[i] * alphaScale : src[i], 0.f);
+					std::memcpy(dest + sizeof(float) * i, &value, sizeof(float));
+				}
+				break;
+			case MipChain::Format::RGBA8Srgb:
+				for (uint32_t i = 0; i < 4 * level.m_width; ++i)
+				{
+					dest[i] = i % 4 == 3 ? LinearToUnorm(src[i] * alphaScale) : LinearToSrgb(src[i], srgbEncoder);
+				}
+				break;
+			default:
+				for (uint32_t i = 0; i < 4 * level.m_width; ++i)
+				{
+					dest[i] = LinearToUnorm(i % 4 == 3 ? src[i] * alphaScale : src[i]);
+				}
+				break;
+			}
+		});
+	}
+
+	// Horizontal pass into scratch, then vertical pass into dest
+	void Downsample(const FLevel& src, FLevel& dest, std::vector<float>& scratch, const FKernel& kernel, const FFunctions& functions)
+	{
+		dest.m_width = std::max(src.m_width / 2, 1u);
+		dest.m_height = std::max(src.m_height / 2, 1u);
+		dest.m_pixels.resize(4 * size_t(dest.m_width) * dest.m_height);
+		scratch.resize(4 * size_t(dest.m_width) * src.m_height);
+
+		ForEachRow(src.m_height, [&](const uint32_t y)
+		{
+			functions.m_row(src.m_pixels.data() + 4 * size_t(y) * src.m_width, src.m_width, scratch.data() + 4 * size_t(y) * dest.m_width, dest.m_width, kernel);
+		});
+
+		ForEachRow(dest.m_height, [&](const uint32_t y)
+		{
+			const float* rows[k_maxTaps];
+			for (uint32_t tap = 0; tap < kernel.m_tapCount; ++tap)
+			{
+				const int32_t sy = std::clamp(int32_t(2 * y) + kernel.m_firstOffset + int32_t(tap), 0, int32_t(src.m_height) - 1);
+				rows[tap] = scratch.data() + 4 * size_t(sy) * dest.m_width;
+			}
+
+			functions.m_column(rows, kernel, dest.m_pixels.data() + 4 * size_t(y) * dest.m_width, 4 * dest.m_width);
+		});
+	}
+
+	float ComputeAlphaCoverage(const FLevel& level, const float alphaReference, const float alphaScale)
+	{
+		size_t coveredCount = 0;
+		for (size_t i = 3; i < level.m_pixels.size(); i += 4)
+		{
+			coveredCount += std::min(level.m_pixels[i] * alphaScale, 1.f) > alphaReference;
+		}
+
+		return float(coveredCount) / float(level.m_pixels.size() / 4);
+	}
+
+	// Coverage grows with the scale, bisect for the one that matches the target
+	float FindAlphaScale(const FLevel& level, const float alphaReference, const float targetCoverage)
+	{
+		float minScale = 0.f, maxScale = 4.f;
+		for (uint32_t iteration = 0; iteration < k_alphaScaleIterations; ++iteration)
+		{
+			const float scale = 0.5f * (minScale + maxScale);
+			if (ComputeAlphaCoverage(level, alphaReference, scale) < targetCoverage)
+			{
+				minScale = scale;
+			}
+			else
+			{
+				maxScale = scale;
+			}
+		}
+
+		return maxScale;
+	}
+}
+
+uint32_t MipChain::GetMipSize(const uint32_t size, const uint32_t mip)
+{
+	return std::max(size >> mip, 1u);
+}
+
+bool MipChain::HasSimdSupport()
+{
+	return GetSimdFunctions() != nullptr;
+}
+
+void MipChain::Generate(
+	const FImage* mips,
+	const uint32_t mipCount,
+	const Format format,
+	const Filter filter,
+	const float alphaReference,
+	const bool allowSimd)
+{
+	if (mipCount < 2)
+	{
+		return;
+	}
+
+	const FKernel& kernel = GetKernel(filter);
+	const FFunctions functions = GetFunctions(allowSimd);
+
+	FLevel level, nextLevel;
+	std::vector<float> scratch;
+	LoadLevel(mips[0], format, level);
+
+	const bool preserveCoverage = alphaReference >= 0.f;
+	const float coverage = preserveCoverage ? ComputeAlphaCoverage(level, alphaReference, 1.f) : 0.f;
+	for (uint32_t mip = 1; mip < mipCount; ++mip)
+	{
+		Downsample(level, nextLevel, scratch, kernel, functions);
+		const float alphaScale = preserveCoverage ? FindAlphaScale(nextLevel, alphaReference, coverage) : 1.f;
+		StoreLevel(nextLevel, format, alphaScale, mips[mip]);
+		std::swap(level, nextLevel);
+	}
+}
+
+double MipChain::MeasureGenerateTime(const uint32_t size, const Format format, const Filter filter, const bool allowSimd)
+{
+	using Clock = std::chrono::high_resolution_clock;
+
+	const size_t pixelSize = format == Format::RGBA32Float ? 4 * sizeof(float) : 4;
+	const uint32_t mipCount = uint32_t(std::log2(size)) + 1;
+	std::vector<std::vector<uint8_t>> buffers(mipCount);
+	std::vector<FImage> mips(mipCount);
+	for (uint32_t mip = 0; mip < mipCount; ++mip)
+	{
+		const uint32_t mipSize = GetMipSize(size, mip);
+		buffers[mip].resize(pixelSize * mipSize * mipSize);
+		mips[mip] = FImage{ buffers[mip].data(), mipSize, mipSize, pixelSize * mipSize };
+	}
+
+	std::mt19937 rng{ 1 };
+	if (format == Format::RGBA32Float)
+	{
+		std::uniform_real_distribution<float> distribution{ 0.f, 16.f };
+		for (size_t i = 0; i < buffers[0].size(); i += sizeof(float))
+		{
+			const float value = distribution(rng);
+			std::memcpy(&buffers[0][i], &value, sizeof(float));
+		}
+	}
+	else
+	{
+		std::uniform_int_distribution<int> distribution{ 0, 255 };
+		for (uint8_t& value : buffers[0])
+		{
+			value = uint8_t(distribution(rng));
+		}
+	}
+
+	double bestTime = std::numeric_limits<double>::max();
+	for (int run = 0; run < 3; ++run)
+	{
+		const auto start = Clock::now();
+		Generate(mips.data(), mipCount, format, filter, -1.f, allowSimd);
+		bestTime = std::min(bestTime, std::chrono::duration<double, std::milli>(Clock::now() - start).count());
+	}
+
+	return bestTime;
+}
@@ -0,0 +1,488 @@
+#include <occlusion.h>
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <limits>
+
+#if defined(_M_X64) || defined(__x86_64__)
+#define OCCLUSION_AVX2 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#define AVX2_TARGET
+#else
+#define AVX2_TARGET __attribute__((target("avx2,fma")))
+#endif
+#elif defined(_M_ARM64) || defined(__aarch64__)
+#define OCCLUSION_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace
+{
+	// Row of 8 pixels starting at x (a multiple of 8) and the edge and depth functions evaluated at their centers
+	struct FSpan
+	{
+		float* m_depth;
+		float m_x;
+		float m_edgeA[3];
+		float m_edgeRow[3]; // b * y + c
+		float m_depthA;
+		float m_depthRow;
+	};
+
+	void RasterizeSpanScalar(const FSpan& span)
+	{
+		for (int lane = 0; lane < 8; ++lane)
+		{
+			const float x = span.m_x + lane + 0.5f;
+			const bool inside =
+				span.m_edgeA[0] * x + span.m_edgeRow[0] >= 0.f &&
+				span.m_edgeA[1] * x + span.m_edgeRow[1] >= 0.f &&
+				span.m_edgeA[2] * x + span.m_edgeRow[2] >= 0.f;
+
+			if (inside)
+			{
+				span.m_depth[lane] = std::max(span.m_depth[lane], span.m_depthA * x + span.m_depthRow);
+			}
+		}
+	}
+
+	// True if any of the pixels in [x0, x1] of the row of 8 starting at x is at or behind depth
+	bool IsSpanVisibleScalar(const float* depth, const int32_t x, const int32_t x0, const int32_t x1, const float boxDepth)
+	{
+		for (int32_t px = std::max(x, x0); px <= std::min(x + 7, x1); ++px)
+		{
+			if (depth[px - x] <= boxDepth)
+			{
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+#if OCCLUSION_AVX2
+	AVX2_TARGET void RasterizeSpanAvx2(const FSpan& span)
+	{
+		const __m256 x = _mm256_add_ps(_mm256_set1_ps(span.m_x + 0.5f), _mm256_setr_ps(0.f, 1.f, 2.f, 3.f, 4.f, 5.f, 6.f, 7.f));
+		const __m256 e0 = _mm256_fmadd_ps(_mm256_set1_ps(span.m_edgeA[0]), x, _mm256_set1_ps(span.m_edgeRow[0]));
+		const __m256 e1 = _mm256_fmadd_ps(_mm256_set1_ps(span.m_edgeA[1]), x, _mm256_set1_ps(span.m_edgeRow[1]));
+		const __m256 e2 = _mm256_fmadd_ps(_mm256_set1_ps(span.m_edgeA[2]), x, _mm256_set1_ps(span.m_edgeRow[2]));
+		const __m256 inside = _mm256_cmp_ps(_mm256_min_ps(e0, _mm256_min_ps(e1, e2)), _mm256_setzero_ps(), _CMP_GE_OQ);
+		if (_mm256_movemask_ps(inside) == 0)
+		{
+			return;
+		}
+
+		const __m256 depth = _mm256_fmadd_ps(_mm256_set1_ps(span.m_depthA), x, _mm256_set1_ps(span.m_depthRow));
+		const __m256 current = _mm256_loadu_ps(span.m_depth);
+		_mm256_storeu_ps(span.m_depth, _mm256_blendv_ps(current, _mm256_max_ps(current, depth), inside));
+	}
+
+	AVX2_TARGET bool IsSpanVisibleAvx2(const float* depth, const int32_t x, const int32_t x0, const int32_t x1, const float boxDepth)
+	{
+		const __m256i px = _mm256_add_epi32(_mm256_set1_epi32(x), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+		const __m256i inRange = _mm256_andnot_si256(
+			_mm256_or_si256(_mm256_cmpgt_epi32(_mm256_set1_epi32(x0), px), _mm256_cmpgt_epi32(px, _mm256_set1_epi32(x1))),
+			_mm256_set1_epi32(-1));
+		const __m256 behind = _mm256_cmp_ps(_mm256_loadu_ps(depth), _mm256_set1_ps(boxDepth), _CMP_LE_OQ);
+		return _mm256_movemask_ps(_mm256_and_ps(behind, _mm256_castsi256_ps(inRange))) != 0;
+	}
+#endif
+
+#if OCCLUSION_NEON
+	// Two halves of four pixels
+	void RasterizeSpanNeon(const FSpan& span)
+	{
+		const float32x4_t laneOffsets = { 0.5f, 1.5f, 2.5f, 3.5f };
+		for (int half = 0; half < 2; ++half)
+		{
+			const float32x4_t x = vaddq_f32(vdupq_n_f32(span.m_x + 4.f * half), laneOffsets);
+			const float32x4_t e0 = vfmaq_f32(vdupq_n_f32(span.m_edgeRow[0]), vdupq_n_f32(span.m_edgeA[0]), x);
+			const float32x4_t e1 = vfmaq_f32(vdupq_n_f32(span.m_edgeRow[1]), vdupq_n_f32(span.m_edgeA[1]), x);
+			const float32x4_t e2 = vfmaq_f32(vdupq_n_f32(span.m_edgeRow[2]), vdupq_n_f32(span.m_edgeA[2]), x);
+			const uint32x4_t inside = vcgeq_f32(vminq_f32(e0, vminq_f32(e1, e2)), vdupq_n_f32(0.f));
+
+			float* dest = span.m_depth + 4 * half;
+			const float32x4_t depth = vfmaq_f32(vdupq_n_f32(span.m_depthRow), vdupq_n_f32(span.m_depthA), x);
+			const float32x4_t current = vld1q_f32(dest);
+			vst1q_f32(dest, vbslq_f32(inside, vmaxq_f32(current, depth), current));
+		}
+	}
+
+	bool IsSpanVisibleNeon(const float* depth, const int32_t x, const int32_t x0, const int32_t x1, const float boxDepth)
+	{
+		const int32x4_t laneOffsets = { 0, 1, 2, 3 };
+		uint32x4_t visible = vdupq_n_u32(0);
+		for (int half = 0; half < 2; ++half)
+		{
+			const int32x4_t px = vaddq_s32(vdupq_n_s32(x + 4 * half), laneOffsets);
+			const uint32x4_t inRange = vandq_u32(vcgeq_s32(px, vdupq_n_s32(x0)), vcleq_s32(px, vdupq_n_s32(x1)));
+			const uint32x4_t behind = vcleq_f32(vld1q_f32(depth + 4 * half), vdupq_n_f32(boxDepth));
+			visible = vorrq_u32(visible, vandq_u32(inRange, behind));
+		}
+
+		return vmaxvq_u32(visible) != 0;
+	}
+#endif
+
+	void RasterizeSpan(const FSpan& span)
+	{
+#if OCCLUSION_AVX2
+		if (Bounds::HasSimdSupport())
+		{
+			return RasterizeSpanAvx2(span);
+		}
+#elif OCCLUSION_NEON
+		return RasterizeSpanNeon(span);
+#endif
+		RasterizeSpanScalar(span);
+	}
+
+	bool IsSpanVisible(const float* depth, const int32_t x, const int32_t x0, const int32_t x1, const float boxDepth)
+	{
+#if OCCLUSION_AVX2
+		if (Bounds::HasSimdSupport())
+		{
+			return IsSpanVisibleAvx2(depth, x, x0, x1, boxDepth);
+		}
+#elif OCCLUSION_NEON
+		return IsSpanVisibleNeon(depth, x, x0, x1, boxDepth);
+#endif
+		return IsSpanVisibleScalar(depth, x, x0, x1, boxDepth);
+	}
+
+	// Row vector transform, dest = (p, 1) * m
+	void TransformPoint(float dest[4], const float p[3], const float m[16])
+	{
+		for (int j = 0; j < 4; ++j)
+		{
+			dest[j] = p[0] * m[j] + p[1] * m[4 + j] + p[2] * m[8 + j] + m[12 + j];
+		}
+	}
+
+	// Signed distance to the reverse-Z near plane z = w, positive in front of it
+	float GetNearDistance(const float v[4])
+	{
+		return v[3] - v[2];
+	}
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------------------------
+//														Depth Buffer
+//-----------------------------------------------------------------------------------------------------------------------------------------------
+
+Occlusion::FDepthBuffer::FDepthBuffer(const uint32_t width, const uint32_t height) :
+	m_tilesX{ (width + k_tileWidth - 1) / k_tileWidth },
+	m_tilesY{ (height + k_tileHeight - 1) / k_tileHeight }
+{
+	m_width = m_tilesX * k_tileWidth;
+	m_height = m_tilesY * k_tileHeight;
+	m_depth.resize(m_width * m_height);
+	m_tileFarthestDepth.resize(GetTileCount());
+	m_tileBins.resize(GetTileCount());
+}
+
+void Occlusion::FDepthBuffer::Begin(const float worldToClip[16])
+{
+	std::copy_n(worldToClip, 16, m_worldToClip);
+	std::fill(m_depth.begin(), m_depth.end(), 0.f);
+	std::fill(m_tileFarthestDepth.begin(), m_tileFarthestDepth.end(), 0.f);
+	m_triangles.clear();
+	for (std::vector<uint32_t>& bin : m_tileBins)
+	{
+		bin.clear();
+	}
+}
+
+size_t Occlusion::FDepthBuffer::AddOccluder(const FOccluder& occluder, const float localToWorld[16])
+{
+	// Affine local to world followed by the view projection
+	float localToClip[16];
+	for (int i = 0; i < 4; ++i)
+	{
+		for (int j = 0; j < 4; ++j)
+		{
+			localToClip[i * 4 + j] = localToWorld[i * 4 + 0] * m_worldToClip[0 * 4 + j] + localToWorld[i * 4 + 1] * m_worldToClip[1 * 4 + j] +
+				localToWorld[i * 4 + 2] * m_worldToClip[2 * 4 + j] + localToWorld[i * 4 + 3] * m_worldToClip[3 * 4 + j];
+		}
+	}
+
+	const size_t vertexCount = occluder.m_positions.size() / 3;
+	m_clipPositions.resize(vertexCount * 4);
+	for (size_t i = 0; i < vertexCount; ++i)
+	{
+		TransformPoint(&m_clipPositions[i * 4], &occluder.m_positions[i * 3], localToClip);
+	}
+
+	const size_t firstTriangle = m_triangles.size();
+	for (size_t i = 0; i + 2 < occluder.m_indices.size(); i += 3)
+	{
+		const float* v[3] = {
+			&m_clipPositions[occluder.m_indices[i + 0] * 4],
+			&m_clipPositions[occluder.m_indices[i + 1] * 4],
+			&m_clipPositions[occluder.m_indices[i + 2] * 4] };
+
+		const int insideCount = (GetNearDistance(v[0]) >= 0.f) + (GetNearDistance(v[1]) >= 0.f) + (GetNearDistance(v[2]) >= 0.f);
+		if (insideCount == 3)
+		{
+			AddTriangle(v[0], v[1], v[2]);
+		}
+		else if (insideCount > 0)
+		{
+			// Clip against the near plane, which leaves a triangle or a quad
+			float polygon[4][4];
+			int polygonSize = 0;
+			for (int edge = 0; edge < 3; ++edge)
+			{
+				const float* a = v[edge];
+				const float* b = v[(edge + 1) % 3];
+				const float da = GetNearDistance(a);
+				const float db = GetNearDistance(b);
+				if (da >= 0.f)
+				{
+					std::copy_n(a, 4, polygon[polygonSize++]);
+				}
+
+				if ((da >= 0.f) != (db >= 0.f))
+				{
+					const float t = da / (da - db);
+					for (int j = 0; j < 4; ++j)
+					{
+						polygon[polygonSize][j] = a[j] + t * (b[j] - a[j]);
+					}
+
+					polygonSize++;
+				}
+			}
+
+			for (int j = 2; j < polygonSize; ++j)
+			{
+				AddTriangle(polygon[0], polygon[j - 1], polygon[j]);
+			}
+		}
+	}
+
+	return m_triangles.size() - firstTriangle;
+}
+
+void Occlusion::FDepthBuffer::AddTriangle(const float v0[4], const float v1[4], const float v2[4])
+{
+	// Vertices on the near plane can still have w = 0 with an infinite projection
+	if (v0[3] <= 0.f || v1[3] <= 0.f || v2[3] <= 0.f)
+	{
+		return;
+	}
+
+	const float* clip[3] = { v0, v1, v2 };
+	float x[3], y[3], depth[3];
+	for (int i = 0; i < 3; ++i)
+	{
+		const float invW = 1.f / clip[i][3];
+		x[i] = (0.5f + 0.5f * clip[i][0] * invW) * m_width;
+		y[i] = (0.5f - 0.5f * clip[i][1] * invW) * m_height;
+		depth[i] = clip[i][2] * invW;
+	}
+
+	// Pixels whose center is inside the screen space bounds
+	FTriangle triangle;
+	triangle.m_minX = std::max((int32_t)std::ceil(std::min({ x[0], x[1], x[2] }) - 0.5f), 0);
+	triangle.m_minY = std::max((int32_t)std::ceil(std::min({ y[0], y[1], y[2] }) - 0.5f), 0);
+	triangle.m_maxX = std::min((int32_t)std::floor(std::max({ x[0], x[1], x[2] }) - 0.5f), (int32_t)m_width - 1);
+	triangle.m_maxY = std::min((int32_t)std::floor(std::max({ y[0], y[1], y[2] }) - 0.5f), (int32_t)m_height - 1);
+	if (triangle.m_minX > triangle.m_maxX || triangle.m_minY > triangle.m_maxY)
+	{
+		return;
+	}
+
+	const float area = (x[1] - x[0]) * (y[2] - y[0]) - (y[1] - y[0]) * (x[2] - x[0]);
+	if (std::abs(area) < 1e-6f)
+	{
+		return;
+	}
+
+	// Edge k is opposite vertex k and evaluates to the area at that vertex. Occluders are rasterized double sided.
+	const float sign = area > 0.f ? 1.f : -1.f;
+	const float invArea = 1.f / std::abs(area);
+	triangle.m_depthA = triangle.m_depthB = triangle.m_depthC = 0.f;
+	for (int k = 0; k < 3; ++k)
+	{
+		const int i = (k + 1) % 3;
+		const int j = (k + 2) % 3;
+		triangle.m_edgeA[k] = sign * (y[i] - y[j]);
+		triangle.m_edgeB[k] = sign * (x[j] - x[i]);
+		triangle.m_edgeC[k] = sign * ((y[j] - y[i]) * x[i] - (x[j] - x[i]) * y[i]);
+
+		triangle.m_depthA += triangle.m_edgeA[k] * depth[k] * invArea;
+		triangle.m_depthB += triangle.m_edgeB[k] * depth[k] * invArea;
+		triangle.m_depthC += triangle.m_edgeC[k] * depth[k] * invArea;
+	}
+
+	// Pixel centers on an edge or a vertex shared by several triangles can round to outside all of them. Grow the edges by a
+	// fraction of a pixel to keep meshes watertight, coverage is only sampled at pixel centers anyway.
+	for (int k = 0; k < 3; ++k)
+	{
+		triangle.m_edgeC[k] += (std::abs(triangle.m_edgeA[k]) + std::abs(triangle.m_edgeB[k])) / 256.f;
+	}
+
+	const uint32_t triangleIndex = (uint32_t)m_triangles.size();
+	m_triangles.push_back(triangle);
+
+	for (int32_t ty = triangle.m_minY / (int32_t)k_tileHeight; ty <= triangle.m_maxY / (int32_t)k_tileHeight; ++ty)
+	{
+		for (int32_t tx = triangle.m_minX / (int32_t)k_tileWidth; tx <= triangle.m_maxX / (int32_t)k_tileWidth; ++tx)
+		{
+			m_tileBins[ty * m_tilesX + tx].push_back(triangleIndex);
+		}
+	}
+}
+
+void Occlusion::FDepthBuffer::RasterizeTile(const uint32_t tileIndex)
+{
+	const int32_t tileX = (tileIndex % m_tilesX) * k_tileWidth;
+	const int32_t tileY = (tileIndex / m_tilesX) * k_tileHeight;
+
+	for (const uint32_t triangleIndex : m_tileBins[tileIndex])
+	{
+		const FTriangle& triangle = m_triangles[triangleIndex];
+		const int32_t x0 = std::max(triangle.m_minX, tileX) & ~7;
+		const int32_t x1 = std::min(triangle.m_maxX, tileX + (int32_t)k_tileWidth - 1);
+		const int32_t y0 = std::max(triangle.m_minY, tileY);
+		const int32_t y1 = std::min(triangle.m_maxY, tileY + (int32_t)k_tileHeight - 1);
+
+		FSpan span;
+		std::copy_n(triangle.m_edgeA, 3, span.m_edgeA);
+		span.m_depthA = triangle.m_depthA;
+		for (int32_t y = y0; y <= y1; ++y)
+		{
+			const float centerY = y + 0.5f;
+			for (int k = 0; k < 3; ++k)
+			{
+				span.m_edgeRow[k] = triangle.m_edgeB[k] * centerY + triangle.m_edgeC[k];
+			}
+
+			span.m_depthRow = triangle.m_depthB * centerY + triangle.m_depthC;
+			for (int32_t x = x0; x <= x1; x += 8)
+			{
+				span.m_depth = &m_depth[y * m_width + x];
+				span.m_x = (float)x;
+				RasterizeSpan(span);
+			}
+		}
+	}
+
+	// Farthest depth of the tile, boxes behind it are hidden anywhere in the tile
+	float farthestDepth = 1.f;
+	for (uint32_t y = 0; y < k_tileHeight; ++y)
+	{
+		const float* row = &m_depth[(tileY + y) * m_width + tileX];
+		farthestDepth = std::min(farthestDepth, *std::min_element(row, row + k_tileWidth));
+	}
+
+	m_tileFarthestDepth[tileIndex] = farthestDepth;
+}
+
+bool Occlusion::FDepthBuffer::IsVisible(const float center[3], const float extents[3]) const
+{
+	// Screen space bounds and nearest depth of the box corners
+	float minX = std::numeric_limits<float>::max(), minY = minX;
+	float maxX = -minX, maxY = -minX;
+	float nearestDepth = 0.f;
+	for (int corner = 0; corner < 8; ++corner)
+	{
+		const float p[3] = {
+			center[0] + (corner & 1 ? extents[0] : -extents[0]),
+			center[1] + (corner & 2 ? extents[1] : -extents[1]),
+			center[2] + (corner & 4 ? extents[2] : -extents[2]) };
+
+		float clip[4];
+		TransformPoint(clip, p, m_worldToClip);
+		if (GetNearDistance(clip) < 0.f || clip[3] <= 0.f)
+		{
+			return true;
+		}
+
+		const float invW = 1.f / clip[3];
+		const float x = (0.5f + 0.5f * clip[0] * invW) * m_width;
+		const float y = (0.5f - 0.5f * clip[1] * invW) * m_height;
+		minX = std::min(minX, x);
+		maxX = std::max(maxX, x);
+		minY = std::min(minY, y);
+		maxY = std::max(maxY, y);
+		nearestDepth = std::max(nearestDepth, clip[2] * invW);
+	}
+
+	// Every pixel the box touches, not just the pixel centers it covers
+	const int32_t x0 = std::max((int32_t)std::floor(minX), 0);
+	const int32_t y0 = std::max((int32_t)std::floor(minY), 0);
+	const int32_t x1 = std::min((int32_t)std::floor(maxX), (int32_t)m_width - 1);
+	const int32_t y1 = std::min((int32_t)std::floor(maxY), (int32_t)m_height - 1);
+	if (x0 > x1 || y0 > y1)
+	{
+		return false;
+	}
+
+	for (int32_t ty = y0 / (int32_t)k_tileHeight; ty <= y1 / (int32_t)k_tileHeight; ++ty)
+	{
+		for (int32_t tx = x0 / (int32_t)k_tileWidth; tx <= x1 / (int32_t)k_tileWidth; ++tx)
+		{
+			// Hierarchical test first, then the pixels of the tile
+			if (nearestDepth < m_tileFarthestDepth[ty * m_tilesX + tx])
+			{
+				continue;
+			}
+
+			const int32_t tileX0 = std::max(x0, tx * (int32_t)k_tileWidth);
+			const int32_t tileX1 = std::min(x1, (tx + 1) * (int32_t)k_tileWidth - 1);
+			const int32_t tileY0 = std::max(y0, ty * (int32_t)k_tileHeight);
+			const int32_t tileY1 = std::min(y1, (ty + 1) * (int32_t)k_tileHeight - 1);
+			for (int32_t y = tileY0; y <= tileY1; ++y)
+			{
+				for (int32_t x = tileX0 & ~7; x <= tileX1; x += 8)
+				{
+					if (IsSpanVisible(&m_depth[y * m_width + x], x, tileX0, tileX1, nearestDepth))
+					{
+						return true;
+					}
+				}
+			}
+		}
+	}
+
+	return false;
+}
+
+size_t Occlusion::FDepthBuffer::CullBoxes(uint32_t* indices, const size_t count, const Bounds::FBoxSoA& boxes) const
+{
+	size_t visibleCount = 0;
+	for (size_t i = 0; i < count; ++i)
+	{
+		const uint32_t index = indices[i];
+		const float center[3] = { boxes.m_centerX[index], boxes.m_centerY[index], boxes.m_centerZ[index] };
+		const float extents[3] = { boxes.m_extentX[index], boxes.m_extentY[index], boxes.m_extentZ[index] };
+		if (IsVisible(center, extents))
+		{
+			indices[visibleCount++] = index;
+		}
+	}
+
+	return visibleCount;
+}
+
+bool Occlusion::FDepthBuffer::SaveImage(const std::filesystem::path& filepath) const
+{
+	std::ofstream file{ filepath, std::ios::binary | std::ios::trunc };
+	if (!file)
+	{
+		return false;
+	}
+
+	// Little endian, rows from the bottom up
+	file << "Pf\n" << m_width << " " << m_height << "\n-1.0\n";
+	for (uint32_t y = m_height; y-- > 0;)
+	{
+		file.write((const char*)&m_depth[y * m_width], m_width * sizeof(float));
+	}
+
+	return (bool)file;
+}
@@ -3,12 +3,363 @@
 #include <profiling.h>
 #include <common.h>
 #include <renderer.h>
+#include <ppl.h>
 #include <ppltasks.h>
 #include <sstream>
+#include <algorithm>
+#include <bit>
+#include <limits>
 #include <imgui.h>
 #include <dxcapi.h>
 #include <microprofile.h>
 
+namespace
+{
+	constexpr size_t k_cullingBatchSize = 4096; // instances per culling task
+
+	// Run of visible instances of a mesh, drawn with a single instanced draw
+	struct FVisibleDraw
+	{
+		uint32_t m_meshIndex;
+		uint32_t m_instanceOffset;
+		uint32_t m_instanceCount;
+	};
+
+	FBvh::Containment TestFrustum(const float planes[][4], const size_t planeCount, const float min[3], const float max[3])
+	{
+		const Vector3 center = 0.5f * (Vector3{ max } + Vector3{ min });
+		const Vector3 extents = 0.5f * (Vector3{ max } - Vector3{ min });
+
+		FBvh::Containment containment = FBvh::Containment::Inside;
+		for (size_t i = 0; i < planeCount; ++i)
+		{
+			const float* plane = planes[i];
+			const float distance = plane[0] * center.x + plane[1] * center.y + plane[2] * center.z + plane[3];
+			const float radius = std::abs(plane[0]) * extents.x + std::abs(plane[1]) * extents.y + std::abs(plane[2]) * extents.z;
+			if (distance + radius < 0.f)
+			{
+				return FBvh::Containment::Outside;
+			}
+
+			if (distance - radius < 0.f)
+			{
+				containment = FBvh::Containment::Intersects;
+			}
+		}
+
+		return containment;
+	}
+
+	bool UseBvhCulling(const FScene& scene)
+	{
+		const size_t instanceCount = scene.m_instanceWorldBounds.Size();
+		return instanceCount >= Settings::k_bvhCullingMinInstances && scene.m_instanceBvh.GetPrimitiveCount() == instanceCount;
+	}
+
+	// Rasterizes the nearest visible occluders into a software depth buffer, tile by tile on the worker threads, and drops the
+	// instances they hide. Returns the new visible count, in instance order.
+	size_t OcclusionCull(std::vector<uint32_t>& visibleInstances, const size_t visibleCount, const FScene& scene, const Matrix& viewProjection, const Vector3& viewPosition,
+		const float planes[][4], const size_t planeCount)
+	{
+		SCOPED_CPU_EVENT(L"occlusion_culling", 0);
+
+		std::vector<std::pair<float, uint32_t>> occluderInstances;
+		for (size_t i = 0; i < visibleCount; ++i)
+		{
+			const uint32_t instanceIndex = visibleInstances[i];
+			const uint32_t meshIndex = scene.m_instanceMeshIndices[instanceIndex];
+			if (meshIndex < scene.m_occluders.size() && !scene.m_occluders[meshIndex].m_indices.empty())
+			{
+				const Bounds::FBoxSoA& bounds = scene.m_instanceWorldBounds;
+				const Vector3 center{ bounds.m_centerX[instanceIndex], bounds.m_centerY[instanceIndex], bounds.m_centerZ[instanceIndex] };
+				occluderInstances.emplace_back(Vector3::DistanceSquared(center, viewPosition), instanceIndex);
+			}
+		}
+
+		std::sort(occluderInstances.begin(), occluderInstances.end());
+
+		Occlusion::FDepthBuffer depthBuffer{ Settings::k_occlusionBufferWidth, Settings::k_occlusionBufferHeight };
+		depthBuffer.Begin((const float*)&viewProjection);
+
+		size_t occluderTriangleCount = 0;
+		for (const auto& [distance, instanceIndex] : occluderInstances)
+		{
+			const Occlusion::FOccluder& occluder = scene.m_occluders[scene.m_instanceMeshIndices[instanceIndex]];
+			if (occluderTriangleCount + occluder.m_indices.size() / 3 > Settings::k_occluderTriangleBudget)
+			{
+				break;
+			}
+
+			const Matrix localToWorld = scene.m_instanceTransforms[instanceIndex] * scene.m_rootTransform;
+			depthBuffer.AddOccluder(occluder, (const float*)&localToWorld);
+			occluderTriangleCount += occluder.m_indices.size() / 3;
+		}
+
+		concurrency::parallel_for(0u, depthBuffer.GetTileCount(), [&depthBuffer](const uint32_t tileIndex)
+		{
+			depthBuffer.RasterizeTile(tileIndex);
+		});
+
+		size_t unoccludedCount = 0;
+		if (UseBvhCulling(scene))
+		{
+			// Traverse the hierarchy again so that whole hidden subtrees are rejected with one test
+			unoccludedCount = scene.m_instanceBvh.Cull(visibleInstances.data(), scene.m_instanceWorldBounds, [&](const float min[3], const float max[3])
+			{
+				if (TestFrustum(planes, planeCount, min, max) == FBvh::Containment::Outside)
+				{
+					return FBvh::Containment::Outside;
+				}
+
+				const float center[3] = { 0.5f * (min[0] + max[0]), 0.5f * (min[1] + max[1]), 0.5f * (min[2] + max[2]) };
+				const float extents[3] = { 0.5f * (max[0] - min[0]), 0.5f * (max[1] - min[1]), 0.5f * (max[2] - min[2]) };
+				return depthBuffer.IsVisible(center, extents) ? FBvh::Containment::Intersects : FBvh::Containment::Outside;
+			});
+
+			std::sort(visibleInstances.begin(), visibleInstances.begin() + unoccludedCount);
+		}
+		else
+		{
+			unoccludedCount = depthBuffer.CullBoxes(visibleInstances.data(), visibleCount, scene.m_instanceWorldBounds);
+		}
+
+		MICROPROFILE_COUNTER_SET("culling/occluder_triangles", occluderTriangleCount);
+		MICROPROFILE_COUNTER_SET("culling/occluded_instances", visibleCount - unoccludedCount);
+
+		return unoccludedCount;
+	}
+
+	// Tests the world bounds of every instance against the view frustum, and against the occluders if enabled, and groups
+	// the visible instances into draws. Large scenes are culled through the instance BVH, small ones in batches on the worker
+	// threads.
+	std::vector<FVisibleDraw> CullScene(const FScene& scene, const FView& view)
+	{
+		SCOPED_CPU_EVENT(L"frustum_culling", 0);
+
+		const Matrix viewProjection = view.m_viewTransform * view.m_projectionTransform;
+		float planes[6][4];
+		const size_t planeCount = Bounds::GetFrustumPlanes(planes, (const float*)&viewProjection);
+
+		const size_t instanceCount = scene.m_instanceWorldBounds.Size();
+		std::vector<uint32_t> visibleInstances(instanceCount);
+		size_t visibleCount = 0;
+		if (UseBvhCulling(scene))
+		{
+			visibleCount = scene.m_instanceBvh.Cull(visibleInstances.data(), scene.m_instanceWorldBounds, [&](const float min[3], const float max[3])
+			{
+				return TestFrustum(planes, planeCount, min, max);
+			});
+
+			// Back to instance order so that instances of a mesh form runs
+			std::sort(visibleInstances.begin(), visibleInstances.begin() + visibleCount);
+		}
+		else
+		{
+			const size_t batchCount = (instanceCount + k_cullingBatchSize - 1) / k_cullingBatchSize;
+			std::vector<size_t> batchVisibleCounts(batchCount);
+			concurrency::parallel_for(size_t(0), batchCount, [&](const size_t batch)
+			{
+				const size_t begin = batch * k_cullingBatchSize;
+				const size_t end = std::min(begin + k_cullingBatchSize, instanceCount);
+				batchVisibleCounts[batch] = Bounds::CullBoxes(&visibleInstances[begin], scene.m_instanceWorldBounds, begin, end, planes, planeCount);
+			});
+
+			// Compact the batches, in instance order
+			for (size_t batch = 0; batch < batchCount; ++batch)
+			{
+				std::copy_n(&visibleInstances[batch * k_cullingBatchSize], batchVisibleCounts[batch], &visibleInstances[visibleCount]);
+				visibleCount += batchVisibleCounts[batch];
+			}
+		}
+
+		MICROPROFILE_COUNTER_SET("culling/frustum_culled_instances", instanceCount - visibleCount);
+
+		if (Settings::k_occlusionCulling)
+		{
+			visibleCount = OcclusionCull(visibleInstances, visibleCount, scene, viewProjection, view.m_position, planes, planeCount);
+		}
+
+		// Instances are grouped by mesh so every run of consecutive visible instances of a mesh becomes one draw. Meshes
+		// that are still streaming in are skipped.
+		std::vector<FVisibleDraw> draws;
+		for (size_t i = 0; i < visibleCount; ++i)
+		{
+			const uint32_t instanceIndex = visibleInstances[i];
+			const uint32_t meshIndex = scene.m_instanceMeshIndices[instanceIndex];
+			if (meshIndex >= scene.m_meshGeo.size())
+			{
+				continue;
+			}
+
+			if (!draws.empty() && draws.back().m_meshIndex == meshIndex && draws.back().m_instanceOffset + draws.back().m_instanceCount == instanceIndex)
+			{
+				draws.back().m_instanceCount++;
+			}
+			else
+			{
+				draws.push_back({ meshIndex, instanceIndex, 1 });
+			}
+		}
+
+		MICROPROFILE_COUNTER_SET("culling/visible_instances", visibleCount);
+		MICROPROFILE_COUNTER_SET("culling/draws", draws.size());
+
+		return draws;
+	}
+
+	// Coarsest LOD whose simplification error projects to less than Settings::k_lodErrorThreshold pixels on screen. All the
+	// instances of a draw share a LOD, so the closest instance decides.
+	uint32_t SelectMeshLod(const FRenderMesh& mesh, const FScene& scene, const FVisibleDraw& draw, const FView& view, const uint32_t resY)
+	{
+		uint32_t selectedLod = mesh.m_lodCount - 1;
+		for (uint32_t instanceIndex = draw.m_instanceOffset; instanceIndex < draw.m_instanceOffset + draw.m_instanceCount && selectedLod > 0; ++instanceIndex)
+		{
+			const Matrix& localToWorld = scene.m_instanceTransforms[instanceIndex];
+			const Bounds::FBoxSoA& worldBounds = scene.m_instanceWorldBounds;
+			const Vector3 center{ worldBounds.m_centerX[instanceIndex], worldBounds.m_centerY[instanceIndex], worldBounds.m_centerZ[instanceIndex] };
+			const Vector3 extents{ worldBounds.m_extentX[instanceIndex], worldBounds.m_extentY[instanceIndex], worldBounds.m_extentZ[instanceIndex] };
+
+			const float distance = (center - view.m_position).Length() - extents.Length();
+			if (distance <= 0.f)
+			{
+				return 0;
+			}
+
+			const float worldScale = std::sqrt(std::max({ localToWorld.Right().LengthSquared(), localToWorld.Up().LengthSquared(), localToWorld.Backward().LengthSquared() }));
+			const float pixelsPerUnit = 0.5f * resY * view.m_projectionTransform._22 / distance;
+
+			uint32_t lod = 0;
+			while (lod < selectedLod && mesh.m_lods[lod + 1].m_error * worldScale * pixelsPerUnit < Settings::k_lodErrorThreshold)
+			{
+				lod++;
+			}
+
+			selectedLod = lod;
+		}
+
+		return selectedLod;
+	}
+
+	// Distance from the view to the closest instance bounds of a draw, 0 if the view is inside one of them
+	float GetNearestDistance(const FScene& scene, const FVisibleDraw& draw, const FView& view)
+	{
+		float nearestDistance = std::numeric_limits<float>::max();
+		for (uint32_t instanceIndex = draw.m_instanceOffset; instanceIndex < draw.m_instanceOffset + draw.m_instanceCount; ++instanceIndex)
+		{
+			const Bounds::FBoxSoA& worldBounds = scene.m_instanceWorldBounds;
+			const Vector3 center{ worldBounds.m_centerX[instanceIndex], worldBounds.m_centerY[instanceIndex], worldBounds.m_centerZ[instanceIndex] };
+			const Vector3 extents{ worldBounds.m_extentX[instanceIndex], worldBounds.m_extentY[instanceIndex], worldBounds.m_extentZ[instanceIndex] };
+			nearestDistance = std::min(nearestDistance, (center - view.m_position).Length() - extents.Length());
+		}
+
+		return std::max(nearestDistance, 0.f);
+	}
+
+	// Sort key, most significant first: pipeline, material and front to back depth bucket
+	constexpr uint32_t k_sortKeyPipelineShift = 56;
+	constexpr uint32_t k_sortKeyMaterialShift = 32;
+	constexpr uint32_t k_sortKeyDepthShift = 16;
+	constexpr uint64_t k_sortKeyMaterialMask = 0xffffff;
+
+	struct FDrawPacket
+	{
+		uint64_t m_sortKey;
+		uint32_t m_pipelineIndex;
+		uint32_t m_meshIndex;
+		uint32_t m_lod;
+		uint32_t m_instanceOffset;
+		uint32_t m_instanceCount;
+	};
+
+	std::vector<FDrawPacket> CreateDrawPackets(const FScene& scene, const FView& view, const uint32_t resY)
+	{
+		std::vector<FDrawPacket> packets;
+		for (const FVisibleDraw& draw : CullScene(scene, view))
+		{
+			const FRenderMesh& mesh = scene.m_meshGeo[draw.m_meshIndex];
+
+			// The upper bits of a positive float are monotonic with its value, which gives buckets of constant relative size
+			const uint64_t depthBucket = std::bit_cast<uint32_t>(GetNearestDistance(scene, draw, view)) >> 16;
+
+			FDrawPacket& packet = packets.emplace_back();
+			packet.m_pipelineIndex = 0;
+			packet.m_meshIndex = draw.m_meshIndex;
+			packet.m_lod = SelectMeshLod(mesh, scene, draw, view, resY);
+			packet.m_instanceOffset = draw.m_instanceOffset;
+			packet.m_instanceCount = draw.m_instanceCount;
+			packet.m_sortKey = (uint64_t)packet.m_pipelineIndex << k_sortKeyPipelineShift |
+				(mesh.m_materialIndex & k_sortKeyMaterialMask) << k_sortKeyMaterialShift |
+				depthBucket << k_sortKeyDepthShift;
+		}
+
+		return packets;
+	}
+
+	// Stable LSD radix sort on the sort keys, one byte per pass. Passes where every key has the same byte are skipped, which
+	// is the case for the unused low bits and for the pipeline while there is a single one.
+	void SortDrawPackets(std::vector<FDrawPacket>& packets)
+	{
+		SCOPED_CPU_EVENT(L"sort_draw_packets", 0);
+
+		uint32_t histograms[8][256] = {};
+		for (const FDrawPacket& packet : packets)
+		{
+			for (uint32_t digit = 0; digit < 8; ++digit)
+			{
+				histograms[digit][(packet.m_sortKey >> (8 * digit)) & 0xff]++;
+			}
+		}
+
+		std::vector<FDrawPacket> scratch(packets.size());
+		for (uint32_t digit = 0; digit < 8 && !packets.empty(); ++digit)
+		{
+			uint32_t* histogram = histograms[digit];
+			if (histogram[(packets[0].m_sortKey >> (8 * digit)) & 0xff] == packets.size())
+			{
+				continue;
+			}
+
+			uint32_t offsets[256];
+			uint32_t offset = 0;
+			for (uint32_t bucket = 0; bucket < 256; ++bucket)
+			{
+				offsets[bucket] = offset;
+				offset += histogram[bucket];
+			}
+
+			for (const FDrawPacket& packet : packets)
+			{
+				scratch[offsets[(packet.m_sortKey >> (8 * digit)) & 0xff]++] = packet;
+			}
+
+			packets.swap(scratch);
+		}
+	}
+
+	struct FStateChanges
+	{
+		size_t m_pipeline;
+		size_t m_material;
+		size_t m_geometry;
+	};
+
+	// State changes the recorder issues for the packets in their current order
+	FStateChanges CountStateChanges(const std::vector<FDrawPacket>& packets, const FScene& scene)
+	{
+		FStateChanges changes = {};
+		for (size_t i = 0; i < packets.size(); ++i)
+		{
+			const FDrawPacket& packet = packets[i];
+			const FDrawPacket* previous = i > 0 ? &packets[i - 1] : nullptr;
+			changes.m_pipeline += !previous || previous->m_pipelineIndex != packet.m_pipelineIndex ? 1 : 0;
+			changes.m_material += !previous || scene.m_meshGeo[previous->m_meshIndex].m_materialIndex != scene.m_meshGeo[packet.m_meshIndex].m_materialIndex ? 1 : 0;
+			changes.m_geometry += !previous || previous->m_meshIndex != packet.m_meshIndex || previous->m_lod != packet.m_lod ? 1 : 0;
+		}
+
+		return changes;
+	}
+}
+
 namespace RenderJob
 {
 	struct BasePassDesc
@@ -58,6 +409,8 @@ namespace RenderJob
 				uint32_t sceneNormalBufferBindlessIndex;
 				uint32_t sceneUvBufferBindlessIndex;
 				FLightProbe sceneProbeData;
+				uint32_t sceneInstanceTransformBufferBindlessIndex;
+				uint32_t sceneMaterialBufferBindlessIndex;
 			};
 
 			std::unique_ptr<FTransientBuffer> frameCb = RenderBackend12::CreateTransientBuffer(
@@ -66,16 +419,24 @@ namespace RenderJob
 				cmdList,
 				[scene = passDesc.scene](uint8_t* pDest)
 				{
+					// Scene buffers do not exist until a streaming scene has published its layout
+					auto GetSrvIndex = [](const std::unique_ptr<FBindlessShaderResource>& buffer)
+					{
+						return buffer ? buffer->m_srvIndex : ~0u;
+					};
+
 					auto cbDest = reinterpret_cast<FrameCbLayout*>(pDest);
 					cbDest->sceneRotation = scene->m_rootTransform;
-					cbDest->sceneIndexBufferBindlessIndex = scene->m_meshIndexBuffer->m_srvIndex;
-					cbDest->scenePositionBufferBindlessIndex = scene->m_meshPositionBuffer->m_srvIndex;
-					cbDest->sceneNormalBufferBindlessIndex = scene->m_meshNormalBuffer->m_srvIndex;
-					cbDest->sceneUvBufferBindlessIndex = scene->m_meshUvBuffer->m_srvIndex;
+					cbDest->sceneIndexBufferBindlessIndex = GetSrvIndex(scene->m_meshIndexBuffer);
+					cbDest->scenePositionBufferBindlessIndex = GetSrvIndex(scene->m_meshPositionBuffer);
+					cbDest->sceneNormalBufferBindlessIndex = GetSrvIndex(scene->m_meshNormalBuffer);
+					cbDest->sceneUvBufferBindlessIndex = GetSrvIndex(scene->m_meshUvBuffer);
 					cbDest->sceneProbeData = scene->m_globalLightProbe;
+					cbDest->sceneInstanceTransformBufferBindlessIndex = GetSrvIndex(scene->m_instanceTransformBuffer);
+					cbDest->sceneMaterialBufferBindlessIndex = GetSrvIndex(scene->m_materialBuffer);
 				});
 
-			d3dCmdList->SetGraphicsRootConstantBufferView(3, frameCb->m_resource->m_d3dResource->GetGPUVirtualAddress());
+			d3dCmdList->SetGraphicsRootConstantBufferView(2, frameCb->m_gpuAddress);
 
 			// View constant buffer
 			struct ViewCbLayout
@@ -95,13 +456,13 @@ namespace RenderJob
 					cbDest->projectionTransform = view->m_projectionTransform;
 				});
 
-			d3dCmdList->SetGraphicsRootConstantBufferView(2, viewCb->m_resource->m_d3dResource->GetGPUVirtualAddress());
+			d3dCmdList->SetGraphicsRootConstantBufferView(1, viewCb->m_gpuAddress);
 
 			D3DDescriptorHeap_t* descriptorHeaps[] = { RenderBackend12::GetBindlessShaderResourceHeap() };
 			d3dCmdList->SetDescriptorHeaps(1, descriptorHeaps);
-			d3dCmdList->SetGraphicsRootDescriptorTable(4, RenderBackend12::GetGPUDescriptor(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, (uint32_t)BindlessDescriptorRange::Texture2DBegin));
-			d3dCmdList->SetGraphicsRootDescriptorTable(5, RenderBackend12::GetGPUDescriptor(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, (uint32_t)BindlessDescriptorRange::BufferBegin));
-			d3dCmdList->SetGraphicsRootDescriptorTable(6, RenderBackend12::GetGPUDescriptor(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, (uint32_t)BindlessDescriptorRange::TextureCubeBegin));
+			d3dCmdList->SetGraphicsRootDescriptorTable(3, RenderBackend12::GetGPUDescriptor(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, (uint32_t)BindlessDescriptorRange::Texture2DBegin));
+			d3dCmdList->SetGraphicsRootDescriptorTable(4, RenderBackend12::GetGPUDescriptor(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, (uint32_t)BindlessDescriptorRange::BufferBegin));
+			d3dCmdList->SetGraphicsRootDescriptorTable(5, RenderBackend12::GetGPUDescriptor(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, (uint32_t)BindlessDescriptorRange::TextureCubeBegin));
 
 			// PSO
 			D3D12_GRAPHICS_PIPELINE_STATE_DESC psoDesc = {};
@@ -120,8 +481,8 @@ namespace RenderJob
 				D3D12_SHADER_BYTECODE& vs = psoDesc.VS;
 				D3D12_SHADER_BYTECODE& ps = psoDesc.PS;
 
-				IDxcBlob* vsBlob = RenderBackend12::CacheShader({ L"base-pass.hlsl", L"vs_main", L"" }, L"vs_6_4");
-				IDxcBlob* psBlob = RenderBackend12::CacheShader({ L"base-pass.hlsl", L"ps_main", L"" }, L"ps_6_4");
+				IDxcBlob* vsBlob = RenderBackend12::CacheShader({ L"base-pass.hlsl", L"vs_main", passDesc.scene->m_quantizedVertices ? L"QUANTIZED_VERTICES=1" : L"QUANTIZED_VERTICES=0" }, L"vs_6_4");
+				IDxcBlob* psBlob = RenderBackend12::CacheShader({ L"base-pass.hlsl", L"ps_main", L"MATERIAL_STRIDE=" + std::to_wstring(sizeof(FMaterial)) }, L"ps_6_4");
 
 				vs.pShaderBytecode = vsBlob->GetBufferPointer();
 				vs.BytecodeLength = vsBlob->GetBufferSize();
@@ -164,8 +525,8 @@ namespace RenderJob
 				desc.StencilEnable = FALSE;
 			}
 
-			D3DPipelineState_t* pso = RenderBackend12::FetchGraphicsPipelineState(psoDesc);
-			d3dCmdList->SetPipelineState(pso);
+			// Indexed by FDrawPacket::m_pipelineIndex
+			D3DPipelineState_t* pipelines[] = { RenderBackend12::FetchGraphicsPipelineState(psoDesc) };
 
 			D3D12_VIEWPORT viewport{ 0.f, 0.f, (float)passDesc.resX, (float)passDesc.resY, 0.f, 1.f };
 			D3D12_RECT screenRect{ 0, 0, (LONG)passDesc.resX, (LONG)passDesc.resY };
@@ -182,69 +543,75 @@ namespace RenderJob
 
 			d3dCmdList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
 			
-			// Issue scene draws
-			for (int meshIndex = 0; meshIndex < passDesc.scene->m_meshGeo.size(); ++meshIndex)
+			// Issue scene draws, one instanced draw per run of visible instances, sorted to minimize state changes
+			std::vector<FDrawPacket> packets = CreateDrawPackets(*passDesc.scene, *passDesc.view, passDesc.resY);
+			const FStateChanges unsortedChanges = CountStateChanges(packets, *passDesc.scene);
+			SortDrawPackets(packets);
+
+			// Draw constants. Between draws of the same mesh LOD only the instance offset changes.
+			struct MeshCbLayout
 			{
-				const FRenderMesh& mesh = passDesc.scene->m_meshGeo[meshIndex];
+				uint32_t indexOffset;
+				uint32_t positionOffset;
+				uint32_t normalOffset;
+				uint32_t uvOffset;
+				uint32_t indexSize;
+				Vector3 positionScale;
+				Vector3 positionBias;
+				uint32_t instanceOffset;
+				uint32_t materialIndex; // into the scene material buffer
+			};
 
-				// Geometry constants
-				struct MeshCbLayout
-				{
-					Matrix localToWorldTransform;
-					uint32_t indexOffset;
-					uint32_t positionOffset;
-					uint32_t normalOffset;
-					uint32_t uvOffset;
-				} meshCb =
+			FStateChanges changes = {};
+			const FDrawPacket* previous = nullptr;
+			for (const FDrawPacket& packet : packets)
+			{
+				const FRenderMesh& mesh = passDesc.scene->m_meshGeo[packet.m_meshIndex];
+				const FRenderMeshLod& lod = mesh.m_lods[packet.m_lod];
+
+				if (!previous || previous->m_pipelineIndex != packet.m_pipelineIndex)
 				{
-					passDesc.scene->m_meshTransforms[meshIndex],
-					passDesc.scene->m_meshGeo[meshIndex].m_indexOffset,
-					passDesc.scene->m_meshGeo[meshIndex].m_positionOffset,
-					passDesc.scene->m_meshGeo[meshIndex].m_normalOffset,
-					passDesc.scene->m_meshGeo[meshIndex].m_uvOffset
-				};	
+					d3dCmdList->SetPipelineState(pipelines[packet.m_pipelineIndex]);
+					changes.m_pipeline++;
+				}
 
-				d3dCmdList->SetGraphicsRoot32BitConstants(0, sizeof(MeshCbLayout)/4, &meshCb, 0);
+				// Materials are read from the scene material buffer, a change only costs the root constants below
+				changes.m_material += !previous || passDesc.scene->m_meshGeo[previous->m_meshIndex].m_materialIndex != mesh.m_materialIndex ? 1 : 0;
 
-				// Material constants
-				struct MaterialCbLayout
+				if (!previous || previous->m_meshIndex != packet.m_meshIndex || previous->m_lod != packet.m_lod)
 				{
-					Vector3 emissiveFactor;
-					float metallicFactor;
-					Vector3 baseColorFactor;
-					float roughnessFactor;
-					int baseColorTextureIndex;
-					int metallicRoughnessTextureIndex;
-					int normalTextureIndex;
-					int baseColorSamplerIndex;
-					int metallicRoughnessSamplerIndex;
-					int normalSamplerIndex;
-				};
-
-				std::unique_ptr<FTransientBuffer> materialCb = RenderBackend12::CreateTransientBuffer(
-					L"material_cb",
-					sizeof(MaterialCbLayout),
-					cmdList,
-					[&mesh](uint8_t* pDest)
+					const MeshCbLayout meshCb =
 					{
-						auto cbDest = reinterpret_cast<MaterialCbLayout*>(pDest);
-						cbDest->emissiveFactor = mesh.m_emissiveFactor;
-						cbDest->metallicFactor = mesh.m_metallicFactor;
-						cbDest->baseColorFactor = mesh.m_baseColorFactor;
-						cbDest->roughnessFactor = mesh.m_roughnessFactor;
-						cbDest->baseColorTextureIndex = mesh.m_baseColorTextureIndex;
-						cbDest->metallicRoughnessTextureIndex = mesh.m_metallicRoughnessTextureIndex;
-						cbDest->normalTextureIndex = mesh.m_normalTextureIndex;
-						cbDest->baseColorSamplerIndex = mesh.m_baseColorSamplerIndex;
-						cbDest->metallicRoughnessSamplerIndex = mesh.m_metallicRoughnessSamplerIndex;
-						cbDest->normalSamplerIndex = mesh.m_normalSamplerIndex;
-					});
-
-				d3dCmdList->SetGraphicsRootConstantBufferView(1, materialCb->m_resource->m_d3dResource->GetGPUVirtualAddress());
+						lod.m_indexOffset,
+						mesh.m_positionOffset,
+						mesh.m_normalOffset,
+						mesh.m_uvOffset,
+						mesh.m_indexFormat == DXGI_FORMAT_R16_UINT ? 2u : 4u,
+						mesh.m_positionScale,
+						mesh.m_positionBias,
+						packet.m_instanceOffset,
+						mesh.m_materialIndex
+					};
+
+					d3dCmdList->SetGraphicsRoot32BitConstants(0, sizeof(MeshCbLayout) / 4, &meshCb, 0);
+					changes.m_geometry++;
+				}
+				else
+				{
+					d3dCmdList->SetGraphicsRoot32BitConstant(0, packet.m_instanceOffset, offsetof(MeshCbLayout, instanceOffset) / 4);
+				}
 
-				d3dCmdList->DrawInstanced(mesh.m_indexCount, 1, 0, 0);
+				d3dCmdList->DrawInstanced(lod.m_indexCount, packet.m_instanceCount, 0, 0);
+				previous = &packet;
 			}
-	
+
+			MICROPROFILE_COUNTER_SET("base_pass/pipeline_changes_unsorted", unsortedChanges.m_pipeline);
+			MICROPROFILE_COUNTER_SET("base_pass/material_changes_unsorted", unsortedChanges.m_material);
+			MICROPROFILE_COUNTER_SET("base_pass/geometry_changes_unsorted", unsortedChanges.m_geometry);
+			MICROPROFILE_COUNTER_SET("base_pass/pipeline_changes", changes.m_pipeline);
+			MICROPROFILE_COUNTER_SET("base_pass/material_changes", changes.m_material);
+			MICROPROFILE_COUNTER_SET("base_pass/geometry_changes", changes.m_geometry);
+
 			return cmdList;
 		});
 	}
@@ -361,7 +728,11 @@ namespace RenderJob
 			constants.invParallaxViewProjMatrix = (parallaxViewMatrix * passDesc.view->m_projectionTransform).Invert();
 			d3dCmdList->SetGraphicsRoot32BitConstants(0, sizeof(CbLayout) / 4, &constants, 0);
 
-			d3dCmdList->DrawInstanced(3, 1, 0, 0);
+			// The environment map is not available until the scene has finished streaming in
+			if (constants.envmapTextureIndex != -1)
+			{
+				d3dCmdList->DrawInstanced(3, 1, 0, 0);
+			}
 
 			return cmdList;
 		});
@@ -430,7 +801,7 @@ namespace RenderJob
 					});
 
 				D3D12_VERTEX_BUFFER_VIEW vbDescriptor = {};
-				vbDescriptor.BufferLocation = vtxBuffer->m_resource->m_d3dResource->GetGPUVirtualAddress();
+				vbDescriptor.BufferLocation = vtxBuffer->m_gpuAddress;
 				vbDescriptor.SizeInBytes = vtxBufferSize;
 				vbDescriptor.StrideInBytes = sizeof(ImDrawVert);
 				d3dCmdList->IASetVertexBuffers(0, 1, &vbDescriptor);
@@ -454,7 +825,7 @@ namespace RenderJob
 					});
 
 				D3D12_INDEX_BUFFER_VIEW ibDescriptor = {};
-				ibDescriptor.BufferLocation = idxBuffer->m_resource->m_d3dResource->GetGPUVirtualAddress();
+				ibDescriptor.BufferLocation = idxBuffer->m_gpuAddress;
 				ibDescriptor.SizeInBytes = idxBufferSize;
 				ibDescriptor.Format = sizeof(ImDrawIdx) == 2 ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT;
 				d3dCmdList->IASetIndexBuffer(&ibDescriptor);
@@ -4,6 +4,7 @@
 #include <sstream>
 #include <filesystem>
 #include <cassert>
+#include <cstdio>
 
 struct ModuleProcs
 {
@@ -11,6 +12,7 @@ struct ModuleProcs
 	decltype(Demo::Teardown)* teardown;
 	decltype(Demo::Tick)* tick;
 	decltype(Demo::Render)* render;
+	decltype(Demo::GetLoadState)* getLoadState;
 	decltype(Demo::OnMouseMove)* mouseMove;
 	decltype(Demo::WndProcHandler)* wndProc;
 };
@@ -45,6 +47,7 @@ bool LoadModule(LPCWSTR modulePath, LPCWSTR moduleName, HMODULE& moduleHnd, Modu
 	exportedProcs.teardown = reinterpret_cast<decltype(Demo::Teardown)*>(GetProcAddress(moduleHnd, "Teardown"));
 	exportedProcs.tick = reinterpret_cast<decltype(Demo::Tick)*>(GetProcAddress(moduleHnd, "Tick"));
 	exportedProcs.render = reinterpret_cast<decltype(Demo::Render)*>(GetProcAddress(moduleHnd, "Render"));
+	exportedProcs.getLoadState = reinterpret_cast<decltype(Demo::GetLoadState)*>(GetProcAddress(moduleHnd, "GetLoadState"));
 	exportedProcs.mouseMove = reinterpret_cast<decltype(Demo::OnMouseMove)*>(GetProcAddress(moduleHnd, "OnMouseMove"));
 	exportedProcs.wndProc = reinterpret_cast<decltype(Demo::WndProcHandler)*>(GetProcAddress(moduleHnd, "WndProcHandler"));
 
@@ -86,6 +89,25 @@ void ErrorExit(LPTSTR lpszFunction)
 	ExitProcess(dw);
 }
 
+// The headless run reports to the console it was started from, or to the std handles it inherited when its output is
+// redirected, as when it runs under ctest
+void AttachParentConsole()
+{
+	if (!GetStdHandle(STD_OUTPUT_HANDLE) && AttachConsole(ATTACH_PARENT_PROCESS))
+	{
+		FILE* stream;
+		freopen_s(&stream, "CONOUT$", "w", stdout);
+		freopen_s(&stream, "CONOUT$", "w", stderr);
+	}
+}
+
+void HeadlessReport(FILE* stream, const std::string& message)
+{
+	fputs(message.c_str(), stream);
+	fflush(stream);
+	OutputDebugStringA(message.c_str());
+}
+
 bool GetFileLastWriteTime(LPCWSTR filePath, FILETIME& writeTime)
 {
 	_WIN32_FILE_ATTRIBUTE_DATA fileAttributeData{};
@@ -150,7 +172,7 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam)
 	return DefWindowProc(hWnd, msg, wParam, lParam);
 }
 
-bool InitializeWindow(HINSTANCE instanceHandle, HWND& windowHandle, const uint32_t resX, const uint32_t resY)
+bool InitializeWindow(HINSTANCE instanceHandle, HWND& windowHandle, const uint32_t resX, const uint32_t resY, const bool visible)
 {
 	WNDCLASS desc;
 	desc.style = CS_HREDRAW | CS_VREDRAW;
@@ -166,7 +188,10 @@ bool InitializeWindow(HINSTANCE instanceHandle, HWND& windowHandle, const uint32
 
 	if (!RegisterClass(&desc))
 	{
-		MessageBox(nullptr, TEXT("Failed to register window"), nullptr, 0);
+		if (visible)
+		{
+			MessageBox(nullptr, TEXT("Failed to register window"), nullptr, 0);
+		}
 		return false;
 	}
 
@@ -187,13 +212,20 @@ bool InitializeWindow(HINSTANCE instanceHandle, HWND& windowHandle, const uint32
 
 	if (!windowHandle)
 	{
-		MessageBox(nullptr, TEXT("Failed to create window"), nullptr, 0);
+		if (visible)
+		{
+			MessageBox(nullptr, TEXT("Failed to create window"), nullptr, 0);
+		}
 		return false;
 	}
 	else
 	{
-		ShowWindow(windowHandle, SW_SHOW);
-		UpdateWindow(windowHandle);
+		if (visible)
+		{
+			ShowWindow(windowHandle, SW_SHOW);
+			UpdateWindow(windowHandle);
+		}
+
 		return true;
 	}
 }
@@ -217,7 +249,34 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR pCmdLine,
 	float elapsedSeconds = 0.016;
 	QueryPerformanceFrequency(&counterFrequency);
 
-	InitializeWindow(hInstance, windowHandle, windowWidth, windowHeight);
+	// Headless mode waits for the scene to load, then runs a fixed number of frames without showing the window and reports
+	// the average CPU frame time. Fails if initialization or loading fails, or if the scene is still loading after the timeout.
+	const bool headless = strstr(pCmdLine, "-headless") != nullptr;
+	const char* frameCountArg = strstr(pCmdLine, "-frames=");
+	const int headlessFrameCount = frameCountArg ? atoi(frameCountArg + strlen("-frames=")) : 1000;
+	const double headlessLoadTimeout = 300.0;
+	int frameIndex = 0;
+	double totalSeconds = 0.0;
+	LARGE_INTEGER headlessStartTime;
+	QueryPerformanceCounter(&headlessStartTime);
+
+	if (headless)
+	{
+		AttachParentConsole();
+
+		if (headlessFrameCount <= 0)
+		{
+			HeadlessReport(stderr, "*** Headless : -frames must be a positive frame count\n");
+			return 2;
+		}
+	}
+
+	if (!InitializeWindow(hInstance, windowHandle, windowWidth, windowHeight, !headless) && headless)
+	{
+		HeadlessReport(stderr, "*** Headless : failed to create the window\n");
+		return 1;
+	}
+
 	CleanTempFiles(LIB_DEMO_DIR, LIB_DEMO_NAME L"_");
 
 	while (msg.wParam != VK_ESCAPE)
@@ -235,10 +294,24 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR pCmdLine,
 
 				if (!LoadModule(LIB_DEMO_DIR, LIB_DEMO_NAME, demoDll, s_demoProcs))
 				{
+					if (headless)
+					{
+						HeadlessReport(stderr, "*** Headless : failed to load the demo module\n");
+						DestroyWindow(windowHandle);
+						return 1;
+					}
+
 					ErrorExit((LPTSTR)TEXT("LoadModule"));
 				}
 				
-				s_demoProcs.init(windowHandle, windowWidth, windowHeight);
+				// The headless smoke run reports a failed initialization through the exit code
+				if (!s_demoProcs.init(windowHandle, windowWidth, windowHeight) && headless)
+				{
+					HeadlessReport(stderr, "*** Headless : initialization failed\n");
+					DestroyWindow(windowHandle);
+					return 1;
+				}
+
 				lastWriteTimestamp = currentWriteTimestamp;
 			}
 		}
@@ -260,6 +333,44 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR pCmdLine,
 			s_demoProcs.render(windowWidth, windowHeight);
 			QueryPerformanceCounter(&endTime);
 			elapsedSeconds = (endTime.QuadPart - startTime.QuadPart) / (float) counterFrequency.QuadPart;
+
+			if (headless)
+			{
+				// Frames are only counted once the scene is fully streamed in
+				const Demo::LoadState loadState = s_demoProcs.getLoadState();
+				const double runSeconds = (endTime.QuadPart - headlessStartTime.QuadPart) / (double) counterFrequency.QuadPart;
+				if (loadState == Demo::LoadState::Loaded)
+				{
+					totalSeconds += elapsedSeconds;
+					if (++frameIndex == headlessFrameCount)
+					{
+						std::ostringstream out;
+						out << "*** Headless : " << frameIndex << " frames, " << 1000.0 * totalSeconds / frameIndex << " ms/frame" << std::endl;
+						HeadlessReport(stdout, out.str());
+
+						s_demoProcs.teardown(windowHandle);
+						DestroyWindow(windowHandle);
+						return 0;
+					}
+				}
+				else if (loadState == Demo::LoadState::Failed || runSeconds > headlessLoadTimeout)
+				{
+					std::ostringstream out;
+					if (loadState == Demo::LoadState::Failed)
+					{
+						out << "*** Headless : scene failed to load" << std::endl;
+					}
+					else
+					{
+						out << "*** Headless : scene still loading after " << headlessLoadTimeout << " s" << std::endl;
+					}
+					HeadlessReport(stderr, out.str());
+
+					s_demoProcs.teardown(windowHandle);
+					DestroyWindow(windowHandle);
+					return 1;
+				}
+			}
 		}
 	}
 
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <sstream>
+#include <string>
+
+// Failed checks of a test, printed after its summary
+struct FCheckReport
+{
+	void Check(const bool success, const std::string& what)
+	{
+		m_passed = m_passed && success;
+		if (!success)
+		{
+			m_stream << "  FAILED: " << what << "\n";
+		}
+	}
+
+	std::stringstream m_stream;
+	bool m_passed = true;
+};
@@ -0,0 +1,192 @@
+#include <mesh-optimizer.h>
+#include <check.h>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <iostream>
+#include <numeric>
+#include <random>
+
+using namespace MeshOptimizer;
+
+namespace
+{
+	// Every triangle rotated to start from its smallest index, which keeps the winding, in sorted order
+	std::vector<std::array<uint32_t, 3>> GetSortedTriangles(const uint32_t* indices, const size_t indexCount)
+	{
+		std::vector<std::array<uint32_t, 3>> triangles(indexCount / 3);
+		for (size_t i = 0; i < triangles.size(); ++i)
+		{
+			const uint32_t* t = &indices[3 * i];
+			const size_t first = t[0] < t[1] ? (t[0] < t[2] ? 0 : 2) : (t[1] < t[2] ? 1 : 2);
+			triangles[i] = { t[first], t[(first + 1) % 3], t[(first + 2) % 3] };
+		}
+
+		std::sort(triangles.begin(), triangles.end());
+		return triangles;
+	}
+}
+
+// The cache, overdraw and fetch passes must keep every input triangle and the cache pass must lower the ACMR of shuffled and
+// scan order triangles
+bool CheckVertexCacheOptimization()
+{
+	FCheckReport check;
+	const FTestMesh mesh = CreateTestMesh(128, 256);
+	const size_t vertexCount = mesh.m_positions.size() / 3;
+	const size_t indexCount = mesh.m_indices.size();
+	const std::vector<std::array<uint32_t, 3>> sourceTriangles = GetSortedTriangles(mesh.m_indices.data(), indexCount);
+
+	// Scan order reuses the previous row of vertices only when it fits in the cache, shuffled order hardly reuses anything
+	std::vector<uint32_t> shuffled = mesh.m_indices;
+	{
+		std::vector<uint32_t> order(indexCount / 3);
+		std::iota(order.begin(), order.end(), 0);
+		std::shuffle(order.begin(), order.end(), std::mt19937{ 1 });
+		for (size_t i = 0; i < order.size(); ++i)
+		{
+			std::copy_n(&mesh.m_indices[3 * order[i]], 3, &shuffled[3 * i]);
+		}
+	}
+
+	const FVertexCacheStats scanStats = AnalyzeVertexCache(mesh.m_indices.data(), indexCount, vertexCount);
+	const FVertexCacheStats shuffledStats = AnalyzeVertexCache(shuffled.data(), indexCount, vertexCount);
+
+	std::vector<uint32_t> scanOptimized(indexCount);
+	OptimizeVertexCache(scanOptimized.data(), mesh.m_indices.data(), indexCount, vertexCount);
+	const FVertexCacheStats scanOptimizedStats = AnalyzeVertexCache(scanOptimized.data(), indexCount, vertexCount);
+	check.Check(GetSortedTriangles(scanOptimized.data(), indexCount) == sourceTriangles, "vertex cache order of scan order triangles is not a permutation of the input");
+	check.Check(scanOptimizedStats.m_acmr < 0.8f * scanStats.m_acmr, "vertex cache order of scan order triangles lowers the ACMR by less than 20%");
+
+	std::vector<uint32_t> clusters;
+	std::vector<uint32_t> cacheOptimized(indexCount);
+	OptimizeVertexCache(cacheOptimized.data(), shuffled.data(), indexCount, vertexCount, k_vertexCacheSize, &clusters);
+	const FVertexCacheStats cacheOptimizedStats = AnalyzeVertexCache(cacheOptimized.data(), indexCount, vertexCount);
+	check.Check(GetSortedTriangles(cacheOptimized.data(), indexCount) == sourceTriangles, "vertex cache order of shuffled triangles is not a permutation of the input");
+	check.Check(cacheOptimizedStats.m_acmr < 0.3f * shuffledStats.m_acmr, "vertex cache order of shuffled triangles lowers the ACMR by less than 70%");
+	check.Check(!clusters.empty() && clusters.front() == 0 && std::is_sorted(clusters.begin(), clusters.end()) && clusters.back() < indexCount && clusters.back() % 3 == 0,
+		"vertex cache clusters are not ordered triangle offsets");
+
+	// Overdraw order moves whole clusters around and only splits them where the local cache efficiency stays close to the mesh's
+	std::vector<uint32_t> overdrawOptimized(indexCount);
+	OptimizeOverdraw(overdrawOptimized.data(), cacheOptimized.data(), indexCount, mesh.m_positions.data(), 3 * sizeof(float), vertexCount, clusters);
+	const FVertexCacheStats overdrawOptimizedStats = AnalyzeVertexCache(overdrawOptimized.data(), indexCount, vertexCount);
+	check.Check(GetSortedTriangles(overdrawOptimized.data(), indexCount) == sourceTriangles, "overdraw order is not a permutation of the input");
+	check.Check(overdrawOptimizedStats.m_acmr < 1.15f * cacheOptimizedStats.m_acmr, "overdraw order gives back more than 15% of the vertex cache gain");
+
+	// Fetch order renumbers vertices by first use without changing the triangles
+	std::vector<uint32_t> remap;
+	std::vector<uint32_t> fetchOptimized = overdrawOptimized;
+	OptimizeVertexFetch(remap, fetchOptimized.data(), indexCount, vertexCount);
+
+	std::vector<uint32_t> sortedRemap = remap;
+	std::sort(sortedRemap.begin(), sortedRemap.end());
+	std::vector<uint32_t> identity(vertexCount);
+	std::iota(identity.begin(), identity.end(), 0);
+	check.Check(sortedRemap == identity, "vertex fetch remap is not a permutation of the vertices");
+
+	bool remapped = remap.size() == vertexCount, firstUseOrder = true;
+	uint32_t nextVertex = 0;
+	for (size_t i = 0; i < indexCount && remapped; ++i)
+	{
+		remapped = fetchOptimized[i] == remap[overdrawOptimized[i]];
+		firstUseOrder = firstUseOrder && fetchOptimized[i] <= nextVertex;
+		nextVertex = std::max(nextVertex, fetchOptimized[i] + 1);
+	}
+
+	check.Check(remapped, "vertex fetch indices do not match the remapped input");
+	check.Check(firstUseOrder, "vertex fetch order does not number vertices in order of first use");
+
+	std::cout << "Mesh optimizer vertex cache checks on " << indexCount / 3 << " triangles: " << (check.m_passed ? "passed" : "FAILED")
+		<< ", ACMR scan order " << scanStats.m_acmr << " -> " << scanOptimizedStats.m_acmr << ", shuffled " << shuffledStats.m_acmr << " -> "
+		<< cacheOptimizedStats.m_acmr << ", overdraw order " << overdrawOptimizedStats.m_acmr << "\n";
+	std::cout << check.m_stream.str();
+	return check.m_passed;
+}
+
+// LOD chains built like the scene cooker's must index the source vertices, land near their triangle targets, grow in error from
+// one LOD to the next and keep the seam vertices. A tight error bound must stop the simplification.
+bool CheckSimplification()
+{
+	FCheckReport check;
+	constexpr uint32_t rings = 64, segments = 128;
+	const FTestMesh mesh = CreateTestMesh(rings, segments);
+	const size_t vertexCount = mesh.m_positions.size() / 3;
+	std::vector<uint32_t> sourceIndices(mesh.m_indices.size());
+	OptimizeVertexCache(sourceIndices.data(), mesh.m_indices.data(), sourceIndices.size(), vertexCount);
+
+	auto GetPosition = [&mesh](const uint32_t v)
+	{
+		return std::array<float, 3>{ mesh.m_positions[3 * v], mesh.m_positions[3 * v + 1], mesh.m_positions[3 * v + 2] };
+	};
+
+	// Same targets as the cooker, half the triangles of the previous LOD and a tenth of the length of the bounds extents
+	const float maxError = 0.1f * 1.05f * std::sqrt(3.f);
+	std::vector<uint32_t> lodIndices = sourceIndices;
+	std::stringstream lodSummary;
+	bool validIndices = true, nearTarget = true, increasingError = true, seamKept = true;
+	float previousError = 0.f;
+
+	for (uint32_t lod = 1; lod < k_maxLodCount; ++lod)
+	{
+		const size_t targetIndexCount = lodIndices.size() / 6 * 3;
+		std::vector<uint32_t> simplifiedIndices(lodIndices.size());
+		float error = 0.f;
+		const size_t indexCount = Simplify(simplifiedIndices.data(), lodIndices.data(), lodIndices.size(), mesh.m_positions.data(), 3 * sizeof(float), vertexCount, targetIndexCount, maxError, &error);
+		simplifiedIndices.resize(indexCount);
+
+		validIndices = validIndices && indexCount > 0 && indexCount % 3 == 0;
+		for (size_t i = 0; i < indexCount; i += 3)
+		{
+			const uint32_t* t = &simplifiedIndices[i];
+			validIndices = validIndices && t[0] < vertexCount && t[1] < vertexCount && t[2] < vertexCount &&
+				GetPosition(t[0]) != GetPosition(t[1]) && GetPosition(t[1]) != GetPosition(t[2]) && GetPosition(t[2]) != GetPosition(t[0]);
+		}
+
+		nearTarget = nearTarget && indexCount <= targetIndexCount && indexCount >= 9 * targetIndexCount / 10;
+		increasingError = increasingError && error > previousError && error <= maxError;
+
+		// Both copies of every vertex along the seam, the poles aside
+		std::vector<bool> referenced(vertexCount, false);
+		for (const uint32_t v : simplifiedIndices)
+		{
+			if (v < vertexCount)
+			{
+				referenced[v] = true;
+			}
+		}
+
+		for (uint32_t ring = 1; ring < rings; ++ring)
+		{
+			seamKept = seamKept && referenced[ring * (segments + 1)] && referenced[ring * (segments + 1) + segments];
+		}
+
+		lodSummary << " " << indexCount / 3 << " (" << error << ")";
+		previousError = error;
+		lodIndices = std::move(simplifiedIndices);
+	}
+
+	check.Check(validIndices, "LOD indices are out of range or form degenerate triangles");
+	check.Check(nearTarget, "LOD triangle counts are not within 10% under their targets");
+	check.Check(increasingError, "LOD errors do not increase from one LOD to the next within the error bound");
+	check.Check(seamKept, "LODs drop vertices along the seam");
+
+	// Most collapses of the bumpy surface cost more than a tight bound
+	constexpr float tightError = 1e-4f;
+	std::vector<uint32_t> tightIndices(sourceIndices.size());
+	float error = 0.f;
+	const size_t tightIndexCount = Simplify(tightIndices.data(), sourceIndices.data(), sourceIndices.size(), mesh.m_positions.data(), 3 * sizeof(float), vertexCount, sourceIndices.size() / 24 * 3, tightError, &error);
+	check.Check(error <= tightError && tightIndexCount > sourceIndices.size() / 2, "simplification does not stop at the error bound");
+
+	std::cout << "Mesh optimizer simplification checks on " << sourceIndices.size() / 3 << " triangles: " << (check.m_passed ? "passed" : "FAILED")
+		<< ", LOD triangles (error)" << lodSummary.str() << ", " << tightIndexCount / 3 << " triangles with an error of " << tightError << "\n";
+	std::cout << check.m_stream.str();
+	return check.m_passed;
+}
+
+int main()
+{
+	bool passed = CheckVertexCacheOptimization();
+	passed = CheckSimplification() && passed;
+	return passed ? 0 : 1;
+}
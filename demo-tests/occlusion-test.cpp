@@ -0,0 +1,218 @@
+#include <occlusion.h>
+#include <check.h>
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+
+using namespace Occlusion;
+
+namespace
+{
+	struct FTestInstance
+	{
+		const FOccluder* m_occluder;
+		float m_localToWorld[16];
+	};
+
+	struct FTestBox
+	{
+		float m_center[3];
+		float m_extents[3];
+		bool m_visible;
+	};
+
+	struct FTestScene
+	{
+		const char* m_name;
+		std::vector<FTestInstance> m_instances;
+		std::vector<FTestBox> m_boxes;
+	};
+
+	// Uniform scale, rotation around x then y, then translation
+	FTestInstance MakeInstance(const FOccluder& occluder, const float scale, const float pitch, const float yaw, const float x, const float y, const float z)
+	{
+		const float cp = std::cos(pitch), sp = std::sin(pitch);
+		const float cy = std::cos(yaw), sy = std::sin(yaw);
+		return { &occluder, {
+			scale * cy, 0.f, -scale * sy, 0.f,
+			scale * sp * sy, scale * cp, scale * sp * cy, 0.f,
+			scale * cp * sy, -scale * sp, scale * cp * cy, 0.f,
+			x, y, z, 1.f } };
+	}
+
+	FOccluder CreateBox()
+	{
+		FOccluder box;
+		for (int corner = 0; corner < 8; ++corner)
+		{
+			box.m_positions.insert(box.m_positions.end(), { corner & 1 ? 1.f : -1.f, corner & 2 ? 1.f : -1.f, corner & 4 ? 1.f : -1.f });
+		}
+
+		box.m_indices = {
+			0, 2, 1, 1, 2, 3, 4, 5, 6, 5, 7, 6,
+			0, 1, 4, 1, 5, 4, 2, 6, 3, 3, 6, 7,
+			0, 4, 2, 2, 4, 6, 1, 3, 5, 3, 7, 5 };
+		return box;
+	}
+
+	// Grid of cells x cells quads in the xy plane over [-1, 1], displaced along z by height
+	template<typename FHeight>
+	FOccluder CreateGrid(const uint32_t cells, FHeight height)
+	{
+		FOccluder grid;
+		for (uint32_t j = 0; j <= cells; ++j)
+		{
+			for (uint32_t i = 0; i <= cells; ++i)
+			{
+				const float x = 2.f * i / cells - 1.f;
+				const float y = 2.f * j / cells - 1.f;
+				grid.m_positions.insert(grid.m_positions.end(), { x, y, height(x, y) });
+			}
+		}
+
+		for (uint32_t j = 0; j < cells; ++j)
+		{
+			for (uint32_t i = 0; i < cells; ++i)
+			{
+				const uint32_t v = j * (cells + 1) + i;
+				grid.m_indices.insert(grid.m_indices.end(), { v, v + 1, v + cells + 1, v + 1, v + cells + 2, v + cells + 1 });
+			}
+		}
+
+		return grid;
+	}
+
+	// Reads a greyscale Portable Float Map as written by FDepthBuffer::SaveImage
+	bool LoadImage(const std::filesystem::path& filepath, std::vector<float>& pixels, uint32_t& width, uint32_t& height)
+	{
+		std::ifstream file{ filepath, std::ios::binary };
+		std::string format;
+		float scale = 0.f;
+		if (!(file >> format >> width >> height >> scale) || format != "Pf" || scale >= 0.f)
+		{
+			return false;
+		}
+
+		file.get();
+		pixels.resize((size_t)width * height);
+		for (uint32_t y = height; y-- > 0;)
+		{
+			file.read((char*)&pixels[y * width], width * sizeof(float));
+		}
+
+		return (bool)file;
+	}
+}
+
+// Rasterizes each occluder set, compares the depth to <name>.pfm in the reference directory and tests boxes in front of, behind
+// and beside the occluders. Mismatching depth is written to <name>-actual.pfm, which replaces the reference when the rasterizer
+// output is meant to change.
+int main(int argc, char** argv)
+{
+	if (argc != 2)
+	{
+		std::cerr << "Usage: occlusion-test <reference directory>\n";
+		return 2;
+	}
+
+	const std::filesystem::path referenceDir = argv[1];
+	FCheckReport check;
+
+	// Camera at the origin looking down +z, 60 degrees vertical field of view, infinite reverse-Z projection
+	constexpr uint32_t width = 128, height = 64;
+	constexpr float nearZ = 0.1f;
+	const float focal = 1.f / std::tan(0.5f * 1.0471976f);
+	const float worldToClip[16] = {
+		focal * height / width, 0.f, 0.f, 0.f,
+		0.f, focal, 0.f, 0.f,
+		0.f, 0.f, 0.f, 1.f,
+		0.f, 0.f, nearZ, 0.f };
+
+	const FOccluder box = CreateBox();
+	const FOccluder quad = CreateGrid(1, [](float, float) { return 0.f; });
+	const FOccluder floor = CreateGrid(8, [](float, float) { return 0.f; });
+	const FOccluder heightfield = CreateGrid(48, [](const float x, const float y) { return 0.15f * std::sin(7.f * x) * std::cos(5.f * y); });
+
+	const FTestScene scenes[] = {
+		{ "quad", { MakeInstance(quad, 1.5f, 0.f, 0.6f, 0.f, 0.f, 4.f) }, {
+			{ { 0.f, 0.f, 10.f }, { 0.5f, 0.5f, 0.5f }, false },
+			{ { 0.f, 0.f, 2.f }, { 0.2f, 0.2f, 0.2f }, true },
+			{ { 6.f, 0.f, 10.f }, { 0.5f, 0.5f, 0.5f }, true } } },
+		{ "boxes", {
+			MakeInstance(box, 1.f, 0.3f, 0.4f, -1.5f, 0.f, 6.f),
+			MakeInstance(box, 0.7f, 0.8f, 1.1f, 0.2f, 0.4f, 4.5f),
+			MakeInstance(box, 1.5f, 0.f, 0.2f, 1.8f, -0.6f, 9.f) }, {
+			{ { -1.5f, 0.f, 12.f }, { 0.4f, 0.4f, 0.4f }, false },
+			{ { -1.5f, 0.f, 6.f }, { 0.2f, 0.2f, 0.2f }, false },
+			{ { -1.5f, 0.f, 4.f }, { 0.2f, 0.2f, 0.2f }, true },
+			{ { 0.f, 2.5f, 8.f }, { 0.3f, 0.3f, 0.3f }, true } } },
+		{ "near-plane", {
+			MakeInstance(floor, 40.f, 1.5707964f, 0.f, 0.f, -1.f, 20.f),
+			MakeInstance(quad, 1.f, 0.f, 1.2f, 1.2f, 0.f, 0.5f) }, {
+			{ { 0.f, -2.f, 10.f }, { 0.5f, 0.5f, 0.5f }, false },
+			{ { 0.f, 0.f, 10.f }, { 0.5f, 0.5f, 0.5f }, true },
+			{ { 0.f, 0.f, 0.f }, { 2.f, 2.f, 2.f }, true } } },
+		{ "heightfield", { MakeInstance(heightfield, 3.f, 0.f, 0.f, 0.f, 0.f, 5.f) }, {
+			{ { 0.f, 0.f, 7.f }, { 1.f, 1.f, 0.5f }, false },
+			{ { 0.f, 0.f, 5.f }, { 0.5f, 0.5f, 0.5f }, true } } },
+	};
+
+	FDepthBuffer depthBuffer{ width, height };
+	size_t triangleCount = 0, mismatchCount = 0;
+	float maxDepthError = 0.f;
+	for (const FTestScene& scene : scenes)
+	{
+		depthBuffer.Begin(worldToClip);
+		for (const FTestInstance& instance : scene.m_instances)
+		{
+			triangleCount += depthBuffer.AddOccluder(*instance.m_occluder, instance.m_localToWorld);
+		}
+
+		for (uint32_t tileIndex = 0; tileIndex < depthBuffer.GetTileCount(); ++tileIndex)
+		{
+			depthBuffer.RasterizeTile(tileIndex);
+		}
+
+		for (const FTestBox& box : scene.m_boxes)
+		{
+			std::stringstream what;
+			what << scene.m_name << ": box at (" << box.m_center[0] << ", " << box.m_center[1] << ", " << box.m_center[2] << ") is "
+				<< (box.m_visible ? "culled" : "not culled");
+			check.Check(depthBuffer.IsVisible(box.m_center, box.m_extents) == box.m_visible, what.str());
+		}
+
+		// Edge functions evaluated with and without FMA can disagree on pixel centers right on an edge, allow a couple of them
+		std::vector<float> reference;
+		uint32_t referenceWidth = 0, referenceHeight = 0;
+		const std::filesystem::path referencePath = referenceDir / (std::string{ scene.m_name } + ".pfm");
+		bool matches = LoadImage(referencePath, reference, referenceWidth, referenceHeight) && referenceWidth == width && referenceHeight == height;
+		check.Check(matches, "missing or invalid reference image " + referencePath.string());
+		if (matches)
+		{
+			size_t sceneMismatchCount = 0;
+			for (size_t i = 0; i < reference.size(); ++i)
+			{
+				const float error = std::abs(depthBuffer.GetDepth()[i] - reference[i]);
+				sceneMismatchCount += error > 1e-5f;
+				maxDepthError = std::max(maxDepthError, error);
+			}
+
+			mismatchCount += sceneMismatchCount;
+			matches = sceneMismatchCount <= 2;
+			check.Check(matches, std::string{ scene.m_name } + ": " + std::to_string(sceneMismatchCount) + " pixels differ from the reference image");
+		}
+
+		if (!matches)
+		{
+			depthBuffer.SaveImage(referenceDir / (std::string{ scene.m_name } + "-actual.pfm"));
+		}
+	}
+
+	std::cout << "Occlusion depth buffer checks on " << std::size(scenes) << " occluder sets, " << triangleCount << " triangles: "
+		<< (check.m_passed ? "passed" : "FAILED") << ", " << mismatchCount << " pixels differ from the reference images, max depth error "
+		<< maxDepthError << "\n";
+	std::cout << check.m_stream.str();
+	return check.m_passed ? 0 : 1;
+}